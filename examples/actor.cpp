@@ -0,0 +1,72 @@
+#include <iostream>
+#include <latch>
+#include <stdexcept>
+
+#include "actor.h"
+#include "eager_task.h"
+#include "task.h"
+#include "thread_pool.h"
+
+namespace {
+
+struct deposit {
+    int amount;
+};
+
+struct withdraw {
+    int amount;
+};
+
+struct account {
+    int balance = 0;
+
+    int handle(deposit msg) { return this->balance += msg.amount; }
+
+    int handle(withdraw msg)
+    {
+        if (msg.amount > this->balance) {
+            throw std::runtime_error("insufficient funds");
+        }
+
+        return this->balance -= msg.amount;
+    }
+};
+
+//! [actor example]
+wwa::coro::eager_task client(wwa::coro::thread_pool& pool, wwa::coro::actor<account>& acc, std::latch& done)
+{
+    co_await pool.schedule();
+
+    acc.tell(deposit{100});  // Fire and forget
+
+    // Messages are handled in order, one at a time: no lock around the balance
+    std::cout << "Balance after withdrawal: " << co_await acc.ask(withdraw{30}) << "\n";
+
+    try {
+        co_await acc.ask(withdraw{500});
+    }
+    catch (const std::exception& e) {
+        std::cout << "Rejected: " << e.what() << "\n";
+    }
+
+    done.count_down();
+}
+//! [actor example]
+
+}  // namespace
+
+int main()
+{
+    wwa::coro::thread_pool pool({.threads = 2});
+    wwa::coro::actor<account> acc;
+    std::latch done(1);
+
+    client(pool, acc, done);
+    done.wait();
+
+    // Expected output:
+    // Balance after withdrawal: 70
+    // Rejected: insufficient funds
+
+    return 0;
+}
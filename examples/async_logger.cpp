@@ -0,0 +1,45 @@
+#include <unistd.h>
+
+#include <thread>
+#include <vector>
+
+#include "async_logger.h"
+
+namespace {
+
+//! [async_logger example]
+void handle_requests(wwa::coro::async_logger& log, int worker)
+{
+    for (int request = 0; request < 2; ++request) {
+        // Formats into the ring of this thread: no locks, no allocations, no system calls
+        log.log("worker=", worker, " request=", request, " ok=", true, " ms=", 0.5);
+    }
+}
+//! [async_logger example]
+
+}  // namespace
+
+int main()
+{
+    {
+        wwa::coro::async_logger log(STDOUT_FILENO);
+        std::vector<std::thread> workers;
+        for (int w = 0; w < 2; ++w) {
+            workers.emplace_back([&log, w] { handle_requests(log, w); });
+        }
+
+        for (auto& t : workers) {
+            t.join();
+        }
+
+        // The destructor writes out everything that is still pending
+    }
+
+    // Expected output (records of different workers may interleave):
+    // worker=0 request=0 ok=true ms=0.5
+    // worker=0 request=1 ok=true ms=0.5
+    // worker=1 request=0 ok=true ms=0.5
+    // worker=1 request=1 ok=true ms=0.5
+
+    return 0;
+}
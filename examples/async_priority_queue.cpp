@@ -0,0 +1,46 @@
+#include <iostream>
+#include <string>
+
+#include "async_priority_queue.h"
+#include "eager_task.h"
+
+namespace {
+
+struct job {
+    int priority;
+    std::string name;
+
+    friend bool operator<(const job& lhs, const job& rhs) noexcept { return lhs.priority < rhs.priority; }
+};
+
+//! [async_priority_queue example]
+wwa::coro::eager_task dispatcher(wwa::coro::async_priority_queue<job>& jobs)
+{
+    // Suspends while the queue is empty; an empty optional means the queue is closed and drained
+    while (auto j = co_await jobs.pop()) {
+        std::cout << j->priority << ": " << j->name << "\n";
+    }
+}
+//! [async_priority_queue example]
+
+}  // namespace
+
+int main()
+{
+    // A single shard gives strict ordering; more shards trade ordering for scalability
+    wwa::coro::async_priority_queue<job> jobs(1);
+
+    jobs.push({1, "cleanup"});
+    jobs.push({5, "billing"});
+    jobs.push({3, "reports"});
+    jobs.close();
+
+    dispatcher(jobs);
+
+    // Expected output:
+    // 5: billing
+    // 3: reports
+    // 1: cleanup
+
+    return 0;
+}
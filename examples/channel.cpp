@@ -0,0 +1,45 @@
+#include <iostream>
+
+#include "channel.h"
+#include "eager_task.h"
+
+namespace {
+
+//! [channel example]
+wwa::coro::eager_task producer(wwa::coro::channel<int>& ch)
+{
+    for (int i = 0; i < 5; ++i) {
+        // Suspends while the channel is full
+        co_await ch.send(i);
+    }
+
+    ch.close();
+}
+
+wwa::coro::eager_task consumer(wwa::coro::channel<int>& ch)
+{
+    // Suspends while the channel is empty; an empty optional means the channel is closed and drained
+    while (auto value = co_await ch.recv()) {
+        std::cout << *value << "\n";
+    }
+}
+//! [channel example]
+
+}  // namespace
+
+int main()
+{
+    wwa::coro::channel<int> ch(2);
+
+    consumer(ch);
+    producer(ch);
+
+    // Expected output:
+    // 0
+    // 1
+    // 2
+    // 3
+    // 4
+
+    return 0;
+}
@@ -0,0 +1,46 @@
+#include <chrono>
+#include <iostream>
+#include <latch>
+#include <string>
+
+#include "delay_queue.h"
+#include "eager_task.h"
+
+namespace {
+
+//! [delay_queue example]
+wwa::coro::eager_task retrier(wwa::coro::delay_queue<std::string>& retries, std::latch& done)
+{
+    // Suspends until the earliest retry is due; all consumers share a single timer
+    while (auto request = co_await retries.pop()) {
+        std::cout << "retrying " << *request << "\n";
+        done.count_down();
+    }
+}
+//! [delay_queue example]
+
+}  // namespace
+
+int main()
+{
+    using namespace std::chrono_literals;
+
+    wwa::coro::delay_queue<std::string> retries;
+    std::latch done(3);
+
+    retrier(retries, done);
+
+    retries.push("GET /c", 30ms);
+    retries.push("GET /a", 10ms);
+    retries.push("GET /b", 20ms);
+
+    done.wait();
+    retries.close();
+
+    // Expected output:
+    // retrying GET /a
+    // retrying GET /b
+    // retrying GET /c
+
+    return 0;
+}
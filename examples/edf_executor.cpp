@@ -0,0 +1,68 @@
+#include <chrono>
+#include <iostream>
+#include <latch>
+#include <mutex>
+#include <string>
+
+#include "eager_task.h"
+#include "edf_executor.h"
+#include "task.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+
+std::mutex output_mutex;
+
+void print(const std::string& what)
+{
+    const std::scoped_lock lock(output_mutex);
+    std::cout << what << "\n";
+}
+
+wwa::coro::task<> lookup(wwa::coro::edf_executor& executor, const std::string& request)
+{
+    // Inherits the deadline of the caller
+    co_await executor.schedule();
+    print(request + ": lookup done");
+}
+
+//! [edf_executor example]
+wwa::coro::eager_task
+handle(wwa::coro::edf_executor& executor, std::string request, std::chrono::milliseconds slack, std::latch& done)
+{
+    // Requests that are about to time out run before those with plenty of slack
+    co_await executor.schedule_within(slack);
+    co_await lookup(executor, request);
+    print(request + ": replied");
+    done.count_down();
+}
+//! [edf_executor example]
+
+}  // namespace
+
+int main()
+{
+    wwa::coro::edf_executor executor(1);
+    std::latch go(1);
+    std::latch done(2);
+
+    // Keep the only worker busy while the requests arrive
+    [](wwa::coro::edf_executor& e, std::latch& l) -> wwa::coro::eager_task {
+        co_await e.schedule();
+        l.wait();
+    }(executor, go);
+
+    handle(executor, "report", 5s, done);
+    handle(executor, "search", 50ms, done);
+    go.count_down();
+    done.wait();
+
+    // Expected output:
+    // search: lookup done
+    // search: replied
+    // report: lookup done
+    // report: replied
+
+    return 0;
+}
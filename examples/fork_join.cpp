@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <latch>
+#include <numeric>
+#include <random>
+#include <span>
+#include <vector>
+
+#include "eager_task.h"
+#include "fork_join.h"
+
+namespace {
+
+//! [fork_join example]
+wwa::coro::parallel_task<long> fib(int n)
+{
+    if (n < 2) {
+        co_return n;
+    }
+
+    auto a = fib(n - 1);
+    a.fork();  // Idle workers may steal this half
+    const long b = co_await fib(n - 2);  // Meanwhile, compute the other half here
+    co_return co_await a + b;  // Runs `a` inline unless somebody has stolen it
+}
+
+wwa::coro::parallel_task<> merge_sort(std::span<int> v, std::span<int> tmp)
+{
+    if (v.size() <= 1024) {
+        std::ranges::sort(v);  // Too small to be worth splitting
+        co_return;
+    }
+
+    const std::size_t mid = v.size() / 2;
+    auto left             = merge_sort(v.first(mid), tmp.first(mid));
+    left.fork();
+    co_await merge_sort(v.subspan(mid), tmp.subspan(mid));
+    co_await left;
+
+    std::ranges::merge(v.first(mid), v.subspan(mid), tmp.begin());
+    std::ranges::copy(tmp.first(v.size()), v.begin());
+}
+//! [fork_join example]
+
+wwa::coro::eager_task run(wwa::coro::fork_join_pool& pool, std::vector<int>& data, std::latch& done)
+{
+    co_await pool.schedule();
+
+    std::cout << "fib(25) = " << co_await fib(25) << "\n";
+
+    std::vector<int> tmp(data.size());
+    co_await merge_sort(data, tmp);
+    std::cout << "Sorted " << data.size() << " numbers: " << std::boolalpha << std::ranges::is_sorted(data) << "\n";
+
+    done.count_down();
+}
+
+}  // namespace
+
+int main()
+{
+    wwa::coro::fork_join_pool pool;
+    std::vector<int> data(100000);
+    std::iota(data.begin(), data.end(), 0);
+    std::ranges::shuffle(data, std::mt19937{1});
+    std::latch done(1);
+
+    run(pool, data, done);
+    done.wait();
+
+    // Expected output:
+    // fib(25) = 75025
+    // Sorted 100000 numbers: true
+
+    return 0;
+}
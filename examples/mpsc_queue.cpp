@@ -0,0 +1,53 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "eager_task.h"
+#include "mpsc_queue.h"
+
+namespace {
+
+struct request : wwa::coro::mpsc_queue_hook {
+    request(int c, std::string t) : client(c), text(std::move(t)) {}
+
+    int client;
+    std::string text;
+};
+
+//! [mpsc_queue example]
+wwa::coro::eager_task server(wwa::coro::mpsc_queue<request>& inbox, std::size_t expected)
+{
+    std::size_t handled = 0;
+    while (handled < expected) {
+        // Suspends only while the inbox is empty; every wake-up drains all pending requests at once
+        for (const request& r : co_await inbox.pop_all()) {
+            std::cout << "client " << r.client << ": " << r.text << "\n";
+            ++handled;
+        }
+    }
+}
+//! [mpsc_queue example]
+
+}  // namespace
+
+int main()
+{
+    wwa::coro::mpsc_queue<request> inbox;
+    std::vector<request> requests{{1, "GET /"}, {2, "GET /about"}, {3, "POST /login"}};
+
+    server(inbox, requests.size());
+
+    // One client at a time, to keep the output deterministic
+    for (auto& r : requests) {
+        std::thread([&inbox, &r] { inbox.push(&r); }).join();
+    }
+
+    // Expected output:
+    // client 1: GET /
+    // client 2: GET /about
+    // client 3: POST /login
+
+    return 0;
+}
@@ -0,0 +1,48 @@
+#include <chrono>
+#include <iostream>
+#include <latch>
+#include <string>
+#include <thread>
+
+#include "eager_task.h"
+#include "offload.h"
+#include "thread_pool.h"
+
+namespace {
+
+// A synchronous library call
+std::string legacy_lookup(int id)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    return "customer #" + std::to_string(id);
+}
+
+//! [offload example]
+wwa::coro::eager_task handle(wwa::coro::thread_pool& pool, int id, std::latch& done)
+{
+    co_await pool.schedule();
+
+    // The worker stays free while the call blocks a thread of the blocking pool
+    const std::string name = co_await wwa::coro::offload(legacy_lookup, id);
+
+    // Back on the worker of the thread pool
+    std::cout << "Found " << name << (pool.running_in_this_thread() ? " on a worker" : "") << "\n";
+    done.count_down();
+}
+//! [offload example]
+
+}  // namespace
+
+int main()
+{
+    wwa::coro::thread_pool pool({.threads = 1});
+    std::latch done(1);
+
+    handle(pool, 42, done);
+    done.wait();
+
+    // Expected output:
+    // Found customer #42 on a worker
+
+    return 0;
+}
@@ -0,0 +1,44 @@
+#include <iostream>
+
+#include "eager_task.h"
+#include "rendezvous_channel.h"
+
+namespace {
+
+//! [rendezvous_channel example]
+wwa::coro::eager_task server(wwa::coro::rendezvous_channel<int>& requests, wwa::coro::rendezvous_channel<int>& responses)
+{
+    while (auto request = co_await requests.recv()) {
+        // Completes only when the client takes the response
+        co_await responses.send(*request * *request);
+    }
+}
+
+wwa::coro::eager_task client(wwa::coro::rendezvous_channel<int>& requests, wwa::coro::rendezvous_channel<int>& responses)
+{
+    for (int i = 1; i <= 3; ++i) {
+        co_await requests.send(i);
+        std::cout << i << "^2 = " << *co_await responses.recv() << "\n";
+    }
+
+    requests.close();
+}
+//! [rendezvous_channel example]
+
+}  // namespace
+
+int main()
+{
+    wwa::coro::rendezvous_channel<int> requests;
+    wwa::coro::rendezvous_channel<int> responses;
+
+    server(requests, responses);
+    client(requests, responses);
+
+    // Expected output:
+    // 1^2 = 1
+    // 2^2 = 4
+    // 3^2 = 9
+
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include <chrono>
+#include <iostream>
+#include <latch>
+#include <string>
+#include <thread>
+#include <variant>
+
+#include "channel.h"
+#include "eager_task.h"
+#include "select.h"
+
+namespace {
+
+//! [select example]
+wwa::coro::eager_task worker(wwa::coro::channel<int>& data, wwa::coro::channel<std::string>& control, std::latch& done)
+{
+    using namespace std::chrono_literals;
+    using wwa::coro::recv;
+    using wwa::coro::select;
+    using wwa::coro::timeout;
+
+    while (true) {
+        // Waits for whichever happens first: data, a control message, or the deadline
+        auto event = co_await select(recv(data), recv(control), timeout(50ms));
+        if (event.index() == 0) {
+            std::cout << "data: " << std::get<0>(event).value_or(-1) << "\n";
+        }
+        else if (event.index() == 1) {
+            std::cout << "control: " << std::get<1>(event).value_or("closed") << "\n";
+            break;
+        }
+        else {
+            std::cout << "idle\n";
+        }
+    }
+
+    done.count_down();
+}
+//! [select example]
+
+}  // namespace
+
+int main()
+{
+    wwa::coro::channel<int> data(4);
+    wwa::coro::channel<std::string> control(1);
+    std::latch done(1);
+
+    worker(data, control, done);
+
+    [](wwa::coro::channel<int>& d) -> wwa::coro::eager_task {
+        co_await d.send(1);
+        co_await d.send(2);
+    }(data);
+
+    // Let the worker time out once
+    std::this_thread::sleep_for(std::chrono::milliseconds(75));
+
+    [](wwa::coro::channel<std::string>& c) -> wwa::coro::eager_task { co_await c.send("stop"); }(control);
+
+    done.wait();
+
+    // Expected output:
+    // data: 1
+    // data: 2
+    // idle
+    // control: stop
+
+    return 0;
+}
@@ -0,0 +1,51 @@
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <latch>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "eager_task.h"
+#include "sharded_runtime.h"
+
+namespace {
+
+// Every shard owns one partition; only the thread of the shard touches it
+using partition = std::unordered_map<std::string, std::string>;
+
+//! [sharded_runtime example]
+wwa::coro::eager_task client(wwa::coro::sharded_runtime& rt, std::vector<partition>& parts, std::latch& done)
+{
+    const auto owner = [&rt](const std::string& key) { return std::hash<std::string>{}(key) % rt.size(); };
+
+    co_await rt.schedule(0);
+
+    const std::string key = "user:42";
+    co_await rt.submit_to(owner(key), [&rt, &parts, &key] { parts[rt.current_shard()][key] = "Alice"; });
+
+    const std::string name = co_await rt.submit_to(owner(key), [&rt, &parts, &key] {
+        return parts[rt.current_shard()][key];  // No lock: the partition belongs to this shard
+    });
+
+    std::cout << key << " = " << name << (rt.current_shard() == 0 ? " (back on shard 0)" : "") << "\n";
+    done.count_down();
+}
+//! [sharded_runtime example]
+
+}  // namespace
+
+int main()
+{
+    wwa::coro::sharded_runtime rt({.shards = 4, .pin_shards = false});
+    std::vector<partition> parts(rt.size());
+    std::latch done(1);
+
+    client(rt, parts, done);
+    done.wait();
+
+    // Expected output:
+    // user:42 = Alice (back on shard 0)
+
+    return 0;
+}
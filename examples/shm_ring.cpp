@@ -0,0 +1,76 @@
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "eager_task.h"
+#include "shm_ring.h"
+
+namespace {
+
+//! [shm_ring example]
+wwa::coro::eager_task producer(wwa::coro::shm_ring& ring, std::atomic<bool>& done)
+{
+    for (std::string_view line : {"first record", "second record", "third record"}) {
+        // Copies the record into the shared mapping; suspends only while the ring is full
+        co_await ring.send(std::as_bytes(std::span(line.data(), line.size())));
+    }
+
+    ring.close();
+    done.store(true);
+}
+
+wwa::coro::eager_task consumer(wwa::coro::shm_ring& ring, std::atomic<bool>& done)
+{
+    auto records = ring.receive();
+    for (auto it = co_await records.begin(); it != records.end(); co_await ++it) {
+        // `*it` points into the shared mapping: no copies, and no system calls while records keep coming
+        const std::span<const std::byte> record = *it;
+        std::cout << std::string_view(reinterpret_cast<const char*>(record.data()), record.size()) << "\n";
+    }
+
+    done.store(true);
+}
+//! [shm_ring example]
+
+void wait_for(const std::atomic<bool>& flag)
+{
+    while (!flag.load()) {
+        std::this_thread::yield();
+    }
+}
+
+}  // namespace
+
+int main()
+{
+    wwa::coro::shm_ring ring(4096);
+    std::atomic<bool> done = false;
+
+    const pid_t pid = fork();
+    if (pid == 0) {
+        // The child attaches to the inherited descriptors; it gets its own poller because threads do not survive fork()
+        wwa::coro::fd_poller poller;
+        wwa::coro::shm_ring attached(ring.native_handles(), poller);
+        producer(attached, done);
+        wait_for(done);
+        _exit(0);
+    }
+
+    consumer(ring, done);
+    wait_for(done);
+    waitpid(pid, nullptr, 0);
+
+    // Expected output:
+    // first record
+    // second record
+    // third record
+
+    return 0;
+}
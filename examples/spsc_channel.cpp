@@ -0,0 +1,47 @@
+#include <iostream>
+#include <string>
+
+#include "eager_task.h"
+#include "spsc_channel.h"
+
+namespace {
+
+//! [spsc_channel example]
+wwa::coro::eager_task producer(wwa::coro::spsc_channel<std::string>& ch)
+{
+    for (const char* word : {"zero", "copy", "slots"}) {
+        // Borrow a free slot and fill it in place
+        std::string* slot = co_await ch.reserve();
+        slot->assign(word);
+        ch.commit();
+    }
+
+    ch.close();
+}
+
+wwa::coro::eager_task consumer(wwa::coro::spsc_channel<std::string>& ch)
+{
+    // Borrow a filled slot, read it in place, and give it back
+    while (const std::string* slot = co_await ch.peek()) {
+        std::cout << *slot << "\n";
+        ch.release();
+    }
+}
+//! [spsc_channel example]
+
+}  // namespace
+
+int main()
+{
+    wwa::coro::spsc_channel<std::string> ch(2);
+
+    consumer(ch);
+    producer(ch);
+
+    // Expected output:
+    // zero
+    // copy
+    // slots
+
+    return 0;
+}
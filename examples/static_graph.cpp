@@ -0,0 +1,62 @@
+#include <iostream>
+#include <latch>
+#include <string>
+
+#include "eager_task.h"
+#include "static_graph.h"
+#include "task.h"
+#include "thread_pool.h"
+
+namespace {
+
+//! [static_graph example]
+struct parse {
+    std::string operator()() const { return "user=42"; }
+};
+
+struct load_user {
+    wwa::coro::task<std::string> operator()(const std::string& request) const { co_return "alice (" + request + ")"; }
+};
+
+struct load_cart {
+    wwa::coro::task<int> operator()(const std::string&) const { co_return 3; }
+};
+
+struct render {
+    std::string operator()(const std::string& user, const int& items) const
+    {
+        return user + " has " + std::to_string(items) + " items";
+    }
+};
+
+// The shape of the pipeline is a type: the order and the wiring are computed at compile time
+using pipeline = wwa::coro::static_graph<
+    wwa::coro::node<parse>,
+    wwa::coro::node<load_user, wwa::coro::depends<parse>>,
+    wwa::coro::node<load_cart, wwa::coro::depends<parse>>,
+    wwa::coro::node<render, wwa::coro::depends<load_user, load_cart>>>;
+
+wwa::coro::eager_task handle(wwa::coro::thread_pool& pool, std::latch& done)
+{
+    pipeline p;  // All storage is inside the object
+    co_await p.run(pool);  // load_user and load_cart run in parallel
+    std::cout << p.get<render>() << "\n";
+    done.count_down();
+}
+//! [static_graph example]
+
+}  // namespace
+
+int main()
+{
+    wwa::coro::thread_pool pool({.threads = 2});
+    std::latch done(1);
+
+    handle(pool, done);
+    done.wait();
+
+    // Expected output:
+    // alice (user=42) has 3 items
+
+    return 0;
+}
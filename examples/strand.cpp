@@ -0,0 +1,46 @@
+#include <iostream>
+#include <latch>
+#include <string>
+
+#include "eager_task.h"
+#include "strand.h"
+#include "thread_pool.h"
+
+namespace {
+
+struct session {
+    wwa::coro::strand strand;
+    std::string log;  // Touched only on the strand
+};
+
+//! [strand example]
+wwa::coro::eager_task on_message(wwa::coro::thread_pool& pool, session& s, std::string text, std::latch& done)
+{
+    co_await pool.schedule();  // Decode, validate, etc. in parallel
+
+    co_await s.strand.schedule();  // One coroutine at a time from here on; no mutex
+    s.log += text;
+    done.count_down();
+}
+//! [strand example]
+
+}  // namespace
+
+int main()
+{
+    wwa::coro::thread_pool pool({.threads = 4});
+    session s;
+    std::latch done(3);
+
+    on_message(pool, s, "a", done);
+    on_message(pool, s, "b", done);
+    on_message(pool, s, "c", done);
+    done.wait();
+
+    std::cout << "Received " << s.log.size() << " messages\n";
+
+    // Expected output:
+    // Received 3 messages
+
+    return 0;
+}
@@ -0,0 +1,48 @@
+#include <iostream>
+#include <latch>
+#include <string>
+
+#include "eager_task.h"
+#include "task.h"
+#include "task_graph.h"
+#include "thread_pool.h"
+
+namespace {
+
+//! [task_graph example]
+wwa::coro::eager_task build(wwa::coro::thread_pool& pool, std::latch& done)
+{
+    wwa::coro::task_graph g;
+
+    auto flags = g.add([] { return std::string("-O2"); });
+
+    // Both objects depend on the flags only: they compile in parallel
+    auto main_o = g.add([](const std::string& f) -> wwa::coro::task<std::string> { co_return "main.o" + f; }, flags);
+    auto util_o = g.add([](const std::string& f) -> wwa::coro::task<std::string> { co_return "util.o" + f; }, flags);
+
+    // Starts the moment the second object is ready; receives references, not copies
+    auto app = g.add(
+        [](const std::string& a, const std::string& b) { return "app <- " + a + " + " + b; }, main_o, util_o
+    );
+
+    co_await g.run(pool);
+    std::cout << app.get() << "\n";
+    done.count_down();
+}
+//! [task_graph example]
+
+}  // namespace
+
+int main()
+{
+    wwa::coro::thread_pool pool({.threads = 2});
+    std::latch done(1);
+
+    build(pool, done);
+    done.wait();
+
+    // Expected output:
+    // app <- main.o-O2 + util.o-O2
+
+    return 0;
+}
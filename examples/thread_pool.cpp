@@ -0,0 +1,75 @@
+#include <iostream>
+#include <latch>
+#include <mutex>
+#include <string>
+
+#include "eager_task.h"
+#include "task.h"
+#include "thread_pool.h"
+
+namespace {
+
+constexpr std::size_t interactive = 0;
+constexpr std::size_t background  = 2;
+
+std::mutex output_mutex;
+
+void print(const std::string& what)
+{
+    const std::scoped_lock lock(output_mutex);
+    std::cout << what << "\n";
+}
+
+wwa::coro::task<> compress(wwa::coro::thread_pool& pool, int chunk)
+{
+    // Inherits the priority of the caller
+    co_await pool.schedule();
+    print("compressed chunk " + std::to_string(chunk));
+}
+
+//! [thread_pool example]
+wwa::coro::eager_task handle_click(wwa::coro::thread_pool& pool, std::latch& done)
+{
+    // Interactive work jumps ahead of queued background work
+    co_await pool.schedule(interactive);
+    print("handled click");
+    done.count_down();
+}
+
+wwa::coro::eager_task nightly_backup(wwa::coro::thread_pool& pool, std::latch& done)
+{
+    co_await pool.schedule(background);
+    for (int chunk = 0; chunk < 2; ++chunk) {
+        co_await compress(pool, chunk);  // Runs with the background priority as well
+    }
+
+    done.count_down();
+}
+//! [thread_pool example]
+
+}  // namespace
+
+int main()
+{
+    wwa::coro::thread_pool pool({.threads = 1});
+    std::latch go(1);
+    std::latch done(2);
+
+    // Keep the only worker busy while the work arrives
+    [](wwa::coro::thread_pool& p, std::latch& l) -> wwa::coro::eager_task {
+        co_await p.schedule(interactive);
+        l.wait();
+    }(pool, go);
+
+    nightly_backup(pool, done);
+    handle_click(pool, done);
+    go.count_down();
+    done.wait();
+
+    // Expected output:
+    // handled click
+    // compressed chunk 0
+    // compressed chunk 1
+
+    return 0;
+}
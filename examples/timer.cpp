@@ -0,0 +1,40 @@
+#include <chrono>
+#include <iostream>
+#include <latch>
+
+#include "eager_task.h"
+#include "timer.h"
+
+namespace {
+
+//! [timer example]
+wwa::coro::eager_task tick(const char* name, std::chrono::milliseconds delay, std::latch& done)
+{
+    // Resumes on the timer thread once the delay has elapsed
+    co_await wwa::coro::sleep_for(delay);
+    std::cout << name << "\n";
+    done.count_down();
+}
+//! [timer example]
+
+}  // namespace
+
+int main()
+{
+    using namespace std::chrono_literals;
+
+    std::latch done(3);
+
+    tick("third", 30ms, done);
+    tick("first", 10ms, done);
+    tick("second", 20ms, done);
+
+    done.wait();
+
+    // Expected output:
+    // first
+    // second
+    // third
+
+    return 0;
+}
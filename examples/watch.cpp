@@ -0,0 +1,47 @@
+#include <iostream>
+
+#include "eager_task.h"
+#include "watch.h"
+
+namespace {
+
+struct limits {
+    int max_connections;
+    int max_requests;
+};
+
+//! [watch example]
+wwa::coro::eager_task reader(const char* name, wwa::coro::watch<limits>& config)
+{
+    // Wait-free read of the latest value
+    auto current = config.borrow();
+    std::cout << name << ": " << current.max_connections << "/" << current.max_requests << "\n";
+
+    // Suspend until a writer publishes a new value
+    while (co_await config.changed()) {
+        current = config.borrow();
+        std::cout << name << ": " << current.max_connections << "/" << current.max_requests << "\n";
+    }
+}
+//! [watch example]
+
+}  // namespace
+
+int main()
+{
+    wwa::coro::watch<limits> config({100, 1000});
+
+    reader("A", config);
+    reader("B", config);
+
+    config.publish({200, 2000});
+    config.close();
+
+    // Expected output:
+    // A: 100/1000
+    // B: 100/1000
+    // A: 200/2000
+    // B: 200/2000
+
+    return 0;
+}
@@ -0,0 +1,402 @@
+#ifndef A7D3E5F1_2C84_4B9A_9E06_5F1B8C27D4A3
+#define A7D3E5F1_2C84_4B9A_9E06_5F1B8C27D4A3
+
+/**
+ * @file actor.h
+ * @brief Actors: state that processes messages one at a time.
+ *
+ * This file contains the definition of the `actor` class template. `co_await a.ask(msg)` hands a message to the
+ * state of the actor and returns the reply; `a.tell(msg)` sends a message without waiting for it.
+ *
+ * Example:
+ * @snippet actor.cpp actor example
+ */
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "detail.h"
+#include "eager_task.h"
+#include "mpsc_queue.h"
+#include "task.h"
+
+namespace wwa::coro {
+
+/**
+ * @brief An object that processes messages one at a time.
+ *
+ * The actor owns a `State`, which handles messages in `handle()` member functions: `state.handle(msg)` returns
+ * the reply, or a `task<>` that produces it. A handler that returns a task may suspend; the actor takes
+ * the next message only after the task has completed, so handlers never overlap and the state needs no lock.
+ *
+ * The mailbox is an intrusive `mpsc_queue`: every `ask()` is a `task<>` whose frame waits in the queue, so
+ * a message costs no allocation beyond that frame. An idle actor holds neither a thread nor a coroutine, only the
+ * state and the empty queue. A message sent to an idle actor is handled right away on the sending thread.
+ * Otherwise, it is queued, and whoever finishes the previous message hands the actor over to it. That hand-over may
+ * happen on the thread where an asynchronous handler completes. Whatever the sender does after its reply must not
+ * hold up the mailbox: on a thread that belongs to a scheduler (such as `thread_pool`), the sender is queued on the
+ * scheduler and the next message starts right away; elsewhere, the next message starts first, and the reply is
+ * delivered as soon as that message has finished or suspended.
+ *
+ * Example:
+ * @snippet actor.cpp actor example
+ *
+ * @tparam State The state; handles messages in `handle()` overloads.
+ */
+template<typename State>
+class actor {
+    class mailbox_op;
+
+public:
+    /**
+     * @brief The reply to a message.
+     *
+     * @tparam Msg The type of the message.
+     */
+    template<typename Msg>
+    using reply_type =
+        typename detail::unwrap_task<decltype(std::declval<State&>().handle(std::declval<Msg>()))>::type;
+
+    /**
+     * @brief Constructs a new actor.
+     *
+     * @param args The arguments to construct the state with.
+     */
+    template<typename... Args>
+    explicit actor(Args&&... args) : m_state(std::forward<Args>(args)...)
+    {}
+
+    /// @cond
+    actor(const actor&)            = delete;
+    actor(actor&&)                 = delete;
+    actor& operator=(const actor&) = delete;
+    actor& operator=(actor&&)      = delete;
+    /// @endcond
+
+    /**
+     * @brief Destructor.
+     *
+     * A finished message gives the actor back before its reply is delivered, so the coroutine awaiting the last
+     * reply may destroy the actor. The destructor waits until the count of messages, possibly updated by another
+     * thread, has dropped to zero.
+     *
+     * @warning All messages must have been handled; a handler must not destroy its own actor.
+     *
+     * @internal
+     * @test @a ActorTest.DestroyFromContinuation
+     */
+    ~actor()
+    {
+        while (this->m_count.load(std::memory_order_acquire) != 0) {
+            std::this_thread::yield();
+        }
+    }
+
+    /**
+     * @brief Sends a message and waits for the reply.
+     *
+     * The message is handled when the returned task is awaited, after the messages sent before it.
+     *
+     * @param msg The message.
+     * @return A task that produces the reply of the handler or rethrows its exception.
+     * @warning A handler must not `ask()` its own actor: the message would wait for the handler forever.
+     *
+     * @internal
+     * @test @a ActorTest.Ask
+     * @test @a ActorTest.AsyncHandler
+     * @test @a ActorTest.Exception
+     * @test @a ActorTest.Serializes
+     * @test @a ActorTest.ReplyBeforeBacklog
+     * @test @a ActorTest.ContinuationOnPool
+     */
+    template<typename Msg>
+    [[nodiscard]] task<reply_type<Msg>> ask(Msg msg)
+    {
+        using result_type  = reply_type<Msg>;
+        using storage_type = std::conditional_t<
+            std::is_void_v<result_type>, std::monostate,
+            std::conditional_t<
+                std::is_reference_v<result_type>, std::add_pointer_t<std::remove_reference_t<result_type>>,
+                result_type>>;
+
+        co_await mailbox_op{*this};
+
+        std::variant<std::monostate, storage_type, std::exception_ptr> result;
+        try {
+            if constexpr (detail::is_task_v<decltype(this->m_state.handle(std::move(msg)))>) {
+                if constexpr (std::is_void_v<result_type>) {
+                    co_await this->m_state.handle(std::move(msg));
+                    result.template emplace<1>();
+                }
+                else if constexpr (std::is_reference_v<result_type>) {
+                    result.template emplace<1>(std::addressof(co_await this->m_state.handle(std::move(msg))));
+                }
+                else {
+                    result.template emplace<1>(co_await this->m_state.handle(std::move(msg)));
+                }
+            }
+            else if constexpr (std::is_void_v<result_type>) {
+                this->m_state.handle(std::move(msg));
+                result.template emplace<1>();
+            }
+            else if constexpr (std::is_reference_v<result_type>) {
+                result.template emplace<1>(std::addressof(this->m_state.handle(std::move(msg))));
+            }
+            else {
+                result.template emplace<1>(this->m_state.handle(std::move(msg)));
+            }
+        }
+        catch (...) {
+            result.template emplace<2>(std::current_exception());
+        }
+
+        // From here on, the actor belongs to the next message: only locals may be touched
+        co_await handover{*this};
+
+        if (auto* e = std::get_if<2>(&result)) {
+            std::rethrow_exception(*e);
+        }
+
+        if constexpr (std::is_reference_v<result_type>) {
+            co_return static_cast<result_type>(*std::get<1>(result));
+        }
+        else if constexpr (!std::is_void_v<result_type>) {
+            co_return std::move(std::get<1>(result));
+        }
+    }
+
+    /**
+     * @brief Sends a message without waiting for it to be handled.
+     *
+     * The reply, if any, is discarded.
+     *
+     * @param msg The message.
+     * @warning As with any `eager_task`, an exception thrown by the handler terminates the program.
+     *
+     * @internal
+     * @test @a ActorTest.Tell
+     */
+    template<typename Msg>
+    void tell(Msg msg)
+    {
+        deliver(*this, std::move(msg));
+    }
+
+private:
+    /** @brief Where the actor is in handing a message over. */
+    enum class phase : unsigned char {
+        idle,      ///< Nobody is in `pump()`.
+        running,   ///< `pump()` is resuming a message.
+        released,  ///< The message resumed by `pump()` has finished and left its `handover` in `m_finished`.
+    };
+
+    /**
+     * @brief Awaitable that waits for the turn of a message.
+     *
+     * The awaiter is the node of the mailbox.
+     */
+    class [[nodiscard]] mailbox_op : private mpsc_queue_hook {
+    public:
+        /**
+         * @brief Constructs a new operation.
+         *
+         * @param a The actor.
+         */
+        explicit mailbox_op(actor& a) noexcept : m_actor(a) {}
+
+        /**
+         * @brief Takes the actor if it is idle.
+         *
+         * @return Whether the message can be handled right away.
+         */
+        [[nodiscard]] bool await_ready() noexcept
+        {
+            std::size_t expected = 0;
+            return this->m_actor.m_count.compare_exchange_strong(expected, 1, std::memory_order_acq_rel);
+        }
+
+        /**
+         * @brief Queues the message; takes the actor if it has become idle meanwhile.
+         *
+         * @param h The awaiting coroutine.
+         */
+        void await_suspend(std::coroutine_handle<> h) noexcept
+        {
+            // Once queued, the coroutine may be resumed by another thread and the awaiter may be gone
+            actor& a       = this->m_actor;
+            this->m_handle = h;
+            a.m_mailbox.push(this);
+            if (a.m_count.fetch_add(1, std::memory_order_acq_rel) == 0) {
+                a.pump(nullptr);
+            }
+        }
+
+        /** @brief Does nothing. */
+        constexpr void await_resume() const noexcept {}
+
+    private:
+        friend class actor;
+        friend class mpsc_queue<mailbox_op>;
+
+        actor& m_actor;                    ///< The actor.
+        std::coroutine_handle<> m_handle;  ///< The coroutine of the message.
+    };
+
+    /**
+     * @brief Awaitable that gives the actor back once a message has its result, and then delivers the reply.
+     *
+     * The count of messages drops before the coroutine of the message is resumed, so that whatever runs when the reply
+     * is delivered may destroy an idle actor. If messages are queued, the coroutine is queued on the scheduler of the
+     * calling thread, or resumed once the next message has started (see `pump()`), so that it never holds them up.
+     * The awaiter is the node that queues the coroutine.
+     */
+    class [[nodiscard]] handover : private detail::resume_node {
+    public:
+        /**
+         * @brief Constructs a new operation.
+         *
+         * @param a The actor, taken by the current message.
+         */
+        explicit handover(actor& a) noexcept : m_actor(a) {}
+
+        /** @brief Always suspends. */
+        [[nodiscard]] constexpr bool await_ready() const noexcept { return false; }
+
+        /**
+         * @brief Gives the actor back.
+         *
+         * @param h The coroutine of the message.
+         * @return Whether the coroutine stays suspended; `false` means that the actor has become idle.
+         */
+        bool await_suspend(std::coroutine_handle<> h) noexcept
+        {
+            // The coroutine may be resumed and destroyed before this function returns, and the awaiter with it
+            actor& a       = this->m_actor;
+            this->m_handle = h;
+            a.m_finished   = this;
+            phase expected = phase::running;
+            if (a.m_phase.compare_exchange_strong(expected, phase::released, std::memory_order_acq_rel)) {
+                // pump() is waiting for this message to return and delivers the reply itself
+                return true;
+            }
+
+            if (a.m_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                return false;
+            }
+
+            a.pump(defer(*this));
+            return true;
+        }
+
+        /** @brief Does nothing. */
+        constexpr void await_resume() const noexcept {}
+
+    private:
+        actor& m_actor;  ///< The actor.
+    };
+
+    using cursor = typename mpsc_queue<mailbox_op>::batch::iterator;
+
+    State m_state;                                   ///< The state.
+    mpsc_queue<mailbox_op> m_mailbox;                ///< Messages waiting for their turn.
+    cursor m_cursor;                                 ///< Messages taken from the mailbox but not handled yet.
+    std::atomic<std::size_t> m_count = 0;            ///< The message being handled and those queued; 0 when idle.
+    std::atomic<phase> m_phase       = phase::idle;  ///< Coordinates `pump()` and `handover`.
+    detail::resume_node* m_finished  = nullptr;      ///< The `handover` of the message that `pump()` has seen finish.
+
+    /**
+     * @brief Handles a message; the body of `tell()`.
+     *
+     * @param a The actor.
+     * @param msg The message.
+     */
+    template<typename Msg>
+    static eager_task deliver(actor& a, Msg msg)
+    {
+        static_cast<void>(co_await a.ask(std::move(msg)));
+    }
+
+    /**
+     * @brief Takes the next message; may only be called by the thread that hands the actor over.
+     *
+     * @return The next message; a message is known to be queued.
+     */
+    mailbox_op* next() noexcept
+    {
+        if (this->m_cursor == cursor{}) {
+            this->m_cursor = this->m_mailbox.try_pop_all().begin();
+        }
+
+        mailbox_op* op = &*this->m_cursor;
+        ++this->m_cursor;
+        return op;
+    }
+
+    /**
+     * @brief Queues a reply on the scheduler of the calling thread.
+     *
+     * @param node The `handover` of the message; holds the coroutine awaiting the reply.
+     * @return The coroutine, which the caller must resume after the next message has started; `nullptr` if it has
+     * been queued.
+     */
+    static std::coroutine_handle<> defer(detail::resume_node& node) noexcept
+    {
+        return detail::reschedule(node, node.m_handle) ? nullptr : node.m_handle;
+    }
+
+    /**
+     * @brief Resumes queued messages until the actor is idle or a handler suspends.
+     *
+     * A message that finishes while it is being resumed only leaves its `handover` in `m_finished`, and the loop
+     * delivers the reply and goes on with the next message; this keeps the stack flat when many messages complete
+     * synchronously. If the handler suspends, the loop returns, and the `handover` of that message takes over.
+     *
+     * Without a scheduler to queue replies on, each reply is resumed after the next message has run, so that the
+     * sender never keeps the mailbox from moving on.
+     *
+     * @param reply The reply of the previous message that is still to be resumed, if any.
+     */
+    void pump(std::coroutine_handle<> reply) noexcept
+    {
+        bool more = true;
+        do {
+            mailbox_op* op = this->next();
+            this->m_phase.store(phase::running, std::memory_order_relaxed);
+            op->m_handle.resume();
+
+            phase expected = phase::running;
+            if (this->m_phase.compare_exchange_strong(expected, phase::idle, std::memory_order_acq_rel)) {
+                break;
+            }
+
+            // Give the actor back first: if it is idle now, the replies may destroy it
+            detail::resume_node* finished = this->m_finished;
+            more = this->m_count.fetch_sub(1, std::memory_order_acq_rel) != 1;
+            if (reply) {
+                reply.resume();
+            }
+
+            reply = defer(*finished);
+        } while (more);
+
+        if (reply) {
+            reply.resume();
+        }
+    }
+};
+
+/**
+ * @example actor.cpp
+ * Example of an actor that keeps an account balance.
+ */
+
+}  // namespace wwa::coro
+
+#endif /* A7D3E5F1_2C84_4B9A_9E06_5F1B8C27D4A3 */
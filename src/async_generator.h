@@ -252,9 +252,9 @@ public:
              * @param h The coroutine handle of the awaiting coroutine.
              * @return The consumer coroutine.
              */
-            [[nodiscard]] constexpr auto await_suspend([[maybe_unused]] std::coroutine_handle<> h) const noexcept
+            [[nodiscard]] std::coroutine_handle<> await_suspend([[maybe_unused]] std::coroutine_handle<> h) noexcept
             {
-                return this->m_consumer;
+                return detail::transfer(this->m_node, this->m_consumer);
             }
 
             /**
@@ -267,6 +267,9 @@ public:
         private:
             /** @brief The consumer coroutine. */
             std::coroutine_handle<> m_consumer;
+
+            /** @brief Queues the consumer when the budget runs out. */
+            detail::resume_node m_node;
         };
         // NOLINTEND(readability-convert-member-functions-to-static)
 
@@ -339,10 +342,10 @@ public:
              * @param consumer The coroutine handle of the awaiting coroutine (consumer).
              * @return The producer coroutine.
              */
-            constexpr std::coroutine_handle<> await_suspend(std::coroutine_handle<> consumer) noexcept
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> consumer) noexcept
             {
                 this->m_promise->set_consumer(consumer);
-                return this->m_producer;
+                return detail::transfer(this->m_node, this->m_producer);
             }
 
             /**
@@ -380,6 +383,8 @@ public:
             promise_type* m_promise;
             /** @brief The producer coroutine. */
             std::coroutine_handle<> m_producer;
+            /** @brief Queues the producer when the budget runs out. */
+            detail::resume_node m_node;
         };
 
         /// @endcond
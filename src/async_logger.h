@@ -0,0 +1,544 @@
+#ifndef D2A81C5F_6E94_4B37_A0D8_5C3F7B12E946
+#define D2A81C5F_6E94_4B37_A0D8_5C3F7B12E946
+
+/**
+ * @file async_logger.h
+ * @brief Asynchronous logger.
+ *
+ * This file contains the definition of the `async_logger` class. `log()` formats a record into a per-thread ring
+ * without system calls; a flushing coroutine writes the rings out in batches with `writev()`.
+ *
+ * @note POSIX only: the logger writes with `writev()`.
+ *
+ * Example:
+ * @snippet async_logger.cpp async_logger example
+ */
+
+#if defined(_WIN32)
+#    error "async_logger.h requires POSIX"
+#endif
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <concepts>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "detail.h"
+#include "eager_task.h"
+#include "timer.h"
+
+namespace wwa::coro {
+
+/** @brief What `async_logger::log()` does when the ring of the calling thread is full. */
+enum class overflow_policy {
+    drop,  ///< Discard the record and count it.
+    block  ///< Wait until the flusher has made room.
+};
+
+/** @brief Options of `async_logger`. */
+struct async_logger_options {
+    std::size_t ring_capacity                = 64 * 1024;  ///< Size of a per-thread ring; rounded up to a power of two.
+    std::size_t flush_threshold              = 16 * 1024;  ///< A ring holding this many bytes wakes up the flusher.
+    std::chrono::milliseconds flush_interval = std::chrono::milliseconds(100);  ///< How often the flusher runs anyway.
+    overflow_policy overflow                 = overflow_policy::drop;           ///< What to do when a ring is full.
+};
+
+/**
+ * @brief Types that `async_logger::log()` can format.
+ *
+ * Strings (anything convertible to `std::string_view`), characters, booleans, integers, and floating-point numbers.
+ */
+template<typename T>
+concept loggable = std::is_arithmetic_v<T> || std::convertible_to<const T&, std::string_view>;
+
+/**
+ * @brief An asynchronous logger.
+ *
+ * Each thread that logs gets its own single-producer single-consumer byte ring. `log()` formats its arguments with
+ * `std::to_chars()` straight into the ring of the calling thread and publishes the record with a release store:
+ * no locks, no allocations, and no system calls on the hot path. The thread's ring is found through a thread-local
+ * cache; only the first record of a thread takes a lock.
+ *
+ * A flushing coroutine collects the pending bytes of all rings into one `iovec` array and writes them with `writev()`,
+ * straight from the rings. The flusher runs on a private timer service thread: it sleeps on a timer for the flush
+ * interval, and a thread whose ring crosses the flush threshold (or is full) pulls the timer forward to wake it up
+ * early. Records of one thread are written in order; records of different threads are interleaved by batch.
+ *
+ * Example:
+ * @snippet async_logger.cpp async_logger example
+ */
+class async_logger {
+public:
+    /**
+     * @brief Constructs a new logger and starts the flusher.
+     *
+     * @param fd The descriptor to write to; not owned, must stay open and should be blocking.
+     * @param options The options.
+     * @throw std::invalid_argument if the ring capacity is zero or too large.
+     *
+     * @internal
+     * @test @a AsyncLoggerTest.InvalidOptions
+     */
+    explicit async_logger(int fd, const async_logger_options& options = {})
+        : m_fd(fd), m_options(options), m_id(next_id().fetch_add(1, std::memory_order_relaxed) + 1)
+    {
+        if (options.ring_capacity == 0 || options.ring_capacity > max_capacity) {
+            throw std::invalid_argument("Invalid ring capacity");
+        }
+
+        this->m_options.ring_capacity = std::bit_ceil(options.ring_capacity);
+        this->flusher();
+    }
+
+    /// @cond
+    async_logger(const async_logger&)            = delete;
+    async_logger(async_logger&&)                 = delete;
+    async_logger& operator=(const async_logger&) = delete;
+    async_logger& operator=(async_logger&&)      = delete;
+    /// @endcond
+
+    /**
+     * @brief Destructor.
+     *
+     * Writes out all pending records and stops the flusher.
+     *
+     * @warning No thread may log while the logger is being destroyed.
+     *
+     * @internal
+     * @test @a AsyncLoggerTest.DestructorFlushes
+     */
+    ~async_logger()
+    {
+        this->m_stop.store(true, std::memory_order_release);
+        this->request_flush();
+        this->m_done.wait(false, std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Logs a record.
+     *
+     * The arguments are formatted one after another, followed by a newline, into the ring of the calling thread.
+     * If the ring is full, the record is dropped or the call waits for the flusher, depending on the overflow policy.
+     *
+     * @param args The parts of the record.
+     * @return Whether the record was logged; `false` means that it was dropped.
+     *
+     * @internal
+     * @test @a AsyncLoggerTest.Format
+     * @test @a AsyncLoggerTest.DropPolicy
+     * @test @a AsyncLoggerTest.BlockPolicy
+     * @test @a AsyncLoggerTest.ManyThreads
+     */
+    template<loggable... Args>
+    bool log(const Args&... args)
+    {
+        ring& r                 = this->local_ring();
+        const std::size_t bound = (format_bound(args) + ... + 1);
+        const std::size_t cap   = this->m_options.ring_capacity;
+
+        std::uint64_t pos  = r.m_head.load(std::memory_order_relaxed);
+        std::uint64_t tail = r.m_tail.load(std::memory_order_acquire);
+        while (cap - (pos - tail) < bound) {
+            if (bound > cap || this->m_options.overflow == overflow_policy::drop) {
+                r.m_dropped.store(r.m_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                this->request_flush();
+                return false;
+            }
+
+            this->request_flush();
+            std::this_thread::yield();
+            tail = r.m_tail.load(std::memory_order_acquire);
+        }
+
+        (r.put(pos, args), ...);
+        r.put(pos, '\n');
+        r.m_head.store(pos, std::memory_order_release);
+
+        if (pos - tail >= this->m_options.flush_threshold) {
+            this->request_flush();
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Asks the flusher to write out pending records now.
+     *
+     * Does not wait for the records to be written.
+     *
+     * @internal
+     * @test @a AsyncLoggerTest.Format
+     */
+    void flush() { this->request_flush(); }
+
+    /**
+     * @brief Returns the number of dropped records.
+     *
+     * @return The number of records dropped because a ring was full or the record did not fit into a ring.
+     *
+     * @internal
+     * @test @a AsyncLoggerTest.DropPolicy
+     */
+    [[nodiscard]] std::uint64_t dropped() const noexcept
+    {
+        std::uint64_t total = 0;
+        for (const ring* r = this->m_rings.load(std::memory_order_acquire); r != nullptr; r = r->m_next) {
+            total += r->m_dropped.load(std::memory_order_relaxed);
+        }
+
+        return total;
+    }
+
+    /**
+     * @brief Returns the number of failed writes.
+     *
+     * Records of a batch whose write fails are discarded.
+     *
+     * @return The number of failed `writev()` calls.
+     */
+    [[nodiscard]] std::uint64_t write_errors() const noexcept
+    {
+        return this->m_write_errors.load(std::memory_order_relaxed);
+    }
+
+private:
+    /// @cond INTERNAL
+    static constexpr std::size_t max_capacity = std::size_t{1} << 30;  ///< The largest ring.
+    static constexpr std::size_t max_iov      = 1024;                  ///< `IOV_MAX` on Linux.
+    static constexpr std::size_t float_chars  = 64;  ///< Enough for the shortest representation of any float.
+    /// @endcond
+
+    /** @brief The ring of one thread. */
+    struct ring {
+        /**
+         * @brief Constructs a new ring.
+         *
+         * @param capacity The size of the ring; a power of two.
+         */
+        explicit ring(std::size_t capacity)
+            : m_buffer(std::make_unique_for_overwrite<char[]>(capacity)), m_mask(capacity - 1)
+        {}
+
+        alignas(detail::cache_line_size) std::atomic<std::uint64_t> m_head = 0;  ///< Write position; thread-owned.
+        std::atomic<std::uint64_t> m_dropped                              = 0;  ///< Dropped records; thread-owned.
+        alignas(detail::cache_line_size) std::atomic<std::uint64_t> m_tail = 0;  ///< Read position; flusher-owned.
+        std::unique_ptr<char[]> m_buffer;                                        ///< The bytes.
+        std::size_t m_mask;                                                      ///< `capacity - 1`.
+        ring* m_next = nullptr;                                                  ///< Next ring of the logger.
+
+        /**
+         * @brief Copies bytes into the ring, wrapping around the end.
+         *
+         * @param pos The write position; advanced past the bytes.
+         * @param data The bytes.
+         * @param size The number of bytes.
+         */
+        void put(std::uint64_t& pos, const char* data, std::size_t size) noexcept
+        {
+            const std::size_t index = pos & this->m_mask;
+            const std::size_t first = std::min(size, this->m_mask + 1 - index);
+            std::memcpy(this->m_buffer.get() + index, data, first);
+            std::memcpy(this->m_buffer.get(), data + first, size - first);
+            pos += size;
+        }
+
+        /**
+         * @brief Formats a value into the ring.
+         *
+         * @param pos The write position; advanced past the value.
+         * @param value The value.
+         */
+        template<typename T>
+        void put(std::uint64_t& pos, const T& value) noexcept
+        {
+            if constexpr (std::is_same_v<T, bool>) {
+                const std::string_view s = value ? "true" : "false";
+                this->put(pos, s.data(), s.size());
+            }
+            else if constexpr (std::is_same_v<T, char>) {
+                this->put(pos, &value, 1);
+            }
+            else if constexpr (std::is_arithmetic_v<T>) {
+                char buf[float_chars];
+                const auto res = std::to_chars(buf, buf + sizeof(buf), value);
+                this->put(pos, buf, static_cast<std::size_t>(res.ptr - buf));
+            }
+            else {
+                const std::string_view s = value;
+                this->put(pos, s.data(), s.size());
+            }
+        }
+    };
+
+    /** @brief The timer the flusher sleeps on. */
+    struct flush_timer : detail::timer_node {
+        std::coroutine_handle<> m_awaiting;  ///< The flusher.
+
+        /** @brief Constructs a new timer. */
+        flush_timer() noexcept { this->m_fire = &flush_timer::fire; }
+
+        /**
+         * @brief Resumes the flusher.
+         *
+         * @param node The timer.
+         */
+        static void fire(detail::timer_node* node) noexcept { static_cast<flush_timer*>(node)->m_awaiting.resume(); }
+    };
+
+    /** @brief Awaitable that puts the flusher to sleep until the interval passes or somebody wakes it up. */
+    class [[nodiscard]] nap_op {
+    public:
+        /**
+         * @brief Constructs a new operation.
+         *
+         * @param logger The logger.
+         */
+        explicit nap_op(async_logger& logger) noexcept : m_logger(logger) {}
+
+        /**
+         * @brief Always suspends.
+         *
+         * @return `false`
+         */
+        [[nodiscard]] constexpr bool await_ready() const noexcept { return false; }
+
+        /**
+         * @brief Arms the timer.
+         *
+         * A wake-up requested before the timer was armed found nothing to pull forward; it is honored here.
+         *
+         * @param h The flusher.
+         */
+        void await_suspend(std::coroutine_handle<> h)
+        {
+            async_logger& logger      = this->m_logger;
+            logger.m_timer.m_awaiting = h;
+            logger.m_service.schedule(&logger.m_timer, timer_service::clock::now() + logger.m_options.flush_interval);
+            if (logger.m_wake.load(std::memory_order_seq_cst)) {
+                logger.m_service.expedite(&logger.m_timer, timer_service::clock::now());
+            }
+        }
+
+        /** @brief Does nothing. */
+        constexpr void await_resume() const noexcept {}
+
+    private:
+        async_logger& m_logger;  ///< The logger.
+    };
+
+    /** @brief Bytes of a ring included in the current batch. */
+    struct pending {
+        ring* m_ring;          ///< The ring.
+        std::uint64_t m_head;  ///< The write position at the time the batch was taken.
+    };
+
+    /** @brief The thread-local ring lookup cache. */
+    struct thread_cache {
+        std::uint64_t m_logger = 0;        ///< The logger the ring belongs to.
+        ring* m_ring           = nullptr;  ///< The ring of the calling thread.
+    };
+
+    int m_fd;                                                            ///< The output descriptor.
+    async_logger_options m_options;                                      ///< The options.
+    std::uint64_t m_id;                                                  ///< Identifies the logger in caches.
+    std::mutex m_mutex;                                                  ///< Guards `m_owned`.
+    std::unordered_map<std::thread::id, std::unique_ptr<ring>> m_owned;  ///< The rings, by thread.
+    std::atomic<ring*> m_rings                = nullptr;                 ///< The rings, as a list for the flusher.
+    std::atomic<bool> m_wake                  = false;                   ///< Whether a wake-up has been requested.
+    std::atomic<bool> m_stop                  = false;                   ///< Whether the logger is being destroyed.
+    std::atomic<bool> m_done                  = false;                   ///< Whether the flusher has finished.
+    std::atomic<std::uint64_t> m_write_errors = 0;                       ///< Failed writes.
+    std::vector<iovec> m_iov;                                            ///< The batch being written; flusher only.
+    std::vector<pending> m_batch;                                        ///< The rings in the batch; flusher only.
+    flush_timer m_timer;                                                 ///< The timer the flusher sleeps on.
+    timer_service m_service;                                             ///< Runs the flusher; destroyed first.
+
+    /**
+     * @brief Returns the source of logger identifiers.
+     *
+     * @return The last assigned identifier.
+     */
+    static std::atomic<std::uint64_t>& next_id() noexcept
+    {
+        static std::atomic<std::uint64_t> id = 0;
+        return id;
+    }
+
+    /**
+     * @brief Returns the upper bound of the formatted size of a value.
+     *
+     * @param value The value.
+     * @return The maximum number of characters.
+     */
+    template<typename T>
+    static constexpr std::size_t format_bound(const T& value) noexcept
+    {
+        if constexpr (std::is_same_v<T, bool>) {
+            return 5;
+        }
+        else if constexpr (std::is_same_v<T, char>) {
+            return 1;
+        }
+        else if constexpr (std::is_integral_v<T>) {
+            return std::numeric_limits<T>::digits10 + 2;
+        }
+        else if constexpr (std::is_floating_point_v<T>) {
+            return float_chars;
+        }
+        else {
+            return std::string_view(value).size();
+        }
+    }
+
+    /**
+     * @brief Returns the ring of the calling thread, creating it on first use.
+     *
+     * @return The ring.
+     */
+    ring& local_ring()
+    {
+        static thread_local thread_cache cache;
+        if (cache.m_logger == this->m_id) [[likely]] {
+            return *cache.m_ring;
+        }
+
+        const std::scoped_lock lock(this->m_mutex);
+        auto& owned = this->m_owned[std::this_thread::get_id()];
+        if (!owned) {
+            owned         = std::make_unique<ring>(this->m_options.ring_capacity);
+            owned->m_next = this->m_rings.load(std::memory_order_relaxed);
+            this->m_rings.store(owned.get(), std::memory_order_release);
+        }
+
+        cache = {this->m_id, owned.get()};
+        return *owned;
+    }
+
+    /**
+     * @brief Wakes up the flusher unless a wake-up is already pending.
+     *
+     * The timer is pulled forward only if it is armed; otherwise the flusher is awake and sees the request
+     * in `nap_op::await_suspend()`.
+     */
+    void request_flush()
+    {
+        if (!this->m_wake.load(std::memory_order_relaxed) && !this->m_wake.exchange(true, std::memory_order_seq_cst)) {
+            this->m_service.expedite(&this->m_timer, timer_service::clock::now());
+        }
+    }
+
+    /**
+     * @brief The flushing coroutine.
+     *
+     * @return The coroutine.
+     */
+    eager_task flusher()
+    {
+        for (;;) {
+            this->m_wake.store(false, std::memory_order_seq_cst);
+            this->write_pending();
+            if (this->m_stop.load(std::memory_order_acquire)) {
+                this->write_pending();
+                break;
+            }
+
+            co_await nap_op{*this};
+        }
+
+        this->m_done.store(true, std::memory_order_release);
+        this->m_done.notify_all();
+    }
+
+    /**
+     * @brief Writes out the pending bytes of all rings in one batch.
+     */
+    void write_pending()
+    {
+        this->m_iov.clear();
+        this->m_batch.clear();
+
+        for (ring* r = this->m_rings.load(std::memory_order_acquire); r != nullptr; r = r->m_next) {
+            const std::uint64_t head = r->m_head.load(std::memory_order_acquire);
+            const std::uint64_t tail = r->m_tail.load(std::memory_order_relaxed);
+            if (head == tail) {
+                continue;
+            }
+
+            const std::size_t index = tail & r->m_mask;
+            const std::size_t size  = head - tail;
+            const std::size_t first = std::min(size, r->m_mask + 1 - index);
+            this->m_iov.push_back({r->m_buffer.get() + index, first});
+            if (size > first) {
+                this->m_iov.push_back({r->m_buffer.get(), size - first});
+            }
+
+            this->m_batch.push_back({r, head});
+        }
+
+        this->write_all();
+        for (const auto& [r, head] : this->m_batch) {
+            r->m_tail.store(head, std::memory_order_release);
+        }
+    }
+
+    /**
+     * @brief Writes the batch, resuming after partial writes.
+     */
+    void write_all()
+    {
+        iovec* iov        = this->m_iov.data();
+        std::size_t count = this->m_iov.size();
+        while (count > 0) {
+            const ssize_t n = ::writev(this->m_fd, iov, static_cast<int>(std::min(count, max_iov)));
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+
+                this->m_write_errors.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            auto written = static_cast<std::size_t>(n);
+            while (count > 0 && written >= iov->iov_len) {
+                written -= iov->iov_len;
+                ++iov;
+                --count;
+            }
+
+            if (written > 0) {
+                iov->iov_base = static_cast<char*>(iov->iov_base) + written;
+                iov->iov_len -= written;
+            }
+        }
+    }
+};
+
+/**
+ * @example async_logger.cpp
+ * Example of logging from several threads without blocking on I/O.
+ */
+
+}  // namespace wwa::coro
+
+#endif /* D2A81C5F_6E94_4B37_A0D8_5C3F7B12E946 */
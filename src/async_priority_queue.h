@@ -0,0 +1,477 @@
+#ifndef E82C4B17_3A9D_4F60_B5E1_7D0C9A6F2B34
+#define E82C4B17_3A9D_4F60_B5E1_7D0C9A6F2B34
+
+/**
+ * @file async_priority_queue.h
+ * @brief Awaitable concurrent priority queue.
+ *
+ * This file contains the definition of the `async_priority_queue` class template, an unbounded priority queue
+ * with an awaitable `pop()` that scales with the number of cores at the cost of strict global ordering.
+ *
+ * Example:
+ * @snippet async_priority_queue.cpp async_priority_queue example
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "detail.h"
+
+namespace wwa::coro {
+
+/**
+ * @brief An unbounded concurrent priority queue with an awaitable `pop()`.
+ *
+ * The queue is a *MultiQueue*: a set of independently locked binary heaps (shards). `push()` inserts into a random shard;
+ * `pop()` picks two random shards and removes the top element of the one with the higher priority. Threads rarely contend
+ * for the same shard, and with high probability the removed element is among the top few elements of the whole queue.
+ * The ordering is therefore *relaxed*: an element may be popped before an element with a slightly higher priority.
+ * With a single shard, the queue is strictly ordered.
+ *
+ * `co_await q.pop()` suspends while the queue is empty. Suspended consumers are kept in an intrusive waiter list
+ * and are resumed inline by `push()` with the pushed element.
+ *
+ * Like `std::priority_queue`, the element with the *highest* priority according to @a Compare is popped first
+ * (the greatest element for `std::less`).
+ *
+ * Example:
+ * @snippet async_priority_queue.cpp async_priority_queue example
+ *
+ * @tparam T The type of the elements.
+ * @tparam Compare The comparison function object type; `Compare(a, b)` returns `true` if @a a has a lower priority than @a b.
+ */
+template<typename T, typename Compare = std::less<T>>
+class async_priority_queue {
+public:
+    /** @brief The type of the elements. */
+    using value_type = T;
+
+    /** @brief The comparison function object type. */
+    using value_compare = Compare;
+
+    class pop_op;
+
+    /**
+     * @brief Constructs a new queue.
+     *
+     * @param shards The number of shards; the default is twice the number of hardware threads.
+     * @param compare The comparison function object.
+     * @throw std::invalid_argument @a shards is zero.
+     *
+     * @internal
+     * @test @a AsyncPriorityQueueTest.ZeroShards
+     */
+    explicit async_priority_queue(std::size_t shards = default_shards(), const Compare& compare = Compare())
+        : m_shard_count(check_shards(shards)), m_shards(std::make_unique<shard[]>(shards)), m_compare(compare)
+    {}
+
+    /// @cond
+    async_priority_queue(const async_priority_queue&)            = delete;
+    async_priority_queue(async_priority_queue&&)                 = delete;
+    async_priority_queue& operator=(const async_priority_queue&) = delete;
+    async_priority_queue& operator=(async_priority_queue&&)      = delete;
+    /// @endcond
+
+    /**
+     * @brief Destructor.
+     *
+     * @warning No coroutines may be suspended on the queue when it is destroyed; call `close()` first.
+     */
+    ~async_priority_queue() = default;
+
+    /**
+     * @brief Returns the number of shards.
+     *
+     * @return The number of shards.
+     */
+    [[nodiscard]] constexpr std::size_t shards() const noexcept { return this->m_shard_count; }
+
+    /**
+     * @brief Returns the number of elements in the queue.
+     *
+     * @return The number of elements; the value may be stale by the time it is returned.
+     */
+    [[nodiscard]] std::size_t size() const noexcept
+    {
+        std::size_t result = 0;
+        for (std::size_t i = 0; i < this->m_shard_count; ++i) {
+            result += this->m_shards[i].size.load(std::memory_order_relaxed);
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief Inserts an element.
+     *
+     * If a consumer is suspended in `pop()`, it is resumed inline by this call.
+     *
+     * @param value The element.
+     * @return Whether the element was inserted; `false` means that the queue has been closed.
+     *
+     * @internal
+     * @test @a AsyncPriorityQueueTest.StrictOrderWithOneShard
+     * @test @a AsyncPriorityQueueTest.PopSuspendsWhenEmpty
+     */
+    bool push(T value)
+    {
+        if (this->is_closed()) {
+            return false;
+        }
+
+        shard& s = this->m_shards[detail::fast_random() % this->m_shard_count];
+        {
+            const std::scoped_lock lock(s.lock);
+            s.heap.push_back(std::move(value));
+            std::ranges::push_heap(s.heap, this->m_compare);
+            s.size.store(s.heap.size(), std::memory_order_relaxed);
+        }
+
+        this->wake_consumer();
+        return true;
+    }
+
+    /**
+     * @brief Removes an element without suspending.
+     *
+     * @return The removed element; an empty optional if the queue is empty.
+     *
+     * @internal
+     * @test @a AsyncPriorityQueueTest.StrictOrderWithOneShard
+     */
+    [[nodiscard]] std::optional<T> try_pop()
+    {
+        std::optional<T> result;
+        this->try_pop(result);
+        return result;
+    }
+
+    /**
+     * @brief Removes an element.
+     *
+     * The returned awaitable completes immediately if the queue is not empty; otherwise, the awaiting coroutine
+     * suspends until an element is pushed or the queue is closed.
+     *
+     * @return An awaitable that yields `std::optional<T>`; an empty optional means that the queue is closed and drained.
+     *
+     * @internal
+     * @test @a AsyncPriorityQueueTest.PopSuspendsWhenEmpty
+     * @test @a AsyncPriorityQueueTest.CrossThread
+     */
+    [[nodiscard]] pop_op pop() noexcept { return pop_op{*this}; }
+
+    /**
+     * @brief Closes the queue.
+     *
+     * Subsequent pushes fail. Suspended consumers are resumed with an empty optional. Elements that are already in
+     * the queue can still be popped.
+     *
+     * @internal
+     * @test @a AsyncPriorityQueueTest.Close
+     */
+    void close()
+    {
+        if (this->m_closed.exchange(true, std::memory_order_acq_rel)) {
+            return;
+        }
+
+        pop_op* waiters = nullptr;
+        {
+            const std::scoped_lock lock(this->m_waiters_lock);
+            waiters = this->m_waiters.take_all();
+            this->m_waiting.store(0, std::memory_order_relaxed);
+        }
+
+        while (waiters != nullptr) {
+            std::coroutine_handle<> h = waiters->m_awaiting;
+            waiters                   = waiters->m_next;
+            h.resume();
+        }
+    }
+
+    /**
+     * @brief Checks whether the queue has been closed.
+     *
+     * @return Whether the queue has been closed.
+     */
+    [[nodiscard]] bool is_closed() const noexcept { return this->m_closed.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Awaitable for the pop operation.
+     *
+     * @see async_priority_queue::pop()
+     */
+    class [[nodiscard]] pop_op : public detail::intrusive_hook<pop_op> {
+    public:
+        /// @cond INTERNAL
+        /**
+         * @brief Constructs a new pop operation.
+         *
+         * @param q The queue.
+         */
+        explicit pop_op(async_priority_queue& q) noexcept : m_queue(q) {}
+        /// @endcond
+
+        /**
+         * @brief Tries to remove an element without suspending.
+         *
+         * @return Whether the operation has completed.
+         */
+        bool await_ready() { return this->m_queue.try_pop(this->m_value) || this->m_queue.is_closed(); }
+
+        /**
+         * @brief Suspends the consumer until an element is pushed.
+         *
+         * @param h The awaiting coroutine.
+         * @return Whether the coroutine should stay suspended.
+         */
+        bool await_suspend(std::coroutine_handle<> h)
+        {
+            this->m_awaiting = h;
+            return this->m_queue.suspend(this);
+        }
+
+        /**
+         * @brief Returns the removed element.
+         *
+         * @return The removed element; an empty optional if the queue is closed and drained.
+         */
+        std::optional<T> await_resume()
+        {
+            if (!this->m_value.has_value()) {
+                // The queue was closed while an element was in flight
+                this->m_queue.try_pop(this->m_value);
+            }
+
+            return std::move(this->m_value);
+        }
+
+    private:
+        friend class async_priority_queue;
+
+        async_priority_queue& m_queue;       ///< The queue.
+        std::optional<T> m_value;            ///< The removed element.
+        std::coroutine_handle<> m_awaiting;  ///< The suspended consumer.
+    };
+
+private:
+    /** @brief A binary heap with its own lock. */
+    struct alignas(detail::cache_line_size) shard {
+        detail::spinlock lock;              ///< Guards the heap.
+        std::vector<T> heap;                ///< The elements.
+        std::atomic<std::size_t> size = 0;  ///< Number of elements; readable without the lock.
+    };
+
+    const std::size_t m_shard_count;          ///< Number of shards.
+    std::unique_ptr<shard[]> m_shards;        ///< The shards.
+    [[no_unique_address]] Compare m_compare;  ///< The comparison function object.
+    std::atomic<bool> m_closed = false;       ///< Whether the queue has been closed.
+
+    alignas(detail::cache_line_size) detail::spinlock m_waiters_lock;  ///< Guards the waiter list.
+    detail::intrusive_queue<pop_op> m_waiters;                         ///< Suspended consumers.
+    std::atomic<std::size_t> m_waiting = 0;                            ///< Number of suspended consumers.
+
+    /**
+     * @brief Returns the default number of shards.
+     *
+     * @return Twice the number of hardware threads (at least 2).
+     */
+    static std::size_t default_shards() noexcept
+    {
+        return 2 * std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    }
+
+    /**
+     * @brief Validates the number of shards.
+     *
+     * @param shards The requested number of shards.
+     * @return @a shards
+     * @throw std::invalid_argument @a shards is zero.
+     */
+    static std::size_t check_shards(std::size_t shards)
+    {
+        if (shards == 0) {
+            throw std::invalid_argument("async_priority_queue must have at least one shard");
+        }
+
+        return shards;
+    }
+
+    /**
+     * @brief Removes the top element of a shard; the lock of the shard must be held.
+     *
+     * @param s The shard; must not be empty.
+     * @param out Receives the element.
+     */
+    void pop_locked(shard& s, std::optional<T>& out)
+    {
+        std::ranges::pop_heap(s.heap, this->m_compare);
+        out.emplace(std::move(s.heap.back()));
+        s.heap.pop_back();
+        s.size.store(s.heap.size(), std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Removes the top element of a shard.
+     *
+     * @param s The shard.
+     * @param out Receives the element.
+     * @return Whether an element was removed.
+     */
+    bool pop_from(shard& s, std::optional<T>& out)
+    {
+        const std::scoped_lock lock(s.lock);
+        if (s.heap.empty()) {
+            return false;
+        }
+
+        this->pop_locked(s, out);
+        return true;
+    }
+
+    /**
+     * @brief Removes the better of the top elements of two shards.
+     *
+     * The shards are locked in address order to avoid deadlocks.
+     *
+     * @param a The first shard.
+     * @param b The second shard; must differ from @a a.
+     * @param out Receives the element.
+     * @return Whether an element was removed.
+     */
+    bool pop_better(shard& a, shard& b, std::optional<T>& out)
+    {
+        shard& first  = &a < &b ? a : b;
+        shard& second = &a < &b ? b : a;
+
+        const std::scoped_lock lock(first.lock, second.lock);
+        shard* victim = nullptr;
+        if (first.heap.empty()) {
+            victim = second.heap.empty() ? nullptr : &second;
+        }
+        else if (second.heap.empty()) {
+            victim = &first;
+        }
+        else {
+            victim = this->m_compare(first.heap.front(), second.heap.front()) ? &second : &first;
+        }
+
+        if (victim == nullptr) {
+            return false;
+        }
+
+        this->pop_locked(*victim, out);
+        return true;
+    }
+
+    /**
+     * @brief Removes an element without suspending.
+     *
+     * Uses the *power of two choices*: two random shards are sampled, and the better top element is removed.
+     * If both sampled shards are empty, all shards are scanned, so that `false` reliably means that the queue was empty.
+     *
+     * @param out Receives the element.
+     * @return Whether an element was removed.
+     */
+    bool try_pop(std::optional<T>& out)
+    {
+        const std::size_t n = this->m_shard_count;
+        const std::size_t i = detail::fast_random() % n;
+        if (n > 1) {
+            const std::size_t j = (i + 1 + detail::fast_random() % (n - 1)) % n;
+            shard& a            = this->m_shards[i];
+            shard& b            = this->m_shards[j];
+
+            const bool a_empty = a.size.load(std::memory_order_relaxed) == 0;
+            const bool b_empty = b.size.load(std::memory_order_relaxed) == 0;
+            if (!a_empty && !b_empty) {
+                if (this->pop_better(a, b, out)) {
+                    return true;
+                }
+            }
+            else if (!a_empty || !b_empty) {
+                if (this->pop_from(a_empty ? b : a, out)) {
+                    return true;
+                }
+            }
+        }
+
+        for (std::size_t k = 0; k < n; ++k) {
+            shard& s = this->m_shards[(i + k) % n];
+            if (s.size.load(std::memory_order_relaxed) != 0 && this->pop_from(s, out)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief Registers a consumer that found the queue empty.
+     *
+     * The waiter counter is published before the shards are re-checked; producers publish their elements before
+     * they check the counter. The two fences guarantee that at least one side observes the other.
+     *
+     * @param op The pop operation.
+     * @return Whether the consumer should stay suspended.
+     */
+    bool suspend(pop_op* op)
+    {
+        const std::scoped_lock lock(this->m_waiters_lock);
+        this->m_waiting.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (this->try_pop(op->m_value) || this->is_closed()) {
+            this->m_waiting.fetch_sub(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        this->m_waiters.push_back(op);
+        return true;
+    }
+
+    /**
+     * @brief Hands an element to a suspended consumer, if any, and resumes it.
+     */
+    void wake_consumer()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (this->m_waiting.load(std::memory_order_relaxed) == 0) [[likely]] {
+            return;
+        }
+
+        pop_op* op = nullptr;
+        {
+            const std::scoped_lock lock(this->m_waiters_lock);
+            op = this->m_waiters.front();
+            if (op == nullptr || !this->try_pop(op->m_value)) {
+                return;
+            }
+
+            this->m_waiters.pop_front();
+            this->m_waiting.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        op->m_awaiting.resume();
+    }
+};
+
+/**
+ * @example async_priority_queue.cpp
+ * Example of dispatching jobs by priority with an awaitable priority queue.
+ */
+
+}  // namespace wwa::coro
+
+#endif /* E82C4B17_3A9D_4F60_B5E1_7D0C9A6F2B34 */
@@ -0,0 +1,696 @@
+#ifndef C9BA168D_8FF6_4547_B6D2_E6AF50D7DDD0
+#define C9BA168D_8FF6_4547_B6D2_E6AF50D7DDD0
+
+/**
+ * @file channel.h
+ * @brief Bounded multi-producer multi-consumer channel.
+ *
+ * This file contains the definition of the `channel` class template, which allows independent coroutines to pass values
+ * to each other. The channel is backed by a lock-free bounded ring buffer; coroutines suspend only when the channel
+ * is full (senders) or empty (receivers).
+ *
+ * Example:
+ * @snippet channel.cpp channel example
+ */
+
+#include <atomic>
+#include <bit>
+#include <coroutine>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "detail.h"
+
+namespace wwa::coro {
+
+/// @cond INTERNAL
+
+namespace detail {
+
+/**
+ * @brief Bounded lock-free multi-producer multi-consumer ring buffer.
+ *
+ * This is Dmitry Vyukov's bounded MPMC queue: every cell carries a sequence number which tells producers and consumers
+ * whether the cell is ready to be written to or read from. Producers and consumers claim positions with a single CAS
+ * and never block each other.
+ *
+ * @tparam T The type of the elements.
+ */
+template<typename T>
+class mpmc_ring {
+public:
+    /**
+     * @brief Constructs a new ring.
+     *
+     * @param capacity The requested capacity; rounded up to the next power of two (at least 2).
+     */
+    explicit mpmc_ring(std::size_t capacity)
+        : m_mask(std::bit_ceil(capacity < 2 ? std::size_t{2} : capacity) - 1),
+          m_cells(std::make_unique<cell[]>(this->m_mask + 1))
+    {
+        for (std::size_t i = 0; i <= this->m_mask; ++i) {
+            this->m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Returns the capacity of the ring.
+     *
+     * @return The capacity of the ring.
+     */
+    [[nodiscard]] constexpr std::size_t capacity() const noexcept { return this->m_mask + 1; }
+
+    /**
+     * @brief Tries to append an element to the ring.
+     *
+     * @param value The value to append; it is moved from only if the operation succeeds.
+     * @return Whether the element was appended; `false` means that the ring is full.
+     */
+    bool try_push(T& value) noexcept(std::is_nothrow_move_constructible_v<T>)
+    {
+        std::size_t pos = this->m_enqueue_pos.load(std::memory_order_relaxed);
+        cell* c         = nullptr;
+        while (true) {
+            c                   = &this->m_cells[pos & this->m_mask];
+            const std::size_t s = c->sequence.load(std::memory_order_acquire);
+            const auto diff     = static_cast<std::ptrdiff_t>(s) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (this->m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                pos = this->m_enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        c->value.emplace(std::move(value));
+        c->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Tries to remove the oldest element from the ring.
+     *
+     * @param out Receives the element.
+     * @return Whether an element was removed; `false` means that the ring is empty.
+     */
+    bool try_pop(std::optional<T>& out) noexcept(std::is_nothrow_move_constructible_v<T>)
+    {
+        std::size_t pos = this->m_dequeue_pos.load(std::memory_order_relaxed);
+        cell* c         = nullptr;
+        while (true) {
+            c                   = &this->m_cells[pos & this->m_mask];
+            const std::size_t s = c->sequence.load(std::memory_order_acquire);
+            const auto diff     = static_cast<std::ptrdiff_t>(s) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0) {
+                if (this->m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                pos = this->m_dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        out.emplace(std::move(*c->value));
+        c->value.reset();
+        c->sequence.store(pos + this->m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    /** @brief A ring cell. */
+    struct cell {
+        std::atomic<std::size_t> sequence;  ///< Sequence number of the cell.
+        std::optional<T> value;             ///< The stored value.
+    };
+
+    const std::size_t m_mask;                                            ///< Capacity minus one.
+    std::unique_ptr<cell[]> m_cells;                                     ///< Ring storage.
+    alignas(cache_line_size) std::atomic<std::size_t> m_enqueue_pos = 0;  ///< Next position to write to.
+    alignas(cache_line_size) std::atomic<std::size_t> m_dequeue_pos = 0;  ///< Next position to read from.
+};
+
+/**
+ * @brief A receiver waiting on a channel.
+ *
+ * @tparam T The type of the values passed through the channel.
+ */
+template<typename T>
+struct channel_receiver : intrusive_hook<channel_receiver<T>>, waiter {
+    std::optional<T> m_value;  ///< The received value.
+};
+
+/**
+ * @brief A sender waiting on a channel.
+ *
+ * @tparam T The type of the values passed through the channel.
+ */
+template<typename T>
+struct channel_sender : intrusive_hook<channel_sender<T>>, waiter {
+    /**
+     * @brief Constructs a new sender.
+     *
+     * @param value The value to send.
+     */
+    explicit channel_sender(T&& value) noexcept(std::is_nothrow_move_constructible_v<T>) : m_value(std::move(value)) {}
+
+    T m_value;            ///< The value to send.
+    bool m_sent = false;  ///< Whether the value has been sent.
+};
+
+}  // namespace detail
+
+/// @endcond
+
+/**
+ * @brief A bounded multi-producer multi-consumer channel.
+ *
+ * The channel passes values of type `T` between independent coroutines. Both sending and receiving are awaitable:
+ * `co_await ch.send(v)` suspends while the channel is full, and `co_await ch.recv()` suspends while the channel is empty.
+ * When there is room (or data), the operation completes without suspending the coroutine.
+ *
+ * Suspended coroutines are kept in intrusive waiter lists whose nodes live inside the awaiters, so waiting does not allocate.
+ * A suspended coroutine is resumed inline by the coroutine that makes its operation possible (or by `close()`).
+ *
+ * Example:
+ * @snippet channel.cpp channel example
+ *
+ * @tparam T The type of the values passed through the channel.
+ */
+template<typename T>
+class channel {
+public:
+    /** @brief The type of the values passed through the channel. */
+    using value_type = T;
+
+    class send_op;
+    class recv_op;
+
+    /// @cond INTERNAL
+    using receiver = detail::channel_receiver<T>;  ///< A suspended receiver.
+    using sender   = detail::channel_sender<T>;    ///< A suspended sender.
+    /// @endcond
+
+    /**
+     * @brief Constructs a new channel.
+     *
+     * @param capacity The maximum number of buffered values; rounded up to the next power of two (at least 2).
+     * @throw std::invalid_argument @a capacity is zero.
+     *
+     * @internal
+     * @test @a ChannelTest.ZeroCapacity
+     * @test @a ChannelTest.Capacity
+     */
+    explicit channel(std::size_t capacity) : m_ring(check_capacity(capacity)) {}
+
+    /// @cond
+    channel(const channel&)            = delete;
+    channel(channel&&)                 = delete;
+    channel& operator=(const channel&) = delete;
+    channel& operator=(channel&&)      = delete;
+    /// @endcond
+
+    /**
+     * @brief Destructor.
+     *
+     * @warning No coroutines may be suspended on the channel when it is destroyed; call `close()` first.
+     */
+    ~channel() = default;
+
+    /**
+     * @brief Returns the capacity of the channel.
+     *
+     * @return The maximum number of values the channel can buffer.
+     */
+    [[nodiscard]] constexpr std::size_t capacity() const noexcept { return this->m_ring.capacity(); }
+
+    /**
+     * @brief Sends a value to the channel.
+     *
+     * The returned awaitable completes immediately if there is room in the channel; otherwise, the awaiting coroutine
+     * suspends until a receiver frees a slot or the channel is closed.
+     *
+     * @param value The value to send.
+     * @return An awaitable that yields `true` if the value was sent, or `false` if the channel has been closed.
+     *
+     * @internal
+     * @test @a ChannelTest.SendRecv
+     * @test @a ChannelTest.SenderSuspendsWhenFull
+     */
+    [[nodiscard]] send_op send(T value) noexcept(std::is_nothrow_move_constructible_v<T>)
+    {
+        return send_op{*this, std::move(value)};
+    }
+
+    /**
+     * @brief Receives a value from the channel.
+     *
+     * The returned awaitable completes immediately if the channel has data; otherwise, the awaiting coroutine
+     * suspends until a sender provides a value or the channel is closed.
+     *
+     * Values that were sent before the channel was closed can still be received.
+     *
+     * @return An awaitable that yields `std::optional<T>`; an empty optional means that the channel is closed and drained.
+     *
+     * @internal
+     * @test @a ChannelTest.SendRecv
+     * @test @a ChannelTest.ReceiverSuspendsWhenEmpty
+     */
+    [[nodiscard]] recv_op recv() noexcept { return recv_op{*this}; }
+
+    /**
+     * @brief Closes the channel.
+     *
+     * Subsequent sends fail. All suspended senders are resumed with `false`; all suspended receivers are resumed
+     * and receive the remaining values, if any, or an empty optional. Closing a closed channel does nothing.
+     *
+     * @internal
+     * @test @a ChannelTest.CloseWakesReceivers
+     * @test @a ChannelTest.CloseWakesSenders
+     * @test @a ChannelTest.DrainAfterClose
+     */
+    void close()
+    {
+        if (this->m_closed.exchange(true, std::memory_order_acq_rel)) {
+            return;
+        }
+
+        // One waiter at a time: a select may wait on this channel in several clauses. Completing it via one clause
+        // makes the claims of the others fail, whereas claiming them all up front would spin on our own claim.
+        while (sender* op = this->take_claimed(this->m_senders, this->m_waiting_senders)) {
+            op->complete();
+        }
+
+        while (receiver* op = this->take_claimed(this->m_receivers, this->m_waiting_receivers)) {
+            op->complete();
+        }
+    }
+
+    /**
+     * @brief Checks whether the channel has been closed.
+     *
+     * @return Whether the channel has been closed.
+     */
+    [[nodiscard]] bool is_closed() const noexcept { return this->m_closed.load(std::memory_order_acquire); }
+
+    /// @cond INTERNAL
+    /**
+     * @brief Returns the lock that guards the waiter lists.
+     *
+     * Used by `select()` to register waiters on several channels atomically.
+     *
+     * @return The lock.
+     */
+    [[nodiscard]] detail::spinlock& waiters_lock() noexcept { return this->m_lock; }
+
+    /**
+     * @brief Registers a receiver that could not receive a value without suspending; the lock must be held.
+     *
+     * The waiter counter is published before the ring is re-checked; senders publish their progress before they
+     * check the counter. The two fences guarantee that at least one side observes the other, so no wake-up is lost.
+     *
+     * @param op The receiver.
+     * @return Whether the receiver has been queued; `false` means that it has received a value or the channel
+     * is closed and drained.
+     */
+    bool enqueue_receiver(receiver* op)
+    {
+        this->m_waiting_receivers.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (this->m_ring.try_pop(op->m_value) || this->is_closed()) {
+            this->m_waiting_receivers.fetch_sub(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        this->m_receivers.push_back(op);
+        return true;
+    }
+
+    /**
+     * @brief Removes a queued receiver; the lock must be held.
+     *
+     * @param op The receiver.
+     */
+    void dequeue_receiver(receiver* op) noexcept
+    {
+        if (this->m_receivers.remove(op)) {
+            this->m_waiting_receivers.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Registers a sender that could not send its value without suspending; the lock must be held.
+     *
+     * @param op The sender.
+     * @return Whether the sender has been queued; `false` means that it has sent the value or the channel is closed.
+     * @see enqueue_receiver()
+     */
+    bool enqueue_sender(sender* op)
+    {
+        this->m_waiting_senders.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (this->is_closed()) {
+            this->m_waiting_senders.fetch_sub(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        if (this->m_ring.try_push(op->m_value)) {
+            this->m_waiting_senders.fetch_sub(1, std::memory_order_relaxed);
+            op->m_sent = true;
+            return false;
+        }
+
+        this->m_senders.push_back(op);
+        return true;
+    }
+
+    /**
+     * @brief Removes a queued sender; the lock must be held.
+     *
+     * @param op The sender.
+     */
+    void dequeue_sender(sender* op) noexcept
+    {
+        if (this->m_senders.remove(op)) {
+            this->m_waiting_senders.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Receives a value that was in flight when the channel was closed.
+     *
+     * @param out Receives the value.
+     */
+    void drain_into(std::optional<T>& out)
+    {
+        if (!out.has_value() && this->m_ring.try_pop(out)) {
+            this->wake_sender();
+        }
+    }
+
+    /**
+     * @brief Hands a freshly pushed value to a suspended receiver, if any, and resumes it.
+     */
+    void wake_receiver()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (this->m_waiting_receivers.load(std::memory_order_relaxed) == 0) [[likely]] {
+            return;
+        }
+
+        receiver* op = nullptr;
+        {
+            const std::scoped_lock lock(this->m_lock);
+            while ((op = this->m_receivers.front()) != nullptr) {
+                if (op->claim()) {
+                    if (!this->m_ring.try_pop(op->m_value)) {
+                        op->unclaim();
+                        return;
+                    }
+
+                    this->m_receivers.pop_front();
+                    this->m_waiting_receivers.fetch_sub(1, std::memory_order_relaxed);
+                    break;
+                }
+
+                // The select this receiver belongs to has completed via another clause
+                this->m_receivers.pop_front();
+                this->m_waiting_receivers.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+
+        if (op != nullptr) {
+            this->wake_sender();
+            op->complete();
+        }
+    }
+
+    /**
+     * @brief Moves the value of a suspended sender, if any, into a freshly freed slot and resumes the sender.
+     */
+    void wake_sender()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (this->m_waiting_senders.load(std::memory_order_relaxed) == 0) [[likely]] {
+            return;
+        }
+
+        sender* op = nullptr;
+        {
+            const std::scoped_lock lock(this->m_lock);
+            while ((op = this->m_senders.front()) != nullptr) {
+                if (op->claim()) {
+                    if (!this->m_ring.try_push(op->m_value)) {
+                        op->unclaim();
+                        return;
+                    }
+
+                    this->m_senders.pop_front();
+                    this->m_waiting_senders.fetch_sub(1, std::memory_order_relaxed);
+                    op->m_sent = true;
+                    break;
+                }
+
+                this->m_senders.pop_front();
+                this->m_waiting_senders.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+
+        if (op != nullptr) {
+            this->wake_receiver();
+            op->complete();
+        }
+    }
+    /// @endcond
+
+    /**
+     * @brief Awaitable for the send operation.
+     *
+     * @see channel::send()
+     */
+    class [[nodiscard]] send_op : private detail::channel_sender<T> {
+    public:
+        /// @cond INTERNAL
+        /**
+         * @brief Constructs a new send operation.
+         *
+         * @param ch The channel.
+         * @param value The value to send.
+         */
+        send_op(channel& ch, T&& value) noexcept(std::is_nothrow_move_constructible_v<T>)
+            : detail::channel_sender<T>(std::move(value)), m_channel(ch)
+        {}
+        /// @endcond
+
+        /**
+         * @brief Tries to send the value without suspending.
+         *
+         * @return Whether the operation has completed.
+         */
+        bool await_ready()
+        {
+            if (this->m_channel.is_closed()) {
+                return true;
+            }
+
+            if (this->m_channel.m_ring.try_push(this->m_value)) {
+                this->m_sent = true;
+                this->m_channel.wake_receiver();
+                return true;
+            }
+
+            return false;
+        }
+
+        /**
+         * @brief Suspends the sender until there is room in the channel.
+         *
+         * @param h The awaiting coroutine.
+         * @return Whether the coroutine should stay suspended.
+         */
+        bool await_suspend(std::coroutine_handle<> h)
+        {
+            this->m_awaiting = h;
+            return this->m_channel.suspend(this);
+        }
+
+        /**
+         * @brief Returns the result of the operation.
+         *
+         * @return Whether the value was sent; `false` means that the channel was closed.
+         */
+        [[nodiscard]] constexpr bool await_resume() const noexcept { return this->m_sent; }
+
+    private:
+        channel& m_channel;  ///< The channel.
+    };
+
+    /**
+     * @brief Awaitable for the receive operation.
+     *
+     * @see channel::recv()
+     */
+    class [[nodiscard]] recv_op : private detail::channel_receiver<T> {
+    public:
+        /// @cond INTERNAL
+        /**
+         * @brief Constructs a new receive operation.
+         *
+         * @param ch The channel.
+         */
+        explicit recv_op(channel& ch) noexcept : m_channel(ch) {}
+        /// @endcond
+
+        /**
+         * @brief Tries to receive a value without suspending.
+         *
+         * @return Whether the operation has completed.
+         */
+        bool await_ready()
+        {
+            if (this->m_channel.m_ring.try_pop(this->m_value)) {
+                this->m_channel.wake_sender();
+                return true;
+            }
+
+            return this->m_channel.is_closed();
+        }
+
+        /**
+         * @brief Suspends the receiver until the channel has data.
+         *
+         * @param h The awaiting coroutine.
+         * @return Whether the coroutine should stay suspended.
+         */
+        bool await_suspend(std::coroutine_handle<> h)
+        {
+            this->m_awaiting = h;
+            return this->m_channel.suspend(this);
+        }
+
+        /**
+         * @brief Returns the received value.
+         *
+         * @return The received value; an empty optional if the channel is closed and drained.
+         */
+        std::optional<T> await_resume()
+        {
+            // The channel may have been closed while a value was in flight
+            this->m_channel.drain_into(this->m_value);
+            return std::move(this->m_value);
+        }
+
+    private:
+        channel& m_channel;  ///< The channel.
+    };
+
+private:
+    detail::mpmc_ring<T> m_ring;                       ///< Buffered values.
+    std::atomic<bool> m_closed = false;                ///< Whether the channel has been closed.
+    detail::spinlock m_lock;                           ///< Guards the waiter lists.
+    detail::intrusive_queue<sender> m_senders;         ///< Suspended senders.
+    detail::intrusive_queue<receiver> m_receivers;     ///< Suspended receivers.
+    std::atomic<std::size_t> m_waiting_senders   = 0;  ///< Number of suspended senders.
+    std::atomic<std::size_t> m_waiting_receivers = 0;  ///< Number of suspended receivers.
+
+    /**
+     * @brief Validates the capacity of the channel.
+     *
+     * @param capacity The requested capacity.
+     * @return @a capacity
+     * @throw std::invalid_argument @a capacity is zero.
+     */
+    static std::size_t check_capacity(std::size_t capacity)
+    {
+        if (capacity == 0) {
+            throw std::invalid_argument("channel capacity must be greater than zero");
+        }
+
+        return capacity;
+    }
+
+    /**
+     * @brief Registers a sender that could not push its value.
+     *
+     * @param op The sender.
+     * @return Whether the sender should stay suspended.
+     */
+    bool suspend(sender* op)
+    {
+        {
+            const std::scoped_lock lock(this->m_lock);
+            if (this->enqueue_sender(op)) {
+                return true;
+            }
+        }
+
+        this->wake_receiver();
+        return false;
+    }
+
+    /**
+     * @brief Registers a receiver that found the channel empty.
+     *
+     * @param op The receiver.
+     * @return Whether the receiver should stay suspended.
+     */
+    bool suspend(receiver* op)
+    {
+        {
+            const std::scoped_lock lock(this->m_lock);
+            if (this->enqueue_receiver(op)) {
+                return true;
+            }
+        }
+
+        this->wake_sender();
+        return false;
+    }
+
+    /**
+     * @brief Detaches the oldest waiter from a list that can still be completed, and claims it.
+     *
+     * Waiters whose select has already completed via another clause are dropped.
+     *
+     * @param queue The waiter list.
+     * @param waiting The counter of the waiters in @a queue.
+     * @return The claimed waiter; `nullptr` if there is none.
+     */
+    template<typename Node>
+    Node* take_claimed(detail::intrusive_queue<Node>& queue, std::atomic<std::size_t>& waiting) noexcept
+    {
+        const std::scoped_lock lock(this->m_lock);
+        while (Node* node = queue.pop_front()) {
+            waiting.fetch_sub(1, std::memory_order_relaxed);
+            if (node->claim()) {
+                return node;
+            }
+        }
+
+        return nullptr;
+    }
+};
+
+/**
+ * @example channel.cpp
+ * Example of passing values between coroutines with a channel.
+ */
+
+}  // namespace wwa::coro
+
+#endif /* C9BA168D_8FF6_4547_B6D2_E6AF50D7DDD0 */
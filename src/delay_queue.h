@@ -0,0 +1,411 @@
+#ifndef A4C07E29_5B1D_4E83_9F26_8D3B6E0A7C15
+#define A4C07E29_5B1D_4E83_9F26_8D3B6E0A7C15
+
+/**
+ * @file delay_queue.h
+ * @brief Queue whose elements become available at a deadline.
+ *
+ * This file contains the definition of the `delay_queue` class template. Elements are pushed together with a deadline
+ * and can be popped only once the deadline has passed; `co_await q.pop()` suspends until the earliest element is due.
+ *
+ * Example:
+ * @snippet delay_queue.cpp delay_queue example
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <compare>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "detail.h"
+#include "timer.h"
+
+namespace wwa::coro {
+
+/**
+ * @brief A queue whose elements become available at a deadline.
+ *
+ * Elements are kept in a binary heap ordered by deadline; elements with equal deadlines are popped in insertion order.
+ * Suspended consumers share a single timer, which is armed for the deadline of the earliest element only while
+ * there are suspended consumers. When the timer fires, due elements are handed straight to the consumers in the order
+ * they suspended, and the timer is re-armed for the next deadline. Pushing an element that is due earlier than
+ * the current head moves the timer.
+ *
+ * Consumers are resumed on the thread that makes their element available: the timer thread, or the thread that pushes
+ * an element that is already due.
+ *
+ * Example:
+ * @snippet delay_queue.cpp delay_queue example
+ *
+ * @tparam T The type of the elements.
+ */
+template<typename T>
+class delay_queue {
+public:
+    /** @brief The type of the elements. */
+    using value_type = T;
+
+    /** @brief The clock used for deadlines. */
+    using clock = timer_service::clock;
+
+    class pop_op;
+
+    /**
+     * @brief Constructs a new queue that uses the default timer service.
+     *
+     * @see timer_service::instance()
+     */
+    delay_queue() : delay_queue(timer_service::instance()) {}
+
+    /**
+     * @brief Constructs a new queue.
+     *
+     * @param service The timer service; must outlive the queue.
+     */
+    explicit delay_queue(timer_service& service) noexcept : m_service(service), m_timer(this) {}
+
+    /// @cond
+    delay_queue(const delay_queue&)            = delete;
+    delay_queue(delay_queue&&)                 = delete;
+    delay_queue& operator=(const delay_queue&) = delete;
+    delay_queue& operator=(delay_queue&&)      = delete;
+    /// @endcond
+
+    /**
+     * @brief Destructor.
+     *
+     * Disarms the timer, waiting for its callback if it is running on another thread. A consumer resumed by the timer
+     * may destroy the queue, for example after it has taken the last element.
+     *
+     * @warning No coroutines may be suspended on the queue when it is destroyed; call `close()` first.
+     *
+     * @internal
+     * @test @a DelayQueueTest.DestroyFromConsumer
+     */
+    ~delay_queue() { this->m_service.cancel(&this->m_timer); }
+
+    /**
+     * @brief Returns the number of elements in the queue, due or not.
+     *
+     * @return The number of elements.
+     */
+    [[nodiscard]] std::size_t size() const
+    {
+        const std::scoped_lock lock(this->m_mutex);
+        return this->m_heap.size();
+    }
+
+    /**
+     * @brief Inserts an element that becomes available at the given point in time.
+     *
+     * If the element is already due and a consumer is suspended, the consumer is resumed inline by this call.
+     *
+     * @param value The element.
+     * @param deadline When the element becomes available.
+     * @return Whether the element was inserted; `false` means that the queue has been closed.
+     *
+     * @internal
+     * @test @a DelayQueueTest.DeadlineOrder
+     * @test @a DelayQueueTest.PopWaitsForDeadline
+     * @test @a DelayQueueTest.EarlierPushMovesTimer
+     */
+    bool push(T value, clock::time_point deadline)
+    {
+        pop_op* ready = nullptr;
+        {
+            const std::scoped_lock lock(this->m_mutex);
+            if (this->m_closed) {
+                return false;
+            }
+
+            this->m_heap.push_back(entry{deadline, this->m_sequence++, std::move(value)});
+            std::ranges::push_heap(this->m_heap, std::greater<>{});
+            ready = this->take_due(clock::now());
+            this->arm();
+        }
+
+        resume_all(ready);
+        return true;
+    }
+
+    /**
+     * @brief Inserts an element that becomes available after the given delay.
+     *
+     * @param value The element.
+     * @param delay How long the element stays invisible.
+     * @return Whether the element was inserted; `false` means that the queue has been closed.
+     */
+    template<typename Rep, typename Period>
+    bool push(T value, std::chrono::duration<Rep, Period> delay)
+    {
+        return this->push(std::move(value), clock::now() + std::chrono::ceil<clock::duration>(delay));
+    }
+
+    /**
+     * @brief Removes the earliest element if it is due, without suspending.
+     *
+     * @return The removed element; an empty optional if no element is due.
+     *
+     * @internal
+     * @test @a DelayQueueTest.DeadlineOrder
+     */
+    [[nodiscard]] std::optional<T> try_pop()
+    {
+        std::optional<T> result;
+        const std::scoped_lock lock(this->m_mutex);
+        this->try_pop_locked(result, clock::now());
+        return result;
+    }
+
+    /**
+     * @brief Removes the earliest element once it is due.
+     *
+     * @return An awaitable that yields `std::optional<T>`; an empty optional means that the queue has been closed
+     * and no element is due.
+     *
+     * @internal
+     * @test @a DelayQueueTest.PopWaitsForDeadline
+     * @test @a DelayQueueTest.ManyConsumersShareTimer
+     */
+    [[nodiscard]] pop_op pop() noexcept { return pop_op{*this}; }
+
+    /**
+     * @brief Closes the queue.
+     *
+     * Subsequent pushes fail. Suspended consumers are resumed with an empty optional; elements that are due can still
+     * be popped, but `pop()` no longer waits for elements that are not.
+     *
+     * @internal
+     * @test @a DelayQueueTest.Close
+     */
+    void close()
+    {
+        pop_op* waiters = nullptr;
+        {
+            const std::scoped_lock lock(this->m_mutex);
+            this->m_closed = true;
+            waiters        = this->m_waiters.take_all();
+        }
+
+        resume_all(waiters);
+    }
+
+    /**
+     * @brief Checks whether the queue has been closed.
+     *
+     * @return Whether the queue has been closed.
+     */
+    [[nodiscard]] bool is_closed() const
+    {
+        const std::scoped_lock lock(this->m_mutex);
+        return this->m_closed;
+    }
+
+    /**
+     * @brief Awaitable for the pop operation.
+     *
+     * @see delay_queue::pop()
+     */
+    class [[nodiscard]] pop_op : public detail::intrusive_hook<pop_op> {
+    public:
+        /// @cond INTERNAL
+        /**
+         * @brief Constructs a new pop operation.
+         *
+         * @param q The queue.
+         */
+        explicit pop_op(delay_queue& q) noexcept : m_queue(q) {}
+        /// @endcond
+
+        /**
+         * @brief Always suspends; readiness is checked in `await_suspend()` under the lock.
+         *
+         * @return `false`
+         */
+        [[nodiscard]] constexpr bool await_ready() const noexcept { return false; }
+
+        /**
+         * @brief Takes a due element or suspends the consumer until one is due.
+         *
+         * @param h The awaiting coroutine.
+         * @return Whether the coroutine should stay suspended.
+         */
+        bool await_suspend(std::coroutine_handle<> h)
+        {
+            const std::scoped_lock lock(this->m_queue.m_mutex);
+            if (this->m_queue.try_pop_locked(this->m_value, clock::now()) || this->m_queue.m_closed) {
+                return false;
+            }
+
+            this->m_awaiting = h;
+            this->m_queue.m_waiters.push_back(this);
+            this->m_queue.arm();
+            return true;
+        }
+
+        /**
+         * @brief Returns the removed element.
+         *
+         * @return The removed element; an empty optional if the queue has been closed.
+         */
+        std::optional<T> await_resume() noexcept { return std::move(this->m_value); }
+
+    private:
+        friend class delay_queue;
+
+        delay_queue& m_queue;                ///< The queue.
+        std::optional<T> m_value;            ///< The removed element.
+        std::coroutine_handle<> m_awaiting;  ///< The suspended consumer.
+    };
+
+private:
+    /** @brief A queued element. */
+    struct entry {
+        clock::time_point deadline;  ///< When the element becomes available.
+        std::uint64_t sequence;      ///< Insertion order; breaks ties between equal deadlines.
+        T value;                     ///< The element.
+
+        /**
+         * @brief Orders entries by deadline, then by insertion order.
+         *
+         * @param other The entry to compare with.
+         * @return The ordering of the entries.
+         */
+        auto operator<=>(const entry& other) const noexcept
+        {
+            if (auto cmp = this->deadline <=> other.deadline; cmp != 0) {
+                return cmp;
+            }
+
+            return this->sequence <=> other.sequence;
+        }
+    };
+
+    /** @brief The timer shared by all suspended consumers. */
+    struct timer : detail::timer_node {
+        /**
+         * @brief Constructs a new timer.
+         *
+         * @param q The queue.
+         */
+        explicit timer(delay_queue* q) noexcept : m_queue(q) { this->m_fire = &timer::fire; }
+
+        delay_queue* m_queue;  ///< The queue.
+
+        /**
+         * @brief Hands due elements to suspended consumers and re-arms the timer.
+         *
+         * @param node The timer.
+         */
+        static void fire(detail::timer_node* node) noexcept { static_cast<timer*>(node)->m_queue->on_timer(); }
+    };
+
+    timer_service& m_service;                                  ///< The timer service.
+    mutable std::mutex m_mutex;                                ///< Guards the state of the queue.
+    std::vector<entry> m_heap;                                 ///< The elements; a min-heap by deadline.
+    detail::intrusive_queue<pop_op> m_waiters;                 ///< Suspended consumers.
+    std::uint64_t m_sequence      = 0;                         ///< Next insertion sequence number.
+    clock::time_point m_armed_for = clock::time_point::max();  ///< The deadline the timer is armed for.
+    bool m_closed                 = false;                     ///< Whether the queue has been closed.
+    timer m_timer;                                             ///< The shared timer.
+
+    /**
+     * @brief Removes the earliest element if it is due; the lock must be held.
+     *
+     * @param out Receives the element.
+     * @param now The current time.
+     * @return Whether an element was removed.
+     */
+    bool try_pop_locked(std::optional<T>& out, clock::time_point now)
+    {
+        if (this->m_heap.empty() || this->m_heap.front().deadline > now) {
+            return false;
+        }
+
+        std::ranges::pop_heap(this->m_heap, std::greater<>{});
+        out.emplace(std::move(this->m_heap.back().value));
+        this->m_heap.pop_back();
+        return true;
+    }
+
+    /**
+     * @brief Hands due elements to suspended consumers; the lock must be held.
+     *
+     * @param now The current time.
+     * @return The first consumer to resume; consumers are linked via `m_next`.
+     */
+    pop_op* take_due(clock::time_point now)
+    {
+        detail::intrusive_queue<pop_op> ready;
+        while (!this->m_waiters.empty() && this->try_pop_locked(this->m_waiters.front()->m_value, now)) {
+            ready.push_back(this->m_waiters.pop_front());
+        }
+
+        return ready.take_all();
+    }
+
+    /**
+     * @brief Arms the timer for the earliest deadline if there are suspended consumers; the lock must be held.
+     *
+     * The timer is left alone if it is already armed for that deadline. If it is armed while nobody waits,
+     * it fires spuriously and is not re-armed.
+     */
+    void arm()
+    {
+        if (this->m_waiters.empty() || this->m_heap.empty()) {
+            return;
+        }
+
+        const clock::time_point deadline = this->m_heap.front().deadline;
+        if (deadline != this->m_armed_for) {
+            this->m_armed_for = deadline;
+            this->m_service.schedule(&this->m_timer, deadline);
+        }
+    }
+
+    /**
+     * @brief Handles the expiry of the shared timer; runs on the timer thread.
+     */
+    void on_timer()
+    {
+        pop_op* ready = nullptr;
+        {
+            const std::scoped_lock lock(this->m_mutex);
+            this->m_armed_for = clock::time_point::max();
+            ready             = this->take_due(clock::now());
+            this->arm();
+        }
+
+        resume_all(ready);
+    }
+
+    /**
+     * @brief Resumes a chain of consumers.
+     *
+     * @param waiters The first consumer of the chain.
+     */
+    static void resume_all(pop_op* waiters)
+    {
+        while (waiters != nullptr) {
+            std::coroutine_handle<> h = waiters->m_awaiting;
+            waiters                   = waiters->m_next;
+            h.resume();
+        }
+    }
+};
+
+/**
+ * @example delay_queue.cpp
+ * Example of scheduling retries with a delay queue.
+ */
+
+}  // namespace wwa::coro
+
+#endif /* A4C07E29_5B1D_4E83_9F26_8D3B6E0A7C15 */
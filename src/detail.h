@@ -11,7 +11,16 @@
  * @warning The functions declared in this file are not intended for public use.
  */
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <thread>
+#include <utility>
 #include "exceptions.h"
 
 /// @cond INTERNAL
@@ -76,6 +85,609 @@ inline void check_coroutine(const std::coroutine_handle<>& h)
     }
 }
 
+/**
+ * @brief Assumed size of a cache line.
+ *
+ * Used to keep independently modified atomics apart and avoid false sharing.
+ * `std::hardware_destructive_interference_size` is not used because its value may differ between translation units.
+ */
+inline constexpr std::size_t cache_line_size = 64;
+
+/**
+ * @brief Hints the processor that the caller is in a spin-wait loop.
+ *
+ * On x86, this is the `pause` instruction, which reduces power consumption and the penalty for leaving the loop.
+ */
+inline void cpu_relax() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+/**
+ * @brief Returns a pseudo-random number from a per-thread xorshift generator.
+ *
+ * The generator is cheap and not suitable for anything but load balancing decisions (picking a queue to push to
+ * or a victim to steal from).
+ *
+ * @return A pseudo-random number.
+ */
+inline std::uint32_t fast_random() noexcept
+{
+    thread_local std::uint32_t state =
+        static_cast<std::uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id())) | 1U;
+
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+/**
+ * @brief A minimal test-and-test-and-set spinlock.
+ *
+ * The lock is used to guard short critical sections, such as manipulation of waiter lists.
+ * It satisfies the *Lockable* requirements and can be used with `std::scoped_lock`.
+ */
+class spinlock {
+public:
+    /**
+     * @brief Acquires the lock.
+     *
+     * Spins on a relaxed load to avoid cache line ping-pong and yields the thread after a few unsuccessful attempts.
+     */
+    void lock() noexcept
+    {
+        for (unsigned int spins = 0; this->m_locked.exchange(true, std::memory_order_acquire); ++spins) {
+            while (this->m_locked.load(std::memory_order_relaxed)) {
+                if (++spins > spins_before_yield) {
+                    std::this_thread::yield();
+                }
+                else {
+                    cpu_relax();
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Attempts to acquire the lock without blocking.
+     *
+     * @return Whether the lock was acquired.
+     */
+    [[nodiscard]] bool try_lock() noexcept
+    {
+        return !this->m_locked.load(std::memory_order_relaxed) &&
+               !this->m_locked.exchange(true, std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Releases the lock.
+     */
+    void unlock() noexcept { this->m_locked.store(false, std::memory_order_release); }
+
+private:
+    static constexpr unsigned int spins_before_yield = 64;  ///< Busy-wait iterations before yielding the thread.
+    std::atomic<bool> m_locked                       = false;  ///< Lock state.
+};
+
+/**
+ * @brief An eventcount: lets threads sleep until a condition they poll for may have changed.
+ *
+ * A waiter announces itself with `prepare_wait()`, checks its condition once more, and then either calls
+ * `cancel_wait()` or sleeps in `wait()`. A notifier makes the condition true and calls `notify_one()` or
+ * `notify_all()`. The waiter count is updated and read with sequentially consistent operations, so either the waiter
+ * sees the new condition, or the notifier sees the waiter and bumps the epoch; a notification that arrives between
+ * `prepare_wait()` and `wait()` is not lost. Notifiers do not enter the kernel when nobody waits.
+ *
+ * Sleeping uses `std::atomic::wait()`, which is a futex on Linux.
+ */
+class eventcount {
+public:
+    /** @brief The epoch a waiter sleeps on. */
+    using key = std::uint32_t;
+
+    /**
+     * @brief Announces a waiter.
+     *
+     * @return The key to pass to `wait()`.
+     */
+    [[nodiscard]] key prepare_wait() noexcept
+    {
+        this->m_waiters.fetch_add(1, std::memory_order_seq_cst);
+        return this->m_epoch.load(std::memory_order_seq_cst);
+    }
+
+    /** @brief Withdraws a waiter that has found its condition true. */
+    void cancel_wait() noexcept { this->m_waiters.fetch_sub(1, std::memory_order_relaxed); }
+
+    /**
+     * @brief Sleeps until notified after `prepare_wait()` returned @a k.
+     *
+     * @param k The key returned by `prepare_wait()`.
+     */
+    void wait(key k) noexcept
+    {
+        this->m_epoch.wait(k, std::memory_order_seq_cst);
+        this->m_waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /** @brief Wakes up one waiter, if any. */
+    void notify_one() noexcept
+    {
+        if (this->m_waiters.load(std::memory_order_seq_cst) != 0) {
+            this->m_epoch.fetch_add(1, std::memory_order_seq_cst);
+            this->m_epoch.notify_one();
+        }
+    }
+
+    /** @brief Wakes up all waiters. */
+    void notify_all() noexcept
+    {
+        if (this->m_waiters.load(std::memory_order_seq_cst) != 0) {
+            this->m_epoch.fetch_add(1, std::memory_order_seq_cst);
+            this->m_epoch.notify_all();
+        }
+    }
+
+private:
+    std::atomic<std::uint32_t> m_epoch   = 0;  ///< Bumped by every notification that finds a waiter.
+    std::atomic<std::uint32_t> m_waiters = 0;  ///< Threads between `prepare_wait()` and the end of `wait()`.
+};
+
+/**
+ * @brief Hook for intrusive singly-linked lists.
+ *
+ * Awaiters derive from this class to be linked into waiter lists without any allocations.
+ *
+ * @tparam Node The type of the list node (CRTP).
+ */
+template<typename Node>
+struct intrusive_hook {
+    Node* m_next = nullptr;  ///< Next node in the list.
+};
+
+/**
+ * @brief Intrusive FIFO list.
+ *
+ * The list does not own its nodes; nodes typically live in the frames of suspended coroutines (inside awaiters).
+ * The list is not thread-safe; users are expected to guard it with a lock.
+ *
+ * @tparam Node The type of the list node; must derive from `intrusive_hook<Node>`.
+ */
+template<typename Node>
+class intrusive_queue {
+public:
+    /**
+     * @brief Checks whether the list is empty.
+     *
+     * @return Whether the list is empty.
+     */
+    [[nodiscard]] constexpr bool empty() const noexcept { return this->m_head == nullptr; }
+
+    /**
+     * @brief Returns the first node of the list without removing it.
+     *
+     * @return The first node; `nullptr` if the list is empty.
+     */
+    [[nodiscard]] constexpr Node* front() const noexcept { return this->m_head; }
+
+    /**
+     * @brief Appends a node to the end of the list.
+     *
+     * @param node The node to append.
+     */
+    constexpr void push_back(Node* node) noexcept
+    {
+        node->m_next = nullptr;
+        if (this->m_tail != nullptr) {
+            this->m_tail->m_next = node;
+        }
+        else {
+            this->m_head = node;
+        }
+
+        this->m_tail = node;
+    }
+
+    /**
+     * @brief Removes and returns the first node of the list.
+     *
+     * @return The first node; `nullptr` if the list is empty.
+     */
+    constexpr Node* pop_front() noexcept
+    {
+        Node* node = this->m_head;
+        if (node != nullptr) {
+            this->m_head = node->m_next;
+            if (this->m_head == nullptr) {
+                this->m_tail = nullptr;
+            }
+
+            node->m_next = nullptr;
+        }
+
+        return node;
+    }
+
+    /**
+     * @brief Removes a node from the list.
+     *
+     * This operation is linear in the size of the list.
+     *
+     * @param node The node to remove.
+     * @return Whether the node was found and removed.
+     */
+    constexpr bool remove(Node* node) noexcept
+    {
+        Node* prev = nullptr;
+        for (Node* cur = this->m_head; cur != nullptr; prev = cur, cur = cur->m_next) {
+            if (cur == node) {
+                (prev != nullptr ? prev->m_next : this->m_head) = cur->m_next;
+                if (this->m_tail == cur) {
+                    this->m_tail = prev;
+                }
+
+                cur->m_next = nullptr;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief Detaches all nodes from the list.
+     *
+     * @return The first node of the detached chain; nodes are linked via `m_next`.
+     */
+    constexpr Node* take_all() noexcept
+    {
+        this->m_tail = nullptr;
+        return std::exchange(this->m_head, nullptr);
+    }
+
+private:
+    Node* m_head = nullptr;  ///< The first node.
+    Node* m_tail = nullptr;  ///< The last node.
+};
+
+/** @brief A suspended coroutine handed to a scheduler; lives in the frame of an awaiter. */
+struct resume_node : intrusive_hook<resume_node> {
+    std::coroutine_handle<> m_handle;  ///< The coroutine to resume.
+    bool m_timed = false;              ///< Whether the node is a `timed_node`.
+};
+
+/** @brief A suspended coroutine that is not worth resuming after a deadline; a deadline of `max()` means none. */
+struct timed_node : resume_node {
+    std::chrono::steady_clock::time_point m_deadline;  ///< When the caller gives up on the coroutine.
+    std::chrono::steady_clock::time_point m_queued;    ///< When the node was queued, if the scheduler measures delays.
+    bool m_expired = false;                            ///< Set by the scheduler if the deadline has passed at dequeue.
+
+    /**
+     * @brief Constructs a new node.
+     *
+     * @param deadline When the caller gives up on the coroutine.
+     */
+    explicit timed_node(std::chrono::steady_clock::time_point deadline) noexcept : m_deadline(deadline), m_queued()
+    {
+        this->m_timed = true;
+    }
+};
+
+/**
+ * @brief What the scheduler running the calling thread offers to library awaitables.
+ *
+ * A scheduler fills this in on its worker threads and refills `m_budget` before every resumption. Library awaitables
+ * that would continue another coroutine by symmetric transfer spend one unit of the budget; when it runs out, they
+ * hand the coroutine back to the scheduler instead (see `transfer()`).
+ */
+struct coop_context {
+    /** @brief Queues a node at the back of a queue of a scheduler; may be called from any thread. */
+    using reschedule_fn = void (*)(void* scheduler, resume_node* node, std::size_t lane) noexcept;
+
+    void* m_scheduler          = nullptr;  ///< The scheduler; `nullptr` if the thread does not belong to one.
+    reschedule_fn m_reschedule = nullptr;  ///< Queues a node on `m_scheduler`.
+    std::size_t m_lane         = 0;        ///< Which queue the running coroutine came from, such as its priority.
+    std::size_t m_budget       = 0;        ///< Transfers left in this resumption; 0 means unlimited.
+};
+
+/**
+ * @brief Returns the cooperative context of the calling thread.
+ *
+ * @return The context.
+ */
+inline coop_context& coop() noexcept
+{
+    static thread_local coop_context ctx;
+    return ctx;
+}
+
+/**
+ * @brief Reschedules a coroutine on the scheduler of the calling thread.
+ *
+ * @param node The node to queue; must stay alive until the coroutine is resumed.
+ * @param h The coroutine.
+ * @return Whether the coroutine has been queued; `false` if the thread does not belong to a scheduler.
+ */
+inline bool reschedule(resume_node& node, std::coroutine_handle<> h) noexcept
+{
+    coop_context& ctx = coop();
+    if (ctx.m_scheduler == nullptr) {
+        return false;
+    }
+
+    node.m_handle = h;
+    ctx.m_reschedule(ctx.m_scheduler, &node, ctx.m_lane);
+    return true;
+}
+
+/**
+ * @brief Picks the coroutine to continue by symmetric transfer, spending one unit of the budget.
+ *
+ * @param node The node to queue @a next with if the budget is exhausted; must stay alive until @a next is resumed.
+ * @param next The coroutine to continue.
+ * @return @a next, or `std::noop_coroutine()` if the budget is exhausted and @a next has been rescheduled.
+ */
+inline std::coroutine_handle<> transfer(resume_node& node, std::coroutine_handle<> next) noexcept
+{
+    coop_context& ctx = coop();
+    if (ctx.m_budget == 0 || --ctx.m_budget != 0) {
+        return next;
+    }
+
+    // Stay exhausted until the scheduler refills the budget
+    ctx.m_budget = 1;
+    return reschedule(node, next) ? std::noop_coroutine() : next;
+}
+
+/**
+ * @brief A cache of coroutine frames owned by one thread.
+ *
+ * Frame sizes up to `max_size` are rounded up to a multiple of `granule`, whichever thread allocates them, so that
+ * a freed frame fits any later frame of its size class. The thread that has installed an arena as `current()` keeps
+ * the frames it frees on per-class free lists (up to `max_cached` per class) and reuses them without going to
+ * the global allocator; larger frames and frames freed on threads without an arena go back to the global allocator.
+ */
+class frame_arena {
+public:
+    static constexpr std::size_t granule    = 64;                  ///< The size classes are multiples of this.
+    static constexpr std::size_t max_size   = 2048;                ///< Larger frames are not cached.
+    static constexpr std::size_t classes    = max_size / granule;  ///< The number of size classes.
+    static constexpr std::size_t max_cached = 256;                 ///< The most frames kept per size class.
+
+    /** @brief Default constructor. */
+    frame_arena() noexcept = default;
+
+    /// @cond
+    frame_arena(const frame_arena&)            = delete;
+    frame_arena(frame_arena&&)                 = delete;
+    frame_arena& operator=(const frame_arena&) = delete;
+    frame_arena& operator=(frame_arena&&)      = delete;
+    /// @endcond
+
+    /** @brief Destructor; returns the cached frames to the global allocator. */
+    ~frame_arena()
+    {
+        for (free_block* head : this->m_free) {
+            while (head != nullptr) {
+                ::operator delete(std::exchange(head, head->m_next));
+            }
+        }
+    }
+
+    /**
+     * @brief Returns the arena of the calling thread.
+     *
+     * @return The arena; `nullptr` if the thread has none.
+     */
+    static frame_arena*& current() noexcept
+    {
+        static thread_local frame_arena* arena = nullptr;
+        return arena;
+    }
+
+    /**
+     * @brief Allocates a frame, from the arena of the calling thread if it has one.
+     *
+     * @param size The size of the frame.
+     * @return The frame.
+     */
+    [[nodiscard]] static void* allocate(std::size_t size)
+    {
+        const std::size_t cls = size_class(size);
+        if (cls < classes) {
+            if (frame_arena* arena = current(); arena != nullptr && arena->m_free[cls] != nullptr) {
+                --arena->m_cached[cls];
+                return std::exchange(arena->m_free[cls], arena->m_free[cls]->m_next);
+            }
+
+            return ::operator new((cls + 1) * granule);
+        }
+
+        return ::operator new(size);
+    }
+
+    /**
+     * @brief Frees a frame, to the arena of the calling thread if it has one.
+     *
+     * @param ptr The frame.
+     * @param size The size of the frame.
+     */
+    static void deallocate(void* ptr, std::size_t size) noexcept
+    {
+        const std::size_t cls = size_class(size);
+        if (frame_arena* arena = current(); arena != nullptr && cls < classes && arena->m_cached[cls] < max_cached) {
+            ++arena->m_cached[cls];
+            arena->m_free[cls] = ::new (ptr) free_block{arena->m_free[cls]};
+            return;
+        }
+
+        ::operator delete(ptr);
+    }
+
+private:
+    /** @brief A cached frame. */
+    struct free_block {
+        free_block* m_next;  ///< The next cached frame of the same class.
+    };
+
+    std::array<free_block*, classes> m_free   = {};  ///< Free lists, by size class.
+    std::array<std::size_t, classes> m_cached = {};  ///< Lengths of the free lists.
+
+    /**
+     * @brief Returns the size class of a frame.
+     *
+     * @param size The size of the frame.
+     * @return The size class; `classes` or more if the frame is not cached.
+     */
+    static constexpr std::size_t size_class(std::size_t size) noexcept { return (size + granule - 1) / granule - 1; }
+};
+
+/**
+ * @brief Shared state of a `select()` operation.
+ *
+ * A select registers one waiter per clause. Whoever wants to complete a clause must first claim the whole select:
+ * the claim is tentative (the claimant may find that it cannot complete the clause after all and give the claim back),
+ * and only one claimant may hold it at a time. Once a clause completes, the select is decided and all other claims fail.
+ *
+ * The select coroutine and the completer race to flip `m_ready`; the second one to arrive resumes (or keeps running)
+ * the coroutine. This allows wakers to complete the select while it is still registering its waiters.
+ */
+class select_state {
+public:
+    /**
+     * @brief Sets the coroutine to resume when the select completes.
+     *
+     * @param h The awaiting coroutine.
+     */
+    void set_awaiting(std::coroutine_handle<> h) noexcept { this->m_awaiting = h; }
+
+    /**
+     * @brief Tentatively claims the select.
+     *
+     * @return Whether the claim succeeded; `false` means that the select has already completed.
+     */
+    [[nodiscard]] bool try_claim() noexcept
+    {
+        int expected = open;
+        while (!this->m_winner.compare_exchange_weak(expected, claimed, std::memory_order_acquire,
+                                                     std::memory_order_relaxed)) {
+            if (expected >= 0) {
+                return false;
+            }
+
+            if (expected == claimed) {
+                cpu_relax();
+            }
+
+            expected = open;
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Gives back a claim that could not be used.
+     */
+    void release() noexcept { this->m_winner.store(open, std::memory_order_release); }
+
+    /**
+     * @brief Completes a claimed select and resumes the coroutine unless it is still registering waiters.
+     *
+     * @param index The index of the completed clause.
+     */
+    void complete(std::size_t index)
+    {
+        this->m_winner.store(static_cast<int>(index), std::memory_order_release);
+        if (this->m_ready.exchange(true, std::memory_order_acq_rel)) {
+            this->m_awaiting.resume();
+        }
+    }
+
+    /**
+     * @brief Completes the select from the select coroutine itself, before any waiter has been published.
+     *
+     * @param index The index of the completed clause.
+     */
+    void complete_inline(std::size_t index) noexcept
+    {
+        this->m_winner.store(static_cast<int>(index), std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Called by the select coroutine after all waiters have been published.
+     *
+     * @return Whether the coroutine should stay suspended; `false` means that a clause has already completed.
+     */
+    [[nodiscard]] bool finish_arming() noexcept { return !this->m_ready.exchange(true, std::memory_order_acq_rel); }
+
+    /**
+     * @brief Returns the index of the completed clause.
+     *
+     * @return The index of the completed clause; only meaningful after the select has completed.
+     */
+    [[nodiscard]] std::size_t winner() const noexcept
+    {
+        return static_cast<std::size_t>(this->m_winner.load(std::memory_order_acquire));
+    }
+
+private:
+    static constexpr int open    = -1;  ///< No clause has completed yet.
+    static constexpr int claimed = -2;  ///< A completer holds a tentative claim.
+
+    std::atomic<int> m_winner = open;    ///< The index of the completed clause, `open`, or `claimed`.
+    std::atomic<bool> m_ready = false;   ///< Set by whichever of the coroutine and the completer comes first.
+    std::coroutine_handle<> m_awaiting;  ///< The coroutine awaiting the select.
+};
+
+/**
+ * @brief A waiter that belongs either to a plain operation or to a `select()`.
+ *
+ * Wakers must call `claim()` before completing the operation; if the claim fails, the waiter is stale (its select
+ * has completed via another clause) and must be dropped from the waiter list.
+ */
+struct waiter {
+    std::coroutine_handle<> m_awaiting;     ///< The suspended coroutine (plain operations only).
+    select_state* m_select = nullptr;       ///< The select this waiter belongs to, if any.
+    std::size_t m_index    = 0;             ///< The index of the clause within the select.
+
+    /**
+     * @brief Claims the waiter for completion.
+     *
+     * @return Whether the waiter may be completed.
+     */
+    [[nodiscard]] bool claim() const noexcept { return this->m_select == nullptr || this->m_select->try_claim(); }
+
+    /**
+     * @brief Gives back a claim that could not be used.
+     */
+    void unclaim() const noexcept
+    {
+        if (this->m_select != nullptr) {
+            this->m_select->release();
+        }
+    }
+
+    /**
+     * @brief Completes a claimed waiter and resumes its coroutine.
+     *
+     * @warning The waiter may be destroyed by the time this function returns.
+     */
+    void complete() const
+    {
+        if (this->m_select != nullptr) {
+            this->m_select->complete(this->m_index);
+        }
+        else {
+            this->m_awaiting.resume();
+        }
+    }
+};
+
 }  // namespace detail
 
 }  // namespace wwa::coro
@@ -0,0 +1,562 @@
+#ifndef E5A04C7B_91D3_4F68_B2E1_7C9D3A50F6B4
+#define E5A04C7B_91D3_4F68_B2E1_7C9D3A50F6B4
+
+/**
+ * @file edf_executor.h
+ * @brief Earliest-deadline-first executor.
+ *
+ * This file contains the definition of the `edf_executor` class. `co_await executor.schedule(deadline)` moves the
+ * awaiting coroutine to a worker thread; workers resume the coroutine with the earliest deadline first.
+ *
+ * Example:
+ * @snippet edf_executor.cpp edf_executor example
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "detail.h"
+
+namespace wwa::coro {
+
+/**
+ * @brief An earliest-deadline-first executor.
+ *
+ * Every worker owns a binary heap of scheduled coroutines ordered by deadline; coroutines with equal deadlines run in
+ * the order they were scheduled. A coroutine that calls `co_await executor.schedule(deadline)` is pushed onto the heap
+ * of the current worker if it already runs on the executor, or of the next worker in round-robin order otherwise.
+ * Workers take the earliest deadline from their own heap; when it is empty, they steal the earliest deadline among
+ * the other workers. Idle workers sleep.
+ *
+ * A worker remembers the deadline of the coroutine it runs, and `schedule()` without an argument uses it. Tasks
+ * started by a coroutine run on the same thread until they suspend, so they inherit the deadline of their parent.
+ * Coroutines scheduled from outside the executor without a deadline get `no_deadline` and run after all work that has
+ * one.
+ *
+ * Workers offer the executor to library awaitables the way `thread_pool` does: `yield_now()` and an exhausted budget of
+ * symmetric transfers put the coroutine back into the heap with the deadline it ran with, and `offload()` sends the
+ * coroutine back to a worker with that deadline when the blocking call returns.
+ *
+ * The executor counts the coroutines resumed after their deadline has passed, see `missed()`.
+ *
+ * Example:
+ * @snippet edf_executor.cpp edf_executor example
+ */
+class edf_executor {
+public:
+    /** @brief The clock used for deadlines. */
+    using clock = std::chrono::steady_clock;
+
+    /** @brief The deadline of work that has none; it sorts after any real deadline. */
+    static constexpr clock::time_point no_deadline = clock::time_point::max();
+
+    class schedule_op;
+
+    /**
+     * @brief Constructs a new executor and starts the workers.
+     *
+     * @param threads The number of workers; zero means `std::thread::hardware_concurrency()`.
+     * @param budget Transfers per resumption before a coroutine yields; see `thread_pool_options::budget`.
+     *
+     * @internal
+     * @test @a EdfExecutorTest.RunsOnWorkers
+     * @test @a EdfExecutorTest.Offload
+     * @test @a EdfExecutorTest.YieldNow
+     */
+    explicit edf_executor(std::size_t threads = 0, std::size_t budget = 128)
+        : m_workers(threads != 0 ? threads : std::max(1U, std::thread::hardware_concurrency())), m_budget(budget)
+    {
+        for (auto& w : this->m_workers) {
+            w = std::make_unique<worker>();
+        }
+
+        for (std::size_t i = 0; i < this->m_workers.size(); ++i) {
+            this->m_workers[i]->m_thread = std::thread([this, i] { this->run(i); });
+        }
+    }
+
+    /// @cond
+    edf_executor(const edf_executor&)            = delete;
+    edf_executor(edf_executor&&)                 = delete;
+    edf_executor& operator=(const edf_executor&) = delete;
+    edf_executor& operator=(edf_executor&&)      = delete;
+    /// @endcond
+
+    /**
+     * @brief Destructor.
+     *
+     * Runs the queued coroutines to their next suspension point, then stops the workers.
+     *
+     * @warning Must not be called from a worker of the executor.
+     *
+     * @internal
+     * @test @a EdfExecutorTest.DestructorDrains
+     */
+    ~edf_executor()
+    {
+        {
+            const std::scoped_lock lock(this->m_mutex);
+            this->m_stop = true;
+        }
+
+        this->m_cv.notify_all();
+        for (auto& w : this->m_workers) {
+            w->m_thread.join();
+        }
+    }
+
+    /**
+     * @brief Moves the awaiting coroutine to the executor, keeping the current deadline.
+     *
+     * @return An awaitable.
+     * @see current_deadline()
+     *
+     * @internal
+     * @test @a EdfExecutorTest.DeadlineInheritance
+     */
+    [[nodiscard]] schedule_op schedule() noexcept { return schedule_op{*this, this->current_deadline()}; }
+
+    /**
+     * @brief Moves the awaiting coroutine to the executor with the given deadline.
+     *
+     * @param deadline When the coroutine should have been resumed.
+     * @return An awaitable.
+     *
+     * @internal
+     * @test @a EdfExecutorTest.EarliestDeadlineFirst
+     */
+    [[nodiscard]] schedule_op schedule(clock::time_point deadline) noexcept { return schedule_op{*this, deadline}; }
+
+    /**
+     * @brief Moves the awaiting coroutine to the executor with a deadline relative to now.
+     *
+     * @param slack How much time the coroutine has.
+     * @return An awaitable.
+     */
+    template<typename Rep, typename Period>
+    [[nodiscard]] schedule_op schedule_within(std::chrono::duration<Rep, Period> slack) noexcept
+    {
+        return this->schedule(clock::now() + std::chrono::duration_cast<clock::duration>(slack));
+    }
+
+    /**
+     * @brief Returns the number of workers.
+     *
+     * @return The number of workers.
+     */
+    [[nodiscard]] std::size_t size() const noexcept { return this->m_workers.size(); }
+
+    /**
+     * @brief Returns the deadline of the coroutine running on the calling thread.
+     *
+     * @return The deadline of the running coroutine if the calling thread is a worker of the executor; `no_deadline`
+     * otherwise.
+     *
+     * @internal
+     * @test @a EdfExecutorTest.DeadlineInheritance
+     */
+    [[nodiscard]] clock::time_point current_deadline() const noexcept
+    {
+        const worker_context& ctx = context();
+        return ctx.m_executor == this ? ctx.m_deadline : no_deadline;
+    }
+
+    /**
+     * @brief Checks whether the calling thread is a worker of the executor.
+     *
+     * @return Whether the calling thread is a worker of the executor.
+     *
+     * @internal
+     * @test @a EdfExecutorTest.RunsOnWorkers
+     */
+    [[nodiscard]] bool running_in_this_thread() const noexcept { return context().m_executor == this; }
+
+    /**
+     * @brief Returns the number of coroutines resumed after their deadline.
+     *
+     * @return The number of missed deadlines.
+     *
+     * @internal
+     * @test @a EdfExecutorTest.MissedDeadlines
+     */
+    [[nodiscard]] std::uint64_t missed() const noexcept { return this->m_missed.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Awaitable for the schedule operation.
+     *
+     * @see edf_executor::schedule()
+     */
+    class [[nodiscard]] schedule_op : private detail::resume_node {
+    public:
+        /// @cond INTERNAL
+        /**
+         * @brief Constructs a new operation.
+         *
+         * @param executor The executor.
+         * @param deadline The deadline.
+         */
+        schedule_op(edf_executor& executor, clock::time_point deadline) noexcept
+            : m_executor(executor), m_deadline(deadline)
+        {}
+        /// @endcond
+
+        /**
+         * @brief Always suspends.
+         *
+         * @return `false`
+         */
+        [[nodiscard]] constexpr bool await_ready() const noexcept { return false; }
+
+        /**
+         * @brief Queues the coroutine.
+         *
+         * @param h The awaiting coroutine.
+         * @throw std::bad_alloc if the heap cannot grow; the coroutine is not queued then.
+         */
+        void await_suspend(std::coroutine_handle<> h)
+        {
+            this->m_handle = h;
+            this->m_executor.enqueue(this, this->m_deadline);
+        }
+
+        /** @brief Does nothing. */
+        constexpr void await_resume() const noexcept {}
+
+    private:
+        edf_executor& m_executor;      ///< The executor.
+        clock::time_point m_deadline;  ///< The deadline.
+    };
+
+private:
+    /** @brief The published deadline of an empty heap; a heap that holds only `no_deadline` publishes one less. */
+    static constexpr clock::rep empty_heap = clock::duration::max().count();
+
+    static_assert(sizeof(std::size_t) >= sizeof(clock::rep), "The lane of a worker must be able to hold a deadline");
+
+    /** @brief A scheduled coroutine. */
+    struct entry {
+        clock::time_point m_deadline;           ///< The deadline.
+        std::uint64_t m_sequence    = 0;        ///< Breaks ties between equal deadlines.
+        detail::resume_node* m_node = nullptr;  ///< The coroutine; `nullptr` if there is none.
+    };
+
+    /** @brief A worker and its heap. */
+    struct alignas(detail::cache_line_size) worker {
+        detail::spinlock m_lock;                                 ///< Guards the heap and the spilled coroutines.
+        std::vector<entry> m_heap;                               ///< The scheduled coroutines.
+        detail::intrusive_queue<detail::resume_node> m_spilled;  ///< Rescheduled coroutines the heap had no room for.
+        std::uint64_t m_sequence           = 0;                  ///< The sequence number of the next push.
+        std::atomic<clock::rep> m_earliest = empty_heap;         ///< The earliest deadline in the heap, for thieves.
+        std::thread m_thread;                                    ///< The worker thread.
+    };
+
+    /** @brief What a thread knows about the executor it works for. */
+    struct worker_context {
+        const edf_executor* m_executor = nullptr;      ///< The executor; `nullptr` if the thread is not a worker.
+        std::size_t m_index            = 0;            ///< The index of the worker.
+        clock::time_point m_deadline   = no_deadline;  ///< The deadline of the running coroutine.
+    };
+
+    std::vector<std::unique_ptr<worker>> m_workers;  ///< The workers.
+    std::size_t m_budget;                            ///< Transfers per resumption.
+    std::atomic<std::size_t> m_next     = 0;         ///< Round-robin cursor for submissions from outside.
+    std::atomic<std::size_t> m_pending  = 0;         ///< Queued coroutines, counted before they become visible.
+    std::atomic<std::size_t> m_idle     = 0;         ///< Sleeping workers.
+    std::atomic<std::uint64_t> m_missed = 0;         ///< Coroutines resumed after their deadline.
+    std::mutex m_mutex;                              ///< Guards sleeping.
+    std::condition_variable m_cv;                    ///< Wakes up sleeping workers.
+    bool m_stop = false;                             ///< Whether the executor is being destroyed.
+
+    /**
+     * @brief Returns the context of the calling thread.
+     *
+     * @return The context.
+     */
+    static worker_context& context() noexcept
+    {
+        static thread_local worker_context ctx;
+        return ctx;
+    }
+
+    /**
+     * @brief Orders the heap so that the earliest deadline is on top.
+     *
+     * @param a The first operation.
+     * @param b The second operation.
+     * @return Whether @a a runs after @a b.
+     */
+    static bool later(const entry& a, const entry& b) noexcept
+    {
+        return a.m_deadline != b.m_deadline ? a.m_deadline > b.m_deadline : a.m_sequence > b.m_sequence;
+    }
+
+    /**
+     * @brief Turns a deadline into the lane of the cooperative context, so that rescheduled coroutines keep it.
+     *
+     * @param deadline The deadline.
+     * @return The lane.
+     */
+    static std::size_t to_lane(clock::time_point deadline) noexcept
+    {
+        return static_cast<std::size_t>(deadline.time_since_epoch().count());
+    }
+
+    /**
+     * @brief Turns the lane of the cooperative context back into a deadline.
+     *
+     * @param lane The lane.
+     * @return The deadline.
+     */
+    static clock::time_point to_deadline(std::size_t lane) noexcept
+    {
+        return clock::time_point(clock::duration(static_cast<clock::rep>(lane)));
+    }
+
+    /**
+     * @brief Publishes the earliest deadline of a worker; the lock of the worker must be held.
+     *
+     * @param w The worker.
+     */
+    static void publish(worker& w) noexcept
+    {
+        clock::rep earliest = empty_heap;
+        if (!w.m_heap.empty()) {
+            earliest = std::min(w.m_heap.front().m_deadline.time_since_epoch().count(), empty_heap - 1);
+        }
+        else if (!w.m_spilled.empty()) {
+            earliest = empty_heap - 1;
+        }
+
+        w.m_earliest.store(earliest, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Picks the worker to queue a coroutine on: the current one, or the next one in round-robin order.
+     *
+     * @return The worker.
+     */
+    worker& target() noexcept
+    {
+        const worker_context& ctx = context();
+        const std::size_t index =
+            ctx.m_executor == this ? ctx.m_index : this->m_next.fetch_add(1, std::memory_order_relaxed) % this->size();
+
+        return *this->m_workers[index];
+    }
+
+    /**
+     * @brief Queues a coroutine and wakes up a sleeping worker.
+     *
+     * The coroutine is counted in `m_pending` before it is queued; the sequentially consistent increment and the check
+     * for sleeping workers pair with `park()`: either the sleeper sees the work, or the submitter sees the sleeper.
+     * The sleeper is woken before the coroutine is queued (it spins until then): a coroutine that `offload()` hands
+     * back may finish, and the executor may be destroyed, as soon as the lock of the worker is released.
+     *
+     * @param node The coroutine.
+     * @param deadline The deadline.
+     * @throw std::bad_alloc if the heap cannot grow; the coroutine is not queued then, and is not counted.
+     */
+    void enqueue(detail::resume_node* node, clock::time_point deadline)
+    {
+        worker& w = this->target();
+        this->m_pending.fetch_add(1, std::memory_order_seq_cst);
+        this->notify();
+        try {
+            const std::scoped_lock lock(w.m_lock);
+            w.m_heap.push_back({deadline, w.m_sequence, node});
+            ++w.m_sequence;
+            std::ranges::push_heap(w.m_heap, later);
+            publish(w);
+        }
+        catch (...) {
+            this->m_pending.fetch_sub(1, std::memory_order_relaxed);
+            throw;
+        }
+    }
+
+    /**
+     * @brief Queues a coroutine that has run on the executor before; used by `yield_now()`, budgets, and `offload()`.
+     *
+     * If the heap cannot grow, the coroutine is not lost: it waits in a list of the worker that needs no allocation,
+     * and runs when the heap is empty.
+     *
+     * @param executor The executor.
+     * @param node The coroutine.
+     * @param lane The deadline the coroutine ran with, see `to_lane()`.
+     */
+    static void reschedule(void* executor, detail::resume_node* node, std::size_t lane) noexcept
+    {
+        auto* self = static_cast<edf_executor*>(executor);
+        try {
+            self->enqueue(node, to_deadline(lane));
+        }
+        catch (...) {
+            worker& w = self->target();
+            self->m_pending.fetch_add(1, std::memory_order_seq_cst);
+            self->notify();
+
+            const std::scoped_lock lock(w.m_lock);
+            w.m_spilled.push_back(node);
+            publish(w);
+        }
+    }
+
+    /** @brief Wakes up a sleeping worker, if there is one, for a coroutine that has been counted. */
+    void notify()
+    {
+        if (this->m_idle.load(std::memory_order_seq_cst) != 0) {
+            this->wake_one();
+        }
+    }
+
+    /**
+     * @brief Takes the coroutine with the earliest deadline from the heap of a worker.
+     *
+     * Spilled coroutines are taken once the heap is empty.
+     *
+     * @param w The worker.
+     * @return The coroutine; an entry without a node if the worker has none.
+     */
+    entry pop(worker& w) noexcept
+    {
+        const std::scoped_lock lock(w.m_lock);
+        entry e;
+        if (!w.m_heap.empty()) {
+            std::ranges::pop_heap(w.m_heap, later);
+            e = w.m_heap.back();
+            w.m_heap.pop_back();
+        }
+        else if (!w.m_spilled.empty()) {
+            e = {no_deadline, 0, w.m_spilled.pop_front()};
+        }
+        else {
+            return e;
+        }
+
+        publish(w);
+        this->m_pending.fetch_sub(1, std::memory_order_relaxed);
+        return e;
+    }
+
+    /**
+     * @brief Steals the coroutine with the earliest deadline from the other workers.
+     *
+     * The published deadlines may be stale; if the chosen victim turns out to be empty, the thief looks again.
+     *
+     * @param index The index of the thief.
+     * @return The coroutine; an entry without a node if there is nothing to steal.
+     */
+    entry steal(std::size_t index) noexcept
+    {
+        const std::size_t n = this->size();
+        for (std::size_t attempt = 1; attempt < n; ++attempt) {
+            worker* victim      = nullptr;
+            clock::rep earliest = empty_heap;
+            for (std::size_t i = 1; i < n; ++i) {
+                worker& w             = *this->m_workers[(index + i) % n];
+                const clock::rep when = w.m_earliest.load(std::memory_order_relaxed);
+                if (when < earliest) {
+                    victim   = &w;
+                    earliest = when;
+                }
+            }
+
+            if (victim == nullptr) {
+                break;
+            }
+
+            if (const entry e = this->pop(*victim); e.m_node != nullptr) {
+                return e;
+            }
+        }
+
+        return {};
+    }
+
+    /**
+     * @brief Puts the calling worker to sleep until there is work or the executor stops.
+     *
+     * @return Whether the worker should go on; `false` once the executor stops and no work is left.
+     */
+    bool park()
+    {
+        std::unique_lock lock(this->m_mutex);
+        this->m_idle.fetch_add(1, std::memory_order_seq_cst);
+        while (this->m_pending.load(std::memory_order_seq_cst) == 0 && !this->m_stop) {
+            this->m_cv.wait(lock);
+        }
+
+        this->m_idle.fetch_sub(1, std::memory_order_relaxed);
+        return this->m_pending.load(std::memory_order_relaxed) != 0 || !this->m_stop;
+    }
+
+    /**
+     * @brief Wakes up one sleeping worker.
+     *
+     * Taking the mutex ensures that a worker that has checked for work is already waiting.
+     */
+    void wake_one()
+    {
+        {
+            const std::scoped_lock lock(this->m_mutex);
+        }
+
+        this->m_cv.notify_one();
+    }
+
+    /**
+     * @brief The body of a worker thread.
+     *
+     * @param index The index of the worker.
+     */
+    void run(std::size_t index)
+    {
+        worker_context& ctx        = context();
+        detail::coop_context& coop = detail::coop();
+        ctx                        = {this, index, no_deadline};
+        coop                       = {this, &edf_executor::reschedule, to_lane(no_deadline), 0};
+
+        worker& self = *this->m_workers[index];
+        for (;;) {
+            entry e = this->pop(self);
+            if (e.m_node == nullptr) {
+                e = this->steal(index);
+            }
+
+            if (e.m_node != nullptr) {
+                ctx.m_deadline = e.m_deadline;
+                coop.m_lane    = to_lane(e.m_deadline);
+                coop.m_budget  = this->m_budget;
+                if (e.m_deadline != no_deadline && clock::now() > e.m_deadline) {
+                    this->m_missed.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                e.m_node->m_handle.resume();
+            }
+            else if (!this->park()) {
+                break;
+            }
+        }
+
+        ctx  = {};
+        coop = {};
+    }
+};
+
+/**
+ * @example edf_executor.cpp
+ * Example of running requests with deadlines on an earliest-deadline-first executor.
+ */
+
+}  // namespace wwa::coro
+
+#endif /* E5A04C7B_91D3_4F68_B2E1_7C9D3A50F6B4 */
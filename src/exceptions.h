@@ -36,6 +36,17 @@ public:
     using std::logic_error::logic_error;
 };
 
+/**
+ * @brief Exception thrown when scheduled work is dropped because its deadline has passed.
+ *
+ * The `deadline_exceeded` exception is thrown from a `co_await` on an executor when the executor finds at dequeue time
+ * that the caller of the coroutine has given up on it, and cancels the coroutine instead of running it.
+ */
+class deadline_exceeded : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
 }  // namespace wwa::coro
 
 #endif /* A271EFBC_A65F_4947_8E87_D4194949A073 */
@@ -0,0 +1,874 @@
+#ifndef E3C5A917_4B2D_4F08_9A6E_71D0B84F2C35
+#define E3C5A917_4B2D_4F08_9A6E_71D0B84F2C35
+
+/**
+ * @file fork_join.h
+ * @brief Fork/join parallelism with work stealing.
+ *
+ * This file contains the definitions of the `parallel_task` class template and the `fork_join_pool` class.
+ * `t.fork()` offers a lazily started task to idle workers of the pool; `co_await t` joins it, running it inline
+ * if nobody has taken it yet.
+ *
+ * Example:
+ * @snippet fork_join.cpp fork_join example
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "detail.h"
+
+namespace wwa::coro {
+
+template<typename T>
+class parallel_task;
+
+/// @cond INTERNAL
+namespace detail {
+
+/**
+ * @brief A Chase-Lev work-stealing deque of coroutine frames.
+ *
+ * The owner thread pushes and pops at the bottom without locks; other threads steal from the top. Only the last item
+ * makes the owner race with thieves, which is settled with a single compare-and-swap. When the ring is full, the owner
+ * replaces it with one twice as large; old rings are kept until the deque is destroyed, because a thief may still
+ * be reading from them.
+ *
+ * @see https://doi.org/10.1145/1073970.1073974
+ * @see https://doi.org/10.1145/2442516.2442524
+ */
+class work_stealing_deque {
+public:
+    /**
+     * @brief Constructs a new deque.
+     *
+     * @param capacity The initial capacity; rounded up to a power of two.
+     */
+    explicit work_stealing_deque(std::size_t capacity)
+    {
+        this->m_rings.push_back(std::make_unique<ring>(std::bit_ceil(std::max<std::size_t>(capacity, 2))));
+        this->m_ring.store(this->m_rings.back().get(), std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Pushes an item to the bottom; called by the owner only.
+     *
+     * @param item The item.
+     */
+    void push(void* item)
+    {
+        const std::int64_t b = this->m_bottom.load(std::memory_order_relaxed);
+        const std::int64_t t = this->m_top.load(std::memory_order_acquire);
+        ring* r              = this->m_ring.load(std::memory_order_relaxed);
+        if (b - t >= static_cast<std::int64_t>(r->m_mask)) {
+            r = this->grow(r, t, b);
+        }
+
+        r->put(b, item);
+        // Sequentially consistent: an idle worker that checks the deque after announcing itself must see the item
+        this->m_bottom.store(b + 1, std::memory_order_seq_cst);
+    }
+
+    /**
+     * @brief Pops the most recently pushed item; called by the owner only.
+     *
+     * @return The item; `nullptr` if the deque is empty or a thief has taken the last item.
+     */
+    [[nodiscard]] void* pop() noexcept
+    {
+        const std::int64_t b = this->m_bottom.load(std::memory_order_relaxed) - 1;
+        ring* r              = this->m_ring.load(std::memory_order_relaxed);
+        this->m_bottom.store(b, std::memory_order_seq_cst);
+        std::int64_t t = this->m_top.load(std::memory_order_seq_cst);
+
+        if (t > b) {
+            this->m_bottom.store(b + 1, std::memory_order_release);
+            return nullptr;
+        }
+
+        void* item = r->get(b);
+        if (t == b) {
+            if (!this->m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                item = nullptr;
+            }
+
+            this->m_bottom.store(b + 1, std::memory_order_release);
+        }
+
+        return item;
+    }
+
+    /**
+     * @brief Steals the oldest item; may be called from any thread.
+     *
+     * @return The item; `nullptr` if the deque is empty or another thread has won the race for the item.
+     */
+    [[nodiscard]] void* steal() noexcept
+    {
+        std::int64_t t       = this->m_top.load(std::memory_order_seq_cst);
+        const std::int64_t b = this->m_bottom.load(std::memory_order_seq_cst);
+        if (t >= b) {
+            return nullptr;
+        }
+
+        void* item = this->m_ring.load(std::memory_order_acquire)->get(t);
+        return this->m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)
+                   ? item
+                   : nullptr;
+    }
+
+    /**
+     * @brief Checks whether the deque looks empty; may be called from any thread.
+     *
+     * @return Whether the deque was empty at the moment of the check.
+     */
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return this->m_top.load(std::memory_order_seq_cst) >= this->m_bottom.load(std::memory_order_seq_cst);
+    }
+
+private:
+    /** @brief A circular buffer of items. */
+    struct ring {
+        std::size_t m_mask;                             ///< The capacity minus one.
+        std::unique_ptr<std::atomic<void*>[]> m_slots;  ///< The items.
+
+        /**
+         * @brief Constructs a new ring.
+         *
+         * @param capacity The capacity; a power of two.
+         */
+        explicit ring(std::size_t capacity)
+            : m_mask(capacity - 1), m_slots(std::make_unique<std::atomic<void*>[]>(capacity))
+        {}
+
+        /**
+         * @brief Stores an item.
+         *
+         * @param index The logical index of the item.
+         * @param item The item.
+         */
+        void put(std::int64_t index, void* item) noexcept
+        {
+            this->m_slots[static_cast<std::size_t>(index) & this->m_mask].store(item, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Loads an item.
+         *
+         * @param index The logical index of the item.
+         * @return The item.
+         */
+        [[nodiscard]] void* get(std::int64_t index) const noexcept
+        {
+            return this->m_slots[static_cast<std::size_t>(index) & this->m_mask].load(std::memory_order_relaxed);
+        }
+    };
+
+    alignas(cache_line_size) std::atomic<std::int64_t> m_top    = 0;        ///< The next item to steal.
+    alignas(cache_line_size) std::atomic<std::int64_t> m_bottom = 0;        ///< The next free slot.
+    std::atomic<ring*> m_ring                                   = nullptr;  ///< The current ring.
+    std::vector<std::unique_ptr<ring>> m_rings;                             ///< Every ring used so far.
+
+    /**
+     * @brief Replaces a full ring with one twice as large.
+     *
+     * @param old The current ring.
+     * @param t The top index.
+     * @param b The bottom index.
+     * @return The new ring.
+     */
+    ring* grow(ring* old, std::int64_t t, std::int64_t b)
+    {
+        auto bigger = std::make_unique<ring>((old->m_mask + 1) * 2);
+        for (std::int64_t i = t; i < b; ++i) {
+            bigger->put(i, old->get(i));
+        }
+
+        ring* r = bigger.get();
+        this->m_rings.push_back(std::move(bigger));
+        this->m_ring.store(r, std::memory_order_release);
+        return r;
+    }
+};
+
+/** @brief What a worker of a `fork_join_pool` shares with the tasks it runs. */
+struct fork_worker {
+    work_stealing_deque m_deque;  ///< Forked tasks that nobody has started yet.
+    eventcount* m_idle;           ///< Idle workers of the pool, to wake up when a task is forked.
+
+    /**
+     * @brief Constructs a new worker.
+     *
+     * @param capacity The initial capacity of the deque.
+     * @param idle Idle workers of the pool.
+     */
+    fork_worker(std::size_t capacity, eventcount* idle) : m_deque(capacity), m_idle(idle) {}
+
+    /**
+     * @brief Returns the worker of the calling thread.
+     *
+     * @return The worker; `nullptr` if the thread does not belong to a `fork_join_pool`.
+     */
+    static fork_worker*& current() noexcept
+    {
+        static thread_local fork_worker* self = nullptr;
+        return self;
+    }
+};
+
+/** @brief How far a forked task that runs detached from its parent has got. */
+enum class fork_state : std::uint8_t {
+    pending,   ///< Not finished, not joined.
+    finished,  ///< Finished before the parent joined it.
+    joining,   ///< The parent waits for it.
+};
+
+// NOLINTBEGIN(readability-convert-member-functions-to-static)
+template<typename Promise>
+struct parallel_promise_base {
+    /**
+     * @brief Allocates the frame of a task from the frame arena of the calling thread, if any.
+     *
+     * @internal
+     * @test @a ForkJoinTest.Fibonacci
+     */
+    [[nodiscard]] static void* operator new(std::size_t size) { return frame_arena::allocate(size); }
+
+    /** @brief Frees the frame of a task. */
+    static void operator delete(void* ptr, std::size_t size) noexcept { frame_arena::deallocate(ptr, size); }
+
+    [[nodiscard]] constexpr auto initial_suspend() const noexcept { return std::suspend_always{}; }
+
+    [[nodiscard]] constexpr auto final_suspend() const noexcept
+    {
+        struct final_awaiter {
+            [[nodiscard]] constexpr bool await_ready() const noexcept { return false; }
+
+            [[nodiscard]] std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+            {
+                auto& promise = handle.promise();
+                if (promise.m_next) {
+                    return detail::transfer(this->node, promise.m_next);
+                }
+
+                // Detached: whoever of the task and its parent comes second continues the parent
+                return promise.m_state.exchange(fork_state::finished, std::memory_order_acq_rel) == fork_state::joining
+                           ? detail::transfer(this->node, promise.m_joiner)
+                           : std::noop_coroutine();
+            }
+
+            void await_resume() const noexcept {}  // GCOVR_EXCL_LINE -- this method is not used
+
+            resume_node node = {};  ///< Queues the continuation when the budget runs out.
+        };
+
+        return final_awaiter{};
+    }
+
+    /**
+     * @internal
+     * @test @a ForkJoinTest.Exception
+     */
+    void unhandled_exception() noexcept { this->m_exception = std::current_exception(); }
+
+    std::coroutine_handle<> m_next;                         ///< The parent, if it runs the task inline.
+    std::coroutine_handle<> m_joiner;                       ///< The parent, if it waits for a detached task.
+    std::atomic<fork_state> m_state = fork_state::pending;  ///< How far a detached task has got.
+    fork_worker* m_home             = nullptr;              ///< The worker the task was forked on; `nullptr` if none.
+
+protected:
+    /**
+     * @internal
+     * @test @a ForkJoinTest.Exception
+     */
+    void rethrow_if_exception() const
+    {
+        if (this->m_exception != nullptr) {
+            std::rethrow_exception(this->m_exception);
+        }
+    }
+
+private:
+    std::exception_ptr m_exception = nullptr;  ///< The exception thrown by the task.
+
+    friend Promise;  ///< Derived classes need to access the constructor.
+
+    /** @brief Default constructor. */
+    parallel_promise_base() noexcept = default;
+};
+// NOLINTEND(readability-convert-member-functions-to-static)
+
+template<typename T>
+struct parallel_promise : parallel_promise_base<parallel_promise<T>> {
+    auto get_return_object() { return parallel_task<T>{std::coroutine_handle<parallel_promise>::from_promise(*this)}; }
+
+    void return_value(T res) noexcept(std::is_nothrow_move_constructible_v<T>)
+    {
+        this->m_result.emplace(std::move(res));
+    }
+
+    T& result_value()
+    {
+        this->rethrow_if_exception();
+        return *this->m_result;
+    }
+
+private:
+    std::optional<T> m_result;  ///< The result produced by the task.
+};
+
+template<>
+struct parallel_promise<void> : parallel_promise_base<parallel_promise<void>> {
+    parallel_task<void> get_return_object();
+    void return_void() const noexcept {}
+    void result_value() const { this->rethrow_if_exception(); }
+};
+
+}  // namespace detail
+/// @endcond
+
+/** @brief Options of `fork_join_pool`. */
+struct fork_join_pool_options {
+    std::size_t threads        = 0;    ///< The number of workers; 0 means one per hardware thread.
+    std::size_t deque_capacity = 256;  ///< Initial capacity of the deque of every worker; grows on demand.
+    std::size_t spins          = 512;  ///< How many times an idle worker looks for work with `pause` before yielding.
+    std::size_t yields         = 8;    ///< How many times an idle worker yields the CPU before it sleeps.
+    std::size_t budget         = 128;  ///< Transfers per resumption; see `thread_pool_options::budget`.
+};
+
+/**
+ * @brief A pool of workers that run `parallel_task`s and steal forked tasks from one another.
+ *
+ * Every worker owns a work-stealing deque (Chase-Lev). `t.fork()` pushes a task that has not started yet to the
+ * bottom of the deque of the worker running the parent; `co_await t` pops it back and runs it inline, like a plain
+ * call, unless an idle worker has stolen it from the top in the meantime. Stolen tasks run in parallel with
+ * the parent; the parent suspends at `co_await t` only if the stolen task has not finished by then, and the worker
+ * that finishes it continues the parent. Recursive divide-and-conquer code thus spreads over the pool from the
+ * top of the recursion down, while the bottom of the recursion runs serially on each worker.
+ *
+ * Coroutines enter the pool with `co_await pool.schedule()`. Frames of `parallel_task`s started on a worker come
+ * from a frame arena of the worker (see `detail::frame_arena`).
+ *
+ * Every resumption may continue at most `fork_join_pool_options::budget` coroutines by symmetric transfer; then the
+ * continuation goes back to the pool, which also bounds the depth of the stack where transfers are not tail calls.
+ *
+ * An idle worker keeps looking for work for a while (`fork_join_pool_options::spins` and `yields`) before it sleeps;
+ * forking only makes a system call when a worker actually sleeps.
+ *
+ * Example:
+ * @snippet fork_join.cpp fork_join example
+ */
+class fork_join_pool {
+public:
+    class schedule_op;
+
+    /**
+     * @brief Constructs a new pool and starts its workers.
+     *
+     * @param options The options.
+     * @throw std::invalid_argument if `deque_capacity` is zero.
+     *
+     * @internal
+     * @test @a ForkJoinTest.InvalidOptions
+     */
+    explicit fork_join_pool(const fork_join_pool_options& options = {}) : m_options(options)
+    {
+        if (this->m_options.deque_capacity == 0) {
+            throw std::invalid_argument("Invalid deque_capacity");
+        }
+
+        if (this->m_options.threads == 0) {
+            this->m_options.threads = std::max(1U, std::thread::hardware_concurrency());
+        }
+
+        for (std::size_t i = 0; i < this->m_options.threads; ++i) {
+            this->m_workers.push_back(std::make_unique<worker>(this->m_options.deque_capacity, &this->m_idle));
+        }
+
+        for (std::size_t i = 0; i < this->m_options.threads; ++i) {
+            this->m_workers[i]->m_thread = std::thread([this, i] { this->run(i); });
+        }
+    }
+
+    /// @cond
+    fork_join_pool(const fork_join_pool&)            = delete;
+    fork_join_pool(fork_join_pool&&)                 = delete;
+    fork_join_pool& operator=(const fork_join_pool&) = delete;
+    fork_join_pool& operator=(fork_join_pool&&)      = delete;
+    /// @endcond
+
+    /**
+     * @brief Destructor.
+     *
+     * The workers run all queued and forked work to its next suspension point, then stop.
+     */
+    ~fork_join_pool()
+    {
+        this->m_stop.store(true, std::memory_order_seq_cst);
+        this->m_idle.notify_all();
+        for (auto& w : this->m_workers) {
+            w->m_thread.join();
+        }
+    }
+
+    /**
+     * @brief Returns the number of workers.
+     *
+     * @return The number of workers.
+     */
+    [[nodiscard]] std::size_t size() const noexcept { return this->m_workers.size(); }
+
+    /**
+     * @brief Returns how many forked tasks idle workers have stolen so far.
+     *
+     * @return The number of steals.
+     *
+     * @internal
+     * @test @a ForkJoinTest.Steal
+     */
+    [[nodiscard]] std::size_t steals() const noexcept { return this->m_steals.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Moves the awaiting coroutine to the pool.
+     *
+     * @return An awaitable.
+     *
+     * @internal
+     * @test @a ForkJoinTest.Fibonacci
+     */
+    [[nodiscard]] schedule_op schedule() noexcept { return schedule_op{*this}; }
+
+    /**
+     * @brief Awaitable for the schedule operation.
+     *
+     * @see fork_join_pool::schedule()
+     */
+    class [[nodiscard]] schedule_op : private detail::resume_node {
+    public:
+        /// @cond INTERNAL
+        /**
+         * @brief Constructs a new operation.
+         *
+         * @param pool The pool.
+         */
+        explicit schedule_op(fork_join_pool& pool) noexcept : m_pool(pool) {}
+        /// @endcond
+
+        /**
+         * @brief Always suspends.
+         *
+         * @return `false`
+         */
+        [[nodiscard]] constexpr bool await_ready() const noexcept { return false; }
+
+        /**
+         * @brief Queues the coroutine.
+         *
+         * @param h The awaiting coroutine.
+         */
+        void await_suspend(std::coroutine_handle<> h) noexcept
+        {
+            this->m_handle = h;
+            this->m_pool.inject(this);
+        }
+
+        /** @brief Does nothing. */
+        constexpr void await_resume() const noexcept {}
+
+    private:
+        fork_join_pool& m_pool;  ///< The pool.
+    };
+
+private:
+    /** @brief A worker. */
+    struct alignas(detail::cache_line_size) worker : detail::fork_worker {
+        detail::frame_arena m_frames;  ///< Frames of tasks; thread-owned.
+        std::thread m_thread;          ///< The thread of the worker.
+
+        using detail::fork_worker::fork_worker;
+    };
+
+    fork_join_pool_options m_options;                          ///< The options.
+    std::vector<std::unique_ptr<worker>> m_workers;            ///< The workers.
+    detail::eventcount m_idle;                                 ///< Parks workers that have no work.
+    std::atomic<std::size_t> m_steals = 0;                     ///< Forked tasks taken by other workers.
+    std::atomic<bool> m_stop          = false;                 ///< Whether the pool is being destroyed.
+    alignas(detail::cache_line_size) detail::spinlock m_lock;  ///< Guards `m_injected`.
+    detail::intrusive_queue<detail::resume_node> m_injected;   ///< Coroutines scheduled onto the pool.
+    std::atomic<std::size_t> m_injected_size = 0;              ///< The length of `m_injected`.
+
+    /**
+     * @brief Queues a coroutine on the pool; may be called from any thread.
+     *
+     * @param node The coroutine.
+     */
+    void inject(detail::resume_node* node) noexcept
+    {
+        {
+            const std::scoped_lock lock(this->m_lock);
+            this->m_injected.push_back(node);
+            this->m_injected_size.fetch_add(1, std::memory_order_seq_cst);
+        }
+
+        this->m_idle.notify_one();
+    }
+
+    /**
+     * @brief Queues a coroutine that has run on the pool before; used by `yield_now()`, budgets, and `offload()`.
+     *
+     * @param pool The pool.
+     * @param node The coroutine.
+     */
+    static void reschedule(void* pool, detail::resume_node* node, std::size_t) noexcept
+    {
+        static_cast<fork_join_pool*>(pool)->inject(node);
+    }
+
+    /**
+     * @brief Finds a coroutine to run: pops the own deque, then takes a scheduled coroutine, then steals.
+     *
+     * @param index The index of the calling worker.
+     * @return The coroutine; `nullptr` if there is no work.
+     */
+    std::coroutine_handle<> find_work(std::size_t index) noexcept
+    {
+        worker& self = *this->m_workers[index];
+        if (void* frame = self.m_deque.pop(); frame != nullptr) {
+            return std::coroutine_handle<>::from_address(frame);
+        }
+
+        if (this->m_injected_size.load(std::memory_order_seq_cst) != 0) {
+            const std::scoped_lock lock(this->m_lock);
+            if (detail::resume_node* node = this->m_injected.pop_front(); node != nullptr) {
+                this->m_injected_size.fetch_sub(1, std::memory_order_relaxed);
+                return node->m_handle;
+            }
+        }
+
+        const std::size_t n     = this->m_workers.size();
+        const std::size_t start = detail::fast_random() % n;
+        for (std::size_t i = 0; i < n; ++i) {
+            const std::size_t victim = (start + i) % n;
+            if (victim == index) {
+                continue;
+            }
+
+            if (void* frame = this->m_workers[victim]->m_deque.steal(); frame != nullptr) {
+                this->m_steals.fetch_add(1, std::memory_order_relaxed);
+                return std::coroutine_handle<>::from_address(frame);
+            }
+        }
+
+        return nullptr;
+    }
+
+    /**
+     * @brief Checks whether any worker has something to take.
+     *
+     * @return Whether there is work.
+     */
+    [[nodiscard]] bool has_work() const noexcept
+    {
+        return this->m_injected_size.load(std::memory_order_seq_cst) != 0 ||
+               std::ranges::any_of(this->m_workers, [](const std::unique_ptr<worker>& w) {
+                   return !w->m_deque.empty();
+               });
+    }
+
+    /**
+     * @brief Waits until there is work or the pool stops: spins, then yields, then sleeps.
+     *
+     * @return Whether the worker should go on; `false` once the pool stops and no work is left.
+     */
+    bool idle()
+    {
+        const auto stopped = [this] { return this->m_stop.load(std::memory_order_seq_cst); };
+
+        for (std::size_t i = 0; i < this->m_options.spins; ++i) {
+            if (this->has_work() || stopped()) {
+                return this->has_work() || !stopped();
+            }
+
+            detail::cpu_relax();
+        }
+
+        for (std::size_t i = 0; i < this->m_options.yields; ++i) {
+            if (this->has_work() || stopped()) {
+                return this->has_work() || !stopped();
+            }
+
+            std::this_thread::yield();
+        }
+
+        const detail::eventcount::key key = this->m_idle.prepare_wait();
+        if (this->has_work() || stopped()) {
+            this->m_idle.cancel_wait();
+            return this->has_work() || !stopped();
+        }
+
+        this->m_idle.wait(key);
+        return true;
+    }
+
+    /**
+     * @brief The body of a worker thread.
+     *
+     * @param index The index of the worker.
+     */
+    void run(std::size_t index)
+    {
+        worker& self                = *this->m_workers[index];
+        detail::fork_worker*& ctx   = detail::fork_worker::current();
+        detail::coop_context& coop  = detail::coop();
+        detail::frame_arena*& arena = detail::frame_arena::current();
+        ctx                         = &self;
+        coop                        = {this, &fork_join_pool::reschedule, 0, 0};
+        arena                       = &self.m_frames;
+
+        for (;;) {
+            if (const std::coroutine_handle<> h = this->find_work(index); h) {
+                coop.m_budget = this->m_options.budget;
+                h.resume();
+            }
+            else if (!this->idle()) {
+                break;
+            }
+        }
+
+        ctx   = nullptr;
+        coop  = {};
+        arena = nullptr;
+    }
+};
+
+/**
+ * @brief A lazily started coroutine that can be forked to run in parallel with its parent.
+ *
+ * A `parallel_task` starts when it is awaited, like `task<>`: `co_await t` runs it inline by symmetric transfer.
+ * On a worker of a `fork_join_pool`, `t.fork()` first offers the task to idle workers; `co_await t` then joins it:
+ * if no worker has taken the task, the parent runs it inline, and the fork has cost a push and a pop on a deque
+ * that only the worker touches; otherwise the parent waits for the task to finish and continues on the thread that
+ * finishes it. Outside a pool, `fork()` does nothing.
+ *
+ * Example:
+ * @snippet fork_join.cpp fork_join example
+ *
+ * @tparam T The type of the result; not a reference.
+ * @warning A forked task must be awaited before it is destroyed.
+ */
+template<typename T = void>
+class [[nodiscard]] parallel_task {
+public:
+    static_assert(!std::is_reference_v<T>, "parallel_task<T> does not support references");
+
+    /** @brief The promise type associated with the task. */
+    using promise_type = detail::parallel_promise<T>;
+
+    /** @brief Default constructor. */
+    parallel_task() noexcept = default;
+
+    /// @cond
+    parallel_task(const parallel_task&)            = delete;
+    parallel_task& operator=(const parallel_task&) = delete;
+    /// @endcond
+
+    /**
+     * @brief Move constructor.
+     *
+     * A forked task may be moved: workers refer to its frame, not to this object.
+     */
+    parallel_task(parallel_task&& other) noexcept : m_coroutine(std::exchange(other.m_coroutine, nullptr)) {}
+
+    /** @brief Move assignment operator. */
+    parallel_task& operator=(parallel_task&& other) noexcept
+    {
+        if (this != std::addressof(other)) {
+            this->reset();
+            this->m_coroutine = std::exchange(other.m_coroutine, nullptr);
+        }
+
+        return *this;
+    }
+
+    /** @brief Destructor. */
+    ~parallel_task() { this->reset(); }
+
+    /**
+     * @brief Offers the task to idle workers of the pool that runs the calling thread.
+     *
+     * Does nothing outside a `fork_join_pool`, or if the task has already been forked.
+     *
+     * @internal
+     * @test @a ForkJoinTest.Steal
+     * @test @a ForkJoinTest.Inline
+     */
+    void fork()
+    {
+        detail::fork_worker* self = detail::fork_worker::current();
+        if (self != nullptr && this->m_coroutine && this->m_coroutine.promise().m_home == nullptr) {
+            this->m_coroutine.promise().m_home = self;
+            self->m_deque.push(this->m_coroutine.address());
+            self->m_idle->notify_one();
+        }
+    }
+
+    /**
+     * @brief Runs or joins the task.
+     *
+     * @return An awaiter that produces a reference to the result of the task.
+     *
+     * @internal
+     * @test @a ForkJoinTest.Fibonacci
+     * @test @a ForkJoinTest.JoinOrder
+     * @test @a ForkJoinTest.Exception
+     */
+    auto operator co_await() & noexcept { return awaiter{this->m_coroutine}; }
+
+    /**
+     * @brief Runs or joins the task.
+     *
+     * @return An awaiter that produces the result of the task, moved out of it.
+     *
+     * @internal
+     * @test @a ForkJoinTest.MergeSort
+     */
+    auto operator co_await() && noexcept
+    {
+        struct rvalue_awaiter : awaiter {
+            decltype(auto) await_resume()
+            {
+                if constexpr (std::is_void_v<T>) {
+                    this->awaiter::await_resume();
+                }
+                else {
+                    return std::move(this->awaiter::await_resume());
+                }
+            }
+        };
+
+        return rvalue_awaiter{{this->m_coroutine}};
+    }
+
+private:
+    std::coroutine_handle<promise_type> m_coroutine;  ///< The coroutine handle associated with the task.
+
+    friend promise_type;  ///< The `promise_type` needs access to the constructor.
+
+    /** @brief Awaiter that runs or joins the task. */
+    struct awaiter {
+        /**
+         * @brief Checks whether a forked task has finished.
+         *
+         * @return Whether the result is available.
+         */
+        [[nodiscard]] bool await_ready() const noexcept
+        {
+            return !this->coroutine || (this->coroutine.promise().m_home != nullptr &&
+                                        this->coroutine.promise().m_state.load(std::memory_order_acquire) ==
+                                            detail::fork_state::finished);
+        }
+
+        /**
+         * @brief Runs the task inline if nobody has taken it, or waits for it.
+         *
+         * @param h The awaiting coroutine.
+         * @return The coroutine to continue.
+         */
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> h) noexcept
+        {
+            promise_type& promise = this->coroutine.promise();
+            if (promise.m_home == nullptr) {
+                promise.m_next = h;
+                return detail::transfer(this->node, this->coroutine);
+            }
+
+            if (promise.m_home == detail::fork_worker::current()) {
+                // Tasks forked after this one sit above it; they have to run anyway, so run them now
+                while (void* frame = promise.m_home->m_deque.pop()) {
+                    if (frame == this->coroutine.address()) {
+                        promise.m_next = h;
+                        return detail::transfer(this->node, this->coroutine);
+                    }
+
+                    std::coroutine_handle<>::from_address(frame).resume();
+                    if (promise.m_state.load(std::memory_order_acquire) == detail::fork_state::finished) {
+                        return detail::transfer(this->node, h);
+                    }
+                }
+            }
+
+            promise.m_joiner = h;
+            return promise.m_state.exchange(detail::fork_state::joining, std::memory_order_acq_rel) ==
+                           detail::fork_state::finished
+                       ? detail::transfer(this->node, h)
+                       : std::noop_coroutine();
+        }
+
+        /**
+         * @brief Returns the result of the task.
+         *
+         * @return The result.
+         * @throw bad_task The task is empty.
+         */
+        decltype(auto) await_resume()
+        {
+            detail::check_coroutine(this->coroutine);
+            return this->coroutine.promise().result_value();
+        }
+
+        // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+        std::coroutine_handle<promise_type> coroutine;
+        detail::resume_node node = {};  ///< Queues the task when the budget runs out.
+        // NOLINTEND(misc-non-private-member-variables-in-classes)
+    };
+
+    /**
+     * @brief Constructor.
+     *
+     * @param handle The coroutine handle.
+     */
+    explicit parallel_task(std::coroutine_handle<promise_type> handle) : m_coroutine(handle) {}
+
+    /** @brief Destroys the coroutine, if any. */
+    void reset() noexcept
+    {
+        if (this->m_coroutine) {
+            assert(this->m_coroutine.promise().m_home == nullptr || this->m_coroutine.done());
+            this->m_coroutine.destroy();
+            this->m_coroutine = nullptr;
+        }
+    }
+};
+
+/**
+ * @example fork_join.cpp
+ * Example of parallel Fibonacci numbers and a parallel merge sort.
+ */
+
+/// @cond INTERNAL
+
+inline parallel_task<void> detail::parallel_promise<void>::get_return_object()
+{
+    return parallel_task<void>{std::coroutine_handle<parallel_promise>::from_promise(*this)};
+}
+
+/// @endcond
+
+}  // namespace wwa::coro
+
+#endif /* E3C5A917_4B2D_4F08_9A6E_71D0B84F2C35 */
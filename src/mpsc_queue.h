@@ -0,0 +1,440 @@
+#ifndef C3E61B84_0F7A_4D29_A5B8_6E92D1C47F30
+#define C3E61B84_0F7A_4D29_A5B8_6E92D1C47F30
+
+/**
+ * @file mpsc_queue.h
+ * @brief Intrusive unbounded multi-producer single-consumer queue.
+ *
+ * This file contains the definition of the `mpsc_queue` class template. Producers push nodes with a single atomic
+ * exchange; the consumer takes all pending nodes at once with `co_await q.pop_all()`.
+ *
+ * Example:
+ * @snippet mpsc_queue.cpp mpsc_queue example
+ */
+
+#include <atomic>
+#include <concepts>
+#include <coroutine>
+#include <cstddef>
+#include <iterator>
+
+#include "detail.h"
+
+namespace wwa::coro {
+
+/**
+ * @brief Hook for nodes of `mpsc_queue`.
+ *
+ * Types stored in an `mpsc_queue` derive from this class. Copying a node does not copy its link.
+ */
+class mpsc_queue_hook {
+public:
+    /** @brief Default constructor. */
+    mpsc_queue_hook() noexcept = default;
+
+    /// @cond
+    mpsc_queue_hook(const mpsc_queue_hook&) noexcept {}
+    mpsc_queue_hook& operator=(const mpsc_queue_hook&) noexcept { return *this; }
+    ~mpsc_queue_hook() = default;
+    /// @endcond
+
+private:
+    template<typename>
+    friend class mpsc_queue;
+
+    std::atomic<mpsc_queue_hook*> m_next = nullptr;  ///< Next node in the queue.
+};
+
+/**
+ * @brief An intrusive unbounded multi-producer single-consumer queue with batch drain.
+ *
+ * This is Dmitry Vyukov's intrusive MPSC queue. `push()` is wait-free: a single atomic exchange on the head pointer,
+ * followed by a store that links the previous node to the new one. The queue never allocates; nodes are owned by
+ * the user and must stay alive until the consumer has taken them.
+ *
+ * The consumer never takes nodes one by one. `co_await q.pop_all()` detaches all pending nodes in one step and returns
+ * them as a `batch`, in the order they were pushed; this amortizes the cache line transfers between the producers
+ * and the consumer over the whole batch. The consumer suspends only when the queue is empty; the producer whose push
+ * makes the queue non-empty again resumes it inline. Producers that push to a non-empty queue never touch
+ * the consumer's state.
+ *
+ * Example:
+ * @snippet mpsc_queue.cpp mpsc_queue example
+ *
+ * @tparam T The type of the nodes; must derive from `mpsc_queue_hook`.
+ */
+template<typename T>
+class mpsc_queue {
+public:
+    /** @brief The type of the nodes. */
+    using value_type = T;
+
+    class batch;
+    class pop_all_op;
+
+    /** @brief Default constructor. */
+    mpsc_queue() noexcept = default;
+
+    /// @cond
+    mpsc_queue(const mpsc_queue&)            = delete;
+    mpsc_queue(mpsc_queue&&)                 = delete;
+    mpsc_queue& operator=(const mpsc_queue&) = delete;
+    mpsc_queue& operator=(mpsc_queue&&)      = delete;
+    /// @endcond
+
+    /**
+     * @brief Destructor.
+     *
+     * @warning The consumer must not be suspended on the queue when it is destroyed; call `close()` first.
+     */
+    ~mpsc_queue() = default;
+
+    /**
+     * @brief Appends a node to the queue.
+     *
+     * The call is wait-free. If the consumer is suspended in `pop_all()`, it is resumed inline by this call.
+     *
+     * @param node The node; must not be in any queue.
+     *
+     * @internal
+     * @test @a MpscQueueTest.PushPopAll
+     * @test @a MpscQueueTest.ConsumerSuspendsWhenEmpty
+     */
+    void push(T* node)
+    {
+        mpsc_queue_hook* hook = node;
+        hook->m_next.store(nullptr, std::memory_order_relaxed);
+        mpsc_queue_hook* prev = this->m_head.exchange(hook, std::memory_order_acq_rel);
+        prev->m_next.store(hook, std::memory_order_release);
+
+        if (prev == &this->m_stub) {
+            // The queue was empty: the consumer may be waiting
+            this->wake();
+        }
+    }
+
+    /**
+     * @brief Checks whether the queue is empty.
+     *
+     * @return Whether the queue is empty; the value may be stale by the time it is returned.
+     */
+    [[nodiscard]] bool empty() const noexcept { return this->m_head.load(std::memory_order_acquire) == &this->m_stub; }
+
+    /**
+     * @brief Detaches all pending nodes without suspending.
+     *
+     * May only be called by the consumer.
+     *
+     * @return The pending nodes; an empty batch if the queue is empty.
+     *
+     * @internal
+     * @test @a MpscQueueTest.PushPopAll
+     */
+    [[nodiscard]] batch try_pop_all() noexcept
+    {
+        if (this->empty()) {
+            return batch{};
+        }
+
+        mpsc_queue_hook* first = wait_next(&this->m_stub);
+        this->m_stub.m_next.store(nullptr, std::memory_order_relaxed);
+
+        // Re-insert the stub to cut the batch off; producers that come after this point link to the stub
+        mpsc_queue_hook* last = this->m_head.exchange(&this->m_stub, std::memory_order_acq_rel);
+        last->m_next.store(&this->m_stub, std::memory_order_release);
+        return batch{first, &this->m_stub};
+    }
+
+    /**
+     * @brief Detaches all pending nodes.
+     *
+     * May only be called by the consumer. The awaiting coroutine suspends while the queue is empty.
+     *
+     * @return An awaitable that yields a `batch`; an empty batch means that the queue is closed and empty.
+     *
+     * @internal
+     * @test @a MpscQueueTest.ConsumerSuspendsWhenEmpty
+     * @test @a MpscQueueTest.CrossThread
+     */
+    [[nodiscard]] pop_all_op pop_all() noexcept { return pop_all_op{*this}; }
+
+    /**
+     * @brief Closes the queue and resumes the consumer if it is suspended.
+     *
+     * Once the queue is closed and empty, `pop_all()` yields an empty batch instead of suspending. Nodes pushed
+     * after `close()` are still delivered.
+     *
+     * @internal
+     * @test @a MpscQueueTest.Close
+     */
+    void close()
+    {
+        this->m_closed.store(true, std::memory_order_release);
+        this->wake();
+    }
+
+    /**
+     * @brief Checks whether the queue has been closed.
+     *
+     * @return Whether the queue has been closed.
+     */
+    [[nodiscard]] bool is_closed() const noexcept { return this->m_closed.load(std::memory_order_acquire); }
+
+    /**
+     * @brief A batch of nodes detached from the queue.
+     *
+     * The batch is a forward range of `T&`, in the order the nodes were pushed. The link to the next node is read
+     * before a node is handed out, so the node may be pushed to a queue (including this one) or destroyed while
+     * the batch is being iterated. Nodes of a batch that is discarded without iteration are simply not visited.
+     */
+    class batch {
+    public:
+        /** @brief Iterator over the nodes of a batch. */
+        class iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;  ///< Iterator category.
+            using difference_type   = std::ptrdiff_t;             ///< Difference type.
+            using value_type        = T;                          ///< Value type.
+            using pointer           = T*;                         ///< Pointer type.
+            using reference         = T&;                         ///< Reference type.
+
+            /** @brief Constructs an end iterator. */
+            iterator() noexcept = default;
+
+            /// @cond INTERNAL
+            /**
+             * @brief Constructs a new iterator.
+             *
+             * @param node The current node.
+             * @param end The node that terminates the batch.
+             */
+            iterator(mpsc_queue_hook* node, mpsc_queue_hook* end) noexcept : m_end(end) { this->step(node); }
+            /// @endcond
+
+            /**
+             * @brief Returns the current node.
+             *
+             * @return The current node.
+             */
+            [[nodiscard]] reference operator*() const noexcept { return *static_cast<T*>(this->m_node); }
+
+            /**
+             * @brief Returns a pointer to the current node.
+             *
+             * @return Pointer to the current node.
+             */
+            [[nodiscard]] pointer operator->() const noexcept { return static_cast<T*>(this->m_node); }
+
+            /**
+             * @brief Advances to the next node.
+             *
+             * @return Reference to this iterator.
+             */
+            iterator& operator++() noexcept
+            {
+                this->step(this->m_following);
+                return *this;
+            }
+
+            /**
+             * @brief Advances to the next node.
+             *
+             * @return Copy of the iterator before advancing.
+             */
+            iterator operator++(int) noexcept
+            {
+                iterator tmp = *this;
+                ++*this;
+                return tmp;
+            }
+
+            /**
+             * @brief Compares two iterators.
+             *
+             * @param other The iterator to compare with.
+             * @return Whether the iterators point to the same node.
+             */
+            [[nodiscard]] bool operator==(const iterator& other) const noexcept
+            {
+                return this->m_node == other.m_node;
+            }
+
+        private:
+            mpsc_queue_hook* m_node      = nullptr;  ///< The current node; `nullptr` at the end.
+            mpsc_queue_hook* m_following = nullptr;  ///< The node after the current one.
+            mpsc_queue_hook* m_end       = nullptr;  ///< The node that terminates the batch.
+
+            /**
+             * @brief Moves to the given node and reads its link.
+             *
+             * @param node The node to move to.
+             */
+            void step(mpsc_queue_hook* node) noexcept
+            {
+                if (node == this->m_end) {
+                    this->m_node = nullptr;
+                }
+                else {
+                    this->m_node      = node;
+                    this->m_following = wait_next(node);
+                }
+            }
+        };
+
+        /** @brief Constructs an empty batch. */
+        batch() noexcept = default;
+
+        /// @cond INTERNAL
+        /**
+         * @brief Constructs a new batch.
+         *
+         * @param first The first node.
+         * @param end The node that terminates the batch.
+         */
+        batch(mpsc_queue_hook* first, mpsc_queue_hook* end) noexcept : m_first(first), m_end(end) {}
+        /// @endcond
+
+        /**
+         * @brief Checks whether the batch is empty.
+         *
+         * @return Whether the batch is empty.
+         */
+        [[nodiscard]] constexpr bool empty() const noexcept { return this->m_first == this->m_end; }
+
+        /**
+         * @brief Returns an iterator to the first node.
+         *
+         * @return Iterator to the first node.
+         * @warning A batch can be iterated only once.
+         */
+        [[nodiscard]] iterator begin() const noexcept { return iterator{this->m_first, this->m_end}; }
+
+        /**
+         * @brief Returns the end iterator.
+         *
+         * @return The end iterator.
+         */
+        [[nodiscard]] iterator end() const noexcept { return iterator{}; }
+
+    private:
+        mpsc_queue_hook* m_first = nullptr;  ///< The first node.
+        mpsc_queue_hook* m_end   = nullptr;  ///< The node that terminates the batch.
+    };
+
+    /**
+     * @brief Awaitable for the `pop_all()` operation.
+     *
+     * @see mpsc_queue::pop_all()
+     */
+    class [[nodiscard]] pop_all_op {
+    public:
+        /// @cond INTERNAL
+        /**
+         * @brief Constructs a new operation.
+         *
+         * @param q The queue.
+         */
+        explicit pop_all_op(mpsc_queue& q) noexcept : m_queue(q) {}
+        /// @endcond
+
+        /**
+         * @brief Tries to take the pending nodes without suspending.
+         *
+         * @return Whether the operation has completed.
+         */
+        bool await_ready() noexcept
+        {
+            this->m_batch = this->m_queue.try_pop_all();
+            return !this->m_batch.empty() || this->m_queue.is_closed();
+        }
+
+        /**
+         * @brief Parks the consumer until a node is pushed or the queue is closed.
+         *
+         * @param h The awaiting coroutine.
+         * @return Whether the coroutine should stay suspended.
+         */
+        bool await_suspend(std::coroutine_handle<> h) noexcept
+        {
+            // Once the handle is published, the consumer may be resumed by a producer at any moment;
+            // the awaiter must not be touched until the handle is taken back.
+            mpsc_queue& q = this->m_queue;
+            q.m_waiter.store(h.address(), std::memory_order_release);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            if (q.empty() && !q.is_closed()) {
+                return true;
+            }
+
+            return q.m_waiter.exchange(nullptr, std::memory_order_acquire) == nullptr;
+        }
+
+        /**
+         * @brief Returns the detached nodes.
+         *
+         * @return The detached nodes; an empty batch if the queue is closed and empty.
+         */
+        batch await_resume() noexcept
+        {
+            if (this->m_batch.empty()) {
+                this->m_batch = this->m_queue.try_pop_all();
+            }
+
+            return this->m_batch;
+        }
+
+    private:
+        mpsc_queue& m_queue;  ///< The queue.
+        batch m_batch;        ///< The detached nodes.
+    };
+
+private:
+    mpsc_queue_hook m_stub;  ///< Marks the consumer's end.
+    alignas(detail::cache_line_size) std::atomic<mpsc_queue_hook*> m_head = &this->m_stub;  ///< The last pushed node.
+    alignas(detail::cache_line_size) std::atomic<void*> m_waiter = nullptr;  ///< The suspended consumer.
+    std::atomic<bool> m_closed                                   = false;    ///< Whether the queue is closed.
+
+    /**
+     * @brief Returns the node after @a node, waiting for a producer that is about to link it.
+     *
+     * A producer publishes its node with the exchange on the head pointer and links it to the previous node
+     * right after; in between, the chain is broken for the duration of a few instructions.
+     *
+     * @param node The node; must not be the last node of the queue.
+     * @return The next node.
+     */
+    static mpsc_queue_hook* wait_next(mpsc_queue_hook* node) noexcept
+    {
+        mpsc_queue_hook* next = nullptr;
+        while ((next = node->m_next.load(std::memory_order_acquire)) == nullptr) {
+            detail::cpu_relax();
+        }
+
+        return next;
+    }
+
+    /**
+     * @brief Resumes the consumer if it is suspended.
+     *
+     * The fence pairs with the one in `pop_all_op::await_suspend()`: either the producer sees the parked consumer,
+     * or the consumer sees the pushed node.
+     */
+    void wake()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (this->m_waiter.load(std::memory_order_relaxed) != nullptr) {
+            if (void* addr = this->m_waiter.exchange(nullptr, std::memory_order_acquire); addr != nullptr) {
+                std::coroutine_handle<>::from_address(addr).resume();
+            }
+        }
+    }
+};
+
+/**
+ * @example mpsc_queue.cpp
+ * Example of draining requests from many producers in batches.
+ */
+
+}  // namespace wwa::coro
+
+#endif /* C3E61B84_0F7A_4D29_A5B8_6E92D1C47F30 */
@@ -0,0 +1,419 @@
+#ifndef C9F1E27A_5B3D_4E80_A6C4_2D7B91F05E63
+#define C9F1E27A_5B3D_4E80_A6C4_2D7B91F05E63
+
+/**
+ * @file offload.h
+ * @brief Running blocking calls off the calling executor.
+ *
+ * This file contains the definition of the `blocking_pool` class and the `offload()` function.
+ * `co_await offload(fn, args...)` runs a synchronous function on a thread of a blocking pool and resumes the awaiting
+ * coroutine on the executor it came from, with the result of the function or its exception.
+ *
+ * Example:
+ * @snippet offload.cpp offload example
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "detail.h"
+
+namespace wwa::coro {
+
+/// @cond INTERNAL
+namespace detail {
+
+/** @brief A call queued on a blocking pool; lives in the frame of the awaiting coroutine. */
+struct offload_node : intrusive_hook<offload_node> {
+    void (*m_run)(offload_node*) noexcept = nullptr;  ///< Makes the call and resumes the caller.
+};
+
+}  // namespace detail
+/// @endcond
+
+/** @brief Options of `blocking_pool`. */
+struct blocking_pool_options {
+    std::size_t max_threads              = 64;  ///< The most threads the pool may run at once.
+    std::chrono::milliseconds keep_alive = std::chrono::seconds(10);  ///< How long an idle thread waits before exiting.
+};
+
+/**
+ * @brief A pool of threads for blocking calls.
+ *
+ * The pool starts a thread whenever a call is submitted and no idle thread is left to take it, up to
+ * `blocking_pool_options::max_threads`; after that, calls wait in a FIFO queue. A thread that has been idle for
+ * `blocking_pool_options::keep_alive` exits, so the pool shrinks back when the load goes away.
+ *
+ * Calls are submitted with `co_await pool.offload(fn, args...)`. The awaiter holds the function, the arguments, and
+ * the result, and is the queue node, so an offloaded call does not allocate.
+ *
+ * Example:
+ * @snippet offload.cpp offload example
+ */
+class blocking_pool {
+public:
+    template<typename F, typename... Args>
+    class offload_op;
+
+    /**
+     * @brief Constructs a new pool; threads are started on demand.
+     *
+     * @param options The options.
+     * @throw std::invalid_argument if `max_threads` is zero.
+     *
+     * @internal
+     * @test @a OffloadTest.InvalidOptions
+     */
+    explicit blocking_pool(const blocking_pool_options& options = {}) : m_options(options)
+    {
+        if (this->m_options.max_threads == 0) {
+            throw std::invalid_argument("Invalid max_threads");
+        }
+    }
+
+    /// @cond
+    blocking_pool(const blocking_pool&)            = delete;
+    blocking_pool(blocking_pool&&)                 = delete;
+    blocking_pool& operator=(const blocking_pool&) = delete;
+    blocking_pool& operator=(blocking_pool&&)      = delete;
+    /// @endcond
+
+    /**
+     * @brief Destructor.
+     *
+     * Waits until the queued calls have been made and all threads have exited.
+     */
+    ~blocking_pool()
+    {
+        std::vector<std::thread> threads;
+        {
+            std::unique_lock lock(this->m_mutex);
+            this->m_stop = true;
+            this->m_work.notify_all();
+            this->m_exited.wait(lock, [this] { return this->m_threads == 0; });
+            threads = std::move(this->m_handles);
+        }
+
+        for (auto& t : threads) {
+            t.join();
+        }
+    }
+
+    /**
+     * @brief Returns the process-wide blocking pool.
+     *
+     * The pool is created on first use and is never destroyed: its destructor would wait for threads that a process
+     * forked from this one does not have, so that process could never exit. Idle threads still exit after
+     * `blocking_pool_options::keep_alive`.
+     *
+     * @return The default pool.
+     *
+     * @internal
+     * @test @a OffloadDeathTest.ExitAfterFork
+     */
+    static blocking_pool& instance()
+    {
+        static auto* pool = new blocking_pool;  // NOLINT(cppcoreguidelines-owning-memory)
+        return *pool;
+    }
+
+    /**
+     * @brief Runs a function on a thread of the pool.
+     *
+     * The function and the arguments are moved into the awaiter. When the call returns, the awaiting coroutine is
+     * queued on the executor that ran it (the priority is kept on a `thread_pool`), or resumed on the thread of the
+     * pool if it did not run on an executor.
+     *
+     * @tparam F The type of the function.
+     * @tparam Args The types of the arguments.
+     * @param fn The function.
+     * @param args The arguments.
+     * @return An awaitable that yields the result of the function or rethrows its exception.
+     *
+     * @internal
+     * @test @a OffloadTest.ResumesOnExecutor
+     * @test @a OffloadTest.Exception
+     */
+    template<typename F, typename... Args>
+    requires std::is_invocable_v<std::decay_t<F>&, std::decay_t<Args>&...>
+    [[nodiscard]] offload_op<std::decay_t<F>, std::decay_t<Args>...> offload(F&& fn, Args&&... args)
+    {
+        return offload_op<std::decay_t<F>, std::decay_t<Args>...>{
+            *this, std::forward<F>(fn), std::forward<Args>(args)...
+        };
+    }
+
+    /**
+     * @brief Returns the number of running threads.
+     *
+     * @return The number of threads, busy or idle.
+     *
+     * @internal
+     * @test @a OffloadTest.Grows
+     */
+    [[nodiscard]] std::size_t threads() const
+    {
+        const std::scoped_lock lock(this->m_mutex);
+        return this->m_threads;
+    }
+
+    /**
+     * @brief Awaitable for an offloaded call.
+     *
+     * @tparam F The type of the function.
+     * @tparam Args The types of the arguments.
+     * @see blocking_pool::offload()
+     */
+    template<typename F, typename... Args>
+    class [[nodiscard]] offload_op : private detail::offload_node {
+    public:
+        /** @brief The type returned by the function. */
+        using result_type = std::invoke_result_t<F&, Args&...>;
+
+        /// @cond INTERNAL
+        /**
+         * @brief Constructs a new operation.
+         *
+         * @param pool The pool.
+         * @param fn The function.
+         * @param args The arguments.
+         */
+        template<typename G, typename... A>
+        offload_op(blocking_pool& pool, G&& fn, A&&... args)
+            : m_pool(pool), m_fn(std::forward<G>(fn)), m_args(std::forward<A>(args)...)
+        {
+            this->m_run = &offload_op::run;
+        }
+        /// @endcond
+
+        /**
+         * @brief Always suspends.
+         *
+         * @return `false`
+         */
+        [[nodiscard]] constexpr bool await_ready() const noexcept { return false; }
+
+        /**
+         * @brief Remembers the executor of the awaiting coroutine and queues the call.
+         *
+         * @param h The awaiting coroutine.
+         */
+        void await_suspend(std::coroutine_handle<> h)
+        {
+            this->m_origin          = detail::coop();
+            this->m_resume.m_handle = h;
+            this->m_pool.submit(this);
+        }
+
+        /**
+         * @brief Returns the result of the call.
+         *
+         * @return The result of the function.
+         * @throw Whatever the function has thrown.
+         */
+        result_type await_resume()
+        {
+            if (auto* e = std::get_if<2>(&this->m_result)) {
+                std::rethrow_exception(*e);
+            }
+
+            if constexpr (std::is_void_v<result_type>) {
+                return;
+            }
+            else if constexpr (std::is_reference_v<result_type>) {
+                return static_cast<result_type>(*std::get<1>(this->m_result));
+            }
+            else {
+                return std::move(std::get<1>(this->m_result));
+            }
+        }
+
+    private:
+        /** @brief How the result is kept: references as pointers, `void` as nothing. */
+        using storage_type = std::conditional_t<
+            std::is_void_v<result_type>, std::monostate,
+            std::conditional_t<
+                std::is_reference_v<result_type>, std::add_pointer_t<std::remove_reference_t<result_type>>,
+                result_type>>;
+
+        blocking_pool& m_pool;          ///< The pool.
+        F m_fn;                         ///< The function.
+        std::tuple<Args...> m_args;     ///< The arguments.
+        detail::resume_node m_resume;   ///< The awaiting coroutine, queued back on its executor.
+        detail::coop_context m_origin;  ///< The executor of the awaiting coroutine.
+        std::variant<std::monostate, storage_type, std::exception_ptr> m_result;  ///< The outcome of the call.
+
+        /**
+         * @brief Makes the call on a thread of the pool and hands the awaiting coroutine back to its executor.
+         *
+         * @param node The operation.
+         */
+        static void run(detail::offload_node* node) noexcept
+        {
+            auto* self = static_cast<offload_op*>(node);
+            try {
+                if constexpr (std::is_void_v<result_type>) {
+                    std::apply(self->m_fn, self->m_args);
+                    self->m_result.template emplace<1>();
+                }
+                else if constexpr (std::is_reference_v<result_type>) {
+                    self->m_result.template emplace<1>(std::addressof(std::apply(self->m_fn, self->m_args)));
+                }
+                else {
+                    self->m_result.template emplace<1>(std::apply(self->m_fn, self->m_args));
+                }
+            }
+            catch (...) {
+                self->m_result.template emplace<2>(std::current_exception());
+            }
+
+            // The coroutine may run and destroy the operation as soon as it is handed over
+            const detail::coop_context origin = self->m_origin;
+            if (origin.m_scheduler != nullptr) {
+                origin.m_reschedule(origin.m_scheduler, &self->m_resume, origin.m_lane);
+            }
+            else {
+                self->m_resume.m_handle.resume();
+            }
+        }
+    };
+
+private:
+    blocking_pool_options m_options;                        ///< The options.
+    mutable std::mutex m_mutex;                             ///< Guards the queue and the counters.
+    std::condition_variable m_work;                         ///< Signals queued calls and shutdown.
+    std::condition_variable m_exited;                       ///< Signals that the last thread is exiting.
+    std::vector<std::thread> m_handles;                     ///< The threads, including those that have exited.
+    std::vector<std::thread::id> m_finished;                ///< Threads that have exited but are not joined yet.
+    detail::intrusive_queue<detail::offload_node> m_queue;  ///< Queued calls.
+    std::size_t m_queued  = 0;                              ///< The length of the queue.
+    std::size_t m_threads = 0;                              ///< Running threads.
+    std::size_t m_idle    = 0;                              ///< Threads waiting for calls.
+    bool m_stop           = false;                          ///< Whether the pool is being destroyed.
+
+    /**
+     * @brief Queues a call and makes sure that a thread will take it.
+     *
+     * @param node The call.
+     * @throw std::system_error if a thread is needed but cannot be started.
+     */
+    void submit(detail::offload_node* node)
+    {
+        const std::scoped_lock lock(this->m_mutex);
+        this->m_queue.push_back(node);
+        ++this->m_queued;
+
+        if (this->m_queued <= this->m_idle) {
+            this->m_work.notify_one();
+        }
+        else if (this->m_threads < this->m_options.max_threads) {
+            this->reap();
+            ++this->m_threads;
+            try {
+                this->m_handles.emplace_back([this] { this->run(); });
+            }
+            catch (...) {
+                --this->m_threads;
+                this->m_queue.remove(node);
+                --this->m_queued;
+                throw;
+            }
+        }
+    }
+
+    /**
+     * @brief Joins the threads that have exited; the lock must be held.
+     *
+     * A thread records itself as finished just before it releases the lock for the last time, so joining it does not
+     * wait for long.
+     */
+    void reap()
+    {
+        for (const std::thread::id id : this->m_finished) {
+            const auto it = std::ranges::find(this->m_handles, id, &std::thread::get_id);
+            it->join();
+            this->m_handles.erase(it);
+        }
+
+        this->m_finished.clear();
+    }
+
+    /** @brief The body of a thread of the pool. */
+    void run()
+    {
+        std::unique_lock lock(this->m_mutex);
+        for (;;) {
+            if (this->m_queue.empty()) {
+                if (this->m_stop) {
+                    break;
+                }
+
+                ++this->m_idle;
+                const bool woken = this->m_work.wait_for(lock, this->m_options.keep_alive, [this] {
+                    return !this->m_queue.empty() || this->m_stop;
+                });
+                --this->m_idle;
+
+                if (!woken) {
+                    break;
+                }
+
+                continue;
+            }
+
+            detail::offload_node* node = this->m_queue.pop_front();
+            --this->m_queued;
+
+            lock.unlock();
+            node->m_run(node);
+            lock.lock();
+        }
+
+        this->m_finished.push_back(std::this_thread::get_id());
+        if (--this->m_threads == 0) {
+            this->m_exited.notify_all();
+        }
+    }
+};
+
+/**
+ * @brief Runs a function on a thread of the process-wide blocking pool.
+ *
+ * @tparam F The type of the function.
+ * @tparam Args The types of the arguments.
+ * @param fn The function.
+ * @param args The arguments.
+ * @return An awaitable that yields the result of the function or rethrows its exception.
+ * @see blocking_pool::offload()
+ *
+ * @internal
+ * @test @a OffloadTest.DefaultPool
+ */
+template<typename F, typename... Args>
+requires std::is_invocable_v<std::decay_t<F>&, std::decay_t<Args>&...>
+[[nodiscard]] auto offload(F&& fn, Args&&... args)
+{
+    return blocking_pool::instance().offload(std::forward<F>(fn), std::forward<Args>(args)...);
+}
+
+/**
+ * @example offload.cpp
+ * Example of offloading blocking calls from a thread pool.
+ */
+
+}  // namespace wwa::coro
+
+#endif /* C9F1E27A_5B3D_4E80_A6C4_2D7B91F05E63 */
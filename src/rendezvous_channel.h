@@ -0,0 +1,325 @@
+#ifndef F3A81D6C_2B47_4E0F_8C95_6D1E7B04A2C3
+#define F3A81D6C_2B47_4E0F_8C95_6D1E7B04A2C3
+
+/**
+ * @file rendezvous_channel.h
+ * @brief Unbuffered (rendezvous) channel.
+ *
+ * This file contains the definition of the `rendezvous_channel` class template. The channel has no buffer:
+ * a send completes only when a receiver takes the value, and vice versa.
+ *
+ * Example:
+ * @snippet rendezvous_channel.cpp rendezvous_channel example
+ */
+
+#include <atomic>
+#include <coroutine>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "detail.h"
+
+namespace wwa::coro {
+
+/**
+ * @brief An unbuffered channel in which senders and receivers meet.
+ *
+ * The first side to arrive suspends. When the other side arrives, the value is moved straight from the sender's
+ * awaiter into the receiver's awaiter, and the waiting peer runs first. On a thread that belongs to a scheduler
+ * (such as `thread_pool`), the side that completed the rendezvous is queued on the scheduler, and control is
+ * transferred to the peer by returning its handle from `await_suspend()` (the same way `async_generator` transfers
+ * control from the producer to the consumer). Elsewhere, there is nowhere to queue it: it resumes the peer inline and
+ * goes on when the peer suspends, the way a `channel` resumes the coroutines it wakes.
+ *
+ * Example:
+ * @snippet rendezvous_channel.cpp rendezvous_channel example
+ *
+ * @tparam T The type of the values passed through the channel.
+ */
+template<typename T>
+class rendezvous_channel {
+public:
+    /** @brief The type of the values passed through the channel. */
+    using value_type = T;
+
+    class send_op;
+    class recv_op;
+
+    /** @brief Default constructor. */
+    rendezvous_channel() noexcept = default;
+
+    /// @cond
+    rendezvous_channel(const rendezvous_channel&)            = delete;
+    rendezvous_channel(rendezvous_channel&&)                 = delete;
+    rendezvous_channel& operator=(const rendezvous_channel&) = delete;
+    rendezvous_channel& operator=(rendezvous_channel&&)      = delete;
+    /// @endcond
+
+    /**
+     * @brief Destructor.
+     *
+     * @warning No coroutines may be suspended on the channel when it is destroyed; call `close()` first.
+     */
+    ~rendezvous_channel() = default;
+
+    /**
+     * @brief Sends a value to the channel.
+     *
+     * The awaiting coroutine suspends until a receiver takes the value or the channel is closed.
+     *
+     * @param value The value to send.
+     * @return An awaitable that yields `true` if a receiver took the value, or `false` if the channel has been closed.
+     *
+     * @internal
+     * @test @a RendezvousChannelTest.ReceiverFirst
+     * @test @a RendezvousChannelTest.SenderFirst
+     * @test @a RendezvousChannelTest.PingPongOnPool
+     */
+    [[nodiscard]] send_op send(T value) noexcept(std::is_nothrow_move_constructible_v<T>)
+    {
+        return send_op{*this, std::move(value)};
+    }
+
+    /**
+     * @brief Receives a value from the channel.
+     *
+     * The awaiting coroutine suspends until a sender provides a value or the channel is closed.
+     *
+     * @return An awaitable that yields `std::optional<T>`; an empty optional means that the channel has been closed.
+     *
+     * @internal
+     * @test @a RendezvousChannelTest.ReceiverFirst
+     * @test @a RendezvousChannelTest.SenderFirst
+     */
+    [[nodiscard]] recv_op recv() noexcept { return recv_op{*this}; }
+
+    /**
+     * @brief Closes the channel.
+     *
+     * All suspended senders are resumed with `false`; all suspended receivers are resumed with an empty optional.
+     * Subsequent operations complete immediately with the same results.
+     *
+     * @internal
+     * @test @a RendezvousChannelTest.Close
+     */
+    void close()
+    {
+        send_op* senders   = nullptr;
+        recv_op* receivers = nullptr;
+        {
+            const std::scoped_lock lock(this->m_lock);
+            if (this->m_closed.exchange(true, std::memory_order_release)) {
+                return;
+            }
+
+            senders   = this->m_senders.take_all();
+            receivers = this->m_receivers.take_all();
+        }
+
+        while (senders != nullptr) {
+            std::coroutine_handle<> h = senders->m_awaiting;
+            senders                   = senders->m_next;
+            h.resume();
+        }
+
+        while (receivers != nullptr) {
+            std::coroutine_handle<> h = receivers->m_awaiting;
+            receivers                 = receivers->m_next;
+            h.resume();
+        }
+    }
+
+    /**
+     * @brief Checks whether the channel has been closed.
+     *
+     * @return Whether the channel has been closed.
+     */
+    [[nodiscard]] bool is_closed() const noexcept { return this->m_closed.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Awaitable for the send operation.
+     *
+     * @see rendezvous_channel::send()
+     */
+    class [[nodiscard]] send_op : public detail::intrusive_hook<send_op> {
+    public:
+        /// @cond INTERNAL
+        /**
+         * @brief Constructs a new send operation.
+         *
+         * @param ch The channel.
+         * @param value The value to send.
+         */
+        send_op(rendezvous_channel& ch, T&& value) noexcept(std::is_nothrow_move_constructible_v<T>)
+            : m_channel(ch), m_value(std::move(value))
+        {}
+        /// @endcond
+
+        /**
+         * @brief Completes immediately only if the channel has been closed.
+         *
+         * @return Whether the operation has completed.
+         */
+        [[nodiscard]] bool await_ready() const noexcept { return this->m_channel.is_closed(); }
+
+        /**
+         * @brief Hands the value to a waiting receiver or parks the sender.
+         *
+         * @param h The awaiting coroutine.
+         * @return The receiver or, if it has already run, @a h; `std::noop_coroutine()` if the sender parks
+         * or has been queued on the scheduler; @a h if the channel has been closed.
+         */
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> h) noexcept(
+            std::is_nothrow_move_constructible_v<T>
+        )
+        {
+            recv_op* receiver = nullptr;
+            {
+                const std::scoped_lock lock(this->m_channel.m_lock);
+                if (this->m_channel.is_closed()) {
+                    return h;
+                }
+
+                receiver = this->m_channel.m_receivers.pop_front();
+                if (receiver == nullptr) {
+                    this->m_awaiting = h;
+                    this->m_channel.m_senders.push_back(this);
+                    return std::noop_coroutine();
+                }
+            }
+
+            receiver->m_value.emplace(std::move(this->m_value));
+            this->m_sent = true;
+            return rendezvous_channel::meet(this->m_node, h, receiver->m_node, receiver->m_awaiting);
+        }
+
+        /**
+         * @brief Returns the result of the operation.
+         *
+         * @return Whether the value was taken by a receiver; `false` means that the channel was closed.
+         */
+        [[nodiscard]] bool await_resume() const noexcept { return this->m_sent; }
+
+    private:
+        friend class rendezvous_channel;
+
+        rendezvous_channel& m_channel;       ///< The channel.
+        T m_value;                           ///< The value to send.
+        std::coroutine_handle<> m_awaiting;  ///< The parked sender.
+        detail::resume_node m_node;          ///< Queues the sender on a scheduler.
+        bool m_sent = false;                 ///< Whether the value has been taken.
+    };
+
+    /**
+     * @brief Awaitable for the receive operation.
+     *
+     * @see rendezvous_channel::recv()
+     */
+    class [[nodiscard]] recv_op : public detail::intrusive_hook<recv_op> {
+    public:
+        /// @cond INTERNAL
+        /**
+         * @brief Constructs a new receive operation.
+         *
+         * @param ch The channel.
+         */
+        explicit recv_op(rendezvous_channel& ch) noexcept : m_channel(ch) {}
+        /// @endcond
+
+        /**
+         * @brief Completes immediately only if the channel has been closed.
+         *
+         * @return Whether the operation has completed.
+         */
+        [[nodiscard]] bool await_ready() const noexcept { return this->m_channel.is_closed(); }
+
+        /**
+         * @brief Takes the value from a waiting sender or parks the receiver.
+         *
+         * @param h The awaiting coroutine.
+         * @return The sender or, if it has already run, @a h; `std::noop_coroutine()` if the receiver parks
+         * or has been queued on the scheduler; @a h if the channel has been closed.
+         */
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> h) noexcept(
+            std::is_nothrow_move_constructible_v<T>
+        )
+        {
+            send_op* sender = nullptr;
+            {
+                const std::scoped_lock lock(this->m_channel.m_lock);
+                if (this->m_channel.is_closed()) {
+                    return h;
+                }
+
+                sender = this->m_channel.m_senders.pop_front();
+                if (sender == nullptr) {
+                    this->m_awaiting = h;
+                    this->m_channel.m_receivers.push_back(this);
+                    return std::noop_coroutine();
+                }
+            }
+
+            this->m_value.emplace(std::move(sender->m_value));
+            sender->m_sent = true;
+            return rendezvous_channel::meet(this->m_node, h, sender->m_node, sender->m_awaiting);
+        }
+
+        /**
+         * @brief Returns the received value.
+         *
+         * @return The received value; an empty optional if the channel was closed.
+         */
+        std::optional<T> await_resume() noexcept(std::is_nothrow_move_constructible_v<T>)
+        {
+            return std::move(this->m_value);
+        }
+
+    private:
+        friend class rendezvous_channel;
+
+        rendezvous_channel& m_channel;       ///< The channel.
+        std::optional<T> m_value;            ///< The received value.
+        std::coroutine_handle<> m_awaiting;  ///< The parked receiver.
+        detail::resume_node m_node;          ///< Queues the receiver on a scheduler.
+    };
+
+private:
+    detail::spinlock m_lock;                       ///< Guards the waiter lists.
+    detail::intrusive_queue<send_op> m_senders;    ///< Parked senders.
+    detail::intrusive_queue<recv_op> m_receivers;  ///< Parked receivers.
+    std::atomic<bool> m_closed = false;            ///< Whether the channel has been closed.
+
+    /**
+     * @brief Lets the parked peer run first once the rendezvous has completed.
+     *
+     * @param self The node of the side that completed the rendezvous.
+     * @param h The coroutine of the side that completed the rendezvous.
+     * @param peer The node of the parked peer.
+     * @param peer_handle The coroutine of the parked peer.
+     * @return The coroutine to transfer control to.
+     */
+    static std::coroutine_handle<> meet(
+        detail::resume_node& self, std::coroutine_handle<> h, detail::resume_node& peer,
+        std::coroutine_handle<> peer_handle
+    ) noexcept
+    {
+        if (detail::reschedule(self, h)) {
+            return detail::transfer(peer, peer_handle);
+        }
+
+        // No scheduler to queue on: the peer runs on this stack until it suspends
+        peer_handle.resume();
+        return h;
+    }
+};
+
+/**
+ * @example rendezvous_channel.cpp
+ * Example of a request/response handoff with a rendezvous channel.
+ */
+
+}  // namespace wwa::coro
+
+#endif /* F3A81D6C_2B47_4E0F_8C95_6D1E7B04A2C3 */
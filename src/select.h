@@ -0,0 +1,465 @@
+#ifndef D61F0A3E_97B2_4C58_8E4D_2F5A6C1B9E07
+#define D61F0A3E_97B2_4C58_8E4D_2F5A6C1B9E07
+
+/**
+ * @file select.h
+ * @brief Waiting for the first of several channel operations.
+ *
+ * This file contains the definition of the `select()` function, which waits for whichever of several channel operations
+ * completes first, and of the `recv()`, `send()`, and `timeout()` functions, which create its clauses.
+ *
+ * Example:
+ * @snippet select.cpp select example
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "channel.h"
+#include "detail.h"
+#include "timer.h"
+
+namespace wwa::coro {
+
+/// @cond INTERNAL
+
+namespace detail {
+
+/**
+ * @brief A `select()` clause that receives a value from a channel.
+ *
+ * Clauses implement the following protocol:
+ *   - `lock()` returns the lock to hold while the clause is prepared, or `nullptr`;
+ *   - `prepare()` runs with all locks held; it either completes the clause immediately or registers a waiter;
+ *   - `unprepare()` runs with all locks held and removes the waiter registered by `prepare()`;
+ *   - `finish()` runs after the locks are released if the clause completed in `prepare()`;
+ *   - `arm()` runs after the locks are released if no clause completed in `prepare()`;
+ *   - `disarm()` runs after the select has completed via another clause;
+ *   - `result()` returns the result of the clause if it completed.
+ *
+ * @tparam T The type of the values passed through the channel.
+ */
+template<typename T>
+class recv_clause {
+public:
+    /** @brief The result of the clause. */
+    using result_type = std::optional<T>;
+
+    /**
+     * @brief Constructs a new clause.
+     *
+     * @param ch The channel.
+     */
+    explicit recv_clause(channel<T>& ch) noexcept : m_channel(ch) {}
+
+    [[nodiscard]] spinlock* lock() noexcept { return &this->m_channel.waiters_lock(); }
+
+    bool prepare(select_state& state, std::size_t index)
+    {
+        this->m_node.m_select = &state;
+        this->m_node.m_index  = index;
+        return !this->m_channel.enqueue_receiver(&this->m_node);
+    }
+
+    void unprepare() noexcept { this->m_channel.dequeue_receiver(&this->m_node); }
+    void finish() { this->m_channel.wake_sender(); }
+    constexpr void arm() const noexcept {}
+
+    void disarm() noexcept
+    {
+        const std::scoped_lock lock(this->m_channel.waiters_lock());
+        this->m_channel.dequeue_receiver(&this->m_node);
+    }
+
+    result_type result()
+    {
+        this->m_channel.drain_into(this->m_node.m_value);
+        return std::move(this->m_node.m_value);
+    }
+
+private:
+    channel<T>& m_channel;        ///< The channel.
+    channel_receiver<T> m_node;  ///< The waiter.
+};
+
+/**
+ * @brief A `select()` clause that sends a value to a channel.
+ *
+ * @tparam T The type of the values passed through the channel.
+ * @see recv_clause
+ */
+template<typename T>
+class send_clause {
+public:
+    /** @brief The result of the clause. */
+    using result_type = bool;
+
+    /**
+     * @brief Constructs a new clause.
+     *
+     * @param ch The channel.
+     * @param value The value to send.
+     */
+    send_clause(channel<T>& ch, T&& value) noexcept(std::is_nothrow_move_constructible_v<T>)
+        : m_channel(ch), m_node(std::move(value))
+    {}
+
+    [[nodiscard]] spinlock* lock() noexcept { return &this->m_channel.waiters_lock(); }
+
+    bool prepare(select_state& state, std::size_t index)
+    {
+        this->m_node.m_select = &state;
+        this->m_node.m_index  = index;
+        return !this->m_channel.enqueue_sender(&this->m_node);
+    }
+
+    void unprepare() noexcept { this->m_channel.dequeue_sender(&this->m_node); }
+    void finish() { this->m_channel.wake_receiver(); }
+    constexpr void arm() const noexcept {}
+
+    void disarm() noexcept
+    {
+        const std::scoped_lock lock(this->m_channel.waiters_lock());
+        this->m_channel.dequeue_sender(&this->m_node);
+    }
+
+    [[nodiscard]] constexpr result_type result() const noexcept { return this->m_node.m_sent; }
+
+private:
+    channel<T>& m_channel;      ///< The channel.
+    channel_sender<T> m_node;  ///< The waiter.
+};
+
+/**
+ * @brief A `select()` clause that completes after a timeout.
+ *
+ * @see recv_clause
+ */
+class timeout_clause : private timer_node {
+public:
+    /** @brief The result of the clause. */
+    using result_type = std::monostate;
+
+    /**
+     * @brief Constructs a new clause.
+     *
+     * @param service The timer service.
+     * @param duration The timeout.
+     */
+    timeout_clause(timer_service& service, timer_service::clock::duration duration) noexcept
+        : m_service(service), m_duration(duration)
+    {
+        this->m_fire = &timeout_clause::fire;
+    }
+
+    [[nodiscard]] constexpr spinlock* lock() const noexcept { return nullptr; }
+
+    bool prepare(select_state& state, std::size_t index) noexcept
+    {
+        this->m_select = &state;
+        this->m_index  = index;
+        return this->m_duration <= timer_service::clock::duration::zero();
+    }
+
+    constexpr void unprepare() const noexcept {}
+    constexpr void finish() const noexcept {}
+
+    void arm()
+    {
+        this->m_service.schedule(this, timer_service::clock::now() + this->m_duration);
+    }
+
+    void disarm() { this->m_service.cancel(this); }
+
+    [[nodiscard]] constexpr result_type result() const noexcept { return {}; }
+
+private:
+    timer_service& m_service;                  ///< The timer service.
+    timer_service::clock::duration m_duration;  ///< The timeout.
+    select_state* m_select = nullptr;           ///< The select.
+    std::size_t m_index    = 0;                 ///< The index of the clause within the select.
+
+    /**
+     * @brief Completes the select unless another clause has completed it.
+     *
+     * @param node The timer.
+     */
+    static void fire(timer_node* node) noexcept
+    {
+        auto* self = static_cast<timeout_clause*>(node);
+        if (self->m_select->try_claim()) {
+            self->m_select->complete(self->m_index);
+        }
+    }
+};
+
+}  // namespace detail
+
+/// @endcond
+
+/**
+ * @brief Awaitable that waits for the first of several channel operations.
+ *
+ * @tparam Clauses The types of the clauses.
+ * @see select()
+ */
+template<typename... Clauses>
+class [[nodiscard]] select_op {
+public:
+    /** @brief The result of the operation: the result of the completed clause, at the index of the clause. */
+    using result_type = std::variant<typename Clauses::result_type...>;
+
+    /// @cond INTERNAL
+    /**
+     * @brief Constructs a new operation.
+     *
+     * @param clauses The clauses.
+     */
+    explicit select_op(Clauses&&... clauses) : m_clauses(std::move(clauses)...) {}
+    /// @endcond
+
+    /**
+     * @brief Always suspends; readiness is checked in `await_suspend()` with all channel locks held.
+     *
+     * @return `false`
+     */
+    [[nodiscard]] constexpr bool await_ready() const noexcept { return false; }
+
+    /**
+     * @brief Completes a ready clause, or registers waiters for all clauses.
+     *
+     * The locks of all channels involved are taken in address order, so that the select is registered atomically
+     * with respect to each channel. Clauses are checked in the order they are listed; the first ready clause wins.
+     *
+     * @param h The awaiting coroutine.
+     * @return Whether the coroutine should stay suspended.
+     */
+    bool await_suspend(std::coroutine_handle<> h)
+    {
+        this->m_state.set_awaiting(h);
+
+        std::array<detail::spinlock*, sizeof...(Clauses)> locks = this->collect_locks(indices{});
+        std::ranges::sort(locks);
+        const auto last  = std::unique(locks.begin(), locks.end());
+        const auto first = std::find_if(locks.begin(), last, [](const detail::spinlock* lock) { return lock != nullptr; });
+
+        std::size_t ready = sizeof...(Clauses);
+        std::for_each(first, last, [](detail::spinlock* lock) { lock->lock(); });
+        this->prepare(indices{}, ready);
+        std::for_each(first, last, [](detail::spinlock* lock) { lock->unlock(); });
+
+        if (ready != sizeof...(Clauses)) {
+            this->m_state.complete_inline(ready);
+            this->finish(indices{}, ready);
+            return false;
+        }
+
+        // Once armed, the select may complete on another thread at any moment; after `finish_arming()`,
+        // the awaitable must not be touched.
+        this->m_armed = true;
+        std::apply([](auto&... clause) { (clause.arm(), ...); }, this->m_clauses);
+        return this->m_state.finish_arming();
+    }
+
+    /**
+     * @brief Deregisters the waiters of the clauses that did not complete and returns the result.
+     *
+     * @return The result of the completed clause.
+     */
+    result_type await_resume()
+    {
+        const std::size_t winner = this->m_state.winner();
+        if (this->m_armed) {
+            this->disarm(indices{}, winner);
+        }
+
+        return this->result(indices{}, winner);
+    }
+
+private:
+    /** @brief Clause indices. */
+    using indices = std::index_sequence_for<Clauses...>;
+
+    std::tuple<Clauses...> m_clauses;  ///< The clauses.
+    detail::select_state m_state;      ///< Shared state of the select.
+    bool m_armed = false;              ///< Whether waiters have been registered for all clauses.
+
+    /**
+     * @brief Collects the locks of all clauses.
+     *
+     * Clauses without a lock contribute `nullptr`, which sorts first and is skipped.
+     *
+     * @return The locks.
+     */
+    template<std::size_t... I>
+    std::array<detail::spinlock*, sizeof...(Clauses)> collect_locks(std::index_sequence<I...>) noexcept
+    {
+        return {std::get<I>(this->m_clauses).lock()...};
+    }
+
+    /**
+     * @brief Prepares clauses in order until one of them completes, and unprepares the ones before it.
+     *
+     * @param ready Receives the index of the completed clause; left unchanged if no clause has completed.
+     */
+    template<std::size_t... I>
+    void prepare(std::index_sequence<I...>, std::size_t& ready)
+    {
+        // Short-circuits at the first clause that completes
+        if (((std::get<I>(this->m_clauses).prepare(this->m_state, I) ? (ready = I, true) : false) || ...)) {
+            ((I < ready ? std::get<I>(this->m_clauses).unprepare() : void()), ...);
+        }
+    }
+
+    /**
+     * @brief Wakes the opposite side of the clause that completed without suspending.
+     *
+     * @param ready The index of the completed clause.
+     */
+    template<std::size_t... I>
+    void finish(std::index_sequence<I...>, std::size_t ready)
+    {
+        ((I == ready ? std::get<I>(this->m_clauses).finish() : void()), ...);
+    }
+
+    /**
+     * @brief Deregisters the waiters of all clauses except the completed one.
+     *
+     * @param winner The index of the completed clause.
+     */
+    template<std::size_t... I>
+    void disarm(std::index_sequence<I...>, std::size_t winner)
+    {
+        ((I != winner ? std::get<I>(this->m_clauses).disarm() : void()), ...);
+    }
+
+    /**
+     * @brief Returns the result of the completed clause.
+     *
+     * @param winner The index of the completed clause.
+     * @return The result.
+     */
+    template<std::size_t... I>
+    result_type result(std::index_sequence<I...>, std::size_t winner)
+    {
+        using getter = result_type (select_op::*)();
+        static constexpr std::array<getter, sizeof...(Clauses)> getters{&select_op::result_at<I>...};
+        return (this->*getters[winner])();  // NOLINT(*-pro-bounds-constant-array-index)
+    }
+
+    /**
+     * @brief Returns the result of the clause at the given index.
+     *
+     * @tparam I The index of the clause.
+     * @return The result.
+     */
+    template<std::size_t I>
+    result_type result_at()
+    {
+        return result_type{std::in_place_index<I>, std::get<I>(this->m_clauses).result()};
+    }
+};
+
+/**
+ * @brief Creates a `select()` clause that receives a value from a channel.
+ *
+ * @param ch The channel.
+ * @return The clause; its result is `std::optional<T>`, which is empty if the channel is closed and drained.
+ */
+template<typename T>
+[[nodiscard]] detail::recv_clause<T> recv(channel<T>& ch) noexcept
+{
+    return detail::recv_clause<T>{ch};
+}
+
+/**
+ * @brief Creates a `select()` clause that sends a value to a channel.
+ *
+ * @param ch The channel.
+ * @param value The value to send; it is not consumed if another clause completes first.
+ * @return The clause; its result is `bool`, which is `false` if the channel has been closed.
+ */
+template<typename T>
+[[nodiscard]] detail::send_clause<T> send(channel<T>& ch, std::type_identity_t<T> value)
+    noexcept(std::is_nothrow_move_constructible_v<T>)
+{
+    return detail::send_clause<T>{ch, std::move(value)};
+}
+
+/**
+ * @brief Creates a `select()` clause that completes after a timeout.
+ *
+ * @param service The timer service.
+ * @param duration The timeout, measured from the moment the select starts waiting.
+ * @return The clause; its result is `std::monostate`.
+ */
+template<typename Rep, typename Period>
+[[nodiscard]] detail::timeout_clause timeout(timer_service& service, std::chrono::duration<Rep, Period> duration) noexcept
+{
+    return detail::timeout_clause{service, std::chrono::ceil<timer_service::clock::duration>(duration)};
+}
+
+/**
+ * @brief Creates a `select()` clause that completes after a timeout, using the default timer service.
+ *
+ * @param duration The timeout, measured from the moment the select starts waiting.
+ * @return The clause; its result is `std::monostate`.
+ * @see timer_service::instance()
+ */
+template<typename Rep, typename Period>
+[[nodiscard]] detail::timeout_clause timeout(std::chrono::duration<Rep, Period> duration) noexcept
+{
+    return timeout(timer_service::instance(), duration);
+}
+
+/**
+ * @brief Waits for the first of several channel operations to complete.
+ *
+ * `co_await select(recv(a), recv(b), send(c, v), timeout(d))` registers a waiter on every channel involved and
+ * suspends until one of the operations completes. The waiters share one atomic claim: the first party to complete
+ * an operation wins, and all other waiters become stale and are removed when the select resumes. No memory is
+ * allocated; the waiters live inside the awaitable.
+ *
+ * If several operations can complete immediately, the first one in the argument list wins. Operations that lose
+ * have no effect: values are neither sent nor received.
+ *
+ * The result is a `std::variant` whose active index is the index of the completed clause.
+ *
+ * Example:
+ * @snippet select.cpp select example
+ *
+ * @param clauses The clauses created with `recv()`, `send()`, and `timeout()`.
+ * @return An awaitable that yields the result of the completed clause.
+ *
+ * @internal
+ * @test @a SelectTest.ReadyClauseWins
+ * @test @a SelectTest.WaitsForFirst
+ * @test @a SelectTest.Send
+ * @test @a SelectTest.Timeout
+ * @test @a SelectTest.Close
+ * @test @a SelectTest.CrossThread
+ */
+template<typename... Clauses>
+requires(sizeof...(Clauses) > 0)
+[[nodiscard]] select_op<Clauses...> select(Clauses... clauses)
+{
+    return select_op<Clauses...>{std::move(clauses)...};
+}
+
+/**
+ * @example select.cpp
+ * Example of servicing data and control channels with a deadline.
+ */
+
+}  // namespace wwa::coro
+
+#endif /* D61F0A3E_97B2_4C58_8E4D_2F5A6C1B9E07 */
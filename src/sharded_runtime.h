@@ -0,0 +1,614 @@
+#ifndef D4B81F6E_3A27_4C95_B0E2_8F6A19C53D70
+#define D4B81F6E_3A27_4C95_B0E2_8F6A19C53D70
+
+/**
+ * @file sharded_runtime.h
+ * @brief Thread-per-core runtime with message passing between shards.
+ *
+ * This file contains the definition of the `sharded_runtime` class. Every shard is an event loop on a thread of its
+ * own; state owned by a shard is only touched by that thread, and `co_await rt.submit_to(shard, fn)` runs a function
+ * on another shard and brings the result back.
+ *
+ * Example:
+ * @snippet sharded_runtime.cpp sharded_runtime example
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "detail.h"
+#include "spsc_channel.h"
+#include "task.h"
+#include "thread_pool.h"
+
+namespace wwa::coro {
+
+/** @brief Options of `sharded_runtime`. */
+struct sharded_runtime_options {
+    std::size_t shards         = 0;     ///< The number of shards; 0 means one per CPU the process may run on.
+    std::size_t queue_capacity = 256;   ///< Slots of every queue between two shards; rounded up to a power of two.
+    bool pin_shards            = true;  ///< Whether to pin every shard to a CPU of its own (Linux only).
+    std::size_t budget         = 128;   ///< Transfers per resumption; see `thread_pool_options::budget`.
+};
+
+/**
+ * @brief A thread-per-core runtime.
+ *
+ * Every shard runs an event loop on a thread of its own, pinned to a CPU. A shard never shares mutable state with
+ * another shard: its run queue is a plain list that only its thread touches, and coroutine frames of `arena_task<>`s
+ * started on the shard, `submit_to()` among them, come from a frame arena of its own (see `detail::frame_arena`).
+ *
+ * Work crosses shards only as messages. Every ordered pair of shards has a bounded single-producer single-consumer
+ * queue (`spsc_channel`); `co_await rt.schedule(shard)` moves the awaiting coroutine to another shard by sending
+ * the awaiter itself through the queue, so moving does not allocate. When a queue is full, the sending shard keeps
+ * the coroutine in a local overflow list and retries from its loop. Threads outside the runtime send to a shard
+ * through a small locked inbox instead.
+ *
+ * `co_await rt.submit_to(shard, fn)` runs `fn` on @a shard (awaiting it if it returns a `task<>`), then returns
+ * to the calling shard with the result or the exception. An idle shard sleeps on a futex; senders only make a system
+ * call to wake it when it actually sleeps.
+ *
+ * Example:
+ * @snippet sharded_runtime.cpp sharded_runtime example
+ */
+class sharded_runtime {
+    struct shard;
+
+public:
+    class schedule_op;
+
+    /** @brief The result of `current_shard()` outside the runtime. */
+    static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+    /**
+     * @brief The result of `submit_to()`.
+     *
+     * @tparam F The type of the function.
+     */
+    template<typename F>
+    using submit_result = typename detail::unwrap_task<std::invoke_result_t<F&>>::type;
+
+    /**
+     * @brief Constructs a new runtime and starts its shards.
+     *
+     * @param options The options.
+     * @throw std::invalid_argument if `queue_capacity` is zero.
+     *
+     * @internal
+     * @test @a ShardedRuntimeTest.InvalidOptions
+     */
+    explicit sharded_runtime(const sharded_runtime_options& options = {}) : m_options(options)
+    {
+        if (this->m_options.queue_capacity == 0) {
+            throw std::invalid_argument("Invalid queue_capacity");
+        }
+
+        std::vector<int> cpus;
+        for (const std::vector<int>& node : detail::cpu_topology()) {
+            cpus.insert(cpus.end(), node.begin(), node.end());
+        }
+
+        if (this->m_options.shards == 0) {
+            this->m_options.shards = std::max<std::size_t>(cpus.size(), 1);
+        }
+
+        const std::size_t n = this->m_options.shards;
+        this->m_shards      = std::vector<std::unique_ptr<shard>>(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            this->m_shards[i] = std::make_unique<shard>(n);
+            shard& s          = *this->m_shards[i];
+            for (std::size_t src = 0; src < n; ++src) {
+                if (src != i) {
+                    s.m_inbound[src] = std::make_unique<channel>(this->m_options.queue_capacity);
+                }
+            }
+
+            if (this->m_options.pin_shards && !cpus.empty()) {
+                s.m_cpu = cpus[i % cpus.size()];
+            }
+        }
+
+        for (std::size_t i = 0; i < n; ++i) {
+            this->m_shards[i]->m_thread = std::thread([this, i] { this->run(i); });
+        }
+    }
+
+    /// @cond
+    sharded_runtime(const sharded_runtime&)            = delete;
+    sharded_runtime(sharded_runtime&&)                 = delete;
+    sharded_runtime& operator=(const sharded_runtime&) = delete;
+    sharded_runtime& operator=(sharded_runtime&&)      = delete;
+    /// @endcond
+
+    /**
+     * @brief Destructor.
+     *
+     * Every shard runs its queued coroutines to their next suspension point. The shards stop together, once none of
+     * them has work left and nothing is in flight between them, so that a coroutine still running on one shard may
+     * send work to another.
+     *
+     * @internal
+     * @test @a ShardedRuntimeTest.StopTogether
+     */
+    ~sharded_runtime()
+    {
+        this->m_stop.store(true, std::memory_order_release);
+        for (auto& s : this->m_shards) {
+            s->m_idle.notify_all();
+        }
+
+        for (auto& s : this->m_shards) {
+            s->m_thread.join();
+        }
+    }
+
+    /**
+     * @brief Returns the number of shards.
+     *
+     * @return The number of shards.
+     */
+    [[nodiscard]] std::size_t size() const noexcept { return this->m_shards.size(); }
+
+    /**
+     * @brief Returns the shard that runs the calling coroutine.
+     *
+     * @return The index of the shard; `npos` if the calling thread does not belong to this runtime.
+     *
+     * @internal
+     * @test @a ShardedRuntimeTest.Schedule
+     */
+    [[nodiscard]] std::size_t current_shard() const noexcept
+    {
+        const shard_context& ctx = context();
+        return ctx.m_runtime == this ? ctx.m_index : npos;
+    }
+
+    /**
+     * @brief Moves the awaiting coroutine to a shard.
+     *
+     * @param shard The index of the shard; must be less than `size()`.
+     * @return An awaitable; completes without suspending if the coroutine already runs on @a shard.
+     *
+     * @internal
+     * @test @a ShardedRuntimeTest.Schedule
+     * @test @a ShardedRuntimeTest.Overflow
+     */
+    [[nodiscard]] schedule_op schedule(std::size_t shard) noexcept { return schedule_op{*this, shard}; }
+
+    /**
+     * @brief Runs a function on a shard and returns to the calling shard.
+     *
+     * A caller outside the runtime stays on @a shard after the call.
+     *
+     * @param shard The index of the shard; must be less than `size()`.
+     * @param fn The function; if it returns a `task<>`, the task is awaited on @a shard.
+     * @return A task that produces the result of @a fn or rethrows its exception.
+     *
+     * @internal
+     * @test @a ShardedRuntimeTest.SubmitTo
+     * @test @a ShardedRuntimeTest.Exception
+     * @test @a ShardedRuntimeTest.Overflow
+     */
+    template<typename F>
+    [[nodiscard]] arena_task<submit_result<F>> submit_to(std::size_t shard, F fn)
+    {
+        using result_type = submit_result<F>;
+
+        const std::size_t origin = this->current_shard();
+        co_await this->schedule(shard);
+
+        std::exception_ptr error = nullptr;
+        std::optional<std::conditional_t<std::is_void_v<result_type>, bool, result_type>> result;
+        try {
+            if constexpr (std::is_void_v<result_type>) {
+                if constexpr (detail::is_task_v<std::invoke_result_t<F&>>) {
+                    co_await std::invoke(fn);
+                }
+                else {
+                    std::invoke(fn);
+                }
+
+                result.emplace(true);
+            }
+            else if constexpr (detail::is_task_v<std::invoke_result_t<F&>>) {
+                result.emplace(co_await std::invoke(fn));
+            }
+            else {
+                result.emplace(std::invoke(fn));
+            }
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+
+        if (origin != npos) {
+            co_await this->schedule(origin);
+        }
+
+        if (error != nullptr) {
+            std::rethrow_exception(error);
+        }
+
+        if constexpr (!std::is_void_v<result_type>) {
+            co_return std::move(*result);
+        }
+    }
+
+    /**
+     * @brief Awaitable for the schedule operation.
+     *
+     * @see sharded_runtime::schedule()
+     */
+    class [[nodiscard]] schedule_op : private detail::resume_node {
+    public:
+        /// @cond INTERNAL
+        /**
+         * @brief Constructs a new operation.
+         *
+         * @param rt The runtime.
+         * @param shard The target shard.
+         */
+        schedule_op(sharded_runtime& rt, std::size_t shard) noexcept : m_runtime(rt), m_shard(shard) {}
+        /// @endcond
+
+        /**
+         * @brief Checks whether the coroutine already runs on the target shard.
+         *
+         * @return Whether the coroutine can continue without moving.
+         */
+        [[nodiscard]] bool await_ready() const noexcept { return this->m_runtime.current_shard() == this->m_shard; }
+
+        /**
+         * @brief Sends the coroutine to the target shard.
+         *
+         * @param h The awaiting coroutine.
+         */
+        void await_suspend(std::coroutine_handle<> h) noexcept
+        {
+            this->m_handle = h;
+            this->m_runtime.post(this, this->m_shard);
+        }
+
+        /** @brief Does nothing. */
+        constexpr void await_resume() const noexcept {}
+
+    private:
+        sharded_runtime& m_runtime;  ///< The runtime.
+        std::size_t m_shard;         ///< The target shard.
+    };
+
+private:
+    using channel = spsc_channel<detail::resume_node*>;
+    using list    = detail::intrusive_queue<detail::resume_node>;
+
+    /** @brief A shard. */
+    struct alignas(detail::cache_line_size) shard {
+        std::vector<std::unique_ptr<channel>> m_inbound;                 ///< Queues from the other shards, by sender.
+        std::vector<list> m_outbound;                                    ///< Overflow to every shard; thread-owned.
+        list m_ready;                                                    ///< Coroutines to resume; thread-owned.
+        detail::frame_arena m_frames;                                    ///< Frames of tasks; thread-owned.
+        int m_cpu = -1;                                                  ///< The CPU of the shard; -1 if not pinned.
+        std::thread m_thread;                                            ///< The thread of the shard.
+        detail::eventcount m_idle;                                       ///< Parks the thread when it has no work.
+        alignas(detail::cache_line_size) detail::spinlock m_inbox_lock;  ///< Guards `m_inbox`.
+        list m_inbox;                                                    ///< Coroutines from outside the runtime.
+        std::atomic<std::size_t> m_inbox_size = 0;                       ///< The length of `m_inbox`.
+
+        /**
+         * @brief Constructs a new shard.
+         *
+         * @param shards The number of shards.
+         */
+        explicit shard(std::size_t shards) : m_inbound(shards), m_outbound(shards) {}
+    };
+
+    /** @brief What the calling thread knows about the runtime it belongs to. */
+    struct shard_context {
+        const sharded_runtime* m_runtime = nullptr;  ///< The runtime; `nullptr` if the thread is not a shard.
+        std::size_t m_index              = 0;        ///< The index of the shard.
+    };
+
+    /** @brief The part of `m_stopped` that counts the stopped shards. */
+    static constexpr std::uint64_t stopped_mask = 0xFFFF'FFFFU;
+
+    /** @brief Takes a shard out of `m_stopped` and bumps the generation in its upper half. */
+    static constexpr std::uint64_t restarted = stopped_mask;
+
+    sharded_runtime_options m_options;             ///< The options.
+    std::vector<std::unique_ptr<shard>> m_shards;  ///< The shards.
+    std::atomic<bool> m_stop             = false;  ///< Whether the runtime is being destroyed.
+    std::atomic<std::uint64_t> m_stopped = 0;      ///< Stopped shards; the upper half counts restarts.
+    std::atomic<bool> m_done             = false;  ///< Whether all shards have stopped with nothing in flight.
+
+    /**
+     * @brief Returns the context of the calling thread.
+     *
+     * @return The context.
+     */
+    static shard_context& context() noexcept
+    {
+        static thread_local shard_context ctx;
+        return ctx;
+    }
+
+    /**
+     * @brief Sends a coroutine to a shard.
+     *
+     * @param node The coroutine.
+     * @param dst The index of the target shard.
+     */
+    void post(detail::resume_node* node, std::size_t dst) noexcept
+    {
+        const shard_context& ctx = context();
+        if (ctx.m_runtime == this) {
+            shard& self = *this->m_shards[ctx.m_index];
+            if (ctx.m_index == dst) {
+                self.m_ready.push_back(node);
+            }
+            else if (list& pending = self.m_outbound[dst]; !pending.empty() || !this->send(node, ctx.m_index, dst)) {
+                // Keep the order of the messages: once a queue overflows, everything to that shard waits its turn
+                pending.push_back(node);
+            }
+
+            return;
+        }
+
+        shard& target = *this->m_shards[dst];
+        {
+            const std::scoped_lock lock(target.m_inbox_lock);
+            target.m_inbox.push_back(node);
+            target.m_inbox_size.fetch_add(1, std::memory_order_seq_cst);
+        }
+
+        target.m_idle.notify_one();
+    }
+
+    /**
+     * @brief Sends a coroutine through the queue between two shards; called by the thread of @a src.
+     *
+     * @param node The coroutine.
+     * @param src The index of the sending shard.
+     * @param dst The index of the target shard.
+     * @return Whether the queue had room.
+     */
+    bool send(detail::resume_node* node, std::size_t src, std::size_t dst) noexcept
+    {
+        shard& target = *this->m_shards[dst];
+        channel& q    = *target.m_inbound[src];
+        if (detail::resume_node** slot = q.try_reserve(); slot != nullptr) {
+            *slot = node;
+            q.commit();
+            target.m_idle.notify_one();
+            return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief Queues a coroutine that has run on the runtime before; used by `yield_now()`, budgets, and `offload()`.
+     *
+     * @param rt The runtime.
+     * @param node The coroutine.
+     * @param index The shard the coroutine ran on.
+     */
+    static void reschedule(void* rt, detail::resume_node* node, std::size_t index) noexcept
+    {
+        static_cast<sharded_runtime*>(rt)->post(node, index);
+    }
+
+    /**
+     * @brief Moves what other threads have sent to the shard to its run queue, and retries overflowed messages.
+     *
+     * @param self The shard of the calling thread.
+     * @param index The index of the shard.
+     * @return Whether messages are still waiting for room in a queue.
+     */
+    bool poll(shard& self, std::size_t index) noexcept
+    {
+        bool blocked = false;
+        for (std::size_t dst = 0; dst < self.m_outbound.size(); ++dst) {
+            list& pending = self.m_outbound[dst];
+            if (pending.empty()) {
+                continue;
+            }
+
+            // A node must leave the list before it is published: the receiver relinks it right away
+            shard& target = *this->m_shards[dst];
+            channel& q    = *target.m_inbound[index];
+            bool sent     = false;
+            while (!pending.empty()) {
+                detail::resume_node** slot = q.try_reserve();
+                if (slot == nullptr) {
+                    break;
+                }
+
+                *slot = pending.pop_front();
+                q.commit();
+                sent = true;
+            }
+
+            if (sent) {
+                target.m_idle.notify_one();
+            }
+
+            blocked = blocked || !pending.empty();
+        }
+
+        for (const std::unique_ptr<channel>& q : self.m_inbound) {
+            if (q != nullptr) {
+                while (detail::resume_node** slot = q->try_peek()) {
+                    self.m_ready.push_back(*slot);
+                    q->release();
+                }
+            }
+        }
+
+        if (self.m_inbox_size.load(std::memory_order_seq_cst) != 0) {
+            detail::resume_node* chain = nullptr;
+            {
+                const std::scoped_lock lock(self.m_inbox_lock);
+                chain = self.m_inbox.take_all();
+                self.m_inbox_size.store(0, std::memory_order_relaxed);
+            }
+
+            while (chain != nullptr) {
+                self.m_ready.push_back(std::exchange(chain, chain->m_next));
+            }
+        }
+
+        return blocked;
+    }
+
+    /**
+     * @brief Checks whether anybody has sent something to the shard; called by the thread of the shard.
+     *
+     * @param self The shard.
+     * @return Whether there is something to receive.
+     */
+    static bool has_input(shard& self) noexcept
+    {
+        return self.m_inbox_size.load(std::memory_order_seq_cst) != 0 ||
+               std::ranges::any_of(self.m_inbound, [](const std::unique_ptr<channel>& q) {
+                   return q != nullptr && q->try_peek() != nullptr;
+               });
+    }
+
+    /**
+     * @brief Checks whether nothing waits to be received by any shard.
+     *
+     * @return Whether all queues and inboxes are empty.
+     */
+    [[nodiscard]] bool drained() const noexcept
+    {
+        return std::ranges::all_of(this->m_shards, [](const std::unique_ptr<shard>& s) {
+            return s->m_inbox_size.load(std::memory_order_seq_cst) == 0 &&
+                   std::ranges::all_of(s->m_inbound, [](const std::unique_ptr<channel>& q) {
+                       return q == nullptr || q->empty();
+                   });
+        });
+    }
+
+    /**
+     * @brief Waits until every shard has run out of work; called by a shard that has, once the runtime is stopping.
+     *
+     * A shard that left on its own would strand its peers: a coroutine still running on another shard may send it
+     * work, or wait for room in a full queue to it. The last shard to stop therefore checks that nothing is in
+     * flight and lets all of them go. A stopped shard that receives something goes back to work; doing so bumps the
+     * generation in `m_stopped`, which makes a concurrent check fail.
+     *
+     * @param self The shard of the calling thread.
+     * @return Whether all shards have stopped; `false` if the shard has work again.
+     */
+    bool stop(shard& self) noexcept
+    {
+        // Stopped shards run nothing, so if none restarts while the queues are checked, nothing can be in flight
+        const std::uint64_t state = this->m_stopped.fetch_add(1, std::memory_order_seq_cst) + 1;
+        if ((state & stopped_mask) == this->size() && this->drained() &&
+            this->m_stopped.load(std::memory_order_seq_cst) == state) {
+            this->m_done.store(true, std::memory_order_release);
+            for (auto& s : this->m_shards) {
+                s->m_idle.notify_all();
+            }
+
+            return true;
+        }
+
+        for (;;) {
+            const detail::eventcount::key key = self.m_idle.prepare_wait();
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (this->m_done.load(std::memory_order_acquire)) {
+                self.m_idle.cancel_wait();
+                return true;
+            }
+
+            if (has_input(self)) {
+                self.m_idle.cancel_wait();
+                this->m_stopped.fetch_add(restarted, std::memory_order_seq_cst);
+                return false;
+            }
+
+            self.m_idle.wait(key);
+        }
+    }
+
+    /**
+     * @brief The event loop of a shard.
+     *
+     * @param index The index of the shard.
+     */
+    void run(std::size_t index)
+    {
+        shard& self = *this->m_shards[index];
+        if (self.m_cpu >= 0) {
+            detail::pin_to_cpu(self.m_cpu);
+        }
+
+        shard_context& ctx          = context();
+        detail::coop_context& coop  = detail::coop();
+        detail::frame_arena*& arena = detail::frame_arena::current();
+        ctx                         = {this, index};
+        coop                        = {this, &sharded_runtime::reschedule, index, 0};
+        arena                       = &self.m_frames;
+
+        for (;;) {
+            const bool blocked = this->poll(self, index);
+
+            if (!self.m_ready.empty()) {
+                // Coroutines queued while this batch runs wait for the next round, after the shard has polled again
+                detail::resume_node* chain = self.m_ready.take_all();
+                while (chain != nullptr) {
+                    detail::resume_node* node = std::exchange(chain, chain->m_next);
+                    coop.m_budget             = this->m_options.budget;
+                    node->m_handle.resume();
+                }
+            }
+            else if (blocked) {
+                std::this_thread::yield();
+            }
+            else {
+                const detail::eventcount::key key = self.m_idle.prepare_wait();
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (has_input(self)) {
+                    self.m_idle.cancel_wait();
+                }
+                else if (this->m_stop.load(std::memory_order_acquire)) {
+                    self.m_idle.cancel_wait();
+                    if (this->stop(self)) {
+                        break;
+                    }
+                }
+                else {
+                    self.m_idle.wait(key);
+                }
+            }
+        }
+
+        ctx   = {};
+        coop  = {};
+        arena = nullptr;
+    }
+};
+
+/**
+ * @example sharded_runtime.cpp
+ * Example of a key-value store partitioned between shards.
+ */
+
+}  // namespace wwa::coro
+
+#endif /* D4B81F6E_3A27_4C95_B0E2_8F6A19C53D70 */
@@ -0,0 +1,989 @@
+#ifndef F7B2D9E4_3C61_4A0F_8E57_1D6A9C3B5E82
+#define F7B2D9E4_3C61_4A0F_8E57_1D6A9C3B5E82
+
+/**
+ * @file shm_ring.h
+ * @brief Shared-memory ring for passing records between processes.
+ *
+ * This file contains the definition of the `shm_ring` class, a single-producer single-consumer ring of variable-length
+ * records in a shared memory mapping, and of the `fd_poller` class, which resumes coroutines when file descriptors
+ * become readable.
+ *
+ * @note Linux only: the ring uses `memfd_create()`, `eventfd()`, and `epoll`.
+ *
+ * Example:
+ * @snippet shm_ring.cpp shm_ring example
+ */
+
+#if !defined(__linux__)
+#    error "shm_ring.h requires Linux"
+#endif
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+#include "async_generator.h"
+#include "detail.h"
+
+namespace wwa::coro {
+
+/// @cond INTERNAL
+
+namespace detail {
+
+/**
+ * @brief An intrusive watch for a readable file descriptor.
+ *
+ * Watches live inside awaiters, so arming a watch does not allocate.
+ */
+struct fd_watch {
+    int m_fd                           = -1;       ///< The watched file descriptor.
+    void (*m_fire)(fd_watch*) noexcept = nullptr;  ///< Invoked on the poller thread when the descriptor is readable.
+};
+
+/**
+ * @brief Throws `std::system_error` for the current `errno`.
+ *
+ * @param what The name of the failed call.
+ */
+[[noreturn]] inline void throw_errno(const char* what)
+{
+    throw std::system_error(errno, std::system_category(), what);
+}
+
+/**
+ * @brief The layout of the control block at the start of the shared mapping.
+ *
+ * Positions are free-running byte counters; the index into the data area is the position modulo the capacity.
+ * Each side writes its own cache line.
+ */
+struct shm_ring_header {
+    static constexpr std::uint64_t signature = 0x676E69725F6D6873ULL;  ///< "shm_ring" in little-endian.
+
+    std::uint64_t magic    = signature;  ///< Identifies the mapping.
+    std::uint64_t capacity = 0;          ///< The size of the data area; a power of two.
+
+    alignas(cache_line_size) std::atomic<std::uint64_t> head = 0;  ///< Write position; owned by the producer.
+    std::atomic<std::uint32_t> producer_waiting              = 0;  ///< Whether the producer waits for space.
+
+    alignas(cache_line_size) std::atomic<std::uint64_t> tail = 0;  ///< Read position; owned by the consumer.
+    std::atomic<std::uint32_t> consumer_waiting              = 0;  ///< Whether the consumer waits for records.
+
+    alignas(cache_line_size) std::atomic<std::uint32_t> closed = 0;  ///< Whether the ring has been closed.
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "Shared atomics must be lock-free to be address-free");
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "Shared atomics must be lock-free to be address-free");
+
+}  // namespace detail
+
+/// @endcond
+
+/** @brief How the thread of an `fd_poller` waits for descriptors. */
+enum class poll_mode {
+    blocking,  ///< Sleep in `epoll_wait()` until a descriptor becomes readable.
+    busy       ///< Call `epoll_wait()` with a zero timeout in a loop; sleep only after a period without events.
+};
+
+/** @brief Options of `fd_poller`. */
+struct fd_poller_options {
+    poll_mode mode                      = poll_mode::blocking;             ///< How the thread waits.
+    std::chrono::microseconds busy_idle = std::chrono::microseconds(100);  ///< Busy mode: sleep after this long idle.
+};
+
+/** @brief What the thread of an `fd_poller` has done so far. */
+struct fd_poller_stats {
+    std::uint64_t busy_polls     = 0;  ///< Calls to `epoll_wait()` with a zero timeout.
+    std::uint64_t blocking_waits = 0;  ///< Calls to `epoll_wait()` that could sleep.
+    std::uint64_t completions    = 0;  ///< Watches fired.
+};
+
+/**
+ * @brief Resumes coroutines when file descriptors become readable.
+ *
+ * The poller owns a thread that waits in `epoll_wait()`. A watch is registered with `EPOLL_CTL_ADD` when it is armed
+ * and removed before it fires, so every armed watch fires at most once. Coroutines are resumed on the poller thread.
+ *
+ * In `poll_mode::busy`, the thread polls with a zero timeout instead of sleeping, which takes the kernel wake-up path
+ * off the latency of every event at the cost of a busy CPU. After `fd_poller_options::busy_idle` without events, the
+ * thread sleeps in `epoll_wait()` until the next event and then goes back to polling. `stats()` reports how many polls
+ * were made for how many completions.
+ */
+class fd_poller {
+public:
+    /**
+     * @brief Constructs a new poller and starts its thread.
+     *
+     * @param options The options.
+     * @throw std::system_error if the epoll instance cannot be created.
+     *
+     * @internal
+     * @test @a ShmRingTest.BusyPoll
+     */
+    explicit fd_poller(const fd_poller_options& options = {})
+        : m_options(options), m_epoll(::epoll_create1(EPOLL_CLOEXEC)),
+          m_wakeup(::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+    {
+        if (this->m_epoll < 0 || this->m_wakeup < 0) {
+            const int error = errno;
+            this->close_descriptors();
+            throw std::system_error(error, std::system_category(), "fd_poller");
+        }
+
+        epoll_event ev{};
+        ev.events   = EPOLLIN;
+        ev.data.ptr = nullptr;
+        if (::epoll_ctl(this->m_epoll, EPOLL_CTL_ADD, this->m_wakeup, &ev) != 0) {
+            const int error = errno;
+            this->close_descriptors();
+            throw std::system_error(error, std::system_category(), "epoll_ctl");
+        }
+
+        this->m_thread = std::thread([this] { this->run(); });
+    }
+
+    /// @cond
+    fd_poller(const fd_poller&)            = delete;
+    fd_poller(fd_poller&&)                 = delete;
+    fd_poller& operator=(const fd_poller&) = delete;
+    fd_poller& operator=(fd_poller&&)      = delete;
+    /// @endcond
+
+    /**
+     * @brief Destructor.
+     *
+     * Stops the poller thread.
+     *
+     * @warning No coroutines may be waiting on the poller when it is destroyed.
+     */
+    ~fd_poller()
+    {
+        this->m_stop.store(true, std::memory_order_release);
+        ::eventfd_write(this->m_wakeup, 1);
+        this->m_thread.join();
+        this->close_descriptors();
+    }
+
+    /**
+     * @brief Returns the process-wide poller.
+     *
+     * The poller is created on first use and is never destroyed: its destructor would join a thread that a process
+     * forked from this one does not have, so that process could never exit.
+     *
+     * @return The default poller.
+     *
+     * @internal
+     * @test @a ShmRingDeathTest.ExitAfterFork
+     */
+    static fd_poller& instance()
+    {
+        static auto* poller = new fd_poller;  // NOLINT(cppcoreguidelines-owning-memory)
+        return *poller;
+    }
+
+    /**
+     * @brief Returns the counters of the poller thread.
+     *
+     * @return The counters; they are read one by one and may be slightly out of step with each other.
+     *
+     * @internal
+     * @test @a ShmRingTest.BusyPoll
+     */
+    [[nodiscard]] fd_poller_stats stats() const noexcept
+    {
+        return {
+            .busy_polls     = this->m_busy_polls.load(std::memory_order_relaxed),
+            .blocking_waits = this->m_blocking_waits.load(std::memory_order_relaxed),
+            .completions    = this->m_completions.load(std::memory_order_relaxed),
+        };
+    }
+
+    /// @cond INTERNAL
+    /**
+     * @brief Arms a watch.
+     *
+     * @param watch The watch; `m_fd` and `m_fire` must be set, and the watch must not be armed.
+     * @return Whether the watch has been armed; if not, `errno` tells why.
+     */
+    [[nodiscard]] bool watch(detail::fd_watch* watch) noexcept
+    {
+        epoll_event ev{};
+        ev.events   = EPOLLIN;
+        ev.data.ptr = watch;
+        return ::epoll_ctl(this->m_epoll, EPOLL_CTL_ADD, watch->m_fd, &ev) == 0;
+    }
+    /// @endcond
+
+private:
+    fd_poller_options m_options;                          ///< The options.
+    int m_epoll;                                          ///< The epoll instance.
+    int m_wakeup;                                         ///< Wakes up the thread on shutdown.
+    std::atomic<bool> m_stop                    = false;  ///< Whether the thread should exit.
+    std::atomic<std::uint64_t> m_busy_polls     = 0;      ///< See `fd_poller_stats::busy_polls`.
+    std::atomic<std::uint64_t> m_blocking_waits = 0;      ///< See `fd_poller_stats::blocking_waits`.
+    std::atomic<std::uint64_t> m_completions    = 0;      ///< See `fd_poller_stats::completions`.
+    std::thread m_thread;                                 ///< The poller thread.
+
+    /**
+     * @brief Closes the epoll instance and the wakeup descriptor.
+     */
+    void close_descriptors() noexcept
+    {
+        if (this->m_epoll >= 0) {
+            ::close(this->m_epoll);
+        }
+
+        if (this->m_wakeup >= 0) {
+            ::close(this->m_wakeup);
+        }
+    }
+
+    /**
+     * @brief The body of the poller thread.
+     */
+    void run()
+    {
+        using clock = std::chrono::steady_clock;
+
+        std::array<epoll_event, 64> events{};
+        auto last_event = clock::now();
+        while (!this->m_stop.load(std::memory_order_acquire)) {
+            const bool busy =
+                this->m_options.mode == poll_mode::busy && clock::now() - last_event < this->m_options.busy_idle;
+
+            // Only the poller thread writes the counters
+            auto& counter = busy ? this->m_busy_polls : this->m_blocking_waits;
+            counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+            const int n = ::epoll_wait(this->m_epoll, events.data(), static_cast<int>(events.size()), busy ? 0 : -1);
+            if (n > 0 && this->m_options.mode == poll_mode::busy) {
+                last_event = clock::now();
+            }
+
+            for (int i = 0; i < n; ++i) {
+                if (auto* watch = static_cast<detail::fd_watch*>(events[static_cast<std::size_t>(i)].data.ptr)) {
+                    ::epoll_ctl(this->m_epoll, EPOLL_CTL_DEL, watch->m_fd, nullptr);
+                    this->m_completions.store(
+                        this->m_completions.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed
+                    );
+                    watch->m_fire(watch);
+                }
+            }
+        }
+    }
+};
+
+/**
+ * @brief A single-producer single-consumer ring of records in shared memory.
+ *
+ * The ring lives in a `memfd` mapping that can be shared with another process by passing the descriptors returned by
+ * `native_handles()` (inherited across `fork()` or sent over a Unix socket) to the attaching constructor. One process
+ * produces with `co_await ring.send(bytes)`, the other consumes with `ring.receive()`, an asynchronous generator that
+ * yields views directly into the mapping: records are copied once, by the producer, and never by the consumer.
+ *
+ * Each record is a 32-bit length followed by the payload, padded to 8 bytes. A record never wraps around the end of
+ * the data area; if it does not fit, the producer skips to the start, so that the consumer always sees the payload
+ * as one contiguous span. Because the skipped bytes count as used until the consumer passes them, a record may take
+ * at most half of the data area: only then does it fit into an empty ring wherever the positions are.
+ *
+ * Each side waits on its own `eventfd` doorbell. A side rings the other's doorbell only if the other has announced
+ * that it is about to wait; the announcement and the ring are ordered by sequentially consistent fences on both sides.
+ * Under load, neither side waits, and sending and receiving make no system calls.
+ *
+ * Waiting coroutines are resumed on the thread of the `fd_poller`.
+ *
+ * Example:
+ * @snippet shm_ring.cpp shm_ring example
+ */
+class shm_ring {
+public:
+    class send_op;
+
+    /** @brief The descriptors that identify a ring. */
+    struct handles {
+        int memory;    ///< The `memfd` with the mapping.
+        int readable;  ///< The consumer's doorbell (`eventfd`).
+        int writable;  ///< The producer's doorbell (`eventfd`).
+    };
+
+    /**
+     * @brief Creates a new ring that uses the default poller.
+     *
+     * @param capacity The size of the data area in bytes; rounded up to a power of two.
+     * @see fd_poller::instance()
+     */
+    explicit shm_ring(std::size_t capacity) : shm_ring(capacity, fd_poller::instance()) {}
+
+    /**
+     * @brief Creates a new ring.
+     *
+     * @param capacity The size of the data area in bytes; rounded up to a power of two.
+     * @param poller The poller that resumes waiting coroutines; must outlive the ring.
+     * @throw std::invalid_argument if @a capacity is zero or too large.
+     * @throw std::system_error if the mapping or the doorbells cannot be created.
+     *
+     * @internal
+     * @test @a ShmRingTest.InvalidCapacity
+     */
+    shm_ring(std::size_t capacity, fd_poller& poller) : m_poller(poller)
+    {
+        if (capacity == 0 || capacity > max_capacity) {
+            throw std::invalid_argument("Invalid capacity");
+        }
+
+        capacity = std::bit_ceil(std::max(capacity, min_capacity));
+
+        try {
+            this->m_handles.memory = ::memfd_create("wwa-coro-shm-ring", MFD_CLOEXEC);
+            if (this->m_handles.memory < 0) {
+                detail::throw_errno("memfd_create");
+            }
+
+            if (::ftruncate(this->m_handles.memory, static_cast<off_t>(header_size + capacity)) != 0) {
+                detail::throw_errno("ftruncate");
+            }
+
+            this->m_handles.readable = create_doorbell();
+            this->m_handles.writable = create_doorbell();
+            this->map(header_size + capacity);
+            this->m_header           = new (this->m_mapping) detail::shm_ring_header{};
+            this->m_header->capacity = capacity;
+            this->init_data(capacity);
+        }
+        catch (...) {
+            this->release();
+            throw;
+        }
+    }
+
+    /**
+     * @brief Attaches to an existing ring using the default poller.
+     *
+     * @param h The descriptors of the ring.
+     * @see fd_poller::instance()
+     */
+    explicit shm_ring(const handles& h) : shm_ring(h, fd_poller::instance()) {}
+
+    /**
+     * @brief Attaches to an existing ring.
+     *
+     * The descriptors are duplicated; the caller keeps ownership of @a h.
+     *
+     * @param h The descriptors of the ring.
+     * @param poller The poller that resumes waiting coroutines; must outlive the ring.
+     * @throw std::invalid_argument if the mapping does not contain a ring.
+     * @throw std::system_error if the descriptors cannot be duplicated or mapped.
+     *
+     * @internal
+     * @test @a ShmRingTest.Attach
+     */
+    shm_ring(const handles& h, fd_poller& poller) : m_poller(poller)
+    {
+        try {
+            this->m_handles.memory   = duplicate(h.memory);
+            this->m_handles.readable = duplicate(h.readable);
+            this->m_handles.writable = duplicate(h.writable);
+
+            struct stat st{};
+            if (::fstat(this->m_handles.memory, &st) != 0) {
+                detail::throw_errno("fstat");
+            }
+
+            const auto size = static_cast<std::size_t>(st.st_size);
+            if (size <= header_size) {
+                throw std::invalid_argument("Not a shm_ring");
+            }
+
+            this->map(size);
+            this->m_header = std::launder(static_cast<detail::shm_ring_header*>(this->m_mapping));
+            if (this->m_header->magic != detail::shm_ring_header::signature ||
+                this->m_header->capacity != size - header_size || !std::has_single_bit(this->m_header->capacity)) {
+                throw std::invalid_argument("Not a shm_ring");
+            }
+
+            this->init_data(this->m_header->capacity);
+        }
+        catch (...) {
+            this->release();
+            throw;
+        }
+    }
+
+    /// @cond
+    shm_ring(const shm_ring&)            = delete;
+    shm_ring(shm_ring&&)                 = delete;
+    shm_ring& operator=(const shm_ring&) = delete;
+    shm_ring& operator=(shm_ring&&)      = delete;
+    /// @endcond
+
+    /**
+     * @brief Destructor.
+     *
+     * Unmaps the ring and closes the descriptors. The ring itself lives on while another process has it mapped.
+     *
+     * @warning No coroutines may be waiting on the ring when it is destroyed.
+     */
+    ~shm_ring() { this->release(); }
+
+    /**
+     * @brief Returns the descriptors that identify the ring.
+     *
+     * @return The descriptors; owned by the ring.
+     */
+    [[nodiscard]] handles native_handles() const noexcept { return this->m_handles; }
+
+    /**
+     * @brief Returns the size of the data area.
+     *
+     * @return The capacity in bytes.
+     */
+    [[nodiscard]] std::size_t capacity() const noexcept { return this->m_mask + 1; }
+
+    /**
+     * @brief Returns the largest payload that can be sent.
+     *
+     * A record of this size takes half of the data area, so it fits into an empty ring even when the producer has to
+     * skip to the start.
+     *
+     * @return The maximum payload size in bytes.
+     *
+     * @internal
+     * @test @a ShmRingTest.InvalidCapacity
+     * @test @a ShmRingTest.LargestPayloadAfterSkip
+     */
+    [[nodiscard]] std::size_t max_payload() const noexcept { return this->capacity() / 2 - record_header_size; }
+
+    /**
+     * @brief Appends a record without suspending.
+     *
+     * May only be called by the producer.
+     *
+     * @param data The payload.
+     * @return Whether the record was appended; `false` means that the ring is full or closed.
+     * @throw std::invalid_argument if the payload is larger than `max_payload()`.
+     *
+     * @internal
+     * @test @a ShmRingTest.CrossProcess
+     */
+    bool try_send(std::span<const std::byte> data)
+    {
+        this->check_payload(data);
+        return !this->is_closed() && this->try_write(data);
+    }
+
+    /**
+     * @brief Appends a record.
+     *
+     * May only be called by the producer. The awaiting coroutine suspends while the ring does not have room for
+     * the record.
+     *
+     * @param data The payload; must stay valid until the operation completes.
+     * @return An awaitable that yields `bool`; `false` means that the ring has been closed. Awaiting it throws
+     * `std::system_error` if the doorbell cannot be watched.
+     * @throw std::invalid_argument if the payload is larger than `max_payload()`.
+     *
+     * @internal
+     * @test @a ShmRingTest.SendReceive
+     * @test @a ShmRingTest.ProducerWaitsForSpace
+     */
+    [[nodiscard]] send_op send(std::span<const std::byte> data)
+    {
+        this->check_payload(data);
+        return send_op{*this, data};
+    }
+
+    /**
+     * @brief Returns the records as they arrive.
+     *
+     * May only be called by the consumer, and only one generator may be active at a time. Each yielded span points
+     * into the shared mapping and stays valid until the generator is advanced; then the record is released to the
+     * producer. The generator suspends while the ring is empty and finishes once the ring is closed and drained.
+     *
+     * @return An asynchronous generator of payloads; advancing it throws `std::system_error` if the doorbell cannot
+     * be watched.
+     *
+     * @internal
+     * @test @a ShmRingTest.SendReceive
+     * @test @a ShmRingTest.Wraparound
+     * @test @a ShmRingTest.WatchError
+     */
+    async_generator<std::span<const std::byte>> receive()
+    {
+        for (;;) {
+            const bool closed = this->is_closed();
+            if (auto record = this->try_peek()) {
+                co_yield *record;
+                this->consume();
+            }
+            else if (closed) {
+                co_return;
+            }
+            else {
+                co_await readable_op{*this};
+            }
+        }
+    }
+
+    /**
+     * @brief Closes the ring.
+     *
+     * Subsequent sends fail, and waiting senders are resumed with `false`. The consumer receives the records sent
+     * before the ring was closed, then its generator finishes. Either side may close the ring.
+     *
+     * @internal
+     * @test @a ShmRingTest.Close
+     */
+    void close() noexcept
+    {
+        this->m_header->closed.store(1, std::memory_order_release);
+        this->ring(this->m_header->consumer_waiting, this->m_handles.readable);
+        this->ring(this->m_header->producer_waiting, this->m_handles.writable);
+    }
+
+    /**
+     * @brief Checks whether the ring has been closed.
+     *
+     * @return Whether the ring has been closed.
+     */
+    [[nodiscard]] bool is_closed() const noexcept
+    {
+        return this->m_header->closed.load(std::memory_order_acquire) != 0;
+    }
+
+private:
+    /// @cond INTERNAL
+    static constexpr std::size_t header_size        = sizeof(detail::shm_ring_header);  ///< Offset of the data area.
+    static constexpr std::size_t record_header_size = 8;                       ///< Size of the length prefix.
+    static constexpr std::size_t min_capacity       = 64;                      ///< The smallest data area.
+    static constexpr std::size_t max_capacity       = std::size_t{1} << 31;    ///< Lengths must fit into 32 bits.
+    static constexpr std::uint32_t wrap_marker = std::numeric_limits<std::uint32_t>::max();  ///< Skip to the start.
+    /// @endcond
+
+    /**
+     * @brief Base of the awaitables that wait for a doorbell.
+     *
+     * @tparam Derived The awaitable; provides `bool try_complete()`.
+     */
+    template<typename Derived>
+    class doorbell_op : private detail::fd_watch {
+    protected:
+        /**
+         * @brief Constructs a new operation.
+         *
+         * @param ring The ring.
+         * @param fd The doorbell to wait on.
+         * @param waiting The flag that announces the wait to the other side.
+         */
+        doorbell_op(shm_ring& ring, int fd, std::atomic<std::uint32_t>& waiting) noexcept
+            : m_ring(ring), m_waiting(waiting)
+        {
+            this->m_fd   = fd;
+            this->m_fire = &doorbell_op::fire;
+        }
+
+        shm_ring& m_ring;  ///< The ring.
+
+        /**
+         * @brief Throws if the doorbell could not be armed.
+         *
+         * @throw std::system_error if the doorbell could not be watched.
+         */
+        void check() const
+        {
+            if (this->m_error != 0) {
+                throw std::system_error(this->m_error, std::system_category(), "epoll_ctl");
+            }
+        }
+
+    public:
+        /**
+         * @brief Tries to complete the operation without suspending.
+         *
+         * @return Whether the operation has completed.
+         */
+        bool await_ready() { return static_cast<Derived*>(this)->try_complete(); }
+
+        /**
+         * @brief Announces the wait and arms the doorbell unless the operation completes in the meantime.
+         *
+         * @param h The awaiting coroutine.
+         * @return Whether the coroutine should stay suspended.
+         */
+        bool await_suspend(std::coroutine_handle<> h) noexcept
+        {
+            this->m_awaiting = h;
+            return !this->arm();
+        }
+
+    private:
+        std::atomic<std::uint32_t>& m_waiting;  ///< The flag that announces the wait.
+        std::coroutine_handle<> m_awaiting;     ///< The suspended coroutine.
+        int m_error = 0;                        ///< Why the doorbell could not be armed, if it could not.
+
+        /**
+         * @brief Announces the wait, re-checks, and arms the doorbell.
+         *
+         * The fence pairs with the one in `shm_ring::ring()`: either the other side sees the announcement,
+         * or this side sees the other side's progress. If the doorbell cannot be watched, the operation completes
+         * with the error, and `await_resume()` throws it in the awaiting coroutine: this may run on the poller
+         * thread, where there is nobody to catch it.
+         *
+         * @return Whether the operation has completed; if not, the awaiter must not be touched.
+         */
+        bool arm() noexcept
+        {
+            this->m_waiting.store(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (static_cast<Derived*>(this)->try_complete()) {
+                this->m_waiting.store(0, std::memory_order_relaxed);
+                return true;
+            }
+
+            if (!this->m_ring.m_poller.watch(this)) {
+                this->m_error = errno;
+                this->m_waiting.store(0, std::memory_order_relaxed);
+                return true;
+            }
+
+            return false;
+        }
+
+        /**
+         * @brief Handles the doorbell; runs on the poller thread.
+         *
+         * Wake-ups may be spurious: a doorbell rung for an earlier wait is consumed here, and the operation
+         * is re-armed.
+         *
+         * @param watch The operation.
+         */
+        static void fire(detail::fd_watch* watch) noexcept
+        {
+            auto* self = static_cast<doorbell_op*>(watch);
+            eventfd_t value;
+            ::eventfd_read(self->m_fd, &value);
+            if (self->arm()) {
+                self->m_awaiting.resume();
+            }
+        }
+    };
+
+public:
+    /**
+     * @brief Awaitable for the send operation.
+     *
+     * @see shm_ring::send()
+     */
+    class [[nodiscard]] send_op : public doorbell_op<send_op> {
+    public:
+        /// @cond INTERNAL
+        /**
+         * @brief Constructs a new send operation.
+         *
+         * @param ring The ring.
+         * @param data The payload.
+         */
+        send_op(shm_ring& ring, std::span<const std::byte> data) noexcept
+            : doorbell_op<send_op>(ring, ring.m_handles.writable, ring.m_header->producer_waiting), m_data(data)
+        {}
+        /// @endcond
+
+        /**
+         * @brief Returns the result of the operation.
+         *
+         * @return Whether the record was sent; `false` means that the ring has been closed.
+         * @throw std::system_error if the doorbell could not be watched.
+         */
+        [[nodiscard]] bool await_resume() const
+        {
+            this->check();
+            return this->m_sent;
+        }
+
+    private:
+        friend class doorbell_op<send_op>;
+
+        std::span<const std::byte> m_data;  ///< The payload.
+        bool m_sent = false;                ///< Whether the record was sent.
+
+        /**
+         * @brief Appends the record if there is room.
+         *
+         * @return Whether the operation has completed.
+         */
+        bool try_complete()
+        {
+            if (this->m_ring.is_closed()) {
+                return true;
+            }
+
+            this->m_sent = this->m_ring.try_write(this->m_data);
+            return this->m_sent;
+        }
+    };
+
+private:
+    /** @brief Awaitable that waits until a record is available or the ring is closed. */
+    class [[nodiscard]] readable_op : public doorbell_op<readable_op> {
+    public:
+        /**
+         * @brief Constructs a new operation.
+         *
+         * @param ring The ring.
+         */
+        explicit readable_op(shm_ring& ring) noexcept
+            : doorbell_op<readable_op>(ring, ring.m_handles.readable, ring.m_header->consumer_waiting)
+        {}
+
+        /**
+         * @brief Completes the wait.
+         *
+         * @throw std::system_error if the doorbell could not be watched.
+         */
+        void await_resume() const { this->check(); }
+
+    private:
+        friend class doorbell_op<readable_op>;
+
+        /**
+         * @brief Checks whether the consumer can proceed.
+         *
+         * @return Whether a record is available or the ring is closed.
+         */
+        [[nodiscard]] bool try_complete() const noexcept
+        {
+            const detail::shm_ring_header* header = this->m_ring.m_header;
+            return header->head.load(std::memory_order_acquire) != header->tail.load(std::memory_order_relaxed) ||
+                   this->m_ring.is_closed();
+        }
+    };
+
+    fd_poller& m_poller;                          ///< Resumes waiting coroutines.
+    handles m_handles{-1, -1, -1};                ///< The descriptors of the ring.
+    void* m_mapping                   = nullptr;  ///< The shared mapping.
+    std::size_t m_mapping_size        = 0;        ///< The size of the mapping.
+    detail::shm_ring_header* m_header = nullptr;  ///< The control block.
+    std::byte* m_data                 = nullptr;  ///< The data area.
+    std::size_t m_mask                = 0;        ///< `capacity - 1`.
+    std::uint64_t m_read_end          = 0;        ///< The read position after the record being consumed.
+
+    /**
+     * @brief Creates a doorbell.
+     *
+     * @return The `eventfd`.
+     */
+    static int create_doorbell()
+    {
+        const int fd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (fd < 0) {
+            detail::throw_errno("eventfd");
+        }
+
+        return fd;
+    }
+
+    /**
+     * @brief Duplicates a descriptor.
+     *
+     * @param fd The descriptor.
+     * @return The duplicate.
+     */
+    static int duplicate(int fd)
+    {
+        const int copy = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+        if (copy < 0) {
+            detail::throw_errno("fcntl");
+        }
+
+        return copy;
+    }
+
+    /**
+     * @brief Maps the ring.
+     *
+     * @param size The size of the mapping.
+     */
+    void map(std::size_t size)
+    {
+        void* addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, this->m_handles.memory, 0);
+        if (addr == MAP_FAILED) {
+            detail::throw_errno("mmap");
+        }
+
+        this->m_mapping      = addr;
+        this->m_mapping_size = size;
+    }
+
+    /**
+     * @brief Sets up the view of the data area.
+     *
+     * @param capacity The size of the data area.
+     */
+    void init_data(std::size_t capacity) noexcept
+    {
+        this->m_data     = static_cast<std::byte*>(this->m_mapping) + header_size;
+        this->m_mask     = capacity - 1;
+        this->m_read_end = this->m_header->tail.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Unmaps the ring and closes the descriptors.
+     */
+    void release() noexcept
+    {
+        if (this->m_mapping != nullptr) {
+            ::munmap(this->m_mapping, this->m_mapping_size);
+            this->m_mapping = nullptr;
+        }
+
+        for (int fd : {this->m_handles.memory, this->m_handles.readable, this->m_handles.writable}) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+
+        this->m_handles = {-1, -1, -1};
+    }
+
+    /**
+     * @brief Rejects payloads that can never fit.
+     *
+     * @param data The payload.
+     */
+    void check_payload(std::span<const std::byte> data) const
+    {
+        if (data.size() > this->max_payload()) {
+            throw std::invalid_argument("Payload is larger than the ring");
+        }
+    }
+
+    /**
+     * @brief Returns the space taken by a record.
+     *
+     * @param length The payload size.
+     * @return The record size, including the length prefix and the padding.
+     */
+    static constexpr std::size_t record_size(std::size_t length) noexcept
+    {
+        return record_header_size + ((length + record_header_size - 1) & ~(record_header_size - 1));
+    }
+
+    /**
+     * @brief Appends a record if there is room; producer only.
+     *
+     * @param data The payload.
+     * @return Whether the record was appended.
+     */
+    bool try_write(std::span<const std::byte> data) noexcept
+    {
+        const std::size_t capacity = this->capacity();
+        const std::size_t size     = record_size(data.size());
+
+        std::uint64_t head       = this->m_header->head.load(std::memory_order_relaxed);
+        const std::uint64_t tail = this->m_header->tail.load(std::memory_order_acquire);
+
+        std::size_t index      = head & this->m_mask;
+        const std::size_t skip = capacity - index < size ? capacity - index : 0;
+        if (capacity - (head - tail) < skip + size) {
+            return false;
+        }
+
+        if (skip != 0) {
+            std::memcpy(this->m_data + index, &wrap_marker, sizeof(wrap_marker));
+            head += skip;
+            index = 0;
+        }
+
+        const auto length = static_cast<std::uint32_t>(data.size());
+        std::memcpy(this->m_data + index, &length, sizeof(length));
+        if (!data.empty()) {
+            std::memcpy(this->m_data + index + record_header_size, data.data(), data.size());
+        }
+
+        this->m_header->head.store(head + size, std::memory_order_release);
+        this->ring(this->m_header->consumer_waiting, this->m_handles.readable);
+        return true;
+    }
+
+    /**
+     * @brief Returns the oldest record without releasing it; consumer only.
+     *
+     * @return The payload; an empty optional if the ring is empty.
+     */
+    std::optional<std::span<const std::byte>> try_peek() noexcept
+    {
+        std::uint64_t tail       = this->m_header->tail.load(std::memory_order_relaxed);
+        const std::uint64_t head = this->m_header->head.load(std::memory_order_acquire);
+        if (tail == head) {
+            return std::nullopt;
+        }
+
+        std::size_t index = tail & this->m_mask;
+        std::uint32_t length;
+        std::memcpy(&length, this->m_data + index, sizeof(length));
+        if (length == wrap_marker) {
+            // The producer always writes a record after the marker
+            tail += this->capacity() - index;
+            index = 0;
+            std::memcpy(&length, this->m_data, sizeof(length));
+        }
+
+        this->m_read_end = tail + record_size(length);
+        return std::span<const std::byte>(this->m_data + index + record_header_size, length);
+    }
+
+    /**
+     * @brief Releases the record returned by the last `try_peek()`; consumer only.
+     */
+    void consume() noexcept
+    {
+        this->m_header->tail.store(this->m_read_end, std::memory_order_release);
+        this->ring(this->m_header->producer_waiting, this->m_handles.writable);
+    }
+
+    /**
+     * @brief Rings the other side's doorbell if it has announced a wait.
+     *
+     * The fence pairs with the one in `doorbell_op::arm()`.
+     *
+     * @param waiting The other side's announcement.
+     * @param fd The other side's doorbell.
+     */
+    static void ring(std::atomic<std::uint32_t>& waiting, int fd) noexcept
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting.load(std::memory_order_relaxed) != 0 && waiting.exchange(0, std::memory_order_relaxed) != 0) {
+            ::eventfd_write(fd, 1);
+        }
+    }
+};
+
+/**
+ * @example shm_ring.cpp
+ * Example of passing records to a child process through a shared-memory ring.
+ */
+
+}  // namespace wwa::coro
+
+#endif /* F7B2D9E4_3C61_4A0F_8E57_1D6A9C3B5E82 */
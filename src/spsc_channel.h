@@ -0,0 +1,368 @@
+#ifndef E0C5B1F2_4D8A_4B2E_9F61_0A7C3D92B418
+#define E0C5B1F2_4D8A_4B2E_9F61_0A7C3D92B418
+
+/**
+ * @file spsc_channel.h
+ * @brief Single-producer single-consumer channel with zero-copy slot loans.
+ *
+ * This file contains the definition of the `spsc_channel` class template. Unlike `channel`, values are never copied
+ * in or out: the producer borrows a free slot, fills it in place, and commits it; the consumer borrows a filled slot,
+ * reads it in place, and releases it.
+ *
+ * Example:
+ * @snippet spsc_channel.cpp spsc_channel example
+ */
+
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <coroutine>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+
+#include "detail.h"
+
+namespace wwa::coro {
+
+/**
+ * @brief A bounded single-producer single-consumer channel with zero-copy slot loans.
+ *
+ * The channel owns a ring of `T` objects, which are constructed once and reused. The producer side is
+ * `co_await reserve()` followed by `commit()`; the consumer side is `co_await peek()` followed by `release()`.
+ * Both awaitables complete without suspending while the ring is not full (producer) or not empty (consumer).
+ *
+ * The read and write indices live on separate cache lines; each side keeps a cached copy of the opposite index
+ * and only reloads it when the cached value suggests the ring is full or empty, so in steady state the two sides
+ * do not touch each other's cache lines.
+ *
+ * Exactly one coroutine (or thread) may act as the producer and exactly one as the consumer at any given time.
+ *
+ * Example:
+ * @snippet spsc_channel.cpp spsc_channel example
+ *
+ * @tparam T The type of the slots; must be default-initializable.
+ */
+template<std::default_initializable T>
+class spsc_channel {
+public:
+    /** @brief The type of the slots. */
+    using value_type = T;
+
+    /**
+     * @brief Constructs a new channel.
+     *
+     * @param capacity The number of slots; rounded up to the next power of two.
+     * @throw std::invalid_argument @a capacity is zero.
+     *
+     * @internal
+     * @test @a SpscChannelTest.ZeroCapacity
+     * @test @a SpscChannelTest.Capacity
+     */
+    explicit spsc_channel(std::size_t capacity)
+        : m_mask(std::bit_ceil(check_capacity(capacity)) - 1), m_slots(std::make_unique<T[]>(this->m_mask + 1))
+    {}
+
+    /// @cond
+    spsc_channel(const spsc_channel&)            = delete;
+    spsc_channel(spsc_channel&&)                 = delete;
+    spsc_channel& operator=(const spsc_channel&) = delete;
+    spsc_channel& operator=(spsc_channel&&)      = delete;
+    ~spsc_channel()                              = default;
+    /// @endcond
+
+    /**
+     * @brief Returns the capacity of the channel.
+     *
+     * @return The number of slots.
+     */
+    [[nodiscard]] constexpr std::size_t capacity() const noexcept { return this->m_mask + 1; }
+
+    /**
+     * @brief Borrows a free slot without suspending.
+     *
+     * @return Pointer to the free slot; `nullptr` if the channel is full or closed.
+     * @note The slot must be published with `commit()` before the next slot can be borrowed.
+     *
+     * @internal
+     * @test @a SpscChannelTest.TryReservePeek
+     */
+    [[nodiscard]] T* try_reserve() noexcept
+    {
+        if (this->is_closed()) {
+            return nullptr;
+        }
+
+        const std::size_t tail = this->m_producer.index.load(std::memory_order_relaxed);
+        if (tail - this->m_producer.cached >= this->capacity()) {
+            this->m_producer.cached = this->m_consumer.index.load(std::memory_order_acquire);
+            if (tail - this->m_producer.cached >= this->capacity()) {
+                return nullptr;
+            }
+        }
+
+        return &this->m_slots[tail & this->m_mask];
+    }
+
+    /**
+     * @brief Borrows a free slot.
+     *
+     * The returned awaitable suspends while the channel is full.
+     *
+     * @return An awaitable that yields a pointer to the free slot, or `nullptr` if the channel has been closed.
+     *
+     * @internal
+     * @test @a SpscChannelTest.ReserveCommitPeekRelease
+     * @test @a SpscChannelTest.ProducerSuspendsWhenFull
+     */
+    [[nodiscard]] auto reserve() noexcept
+    {
+        return slot_op<&spsc_channel::try_reserve, &spsc_channel::can_reserve, &spsc_channel::m_producer_waiter>{*this};
+    }
+
+    /**
+     * @brief Publishes the slot borrowed with `reserve()` and resumes the consumer if it is waiting.
+     */
+    void commit()
+    {
+        const std::size_t tail = this->m_producer.index.load(std::memory_order_relaxed);
+        this->m_producer.index.store(tail + 1, std::memory_order_release);
+        wake(this->m_consumer_waiter);
+    }
+
+    /**
+     * @brief Borrows the oldest filled slot without suspending.
+     *
+     * @return Pointer to the filled slot; `nullptr` if the channel is empty.
+     * @note The slot must be returned with `release()` before the next slot can be borrowed.
+     *
+     * @internal
+     * @test @a SpscChannelTest.TryReservePeek
+     */
+    [[nodiscard]] T* try_peek() noexcept
+    {
+        const std::size_t head = this->m_consumer.index.load(std::memory_order_relaxed);
+        if (head == this->m_consumer.cached) {
+            this->m_consumer.cached = this->m_producer.index.load(std::memory_order_acquire);
+            if (head == this->m_consumer.cached) {
+                return nullptr;
+            }
+        }
+
+        return &this->m_slots[head & this->m_mask];
+    }
+
+    /**
+     * @brief Borrows the oldest filled slot.
+     *
+     * The returned awaitable suspends while the channel is empty.
+     *
+     * @return An awaitable that yields a pointer to the filled slot, or `nullptr` if the channel is closed and drained.
+     *
+     * @internal
+     * @test @a SpscChannelTest.ReserveCommitPeekRelease
+     * @test @a SpscChannelTest.ConsumerSuspendsWhenEmpty
+     */
+    [[nodiscard]] auto peek() noexcept
+    {
+        return slot_op<&spsc_channel::try_peek, &spsc_channel::can_peek, &spsc_channel::m_consumer_waiter>{*this};
+    }
+
+    /**
+     * @brief Returns the slot borrowed with `peek()` to the producer and resumes the producer if it is waiting.
+     */
+    void release()
+    {
+        const std::size_t head = this->m_consumer.index.load(std::memory_order_relaxed);
+        this->m_consumer.index.store(head + 1, std::memory_order_release);
+        wake(this->m_producer_waiter);
+    }
+
+    /**
+     * @brief Closes the channel.
+     *
+     * After the channel is closed, `reserve()` yields `nullptr`; `peek()` yields the remaining committed slots
+     * and then `nullptr`. Suspended coroutines are resumed.
+     *
+     * @internal
+     * @test @a SpscChannelTest.Close
+     */
+    void close()
+    {
+        this->m_closed.store(true, std::memory_order_release);
+        wake(this->m_producer_waiter);
+        wake(this->m_consumer_waiter);
+    }
+
+    /**
+     * @brief Checks whether the channel has been closed.
+     *
+     * @return Whether the channel has been closed.
+     */
+    [[nodiscard]] bool is_closed() const noexcept { return this->m_closed.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Checks whether every committed slot has been released.
+     *
+     * May be called from any thread; the answer may be stale by the time it is used.
+     *
+     * @return Whether the channel is empty.
+     */
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return this->m_consumer.index.load(std::memory_order_acquire) ==
+               this->m_producer.index.load(std::memory_order_acquire);
+    }
+
+private:
+    /** @brief An index owned by one side, together with that side's cached copy of the opposite index. */
+    struct alignas(detail::cache_line_size) side {
+        std::atomic<std::size_t> index = 0;  ///< The index owned by this side.
+        std::size_t cached             = 0;  ///< Cached copy of the opposite index.
+    };
+
+    const std::size_t m_mask;                                                   ///< Capacity minus one.
+    std::unique_ptr<T[]> m_slots;                                               ///< The slots.
+    side m_producer;                                                            ///< Write index.
+    side m_consumer;                                                            ///< Read index.
+    alignas(detail::cache_line_size) std::atomic<void*> m_producer_waiter = nullptr;  ///< Suspended producer.
+    alignas(detail::cache_line_size) std::atomic<void*> m_consumer_waiter = nullptr;  ///< Suspended consumer.
+    std::atomic<bool> m_closed                                            = false;    ///< Whether the channel is closed.
+
+    /**
+     * @brief Validates the capacity of the channel.
+     *
+     * @param capacity The requested capacity.
+     * @return @a capacity
+     * @throw std::invalid_argument @a capacity is zero.
+     */
+    static std::size_t check_capacity(std::size_t capacity)
+    {
+        if (capacity == 0) {
+            throw std::invalid_argument("spsc_channel capacity must be greater than zero");
+        }
+
+        return capacity;
+    }
+
+    /**
+     * @brief Checks whether `reserve()` can complete without touching the producer's state.
+     *
+     * @return Whether a slot is free or the channel is closed.
+     */
+    [[nodiscard]] bool can_reserve() const noexcept
+    {
+        return this->is_closed() || this->m_producer.index.load(std::memory_order_relaxed) -
+                                            this->m_consumer.index.load(std::memory_order_acquire) <
+                                        this->capacity();
+    }
+
+    /**
+     * @brief Checks whether `peek()` can complete without touching the consumer's state.
+     *
+     * @return Whether a slot is filled or the channel is closed.
+     */
+    [[nodiscard]] bool can_peek() const noexcept
+    {
+        return this->is_closed() || this->m_consumer.index.load(std::memory_order_relaxed) !=
+                                        this->m_producer.index.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Resumes the coroutine parked in @a waiter, if any.
+     *
+     * The fence pairs with the one in `slot_op::await_suspend()`: either the waker sees the parked coroutine,
+     * or the coroutine sees the state change that made it ready.
+     *
+     * @param waiter The waiter slot.
+     */
+    static void wake(std::atomic<void*>& waiter)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiter.load(std::memory_order_relaxed) != nullptr) {
+            if (void* addr = waiter.exchange(nullptr, std::memory_order_acquire); addr != nullptr) {
+                std::coroutine_handle<>::from_address(addr).resume();
+            }
+        }
+    }
+
+    /**
+     * @brief Awaitable that borrows a slot.
+     *
+     * @tparam TryAcquire Non-suspending acquisition function (`try_reserve` or `try_peek`).
+     * @tparam CanAcquire Read-only readiness check (`can_reserve` or `can_peek`).
+     * @tparam Waiter The waiter slot of the side performing the operation.
+     */
+    template<
+        T* (spsc_channel::*TryAcquire)() noexcept, bool (spsc_channel::*CanAcquire)() const noexcept,
+        std::atomic<void*> spsc_channel::*Waiter>
+    class [[nodiscard]] slot_op {
+    public:
+        /**
+         * @brief Constructs a new operation.
+         *
+         * @param ch The channel.
+         */
+        explicit slot_op(spsc_channel& ch) noexcept : m_channel(ch) {}
+
+        /**
+         * @brief Tries to borrow a slot without suspending.
+         *
+         * @return Whether the operation has completed.
+         */
+        bool await_ready() noexcept
+        {
+            this->m_slot = (this->m_channel.*TryAcquire)();
+            return this->m_slot != nullptr || this->m_channel.is_closed();
+        }
+
+        /**
+         * @brief Parks the coroutine until a slot becomes available or the channel is closed.
+         *
+         * @param h The awaiting coroutine.
+         * @return Whether the coroutine should stay suspended.
+         */
+        bool await_suspend(std::coroutine_handle<> h) noexcept
+        {
+            // Once the handle is published, the coroutine may be resumed by another thread at any moment;
+            // the awaiter must not be touched until the handle is taken back.
+            const spsc_channel& ch = this->m_channel;
+            auto& waiter           = this->m_channel.*Waiter;
+            waiter.store(h.address(), std::memory_order_release);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            if (!(ch.*CanAcquire)()) {
+                return true;
+            }
+
+            return waiter.exchange(nullptr, std::memory_order_acquire) == nullptr;
+        }
+
+        /**
+         * @brief Returns the borrowed slot.
+         *
+         * @return Pointer to the slot; `nullptr` if the channel has been closed (and, for `peek()`, drained).
+         */
+        T* await_resume() noexcept
+        {
+            if (this->m_slot == nullptr) {
+                this->m_slot = (this->m_channel.*TryAcquire)();
+            }
+
+            return this->m_slot;
+        }
+
+    private:
+        spsc_channel& m_channel;  ///< The channel.
+        T* m_slot = nullptr;      ///< The borrowed slot.
+    };
+};
+
+/**
+ * @example spsc_channel.cpp
+ * Example of zero-copy slot loans with an SPSC channel.
+ */
+
+}  // namespace wwa::coro
+
+#endif /* E0C5B1F2_4D8A_4B2E_9F61_0A7C3D92B418 */
@@ -0,0 +1,631 @@
+#ifndef F9416BD6_25CD_4AD7_8F7D_13AA74D66158
+#define F9416BD6_25CD_4AD7_8F7D_13AA74D66158
+
+/**
+ * @file static_graph.h
+ * @brief Task graphs whose shape is known at compile time.
+ *
+ * This file contains the definition of the `static_graph` class template. The graph is a type:
+ * `static_graph<node<A>, node<B, depends<A>>>` is a pipeline where `B` runs after `A` and receives a reference to its
+ * result. Dependencies are resolved, checked for cycles and sorted topologically at compile time; all storage is part
+ * of the graph object.
+ *
+ * Example:
+ * @snippet static_graph.cpp static_graph example
+ */
+
+#include <array>
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "eager_task.h"
+#include "exceptions.h"
+#include "task.h"
+
+namespace wwa::coro {
+
+/**
+ * @brief The dependencies of a `node` of a `static_graph`.
+ *
+ * @tparam Deps The function types of the nodes that must finish first.
+ */
+template<typename... Deps>
+struct depends {};
+
+/**
+ * @brief A node of a `static_graph`.
+ *
+ * @tparam F The function of the node; its type identifies the node within the graph.
+ * @tparam Deps The dependencies of the node, as `depends<...>`.
+ */
+template<typename F, typename Deps = depends<>>
+struct node;
+
+/// @cond
+template<typename F, typename... Deps>
+struct node<F, depends<Deps...>> {
+    using function     = F;                 ///< The function of the node.
+    using dependencies = depends<Deps...>;  ///< The dependencies of the node.
+};
+/// @endcond
+
+/// @cond INTERNAL
+namespace detail {
+
+/** @brief What the result of a predecessor contributes to the arguments of a node: a reference to it. */
+template<typename T>
+struct static_arg {
+    using type = std::tuple<T&>;  ///< The arguments.
+};
+
+/** @brief What a predecessor without a result contributes to the arguments of a node: nothing. */
+template<>
+struct static_arg<void> {
+    using type = std::tuple<>;  ///< The arguments.
+};
+
+/**
+ * @brief Everything `static_graph` computes at compile time.
+ *
+ * Nodes are numbered in the order they are listed; `edges[i][j]` is the number of times node `j` lists node `i` as a
+ * dependency.
+ */
+template<typename... Nodes>
+struct static_graph_traits {
+    static constexpr std::size_t size = sizeof...(Nodes);  ///< The number of nodes.
+
+    /** @brief The `I`-th node. */
+    template<std::size_t I>
+    using node_t = std::tuple_element_t<I, std::tuple<Nodes...>>;
+
+    /** @brief The function of the `I`-th node. */
+    template<std::size_t I>
+    using function_t = typename node_t<I>::function;
+
+    /**
+     * @brief Finds the node with function `F`.
+     *
+     * @return The index of the first node with function `F`, or `size` if there is none.
+     */
+    template<typename F>
+    static consteval std::size_t index_of() noexcept
+    {
+        constexpr std::array<bool, size> matches{std::is_same_v<F, typename Nodes::function>...};
+        for (std::size_t i = 0; i < size; ++i) {
+            if (matches[i]) {
+                return i;
+            }
+        }
+
+        return size;
+    }
+
+    /**
+     * @brief Finds the dependencies of a node.
+     *
+     * @return The indices of the dependencies, in order; `size` for unknown ones.
+     */
+    template<typename... Deps>
+    static consteval std::array<std::size_t, sizeof...(Deps)> indices(depends<Deps...>) noexcept
+    {
+        return {index_of<Deps>()...};
+    }
+
+    /** @brief The indices of the dependencies of the `I`-th node. */
+    template<std::size_t I>
+    static constexpr auto dependencies = indices(typename node_t<I>::dependencies{});
+
+    /** @brief The adjacency matrix of the graph. */
+    static constexpr auto edges = [] {
+        std::array<std::array<std::size_t, size>, size> result{};
+        [&result]<std::size_t... J>(std::index_sequence<J...>) {
+            (
+                [&result] {
+                    for (std::size_t i : dependencies<J>) {
+                        if (i < size) {
+                            ++result[i][J];
+                        }
+                    }
+                }(),
+                ...
+            );
+        }(std::make_index_sequence<size>{});
+
+        return result;
+    }();
+
+    /** @brief The number of dependencies of every node. */
+    static constexpr auto in_degree = [] {
+        std::array<std::size_t, size> result{};
+        for (std::size_t i = 0; i < size; ++i) {
+            for (std::size_t j = 0; j < size; ++j) {
+                result[j] += edges[i][j];
+            }
+        }
+
+        return result;
+    }();
+
+    /**
+     * @brief Checks whether the `I`-th node has no successors.
+     *
+     * @return Whether no node depends on the `I`-th one.
+     */
+    template<std::size_t I>
+    static consteval bool is_sink() noexcept
+    {
+        for (std::size_t j = 0; j < size; ++j) {
+            if (edges[I][j] != 0) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /** @brief The number of nodes without successors. */
+    static constexpr std::size_t sinks = []<std::size_t... I>(std::index_sequence<I...>) {
+        return (std::size_t{0} + ... + static_cast<std::size_t>(is_sink<I>()));
+    }(std::make_index_sequence<size>{});
+
+    /** @brief The nodes in topological order (Kahn's algorithm); incomplete if the graph has a cycle. */
+    static constexpr auto order = [] {
+        std::array<std::size_t, size> pending = in_degree;
+        std::array<std::size_t, size> result{};
+        std::size_t tail = 0;
+
+        for (std::size_t i = 0; i < size; ++i) {
+            if (pending[i] == 0) {
+                result[tail++] = i;
+            }
+        }
+
+        for (std::size_t head = 0; head < tail; ++head) {
+            for (std::size_t j = 0; j < size; ++j) {
+                if (edges[result[head]][j] != 0) {
+                    pending[j] -= edges[result[head]][j];
+                    if (pending[j] == 0) {
+                        result[tail++] = j;
+                    }
+                }
+            }
+        }
+
+        return std::pair{result, tail};
+    }();
+
+    /** @brief Whether no two nodes share a function type. */
+    static constexpr bool unique = []<std::size_t... I>(std::index_sequence<I...>) {
+        return ((index_of<function_t<I>>() == I) && ...);
+    }(std::make_index_sequence<size>{});
+
+    /** @brief Whether every dependency is a node of the graph. */
+    static constexpr bool known = [] {
+        std::size_t count = 0;
+        for (const auto& row : edges) {
+            for (std::size_t n : row) {
+                count += n;
+            }
+        }
+
+        return count == []<std::size_t... I>(std::index_sequence<I...>) {
+            return (std::size_t{0} + ... + dependencies<I>.size());
+        }(std::make_index_sequence<size>{});
+    }();
+
+    /** @brief Whether the graph has no cycles. */
+    static constexpr bool acyclic = order.second == size;
+
+    /** @brief The result type of the `I`-th node. */
+    template<std::size_t I, typename Deps = typename node_t<I>::dependencies>
+    struct result;
+
+    /// @cond
+    template<std::size_t I, typename... Deps>
+    struct result<I, depends<Deps...>> {
+        /// The arguments of the function.
+        using args = decltype(std::tuple_cat(
+            std::declval<typename static_arg<typename result<index_of<Deps>()>::type>::type>()...
+        ));
+
+        /// The result type.
+        using type =
+            typename unwrap_task<decltype(std::apply(std::declval<function_t<I>&>(), std::declval<args>()))>::type;
+    };
+    /// @endcond
+
+    /** @brief The result type of the `I`-th node. */
+    template<std::size_t I>
+    using result_t = typename result<I>::type;
+
+    /** @brief How the result of the `I`-th node is stored; `std::monostate` stands in for `void`. */
+    template<std::size_t I>
+    using slot_t = std::optional<std::conditional_t<std::is_void_v<result_t<I>>, std::monostate, result_t<I>>>;
+
+};
+
+}  // namespace detail
+/// @endcond
+
+/**
+ * @brief A graph of dependent tasks whose shape is part of its type.
+ *
+ * `static_graph<node<A>, node<B, depends<A>>, node<C, depends<A, B>>>` describes a pipeline of three function objects.
+ * The type of a function identifies its node; the nodes may be listed in any order. Like in `task_graph`, a function
+ * receives lvalue references to the results of the dependencies that produce one, in the order they are listed, and
+ * may return a `task<>`.
+ *
+ * Unknown dependencies, duplicate nodes and cycles are compile-time errors. Everything else the scheduling needs is
+ * computed at compile time as well: the successors of every node are unrolled into straight-line code, a node with a
+ * single predecessor is started by that predecessor without touching an atomic counter, and only nodes without
+ * successors count towards completion. The results live in a `std::tuple` inside the graph object; there are no
+ * virtual calls and no allocations apart from the coroutine frames.
+ *
+ * `co_await g.run(sched)` runs independent nodes in parallel on `sched`; `co_await g.run()` runs all nodes inline, one
+ * after another, in topological order. If a node throws, the nodes that depend on it, directly or not, are skipped
+ * and get the same exception; `run()` rethrows the exception of the earliest listed node that has one.
+ *
+ * Example:
+ * @snippet static_graph.cpp static_graph example
+ *
+ * @tparam Nodes The nodes, as `node<F, depends<...>>`.
+ * @note Nodes that run in parallel may receive references to the same result; they should only read it.
+ */
+template<typename... Nodes>
+class static_graph {
+    using traits = detail::static_graph_traits<Nodes...>;
+
+    static_assert(traits::unique, "static_graph: two nodes have the same function type");
+    static_assert(traits::known, "static_graph: a dependency is not a node of the graph");
+    static_assert(traits::acyclic, "static_graph: the dependencies form a cycle");
+
+    /** @brief How the results of all nodes are stored. */
+    using results = decltype([]<std::size_t... I>(std::index_sequence<I...>) {
+        return std::tuple<typename traits::template slot_t<I>...>{};
+    }(std::make_index_sequence<traits::size>{}));
+
+public:
+    /**
+     * @brief The result type of the node with function `F`.
+     *
+     * @tparam F The function type of the node.
+     */
+    template<typename F>
+    using result_t = typename traits::template result_t<traits::template index_of<F>()>;
+
+    /** @brief Constructs a graph with default-constructed functions. */
+    static_graph() = default;
+
+    /**
+     * @brief Constructs a graph with the given functions.
+     *
+     * @param fns The functions of the nodes, in the order the nodes are listed.
+     */
+    explicit static_graph(typename Nodes::function... fns)
+        requires(sizeof...(Nodes) > 0)
+        : m_functions(std::move(fns)...)
+    {}
+
+    /// @cond
+    static_graph(const static_graph&)            = delete;
+    static_graph(static_graph&&)                 = delete;
+    static_graph& operator=(const static_graph&) = delete;
+    static_graph& operator=(static_graph&&)      = delete;
+    ~static_graph()                              = default;
+    /// @endcond
+
+    /**
+     * @brief Returns the number of nodes.
+     *
+     * @return The number of nodes.
+     */
+    [[nodiscard]] static constexpr std::size_t size() noexcept { return traits::size; }
+
+    /**
+     * @brief Returns the order in which `run()` without a scheduler runs the nodes.
+     *
+     * @return The indices of the nodes, in the order they are listed, sorted topologically.
+     *
+     * @internal
+     * @test @a StaticGraphTest.Order
+     */
+    [[nodiscard]] static constexpr std::array<std::size_t, sizeof...(Nodes)> order() noexcept
+    {
+        return traits::order.first;
+    }
+
+    /**
+     * @brief Runs the graph on a scheduler.
+     *
+     * The graph may run again once the previous run has completed; every run starts from scratch.
+     *
+     * @param sched The scheduler to run the nodes on; anything with a `schedule()` awaitable, such as `thread_pool`.
+     * @return A task that completes when all nodes have finished.
+     * @throw Whatever the earliest listed failed node has thrown.
+     *
+     * @internal
+     * @test @a StaticGraphTest.Diamond
+     * @test @a StaticGraphTest.Parallel
+     * @test @a StaticGraphTest.Exception
+     * @test @a StaticGraphTest.Empty
+     * @test @a StaticGraphTest.Rerun
+     */
+    template<typename Scheduler>
+    task<> run(Scheduler& sched)
+    {
+        this->reset();
+
+        // One extra count for `run()` itself: the last node to finish must not resume it before it has suspended
+        this->m_remaining.store(traits::sinks + 1, std::memory_order_relaxed);
+        [this, &sched]<std::size_t... I>(std::index_sequence<I...>) {
+            (this->template start<I>(sched), ...);
+        }(std::make_index_sequence<traits::size>{});
+
+        co_await completion{*this};
+        this->rethrow();
+    }
+
+    /**
+     * @brief Runs the graph inline, one node after another, in topological order.
+     *
+     * @return A task that completes when all nodes have finished.
+     * @throw Whatever the earliest listed failed node has thrown.
+     *
+     * @internal
+     * @test @a StaticGraphTest.Inline
+     * @test @a StaticGraphTest.Exception
+     */
+    task<> run()
+    {
+        this->reset();
+        co_await this->run_sequential(std::make_index_sequence<traits::size>{});
+        this->rethrow();
+    }
+
+    /**
+     * @brief Returns the result of a node after the graph has run.
+     *
+     * @tparam F The function type of the node.
+     * @return A reference to the result; nothing if the node produces nothing.
+     * @throw bad_result_access if the graph has not run yet.
+     * @throw Whatever the node or one of its dependencies has thrown.
+     *
+     * @internal
+     * @test @a StaticGraphTest.Diamond
+     * @test @a StaticGraphTest.Exception
+     * @test @a StaticGraphTest.Rerun
+     */
+    template<typename F>
+    std::add_lvalue_reference_t<result_t<F>> get()
+    {
+        constexpr std::size_t index = traits::template index_of<F>();
+        static_assert(index < traits::size, "static_graph: F is not a node of the graph");
+
+        if (this->m_exceptions[index] != nullptr) {
+            std::rethrow_exception(this->m_exceptions[index]);
+        }
+
+        auto& slot = std::get<index>(this->m_results);
+        if (!slot.has_value()) {
+            throw bad_result_access("static_graph node has not run");
+        }
+
+        if constexpr (!std::is_void_v<result_t<F>>) {
+            return *slot;
+        }
+    }
+
+private:
+    /** @brief Awaitable that waits for the last node to finish. */
+    struct completion {
+        static_graph& m_graph;  ///< The graph.
+
+        [[nodiscard]] constexpr bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(std::coroutine_handle<> h) noexcept
+        {
+            this->m_graph.m_waiter = h;
+            return this->m_graph.m_remaining.fetch_sub(1, std::memory_order_acq_rel) != 1;
+        }
+
+        constexpr void await_resume() const noexcept {}
+    };
+
+    std::tuple<typename Nodes::function...> m_functions;                 ///< The functions of the nodes.
+    results m_results;                                                   ///< The results of the nodes.
+    std::array<std::exception_ptr, sizeof...(Nodes)> m_exceptions;       ///< What the nodes have thrown in this run.
+    std::array<std::atomic<std::size_t>, sizeof...(Nodes)> m_pending{};  ///< Unfinished dependencies of every node.
+    std::atomic<std::size_t> m_remaining = 0;                            ///< Sinks that have not finished, plus one.
+    std::coroutine_handle<> m_waiter;                                    ///< The coroutine that runs the graph.
+
+    /** @brief Forgets the results of the previous run. */
+    void reset() noexcept
+    {
+        std::apply([](auto&... slot) { (slot.reset(), ...); }, this->m_results);
+        for (std::size_t i = 0; i < traits::size; ++i) {
+            this->m_exceptions[i] = nullptr;
+            this->m_pending[i].store(traits::in_degree[i], std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Rethrows the exception of the earliest listed failed node, if any.
+     *
+     * @throw Whatever that node has thrown.
+     */
+    void rethrow() const
+    {
+        for (const std::exception_ptr& exception : this->m_exceptions) {
+            if (exception != nullptr) {
+                std::rethrow_exception(exception);
+            }
+        }
+    }
+
+    /**
+     * @brief Returns what a dependency contributes to the arguments of a function.
+     *
+     * @tparam J The index of the dependency.
+     * @return A tuple with a reference to the result of the dependency, or an empty tuple if it produces nothing.
+     */
+    template<std::size_t J>
+    typename detail::static_arg<typename traits::template result_t<J>>::type argument() noexcept
+    {
+        using value_type = typename traits::template result_t<J>;
+        if constexpr (std::is_void_v<value_type>) {
+            return {};
+        }
+        else {
+            return typename detail::static_arg<value_type>::type{*std::get<J>(this->m_results)};
+        }
+    }
+
+    /**
+     * @brief Collects the arguments of a function.
+     *
+     * @return A tuple of references to the results of @a Deps.
+     */
+    template<typename... Deps>
+    auto arguments(depends<Deps...>) noexcept
+    {
+        return std::tuple_cat(this->template argument<traits::template index_of<Deps>()>()...);
+    }
+
+    /**
+     * @brief Runs a node whose dependencies have all finished, unless one of them has failed.
+     *
+     * @tparam I The index of the node.
+     * @return The task that runs the node.
+     */
+    template<std::size_t I>
+    task<> execute()
+    {
+        for (std::size_t dep : traits::template dependencies<I>) {
+            if (this->m_exceptions[dep] != nullptr) {
+                this->m_exceptions[I] = this->m_exceptions[dep];
+                co_return;
+            }
+        }
+
+        try {
+            auto& fn         = std::get<I>(this->m_functions);
+            auto& slot       = std::get<I>(this->m_results);
+            auto args        = this->arguments(typename traits::template node_t<I>::dependencies{});
+            using value_type = typename traits::template result_t<I>;
+            using fn_result  = decltype(std::apply(fn, args));
+
+            if constexpr (std::is_void_v<value_type>) {
+                if constexpr (detail::is_task_v<fn_result>) {
+                    co_await std::apply(fn, args);
+                }
+                else {
+                    std::apply(fn, args);
+                }
+
+                slot.emplace();
+            }
+            else if constexpr (detail::is_task_v<fn_result>) {
+                slot.emplace(co_await std::apply(fn, args));
+            }
+            else {
+                slot.emplace(std::apply(fn, args));
+            }
+        }
+        catch (...) {
+            this->m_exceptions[I] = std::current_exception();
+        }
+    }
+
+    /**
+     * @brief Runs the nodes one after another.
+     *
+     * @tparam K Positions in the topological order.
+     * @return The task that runs the nodes.
+     */
+    template<std::size_t... K>
+    task<> run_sequential(std::index_sequence<K...>)
+    {
+        (co_await this->template execute<traits::order.first[K]>(), ...);
+    }
+
+    /**
+     * @brief Starts a node if it has no dependencies.
+     *
+     * @tparam I The index of the node.
+     * @param sched The scheduler.
+     */
+    template<std::size_t I, typename Scheduler>
+    void start(Scheduler& sched)
+    {
+        if constexpr (traits::in_degree[I] == 0) {
+            this->template launch<I>(sched);
+        }
+    }
+
+    /**
+     * @brief Tells a successor that a dependency has finished, and starts it if that was the last one.
+     *
+     * @tparam I The index of the finished node.
+     * @tparam J The index of a node; nothing happens unless it depends on @a I.
+     * @param sched The scheduler.
+     */
+    template<std::size_t I, std::size_t J, typename Scheduler>
+    void release(Scheduler& sched)
+    {
+        constexpr std::size_t count = traits::edges[I][J];
+        if constexpr (count == 0) {
+            // Not a successor
+        }
+        else if constexpr (count == traits::in_degree[J]) {
+            // The only predecessor: nothing to count
+            this->template launch<J>(sched);
+        }
+        else {
+            if (this->m_pending[J].fetch_sub(count, std::memory_order_acq_rel) == count) {
+                this->template launch<J>(sched);
+            }
+        }
+    }
+
+    /**
+     * @brief Runs a node on the scheduler, then starts the successors it has made ready.
+     *
+     * Only sinks touch the graph after releasing their successors: the graph may be gone once the last sink is done.
+     *
+     * @tparam I The index of the node.
+     * @param sched The scheduler.
+     */
+    template<std::size_t I, typename Scheduler>
+    eager_task launch(Scheduler& sched)
+    {
+        co_await sched.schedule();
+        co_await this->template execute<I>();
+
+        if constexpr (traits::template is_sink<I>()) {
+            if (this->m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                this->m_waiter.resume();
+            }
+        }
+        else {
+            [this, &sched]<std::size_t... J>(std::index_sequence<J...>) {
+                (this->template release<I, J>(sched), ...);
+            }(std::make_index_sequence<traits::size>{});
+        }
+    }
+};
+
+/**
+ * @example static_graph.cpp
+ * Example of a fixed request pipeline described as a type.
+ */
+
+}  // namespace wwa::coro
+
+#endif /* F9416BD6_25CD_4AD7_8F7D_13AA74D66158 */
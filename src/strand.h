@@ -0,0 +1,196 @@
+#ifndef F2B7D049_6A1C_4E35_8D9E_3C05A7E1B842
+#define F2B7D049_6A1C_4E35_8D9E_3C05A7E1B842
+
+/**
+ * @file strand.h
+ * @brief Serial executor.
+ *
+ * This file contains the definition of the `strand` class. Coroutines that go through `co_await s.schedule()` never
+ * run concurrently with each other, so the state they share needs no lock.
+ *
+ * Example:
+ * @snippet strand.cpp strand example
+ */
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <thread>
+#include <utility>
+
+#include "detail.h"
+#include "mpsc_queue.h"
+
+namespace wwa::coro {
+
+/**
+ * @brief A serial executor without a thread of its own.
+ *
+ * `co_await s.schedule()` puts the awaiting coroutine on the strand. The coroutine then runs exclusively until it
+ * suspends again or completes; any suspension, including `yield_now()` and `offload()`, takes it off the strand,
+ * so a coroutine that needs the protected state after a `co_await` schedules itself on the strand again.
+ *
+ * The strand is an `mpsc_queue` of awaiters and a count of scheduled coroutines that doubles as the running flag.
+ * The coroutine that raises the count from zero runs the strand on its own thread: it resumes itself inline and then
+ * every coroutine that has been queued meanwhile, in FIFO order, until the count drops back to zero. Uncontended
+ * scheduling therefore continues on the calling thread; under contention, the coroutines queue up behind the one that
+ * runs the strand and are resumed by it, and the other threads go on with their own work.
+ *
+ * While the strand runs, the budget of the scheduler the thread belongs to (see `thread_pool_options::budget`) is
+ * suspended: the scheduler would otherwise send a coroutine that awaits tasks back to its queue and off the strand.
+ *
+ * Example:
+ * @snippet strand.cpp strand example
+ */
+class strand {
+public:
+    class schedule_op;
+
+    /** @brief Default constructor. */
+    strand() noexcept = default;
+
+    /// @cond
+    strand(const strand&)            = delete;
+    strand(strand&&)                 = delete;
+    strand& operator=(const strand&) = delete;
+    strand& operator=(strand&&)      = delete;
+    /// @endcond
+
+    /**
+     * @brief Destructor.
+     *
+     * The thread that runs the strand still updates the count after the last coroutine has left; the destructor
+     * waits for that.
+     *
+     * @warning No coroutine may be scheduled on the strand once it is being destroyed, and it must not be destroyed
+     * by a coroutine that runs on it.
+     */
+    ~strand()
+    {
+        while (this->m_count.load(std::memory_order_acquire) != 0) {
+            std::this_thread::yield();
+        }
+    }
+
+    /**
+     * @brief Puts the awaiting coroutine on the strand.
+     *
+     * @return An awaitable.
+     *
+     * @internal
+     * @test @a StrandTest.RunsInline
+     * @test @a StrandTest.Fifo
+     * @test @a StrandTest.Serializes
+     */
+    [[nodiscard]] schedule_op schedule() noexcept { return schedule_op{*this}; }
+
+    /**
+     * @brief Checks whether the calling thread is running the strand.
+     *
+     * @return Whether the calling coroutine runs on this strand.
+     *
+     * @internal
+     * @test @a StrandTest.RunsInline
+     * @test @a StrandTest.KeepsBudgetOff
+     */
+    [[nodiscard]] bool running_in_this_thread() const noexcept { return current() == this; }
+
+    /**
+     * @brief Awaitable for the `schedule()` operation.
+     *
+     * @see strand::schedule()
+     */
+    class [[nodiscard]] schedule_op : private mpsc_queue_hook {
+    public:
+        /// @cond INTERNAL
+        /**
+         * @brief Constructs a new operation.
+         *
+         * @param s The strand.
+         */
+        explicit schedule_op(strand& s) noexcept : m_strand(s) {}
+        /// @endcond
+
+        /**
+         * @brief Always suspends; the strand resumes the coroutine.
+         *
+         * @return `false`.
+         */
+        [[nodiscard]] static constexpr bool await_ready() noexcept { return false; }
+
+        /**
+         * @brief Queues the coroutine and runs the strand if nobody else does.
+         *
+         * @param h The awaiting coroutine.
+         */
+        void await_suspend(std::coroutine_handle<> h) noexcept
+        {
+            // Once queued, the coroutine may be resumed by another thread and the awaiter may be gone
+            strand& s      = this->m_strand;
+            this->m_handle = h;
+            s.m_queue.push(this);
+            if (s.m_count.fetch_add(1, std::memory_order_acq_rel) == 0) {
+                s.run();
+            }
+        }
+
+        /** @brief Does nothing. */
+        constexpr void await_resume() const noexcept {}
+
+    private:
+        friend class strand;
+        friend class mpsc_queue<schedule_op>;
+
+        strand& m_strand;                  ///< The strand.
+        std::coroutine_handle<> m_handle;  ///< The awaiting coroutine.
+    };
+
+private:
+    mpsc_queue<schedule_op> m_queue;  ///< Coroutines waiting for the strand.
+    alignas(detail::cache_line_size) std::atomic<std::size_t> m_count = 0;  ///< Scheduled coroutines; 0 when idle.
+
+    /**
+     * @brief Returns the strand run by the calling thread.
+     *
+     * @return The strand; `nullptr` if the thread does not run a strand.
+     */
+    static strand*& current() noexcept
+    {
+        static thread_local strand* s = nullptr;
+        return s;
+    }
+
+    /**
+     * @brief Resumes the queued coroutines one at a time until none is left.
+     *
+     * Each batch taken from the queue is resumed in full before the count is lowered by its size; the call returns
+     * once the count reaches zero, and the next `schedule()` runs the strand again.
+     */
+    void run() noexcept
+    {
+        strand* const outer        = std::exchange(current(), this);
+        detail::coop_context& coop = detail::coop();
+        const std::size_t budget   = std::exchange(coop.m_budget, 0);
+
+        std::size_t done = 0;
+        do {
+            done = 0;
+            for (schedule_op& op : this->m_queue.try_pop_all()) {
+                ++done;
+                op.m_handle.resume();
+            }
+        } while (this->m_count.fetch_sub(done, std::memory_order_acq_rel) != done);
+
+        coop.m_budget = budget;
+        current()     = outer;
+    }
+};
+
+/**
+ * @example strand.cpp
+ * Example of serializing access to per-session state without a lock.
+ */
+
+}  // namespace wwa::coro
+
+#endif /* F2B7D049_6A1C_4E35_8D9E_3C05A7E1B842 */
@@ -16,6 +16,7 @@
 
 #include <cassert>
 #include <coroutine>
+#include <cstddef>
 #include <exception>
 #include <memory>
 #include <optional>
@@ -28,13 +29,36 @@
 /** @brief Library namespace. */
 namespace wwa::coro {
 
-template<typename Result>
+template<typename Result, typename Frames>
 class task;
 
 /// @cond INTERNAL
 
 namespace detail {
 
+/**
+ * @brief Gives the promise of a task the frame allocator `Frames`.
+ *
+ * @tparam Frames A class with static `allocate(size)` and `deallocate(ptr, size)`; `void` keeps the global allocator.
+ */
+template<typename Frames>
+struct frame_allocation {
+    /**
+     * @brief Allocates the frame of a task.
+     *
+     * @internal
+     * @test @a ShardedRuntimeTest.ArenaTask
+     */
+    [[nodiscard]] static void* operator new(std::size_t size) { return Frames::allocate(size); }
+
+    /** @brief Frees the frame of a task. */
+    static void operator delete(void* ptr, std::size_t size) noexcept { Frames::deallocate(ptr, size); }
+};
+
+/** @brief Frames of tasks come from the global allocator, as those of any coroutine. */
+template<>
+struct frame_allocation<void> {};
+
 // NOLINTBEGIN(readability-convert-member-functions-to-static)
 template<typename Promise>
 struct promise_base {
@@ -51,13 +75,15 @@ struct promise_base {
         struct nested_awaiter {
             [[nodiscard]] constexpr bool await_ready() const noexcept { return false; }
 
-            [[nodiscard]] auto await_suspend(std::coroutine_handle<Promise> handle) const noexcept
+            [[nodiscard]] std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
             {
                 const auto& promise = handle.promise();
-                return promise.m_next ? promise.m_next : std::noop_coroutine();
+                return promise.m_next ? detail::transfer(this->node, promise.m_next) : std::noop_coroutine();
             }
 
             void await_resume() const noexcept {}  // GCOVR_EXCL_LINE -- this method is not used
+
+            resume_node node = {};  ///< Queues the continuation when the budget runs out.
         };
 
         return nested_awaiter{};
@@ -91,14 +117,14 @@ private:
 };
 // NOLINTEND(readability-convert-member-functions-to-static)
 
-template<typename T>
-struct promise_type : promise_base<promise_type<T>> {
+template<typename T, typename Frames>
+struct promise_type : promise_base<promise_type<T, Frames>>, frame_allocation<Frames> {
     using value_type = std::remove_reference_t<T>;
     using storage_type =
         std::conditional_t<std::is_lvalue_reference_v<T>, std::add_pointer_t<value_type>, std::optional<value_type>>;
     using reference = std::conditional_t<std::is_rvalue_reference_v<T>, T, std::add_lvalue_reference_t<value_type>>;
 
-    auto get_return_object() { return task<T>{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+    auto get_return_object() { return task<T, Frames>{std::coroutine_handle<promise_type>::from_promise(*this)}; }
 
     /**
      * @internal
@@ -169,13 +195,33 @@ private:
     storage_type m_result{};
 };
 
-template<>
-struct promise_type<void> : promise_base<promise_type<void>> {
-    task<void> get_return_object();
+template<typename Frames>
+struct promise_type<void, Frames> : promise_base<promise_type<void, Frames>>, frame_allocation<Frames> {
+    task<void, Frames> get_return_object();
     void return_void() const noexcept {}
     void result_value() const { this->rethrow_if_exception(); }
 };
 
+/** @brief The result of a callable: its return type, or the result type of the task it returns. */
+template<typename T>
+struct unwrap_task {
+    using type = T;  ///< The result type.
+};
+
+/** @brief The result of a callable that returns a task. */
+template<typename T, typename Frames>
+struct unwrap_task<task<T, Frames>> {
+    using type = T;  ///< The result type.
+};
+
+/** @brief Whether a type is a task, whatever its frame allocator. */
+template<typename T>
+inline constexpr bool is_task_v = false;
+
+/** @brief A task is a task. */
+template<typename T, typename Frames>
+inline constexpr bool is_task_v<task<T, Frames>> = true;
+
 }  // namespace detail
 
 /// @endcond
@@ -191,8 +237,10 @@ struct promise_type<void> : promise_base<promise_type<void>> {
  * @snippet task.cpp sample tasks
  *
  * @tparam Result The type of the result produced by the task.
+ * @tparam Frames Where the frame of the coroutine comes from; `void` (the default) means the global allocator.
+ * @see arena_task
  */
-template<typename Result = void>
+template<typename Result = void, typename Frames = void>
 class [[nodiscard]] task {
 public:
     /**
@@ -200,7 +248,7 @@ public:
      *
      * The `promise_type` alias is a type alias for the promise type associated with the task.
      */
-    using promise_type = detail::promise_type<Result>;
+    using promise_type = detail::promise_type<Result, Frames>;
 
     /**
      * @brief Default constructor.
@@ -407,10 +455,10 @@ public:
         struct awaiter {
             [[nodiscard]] constexpr bool await_ready() const noexcept { return detail::is_ready(this->coroutine); }
 
-            auto await_suspend(std::coroutine_handle<> awaiting) noexcept
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
             {
                 this->coroutine.promise().set_next(awaiting);
-                return this->coroutine;
+                return detail::transfer(this->node, this->coroutine);
             }
 
             decltype(auto) await_resume()
@@ -425,8 +473,10 @@ public:
                 }
             }
 
-            // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+            // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
             std::coroutine_handle<promise_type> coroutine;
+            detail::resume_node node = {};  ///< Queues the task when the budget runs out.
+            // NOLINTEND(misc-non-private-member-variables-in-classes)
         };
 
         return awaiter{this->m_coroutine};
@@ -448,10 +498,10 @@ public:
         struct awaiter {
             [[nodiscard]] constexpr bool await_ready() const noexcept { return detail::is_ready(this->coroutine); }
 
-            auto await_suspend(std::coroutine_handle<> awaiting) noexcept
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
             {
                 this->coroutine.promise().set_next(awaiting);
-                return this->coroutine;
+                return detail::transfer(this->node, this->coroutine);
             }
 
             decltype(auto) await_resume()
@@ -460,8 +510,10 @@ public:
                 return std::move(this->coroutine.promise().result_value());
             }
 
-            // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+            // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
             std::coroutine_handle<promise_type> coroutine;
+            detail::resume_node node = {};  ///< Queues the task when the budget runs out.
+            // NOLINTEND(misc-non-private-member-variables-in-classes)
         };
 
         return awaiter{this->m_coroutine};
@@ -482,6 +534,21 @@ private:
     explicit task(std::coroutine_handle<promise_type> handle) : m_coroutine(handle) {}
 };
 
+/**
+ * @brief A task whose frame comes from the frame arena of the thread that starts it.
+ *
+ * The shards of a `sharded_runtime` and the workers of a `fork_join_pool` install an arena, which keeps freed frames
+ * for reuse (see `detail::frame_arena`). Elsewhere, the frame comes from the global allocator, its size rounded up
+ * to a size class. The frame may be freed on any thread. Plain `task<>`s never use an arena.
+ *
+ * @tparam Result The type of the result produced by the task.
+ *
+ * @internal
+ * @test @a ShardedRuntimeTest.ArenaTask
+ */
+template<typename Result = void>
+using arena_task = task<Result, detail::frame_arena>;
+
 /**
  * @example task.cpp
  * Example of how to use tasks.
@@ -489,9 +556,10 @@ private:
 
 /// @cond INTERNAL
 
-inline task<void> detail::promise_type<void>::get_return_object()
+template<typename Frames>
+inline task<void, Frames> detail::promise_type<void, Frames>::get_return_object()
 {
-    return task<void>{std::coroutine_handle<promise_type>::from_promise(*this)};
+    return task<void, Frames>{std::coroutine_handle<promise_type>::from_promise(*this)};
 }
 
 /// @endcond
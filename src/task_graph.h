@@ -0,0 +1,401 @@
+#ifndef C03F33E6_9DCC_4476_9849_FCDE2BEAFCC2
+#define C03F33E6_9DCC_4476_9849_FCDE2BEAFCC2
+
+/**
+ * @file task_graph.h
+ * @brief Dynamic task graphs.
+ *
+ * This file contains the definition of the `task_graph` class. Nodes are functions, possibly returning `task<>`s;
+ * edges are dependencies. `co_await g.run(pool)` starts every node on the pool as soon as its last predecessor
+ * finishes, and hands it references to the results of its predecessors.
+ *
+ * Example:
+ * @snippet task_graph.cpp task_graph example
+ */
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "eager_task.h"
+#include "exceptions.h"
+#include "task.h"
+
+namespace wwa::coro {
+
+/// @cond INTERNAL
+namespace detail {
+
+/** @brief A node of a `task_graph`, without its result. */
+struct graph_vertex {
+    std::vector<graph_vertex*> m_predecessors;     ///< Nodes that must finish first.
+    std::vector<graph_vertex*> m_successors;       ///< Nodes that wait for this one.
+    std::atomic<std::size_t> m_pending = 0;        ///< Predecessors that have not finished yet in this run.
+    std::exception_ptr m_exception     = nullptr;  ///< What the node or one of its predecessors threw in this run.
+
+    graph_vertex() noexcept = default;
+
+    graph_vertex(const graph_vertex&)            = delete;
+    graph_vertex(graph_vertex&&)                 = delete;
+    graph_vertex& operator=(const graph_vertex&) = delete;
+    graph_vertex& operator=(graph_vertex&&)      = delete;
+
+    virtual ~graph_vertex() = default;
+
+    /**
+     * @brief Runs the function of the node and stores its result.
+     *
+     * @return The task that runs the function.
+     */
+    virtual task<> execute() = 0;
+
+    /** @brief Forgets the result of the previous run. */
+    virtual void reset() noexcept = 0;
+};
+
+/** @brief A node of a `task_graph` that produces a `T`. */
+template<typename T>
+struct graph_value : graph_vertex {
+    std::optional<T> m_result;  ///< The result of the node.
+
+    void reset() noexcept override { this->m_result.reset(); }
+};
+
+/** @brief A node of a `task_graph` that produces nothing. */
+template<>
+struct graph_value<void> : graph_vertex {
+    void reset() noexcept override {}
+};
+
+/** @brief What the result of a predecessor contributes to the arguments of a node: a reference to it. */
+template<typename T>
+struct graph_arg {
+    using type = std::tuple<T&>;  ///< The arguments.
+};
+
+/** @brief What a predecessor without a result contributes to the arguments of a node: nothing. */
+template<>
+struct graph_arg<void> {
+    using type = std::tuple<>;  ///< The arguments.
+};
+
+/** @brief The arguments of a node with predecessors of types `Deps`. */
+template<typename... Deps>
+using graph_args_t = decltype(std::tuple_cat(std::declval<typename graph_arg<Deps>::type>()...));
+
+/** @brief The result of a node with function `F` and predecessors of types `Deps`. */
+template<typename F, typename... Deps>
+using graph_result_t =
+    typename unwrap_task<decltype(std::apply(std::declval<F&>(), std::declval<graph_args_t<Deps...>>()))>::type;
+
+/** @brief A node of a `task_graph` with its function. */
+template<typename T, typename F, typename... Deps>
+struct graph_body : graph_value<T> {
+    F m_fn;                                         ///< The function.
+    std::tuple<graph_value<Deps>*...> m_arguments;  ///< The predecessors whose results are passed to the function.
+
+    /**
+     * @brief Constructs a new node.
+     *
+     * @param fn The function.
+     * @param deps The predecessors.
+     */
+    explicit graph_body(F fn, graph_value<Deps>*... deps) : m_fn(std::move(fn)), m_arguments(deps...) {}
+
+    task<> execute() override
+    {
+        graph_args_t<Deps...> args = std::apply(
+            [](graph_value<Deps>*... deps) { return std::tuple_cat(graph_body::argument(deps)...); },
+            this->m_arguments
+        );
+
+        using result_type = decltype(std::apply(this->m_fn, args));
+        if constexpr (std::is_void_v<T>) {
+            if constexpr (is_task_v<result_type>) {
+                co_await std::apply(this->m_fn, args);
+            }
+            else {
+                std::apply(this->m_fn, args);
+            }
+        }
+        else if constexpr (is_task_v<result_type>) {
+            this->m_result.emplace(co_await std::apply(this->m_fn, args));
+        }
+        else {
+            this->m_result.emplace(std::apply(this->m_fn, args));
+        }
+    }
+
+    /**
+     * @brief Returns what a predecessor contributes to the arguments of the function.
+     *
+     * @param dep The predecessor.
+     * @return A tuple with a reference to the result of @a dep, or an empty tuple if @a dep produces nothing.
+     */
+    template<typename D>
+    static typename graph_arg<D>::type argument(graph_value<D>* dep) noexcept
+    {
+        if constexpr (std::is_void_v<D>) {
+            return {};
+        }
+        else {
+            return typename graph_arg<D>::type{*dep->m_result};
+        }
+    }
+};
+
+}  // namespace detail
+/// @endcond
+
+/**
+ * @brief A graph of dependent tasks.
+ *
+ * `add(fn, deps...)` adds a node that runs `fn` after the nodes @a deps. `fn` receives lvalue references to the results
+ * of the dependencies that produce one, in order: results travel along the edges without being copied. If `fn`
+ * returns a `task<>`, the node is done when the task is.
+ *
+ * `co_await g.run(sched)` runs the graph. Every node keeps an atomic count of predecessors that have not finished yet;
+ * the node that brings the count of a successor to zero starts the successor on `sched` right away, so independent
+ * branches never wait for each other. `run()` completes when all nodes have finished.
+ *
+ * If a node throws, the nodes that depend on it, directly or not, are skipped and get the same exception; the other
+ * nodes still run, and `run()` rethrows the exception of the earliest added node that has one.
+ *
+ * Example:
+ * @snippet task_graph.cpp task_graph example
+ *
+ * @note Nodes that run in parallel may receive references to the same result; they should only read it.
+ */
+class task_graph {
+public:
+    template<typename T>
+    class node;
+
+    /**
+     * @brief The result of a node with function `F` and dependencies of types `Deps`.
+     *
+     * @tparam F The type of the function.
+     * @tparam Deps The result types of the dependencies.
+     */
+    template<typename F, typename... Deps>
+    using result_t = detail::graph_result_t<F, Deps...>;
+
+    /** @brief Constructs an empty graph. */
+    task_graph() noexcept = default;
+
+    /// @cond
+    task_graph(const task_graph&)            = delete;
+    task_graph(task_graph&&)                 = delete;
+    task_graph& operator=(const task_graph&) = delete;
+    task_graph& operator=(task_graph&&)      = delete;
+    ~task_graph()                            = default;
+    /// @endcond
+
+    /**
+     * @brief Adds a node.
+     *
+     * @param fn The function of the node; called with references to the results of @a deps.
+     * @param deps The nodes that must finish first; they must belong to this graph.
+     * @return The node.
+     *
+     * @internal
+     * @test @a TaskGraphTest.Diamond
+     * @test @a TaskGraphTest.VoidNodes
+     */
+    template<typename F, typename... Deps>
+    node<result_t<F, Deps...>> add(F fn, node<Deps>... deps)
+    {
+        using value_type = result_t<F, Deps...>;
+
+        auto vertex = std::make_unique<detail::graph_body<value_type, F, Deps...>>(std::move(fn), deps.m_vertex...);
+        (link(deps.m_vertex, vertex.get()), ...);
+
+        node<value_type> result{vertex.get()};
+        this->m_vertices.push_back(std::move(vertex));
+        return result;
+    }
+
+    /**
+     * @brief Returns the number of nodes.
+     *
+     * @return The number of nodes.
+     */
+    [[nodiscard]] std::size_t size() const noexcept { return this->m_vertices.size(); }
+
+    /**
+     * @brief Runs the graph.
+     *
+     * The graph may run again once the previous run has completed; every run starts from scratch.
+     *
+     * @param sched The scheduler to run the nodes on; anything with a `schedule()` awaitable, such as `thread_pool`.
+     * @return A task that completes when all nodes have finished.
+     * @throw Whatever the earliest added failed node has thrown.
+     *
+     * @internal
+     * @test @a TaskGraphTest.Diamond
+     * @test @a TaskGraphTest.Dependencies
+     * @test @a TaskGraphTest.Exception
+     * @test @a TaskGraphTest.Empty
+     * @test @a TaskGraphTest.Rerun
+     */
+    template<typename Scheduler>
+    task<> run(Scheduler& sched)
+    {
+        // One extra count for `run()` itself: the last node to finish must not resume it before it has suspended
+        this->m_remaining.store(this->m_vertices.size() + 1, std::memory_order_relaxed);
+        for (const auto& vertex : this->m_vertices) {
+            vertex->m_pending.store(vertex->m_predecessors.size(), std::memory_order_relaxed);
+            vertex->m_exception = nullptr;
+            vertex->reset();
+        }
+
+        for (const auto& vertex : this->m_vertices) {
+            if (vertex->m_predecessors.empty()) {
+                this->launch(sched, vertex.get());
+            }
+        }
+
+        co_await completion{*this};
+
+        for (const auto& vertex : this->m_vertices) {
+            if (vertex->m_exception != nullptr) {
+                std::rethrow_exception(vertex->m_exception);
+            }
+        }
+    }
+
+    /**
+     * @brief A node of a task graph.
+     *
+     * A lightweight handle: copying it does not copy the node.
+     *
+     * @tparam T The type of the result of the node.
+     */
+    template<typename T>
+    class node {
+    public:
+        /**
+         * @brief Returns the result of the node after the graph has run.
+         *
+         * @return A reference to the result; nothing if `T` is `void`.
+         * @throw bad_result_access if the graph has not run yet.
+         * @throw Whatever the node or one of its dependencies has thrown.
+         *
+         * @internal
+         * @test @a TaskGraphTest.Diamond
+         * @test @a TaskGraphTest.Exception
+         */
+        std::add_lvalue_reference_t<T> get() const
+        {
+            if (this->m_vertex->m_exception != nullptr) {
+                std::rethrow_exception(this->m_vertex->m_exception);
+            }
+
+            if constexpr (!std::is_void_v<T>) {
+                if (!this->m_vertex->m_result.has_value()) {
+                    throw bad_result_access("task_graph node has not run");
+                }
+
+                return *this->m_vertex->m_result;
+            }
+        }
+
+    private:
+        detail::graph_value<T>* m_vertex;  ///< The node.
+
+        friend task_graph;  ///< `task_graph` creates nodes and links them.
+
+        /**
+         * @brief Constructor.
+         *
+         * @param vertex The node.
+         */
+        explicit node(detail::graph_value<T>* vertex) noexcept : m_vertex(vertex) {}
+    };
+
+private:
+    /** @brief Awaitable that waits for the last node to finish. */
+    struct completion {
+        task_graph& m_graph;  ///< The graph.
+
+        [[nodiscard]] constexpr bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(std::coroutine_handle<> h) noexcept
+        {
+            this->m_graph.m_waiter = h;
+            return this->m_graph.m_remaining.fetch_sub(1, std::memory_order_acq_rel) != 1;
+        }
+
+        constexpr void await_resume() const noexcept {}
+    };
+
+    std::vector<std::unique_ptr<detail::graph_vertex>> m_vertices;  ///< The nodes, in the order they were added.
+    std::atomic<std::size_t> m_remaining = 0;                       ///< Nodes that have not finished yet, plus one.
+    std::coroutine_handle<> m_waiter;                               ///< The coroutine that runs the graph.
+
+    /**
+     * @brief Adds an edge.
+     *
+     * @param from The node that must finish first.
+     * @param to The node that waits for @a from.
+     */
+    static void link(detail::graph_vertex* from, detail::graph_vertex* to)
+    {
+        from->m_successors.push_back(to);
+        to->m_predecessors.push_back(from);
+    }
+
+    /**
+     * @brief Runs a node whose dependencies have all finished, then starts the successors it has made ready.
+     *
+     * @param sched The scheduler.
+     * @param vertex The node.
+     */
+    template<typename Scheduler>
+    eager_task launch(Scheduler& sched, detail::graph_vertex* vertex)
+    {
+        co_await sched.schedule();
+
+        for (const detail::graph_vertex* dep : vertex->m_predecessors) {
+            if (dep->m_exception != nullptr) {
+                vertex->m_exception = dep->m_exception;
+                break;
+            }
+        }
+
+        if (vertex->m_exception == nullptr) {
+            try {
+                co_await vertex->execute();
+            }
+            catch (...) {
+                vertex->m_exception = std::current_exception();
+            }
+        }
+
+        for (detail::graph_vertex* next : vertex->m_successors) {
+            if (next->m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                this->launch(sched, next);
+            }
+        }
+
+        if (this->m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            this->m_waiter.resume();
+        }
+    }
+};
+
+/**
+ * @example task_graph.cpp
+ * Example of a build pipeline described as a task graph.
+ */
+
+}  // namespace wwa::coro
+
+#endif /* C03F33E6_9DCC_4476_9849_FCDE2BEAFCC2 */
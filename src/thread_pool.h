@@ -0,0 +1,1005 @@
+#ifndef B38E5D16_C2F9_4A71_9D0B_E64A7F21C853
+#define B38E5D16_C2F9_4A71_9D0B_E64A7F21C853
+
+/**
+ * @file thread_pool.h
+ * @brief Thread pool with priority levels.
+ *
+ * This file contains the definition of the `thread_pool` class. `co_await pool.schedule(priority)` moves the awaiting
+ * coroutine to a worker thread; every worker keeps one queue per priority level.
+ *
+ * Example:
+ * @snippet thread_pool.cpp thread_pool example
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <system_error>
+
+#include <sched.h>
+#endif
+
+#include "detail.h"
+#include "exceptions.h"
+
+namespace wwa::coro {
+
+/// @cond INTERNAL
+namespace detail {
+
+/**
+ * @brief Parses a CPU list such as `0-3,8,10-11`.
+ *
+ * @param list The list.
+ * @return The CPUs; malformed ranges are skipped.
+ */
+inline std::vector<int> parse_cpu_list(std::string_view list)
+{
+    std::vector<int> cpus;
+    while (!list.empty()) {
+        const std::size_t comma = list.find(',');
+        std::string_view range  = list.substr(0, comma);
+        list                    = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+
+        const char* end = range.data() + range.size();
+        int first       = 0;
+        const auto res  = std::from_chars(range.data(), end, first);
+        if (res.ec != std::errc{}) {
+            continue;
+        }
+
+        int last = first;
+        if (res.ptr != end && (*res.ptr != '-' || std::from_chars(res.ptr + 1, end, last).ec != std::errc{})) {
+            continue;
+        }
+
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+
+    return cpus;
+}
+
+/**
+ * @brief Returns the CPUs that the process may run on, grouped by NUMA node.
+ *
+ * Nodes come from `/sys/devices/system/node`; a machine without that directory (or a platform other than Linux) is
+ * treated as a single node. Nodes without usable CPUs are left out.
+ *
+ * @return The CPUs of every node; empty if the affinity of the process cannot be queried.
+ */
+inline std::vector<std::vector<int>> cpu_topology()
+{
+    std::vector<std::vector<int>> nodes;
+#if defined(__linux__)
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return nodes;
+    }
+
+    const auto usable = [&allowed](int cpu) { return cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed) != 0; };
+
+    std::map<int, std::vector<int>> by_node;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator("/sys/devices/system/node", ec)) {
+        const std::string name = entry.path().filename().string();
+        int node               = 0;
+        if (!name.starts_with("node") ||
+            std::from_chars(name.data() + 4, name.data() + name.size(), node).ptr != name.data() + name.size()) {
+            continue;
+        }
+
+        std::ifstream in(entry.path() / "cpulist");
+        std::string list;
+        std::getline(in, list);
+
+        std::vector<int> cpus = parse_cpu_list(list);
+        std::erase_if(cpus, [&usable](int cpu) { return !usable(cpu); });
+        if (!cpus.empty()) {
+            by_node.emplace(node, std::move(cpus));
+        }
+    }
+
+    for (auto& entry : by_node) {
+        nodes.push_back(std::move(entry.second));
+    }
+
+    if (nodes.empty()) {
+        nodes.emplace_back();
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (usable(cpu)) {
+                nodes.back().push_back(cpu);
+            }
+        }
+    }
+#endif
+
+    return nodes;
+}
+
+/**
+ * @brief Pins the calling thread to a CPU.
+ *
+ * @param cpu The CPU.
+ */
+inline void pin_to_cpu([[maybe_unused]] int cpu) noexcept
+{
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    static_cast<void>(sched_setaffinity(0, sizeof(set), &set));
+#endif
+}
+
+}  // namespace detail
+/// @endcond
+
+/** @brief How a worker chooses between its priority levels. */
+enum class priority_selection {
+    strict,   ///< Always run the highest non-empty level.
+    weighted  ///< Serve levels in turn, up to their weights in a row.
+};
+
+/** @brief Options of `thread_pool`. */
+struct thread_pool_options {
+    std::size_t threads              = 0;      ///< The number of workers; 0 means one per hardware thread.
+    std::size_t priorities           = 3;      ///< The number of priority levels; level 0 is the highest.
+    std::size_t default_priority     = 1;      ///< The priority of coroutines scheduled from outside the pool.
+    priority_selection selection     = priority_selection::strict;  ///< How workers choose between levels.
+    std::vector<std::size_t> weights = {};     ///< Weights of the levels; by default, halves with every level.
+    bool pin_workers                 = false;  ///< Pin the workers to CPUs, grouped by NUMA node (Linux only).
+    std::size_t spins                = 512;    ///< How many times an idle worker polls with `pause` before yielding.
+    std::size_t yields               = 8;      ///< How many times an idle worker yields the CPU before it sleeps.
+    std::size_t budget               = 128;    ///< Transfers per resumption before a coroutine yields; 0: unlimited.
+
+    std::size_t min_threads                   = 0;  ///< Elastic sizing: the fewest active workers; 0 turns it off.
+    std::chrono::microseconds target_delay    = std::chrono::microseconds(200);  ///< Grow above this queueing delay.
+    std::chrono::milliseconds resize_interval = std::chrono::milliseconds(10);   ///< The least time between resizes.
+};
+
+/**
+ * @brief Awaitable for the yield operation.
+ *
+ * @see yield_now()
+ */
+class [[nodiscard]] yield_now_op : private detail::resume_node {
+public:
+    /**
+     * @brief Checks whether there is a scheduler to yield to.
+     *
+     * @return Whether the calling thread is not a worker of a pool, and the coroutine continues right away.
+     */
+    [[nodiscard]] static bool await_ready() noexcept { return detail::coop().m_scheduler == nullptr; }
+
+    /**
+     * @brief Queues the coroutine at the back of the queue of the current worker.
+     *
+     * @param h The awaiting coroutine.
+     */
+    void await_suspend(std::coroutine_handle<> h) noexcept { static_cast<void>(detail::reschedule(*this, h)); }
+
+    /** @brief Does nothing. */
+    constexpr void await_resume() const noexcept {}
+};
+
+/**
+ * @brief Lets the coroutines queued on the current worker run first.
+ *
+ * On a worker of a `thread_pool`, the awaiting coroutine goes to the back of the queue of its priority level.
+ * Elsewhere, `co_await yield_now()` does nothing.
+ *
+ * @return An awaitable.
+ *
+ * @internal
+ * @test @a ThreadPoolTest.YieldNow
+ */
+[[nodiscard]] inline yield_now_op yield_now() noexcept
+{
+    return {};
+}
+
+/**
+ * @brief A thread pool with priority levels.
+ *
+ * Every worker owns one FIFO queue per priority level. A coroutine that calls `co_await pool.schedule(priority)` is
+ * linked into a queue (the awaiter is the queue node, so scheduling does not allocate): into the queue of the current
+ * worker if it already runs on the pool, or of the next worker in round-robin order otherwise. Workers take work from
+ * their own queues, either strictly by priority or in weighted turns, and steal the highest-priority work from
+ * the others when they run dry.
+ *
+ * A worker that runs out of work spins for a while (`thread_pool_options::spins`), then yields the CPU a few times
+ * (`thread_pool_options::yields`), and only then sleeps on an eventcount. Submitters make a system call to wake up
+ * a worker only if one is actually asleep, so a busy pool hands work over without entering the kernel, and an idle
+ * pool does not keep CPUs busy.
+ *
+ * A coroutine that keeps running without suspending for real (awaiting tasks that complete synchronously, or pulling
+ * values from an asynchronous generator) would hold its worker indefinitely. Every resumption therefore gets a budget
+ * (`thread_pool_options::budget`) of symmetric transfers between coroutines; once it is spent, the next transfer puts
+ * the coroutine to resume at the back of the queue instead. `co_await yield_now()` does the same explicitly.
+ *
+ * Under overload, queued coroutines may outlive the patience of their callers. `schedule(priority, deadline)` attaches
+ * a deadline that the worker checks when it takes the coroutine from the queue: expired coroutines are resumed only to
+ * throw `deadline_exceeded` from `co_await`, which skips the work, and are counted in `shed()`.
+ *
+ * With `thread_pool_options::min_threads`, the pool is elastic: only the first `active()` workers take work, and the
+ * rest sleep on a futex. Workers measure how long scheduled coroutines have waited in the queue and keep a moving
+ * average (`queue_delay()`). When the average exceeds `thread_pool_options::target_delay`, a worker activates one
+ * more worker; when the last active worker runs out of work while the average is below half the target, it
+ * deactivates itself. Resizing happens at most once per `thread_pool_options::resize_interval`. Submitters only read
+ * the active count to pick a queue; all decisions are made by workers with atomic operations.
+ *
+ * A worker remembers the priority of the coroutine it runs, and `schedule()` without an argument uses it. Tasks
+ * started by a coroutine run on the same thread until they suspend, so they inherit the priority of their parent.
+ *
+ * With `thread_pool_options::pin_workers`, the workers are spread over the NUMA nodes of the machine in turn and
+ * pinned to a CPU of their node; a worker that runs dry steals from the workers of its own node before it crosses to
+ * another node. Coroutine frames are allocated by the thread that starts the coroutine, so the frames of tasks started
+ * on a worker land on the memory of its node (Linux places pages on the node of the thread that first touches them).
+ * On a single-node machine, or where the topology cannot be read, all workers belong to node 0.
+ *
+ * Example:
+ * @snippet thread_pool.cpp thread_pool example
+ */
+class thread_pool {
+public:
+    /** @brief The clock used for deadlines. */
+    using clock = std::chrono::steady_clock;
+
+    /** @brief The deadline of work that has none. */
+    static constexpr clock::time_point no_deadline = clock::time_point::max();
+
+    class schedule_op;
+
+    /**
+     * @brief Constructs a new pool and starts the workers.
+     *
+     * @param options The options.
+     * @throw std::invalid_argument if the options are inconsistent.
+     *
+     * @internal
+     * @test @a ThreadPoolTest.InvalidOptions
+     */
+    explicit thread_pool(const thread_pool_options& options = {}) : m_options(options)
+    {
+        if (this->m_options.threads == 0) {
+            this->m_options.threads = std::max(1U, std::thread::hardware_concurrency());
+        }
+
+        const std::size_t levels = this->m_options.priorities;
+        if (levels == 0 || this->m_options.default_priority >= levels) {
+            throw std::invalid_argument("Invalid priorities");
+        }
+
+        if (this->m_options.weights.empty()) {
+            for (std::size_t level = 0; level < levels; ++level) {
+                this->m_options.weights.push_back(std::size_t{1} << std::min<std::size_t>(levels - 1 - level, 16));
+            }
+        }
+        else if (this->m_options.weights.size() != levels ||
+                 std::ranges::find(this->m_options.weights, std::size_t{0}) != this->m_options.weights.end()) {
+            throw std::invalid_argument("Invalid weights");
+        }
+
+        if (this->m_options.min_threads > this->m_options.threads) {
+            throw std::invalid_argument("Invalid min_threads");
+        }
+
+        this->m_active.store(this->elastic() ? this->m_options.min_threads : this->m_options.threads);
+
+        this->m_workers = std::vector<std::unique_ptr<worker>>(this->m_options.threads);
+        for (auto& w : this->m_workers) {
+            w = std::make_unique<worker>(levels, this->m_options.weights.front());
+        }
+
+        if (this->m_options.pin_workers) {
+            this->place_workers();
+        }
+
+        this->plan_stealing();
+
+        for (std::size_t i = 0; i < this->m_workers.size(); ++i) {
+            this->m_workers[i]->m_thread = std::thread([this, i] { this->run(i); });
+        }
+    }
+
+    /// @cond
+    thread_pool(const thread_pool&)            = delete;
+    thread_pool(thread_pool&&)                 = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+    thread_pool& operator=(thread_pool&&)      = delete;
+    /// @endcond
+
+    /**
+     * @brief Destructor.
+     *
+     * Runs the queued coroutines to their next suspension point, then stops the workers.
+     *
+     * @warning Must not be called from a worker of the pool.
+     *
+     * @internal
+     * @test @a ThreadPoolTest.DestructorDrains
+     */
+    ~thread_pool()
+    {
+        this->m_stop.store(true, std::memory_order_seq_cst);
+        this->m_idle.notify_all();
+        this->m_roster.fetch_add(1, std::memory_order_seq_cst);
+        this->m_roster.notify_all();
+        for (auto& w : this->m_workers) {
+            w->m_thread.join();
+        }
+    }
+
+    /**
+     * @brief Moves the awaiting coroutine to the pool, keeping the current priority.
+     *
+     * @return An awaitable.
+     * @see current_priority()
+     *
+     * @internal
+     * @test @a ThreadPoolTest.PriorityInheritance
+     */
+    [[nodiscard]] schedule_op schedule() noexcept
+    {
+        return schedule_op{*this, this->current_priority(), no_deadline};
+    }
+
+    /**
+     * @brief Moves the awaiting coroutine to the pool with the given priority.
+     *
+     * @param priority The priority level; 0 is the highest.
+     * @return An awaitable.
+     * @throw std::invalid_argument if @a priority is not a valid level.
+     *
+     * @internal
+     * @test @a ThreadPoolTest.StrictPriority
+     * @test @a ThreadPoolTest.WeightedSelection
+     */
+    [[nodiscard]] schedule_op schedule(std::size_t priority)
+    {
+        if (priority >= this->m_options.priorities) {
+            throw std::invalid_argument("Invalid priority");
+        }
+
+        return schedule_op{*this, priority, no_deadline};
+    }
+
+    /**
+     * @brief Moves the awaiting coroutine to the pool with the given priority, unless its caller gives up first.
+     *
+     * If the deadline has passed by the time a worker takes the coroutine from the queue, the worker does not run it:
+     * `co_await` throws `deadline_exceeded` instead, and the coroutine is counted in `shed()`.
+     *
+     * @param priority The priority level; 0 is the highest.
+     * @param deadline When the caller gives up on the coroutine.
+     * @return An awaitable.
+     * @throw std::invalid_argument if @a priority is not a valid level.
+     *
+     * @internal
+     * @test @a ThreadPoolTest.ShedExpired
+     */
+    [[nodiscard]] schedule_op schedule(std::size_t priority, clock::time_point deadline)
+    {
+        if (priority >= this->m_options.priorities) {
+            throw std::invalid_argument("Invalid priority");
+        }
+
+        return schedule_op{*this, priority, deadline};
+    }
+
+    /**
+     * @brief Returns the number of workers.
+     *
+     * @return The number of workers.
+     */
+    [[nodiscard]] std::size_t size() const noexcept { return this->m_workers.size(); }
+
+    /**
+     * @brief Returns the number of priority levels.
+     *
+     * @return The number of priority levels.
+     */
+    [[nodiscard]] std::size_t priorities() const noexcept { return this->m_options.priorities; }
+
+    /**
+     * @brief Returns the number of coroutines cancelled because their deadline had passed when they were dequeued.
+     *
+     * @return The number of shed coroutines.
+     *
+     * @internal
+     * @test @a ThreadPoolTest.ShedExpired
+     */
+    [[nodiscard]] std::uint64_t shed() const noexcept { return this->m_shed.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Returns the number of workers that take work.
+     *
+     * @return The number of active workers; `size()` unless the pool is elastic.
+     *
+     * @internal
+     * @test @a ThreadPoolTest.Elastic
+     */
+    [[nodiscard]] std::size_t active() const noexcept { return this->m_active.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Returns the moving average of the time scheduled coroutines spend in the queue.
+     *
+     * @return The average delay; only measured if the pool is elastic.
+     *
+     * @internal
+     * @test @a ThreadPoolTest.Elastic
+     */
+    [[nodiscard]] clock::duration queue_delay() const noexcept
+    {
+        return clock::duration(this->m_delay.load(std::memory_order_relaxed));
+    }
+
+    /**
+     * @brief Returns the priority of the coroutine running on the calling thread.
+     *
+     * @return The priority of the running coroutine if the calling thread is a worker of the pool; the default
+     * priority otherwise.
+     *
+     * @internal
+     * @test @a ThreadPoolTest.PriorityInheritance
+     */
+    [[nodiscard]] std::size_t current_priority() const noexcept
+    {
+        const worker_context& ctx = context();
+        return ctx.m_pool == this ? ctx.m_priority : this->m_options.default_priority;
+    }
+
+    /**
+     * @brief Checks whether the calling thread is a worker of the pool.
+     *
+     * @return Whether the calling thread is a worker of the pool.
+     *
+     * @internal
+     * @test @a ThreadPoolTest.RunsOnWorkers
+     */
+    [[nodiscard]] bool running_in_this_thread() const noexcept { return context().m_pool == this; }
+
+    /**
+     * @brief Returns the number of NUMA nodes the workers are spread over.
+     *
+     * @return The number of nodes; 1 unless the workers are pinned on a multi-node machine.
+     *
+     * @internal
+     * @test @a ThreadPoolTest.PinnedWorkers
+     */
+    [[nodiscard]] std::size_t nodes() const noexcept { return this->m_nodes; }
+
+    /**
+     * @brief Returns the NUMA node of the calling worker.
+     *
+     * @return The node of the worker; 0 if the calling thread is not a worker of the pool.
+     *
+     * @internal
+     * @test @a ThreadPoolTest.PinnedWorkers
+     */
+    [[nodiscard]] std::size_t current_node() const noexcept
+    {
+        const worker_context& ctx = context();
+        return ctx.m_pool == this ? this->m_workers[ctx.m_index]->m_node : 0;
+    }
+
+    /**
+     * @brief Awaitable for the schedule operation.
+     *
+     * @see thread_pool::schedule()
+     */
+    class [[nodiscard]] schedule_op : private detail::timed_node {
+    public:
+        /// @cond INTERNAL
+        /**
+         * @brief Constructs a new operation.
+         *
+         * @param pool The pool.
+         * @param priority The priority level.
+         * @param deadline When the caller gives up on the coroutine; `no_deadline` if never.
+         */
+        schedule_op(thread_pool& pool, std::size_t priority, clock::time_point deadline) noexcept
+            : detail::timed_node(deadline), m_pool(pool), m_priority(priority)
+        {}
+        /// @endcond
+
+        /**
+         * @brief Always suspends.
+         *
+         * @return `false`
+         */
+        [[nodiscard]] constexpr bool await_ready() const noexcept { return false; }
+
+        /**
+         * @brief Queues the coroutine.
+         *
+         * @param h The awaiting coroutine.
+         */
+        void await_suspend(std::coroutine_handle<> h) noexcept
+        {
+            this->m_handle = h;
+            this->m_pool.enqueue(this, this->m_priority);
+        }
+
+        /**
+         * @brief Checks whether the coroutine has been cancelled.
+         *
+         * @throw deadline_exceeded if the deadline had passed when a worker took the coroutine from the queue.
+         */
+        void await_resume() const
+        {
+            if (this->m_expired) {
+                throw deadline_exceeded("Deadline exceeded while queued");
+            }
+        }
+
+    private:
+        friend class thread_pool;
+
+        thread_pool& m_pool;     ///< The pool.
+        std::size_t m_priority;  ///< The priority level.
+    };
+
+private:
+    /** @brief A worker and its queues. */
+    struct alignas(detail::cache_line_size) worker {
+        /**
+         * @brief Constructs a new worker.
+         *
+         * @param levels The number of priority levels.
+         * @param credit The weight of the highest level.
+         */
+        worker(std::size_t levels, std::size_t credit)
+            : m_queues(std::make_unique<detail::intrusive_queue<detail::resume_node>[]>(levels)), m_credit(credit)
+        {}
+
+        detail::spinlock m_lock;                                           ///< Guards the queues.
+        std::unique_ptr<detail::intrusive_queue<detail::resume_node>[]> m_queues;  ///< One queue per level.
+        std::atomic<std::size_t> m_size = 0;  ///< The number of queued coroutines; lets thieves skip empty workers.
+        std::size_t m_cursor            = 0;  ///< The level served in weighted mode; worker only.
+        std::size_t m_credit;                 ///< What is left of the weight of `m_cursor`; worker only.
+        std::size_t m_node = 0;               ///< The NUMA node of the worker.
+        int m_cpu          = -1;              ///< The CPU the worker is pinned to; -1 if it is not pinned.
+        std::vector<std::size_t> m_victims;   ///< The other workers in stealing order: same node first.
+        std::thread m_thread;                 ///< The worker thread.
+    };
+
+    /** @brief A queued coroutine and its priority level. */
+    struct job {
+        detail::resume_node* m_node = nullptr;  ///< The coroutine; `nullptr` if there is none.
+        std::size_t m_priority      = 0;        ///< The priority level.
+    };
+
+    /** @brief What a thread knows about the pool it works for. */
+    struct worker_context {
+        const thread_pool* m_pool = nullptr;  ///< The pool; `nullptr` if the thread is not a worker.
+        std::size_t m_index       = 0;        ///< The index of the worker.
+        std::size_t m_priority    = 0;        ///< The priority of the running coroutine.
+    };
+
+    thread_pool_options m_options;                   ///< The options.
+    std::vector<std::unique_ptr<worker>> m_workers;  ///< The workers.
+    std::size_t m_nodes = 1;                         ///< The number of NUMA nodes the workers are spread over.
+    std::atomic<std::size_t> m_next    = 0;          ///< Round-robin cursor for submissions from outside.
+    std::atomic<std::size_t> m_pending = 0;          ///< Queued coroutines, counted before they become visible.
+    std::atomic<std::uint64_t> m_shed  = 0;          ///< Coroutines cancelled at dequeue.
+    std::atomic<bool> m_stop           = false;      ///< Whether the pool is being destroyed.
+    detail::eventcount m_idle;                       ///< Idle workers sleep here.
+
+    alignas(detail::cache_line_size) std::atomic<std::size_t> m_active = 0;  ///< Workers that take work.
+    std::atomic<std::uint32_t> m_roster      = 0;  ///< Bumped when `m_active` grows or the pool stops.
+    std::atomic<clock::rep> m_delay          = 0;  ///< Moving average of the queueing delay.
+    std::atomic<clock::rep> m_last_resize    = 0;  ///< When the active count last changed.
+
+    /**
+     * @brief Returns the context of the calling thread.
+     *
+     * @return The context.
+     */
+    static worker_context& context() noexcept
+    {
+        static thread_local worker_context ctx;
+        return ctx;
+    }
+
+    /** @brief Assigns every worker a NUMA node and a CPU of that node, taking the nodes in turn. */
+    void place_workers()
+    {
+        const std::vector<std::vector<int>> topology = detail::cpu_topology();
+        if (topology.empty()) {
+            return;
+        }
+
+        this->m_nodes = std::min(topology.size(), this->size());
+        for (std::size_t i = 0; i < this->size(); ++i) {
+            worker& w                    = *this->m_workers[i];
+            const std::vector<int>& cpus = topology[i % topology.size()];
+            w.m_node                     = i % topology.size();
+            w.m_cpu                      = cpus[(i / topology.size()) % cpus.size()];
+        }
+    }
+
+    /** @brief Orders the victims of every worker: the workers of the same node first, then the rest. */
+    void plan_stealing()
+    {
+        const std::size_t n = this->size();
+        for (std::size_t index = 0; index < n; ++index) {
+            worker& self = *this->m_workers[index];
+            for (const bool local : {true, false}) {
+                for (std::size_t i = 1; i < n; ++i) {
+                    const std::size_t victim = (index + i) % n;
+                    if ((this->m_workers[victim]->m_node == self.m_node) == local) {
+                        self.m_victims.push_back(victim);
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Queues a coroutine and wakes up a sleeping worker.
+     *
+     * The coroutine is counted in `m_pending` before it is queued; the sequentially consistent increment and the check
+     * for sleeping workers in the eventcount pair with `idle()`: either the sleeper sees the work, or the submitter
+     * sees the sleeper.
+     *
+     * @param node The coroutine.
+     * @param priority The priority level.
+     */
+    void enqueue(detail::resume_node* node, std::size_t priority) noexcept
+    {
+        const worker_context& ctx = context();
+        const std::size_t index   = ctx.m_pool == this ? ctx.m_index
+                                                       : this->m_next.fetch_add(1, std::memory_order_relaxed) %
+                                                           this->m_active.load(std::memory_order_relaxed);
+
+        if (node->m_timed && this->elastic()) {
+            static_cast<detail::timed_node*>(node)->m_queued = clock::now();
+        }
+
+        this->m_pending.fetch_add(1, std::memory_order_seq_cst);
+
+        worker& w = *this->m_workers[index];
+        {
+            const std::scoped_lock lock(w.m_lock);
+            w.m_queues[priority].push_back(node);
+            w.m_size.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        this->m_idle.notify_one();
+    }
+
+    /**
+     * @brief Queues a coroutine that the pool has resumed before; used by `yield_now()`, budgets, and `offload()`.
+     *
+     * @param pool The pool.
+     * @param node The coroutine.
+     * @param priority The priority the coroutine ran with.
+     */
+    static void reschedule(void* pool, detail::resume_node* node, std::size_t priority) noexcept
+    {
+        static_cast<thread_pool*>(pool)->enqueue(node, priority);
+    }
+
+    /**
+     * @brief Removes the first coroutine of a level; the lock of the worker must be held.
+     *
+     * @param w The worker.
+     * @param level The level; must not be empty.
+     * @return The job.
+     */
+    job take(worker& w, std::size_t level) noexcept
+    {
+        w.m_size.fetch_sub(1, std::memory_order_relaxed);
+        this->m_pending.fetch_sub(1, std::memory_order_relaxed);
+        return {w.m_queues[level].pop_front(), level};
+    }
+
+    /**
+     * @brief Takes the next coroutine from the queues of a worker, highest level first.
+     *
+     * @param w The worker.
+     * @return The job; empty if the queues are empty.
+     */
+    job pop_highest(worker& w) noexcept
+    {
+        const std::scoped_lock lock(w.m_lock);
+        for (std::size_t level = 0; level < this->m_options.priorities; ++level) {
+            if (!w.m_queues[level].empty()) {
+                return this->take(w, level);
+            }
+        }
+
+        return {};
+    }
+
+    /**
+     * @brief Takes the next coroutine from the own queues of a worker.
+     *
+     * In weighted mode, the worker serves a level up to its weight in a row, then moves on to the next non-empty level.
+     *
+     * @param w The worker.
+     * @return The job; empty if the queues are empty.
+     */
+    job pop_local(worker& w) noexcept
+    {
+        if (this->m_options.selection == priority_selection::strict) {
+            return this->pop_highest(w);
+        }
+
+        const std::size_t levels = this->m_options.priorities;
+        const std::scoped_lock lock(w.m_lock);
+        for (std::size_t i = 0; i <= levels; ++i) {
+            if (w.m_credit > 0 && !w.m_queues[w.m_cursor].empty()) {
+                --w.m_credit;
+                return this->take(w, w.m_cursor);
+            }
+
+            w.m_cursor = (w.m_cursor + 1) % levels;
+            w.m_credit = this->m_options.weights[w.m_cursor];
+        }
+
+        return {};
+    }
+
+    /**
+     * @brief Steals a coroutine from another worker, trying the workers of the same node first.
+     *
+     * @param index The index of the thief.
+     * @return The job; empty if there is nothing to steal.
+     */
+    job steal(std::size_t index) noexcept
+    {
+        for (const std::size_t v : this->m_workers[index]->m_victims) {
+            worker& victim = *this->m_workers[v];
+            if (victim.m_size.load(std::memory_order_relaxed) != 0) {
+                if (const job j = this->pop_highest(victim); j.m_node != nullptr) {
+                    return j;
+                }
+            }
+        }
+
+        return {};
+    }
+
+    /**
+     * @brief Waits until there is work or the pool stops: spins, then yields, then sleeps.
+     *
+     * @return Whether the worker should go on; `false` once the pool stops and no work is left.
+     */
+    bool idle()
+    {
+        const auto has_work = [this] { return this->m_pending.load(std::memory_order_seq_cst) != 0; };
+        const auto stopped  = [this] { return this->m_stop.load(std::memory_order_seq_cst); };
+
+        for (std::size_t i = 0; i < this->m_options.spins; ++i) {
+            if (has_work() || stopped()) {
+                return has_work() || !stopped();
+            }
+
+            detail::cpu_relax();
+        }
+
+        for (std::size_t i = 0; i < this->m_options.yields; ++i) {
+            if (has_work() || stopped()) {
+                return has_work() || !stopped();
+            }
+
+            std::this_thread::yield();
+        }
+
+        const detail::eventcount::key key = this->m_idle.prepare_wait();
+        if (has_work() || stopped()) {
+            this->m_idle.cancel_wait();
+            return has_work() || !stopped();
+        }
+
+        this->m_idle.wait(key);
+        return true;
+    }
+
+    /**
+     * @brief Checks whether the pool resizes itself.
+     *
+     * @return Whether the pool is elastic.
+     */
+    [[nodiscard]] bool elastic() const noexcept { return this->m_options.min_threads != 0; }
+
+    /**
+     * @brief Looks at a scheduled coroutine that has just been dequeued.
+     *
+     * Marks the coroutine as cancelled if its deadline has passed; in an elastic pool, also accounts for its queueing
+     * delay and grows the pool if the delay is too long.
+     *
+     * @param node The coroutine.
+     */
+    void dequeued(detail::timed_node* node) noexcept
+    {
+        const bool has_deadline = node->m_deadline != no_deadline;
+        if (!has_deadline && !this->elastic()) {
+            return;
+        }
+
+        const clock::time_point now = clock::now();
+        if (has_deadline && now > node->m_deadline) {
+            node->m_expired = true;
+            this->m_shed.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (this->elastic()) {
+            // Exponential moving average with a weight of 1/8; concurrent updates may lose a sample
+            const clock::rep sample = (now - node->m_queued).count();
+            const clock::rep delay  = this->m_delay.load(std::memory_order_relaxed);
+            this->m_delay.store(delay + (sample - delay) / 8, std::memory_order_relaxed);
+
+            if (clock::duration(delay) > this->m_options.target_delay) {
+                this->resize(now, +1);
+            }
+        }
+    }
+
+    /**
+     * @brief Changes the number of active workers by one, unless it has changed recently.
+     *
+     * @param now The current time.
+     * @param delta +1 to grow, -1 to shrink.
+     * @param from The active count to shrink from; only the last active worker may deactivate itself.
+     * @return Whether the number has changed.
+     */
+    bool resize(clock::time_point now, int delta, std::size_t from = 0) noexcept
+    {
+        const clock::rep last = this->m_last_resize.load(std::memory_order_relaxed);
+        if (now.time_since_epoch().count() - last < clock::duration(this->m_options.resize_interval).count()) {
+            return false;
+        }
+
+        std::size_t active = this->m_active.load(std::memory_order_relaxed);
+        if (delta > 0 ? active >= this->size() : (active != from || active <= this->m_options.min_threads)) {
+            return false;
+        }
+
+        // Whoever wins the race for the timestamp resizes
+        clock::rep expected = last;
+        if (!this->m_last_resize.compare_exchange_strong(
+                expected, now.time_since_epoch().count(), std::memory_order_relaxed
+            )) {
+            return false;
+        }
+
+        if (!this->m_active.compare_exchange_strong(
+                active, delta > 0 ? active + 1 : active - 1, std::memory_order_seq_cst
+            )) {
+            return false;
+        }
+
+        if (delta > 0) {
+            this->m_roster.fetch_add(1, std::memory_order_seq_cst);
+            this->m_roster.notify_all();
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Called when an active worker of an elastic pool runs out of work.
+     *
+     * An idle worker means that nothing waits in the queue, so the average delay decays. If it falls below half the
+     * target, the last active worker deactivates itself.
+     *
+     * @param index The index of the worker.
+     * @return Whether the worker has deactivated itself.
+     */
+    bool retire(std::size_t index) noexcept
+    {
+        const clock::rep delay   = this->m_delay.load(std::memory_order_relaxed);
+        const clock::rep decayed = delay - delay / 8;
+        this->m_delay.store(decayed, std::memory_order_relaxed);
+
+        return decayed < clock::duration(this->m_options.target_delay).count() / 2 &&
+               this->resize(clock::now(), -1, index + 1);
+    }
+
+    /**
+     * @brief Puts an inactive worker to sleep until it is activated or the pool stops.
+     *
+     * @param index The index of the worker.
+     * @return Whether the worker is active; `false` if the pool stops.
+     */
+    bool wait_active(std::size_t index) noexcept
+    {
+        for (;;) {
+            const std::uint32_t roster = this->m_roster.load(std::memory_order_seq_cst);
+            if (index < this->m_active.load(std::memory_order_seq_cst)) {
+                return true;
+            }
+
+            if (this->m_stop.load(std::memory_order_seq_cst)) {
+                return false;
+            }
+
+            this->m_roster.wait(roster, std::memory_order_seq_cst);
+        }
+    }
+
+    /**
+     * @brief The body of a worker thread.
+     *
+     * @param index The index of the worker.
+     */
+    void run(std::size_t index)
+    {
+        worker_context& ctx        = context();
+        detail::coop_context& coop = detail::coop();
+        ctx                        = {this, index, this->m_options.default_priority};
+        coop                       = {this, &thread_pool::reschedule, 0, 0};
+
+        worker& self = *this->m_workers[index];
+        if (self.m_cpu >= 0) {
+            detail::pin_to_cpu(self.m_cpu);
+        }
+
+        for (;;) {
+            if (this->elastic() && index >= this->m_active.load(std::memory_order_relaxed)) {
+                if (this->wait_active(index)) {
+                    continue;
+                }
+
+                break;
+            }
+
+            job j = this->pop_local(self);
+            if (j.m_node == nullptr) {
+                j = this->steal(index);
+            }
+
+            if (j.m_node != nullptr) {
+                if (j.m_node->m_timed) {
+                    this->dequeued(static_cast<detail::timed_node*>(j.m_node));
+                }
+
+                ctx.m_priority = j.m_priority;
+                coop.m_lane    = j.m_priority;
+                coop.m_budget  = this->m_options.budget;
+                j.m_node->m_handle.resume();
+            }
+            else if (this->elastic() && this->retire(index)) {
+                continue;
+            }
+            else if (!this->idle()) {
+                break;
+            }
+        }
+
+        ctx  = {};
+        coop = {};
+    }
+};
+
+/**
+ * @example thread_pool.cpp
+ * Example of running interactive and background work on a thread pool.
+ */
+
+}  // namespace wwa::coro
+
+#endif /* B38E5D16_C2F9_4A71_9D0B_E64A7F21C853 */
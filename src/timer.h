@@ -0,0 +1,387 @@
+#ifndef B5E29C7A_0D43_4A6F_9E18_C27F4B8D3A51
+#define B5E29C7A_0D43_4A6F_9E18_C27F4B8D3A51
+
+/**
+ * @file timer.h
+ * @brief Timer service.
+ *
+ * This file contains the definition of the `timer_service` class, which resumes coroutines at given points in time,
+ * and of the `sleep_for()` and `sleep_until()` awaitables.
+ *
+ * Example:
+ * @snippet timer.cpp timer example
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <mutex>
+#include <thread>
+
+namespace wwa::coro {
+
+class timer_service;
+
+/// @cond INTERNAL
+
+namespace detail {
+
+/**
+ * @brief An intrusive timer.
+ *
+ * Timers live inside awaiters (or other objects owned by the waiting party), so arming a timer does not allocate.
+ */
+struct timer_node {
+    /** @brief The clock used for deadlines. */
+    using clock = std::chrono::steady_clock;
+
+    timer_node* m_prev                   = nullptr;  ///< Previous timer in the list.
+    timer_node* m_next                   = nullptr;  ///< Next timer in the list.
+    clock::time_point m_deadline;                    ///< When the timer fires; guarded by the service.
+    void (*m_fire)(timer_node*) noexcept = nullptr;  ///< Invoked on the timer thread when the timer fires.
+    bool m_linked                        = false;    ///< Whether the timer is armed.
+};
+
+}  // namespace detail
+
+/// @endcond
+
+/**
+ * @brief A timer service.
+ *
+ * The service owns a thread that sleeps until the earliest deadline and fires expired timers. Armed timers are kept
+ * in an intrusive list sorted by deadline; a new timer is inserted by scanning from the latest deadline, which is O(1)
+ * when timers are armed in deadline order (the common case for timeouts of the same duration).
+ *
+ * Coroutines waiting on a timer are resumed on the timer thread; they should hand off long-running work to avoid
+ * delaying other timers.
+ *
+ * Example:
+ * @snippet timer.cpp timer example
+ */
+class timer_service {
+public:
+    /** @brief The clock used for deadlines. */
+    using clock = detail::timer_node::clock;
+
+    /**
+     * @brief Constructs a new timer service and starts its thread.
+     */
+    timer_service() : m_thread([this] { this->run(); }) {}
+
+    /// @cond
+    timer_service(const timer_service&)            = delete;
+    timer_service(timer_service&&)                 = delete;
+    timer_service& operator=(const timer_service&) = delete;
+    timer_service& operator=(timer_service&&)      = delete;
+    /// @endcond
+
+    /**
+     * @brief Destructor.
+     *
+     * Stops the timer thread. Timers that are still armed fire immediately so that no coroutine is left suspended.
+     *
+     * @internal
+     * @test @a TimerTest.DestructorFiresPending
+     */
+    ~timer_service()
+    {
+        {
+            const std::scoped_lock lock(this->m_mutex);
+            this->m_stop = true;
+        }
+
+        this->m_cv.notify_all();
+        this->m_thread.join();
+
+        while (this->m_head != nullptr) {
+            detail::timer_node* node = this->m_head;
+            this->unlink(node);
+            node->m_fire(node);
+        }
+    }
+
+    /**
+     * @brief Returns the process-wide timer service.
+     *
+     * The service is created on first use.
+     *
+     * @return The default timer service.
+     */
+    static timer_service& instance()
+    {
+        static timer_service service;
+        return service;
+    }
+
+    /**
+     * @brief Suspends the awaiting coroutine until the given point in time.
+     *
+     * @param deadline When to resume the coroutine.
+     * @return An awaitable.
+     *
+     * @internal
+     * @test @a TimerTest.SleepUntil
+     */
+    [[nodiscard]] auto sleep_until(clock::time_point deadline) noexcept { return sleep_op{*this, deadline}; }
+
+    /**
+     * @brief Suspends the awaiting coroutine for the given duration.
+     *
+     * @param duration How long to sleep.
+     * @return An awaitable.
+     *
+     * @internal
+     * @test @a TimerTest.SleepFor
+     */
+    template<typename Rep, typename Period>
+    [[nodiscard]] auto sleep_for(std::chrono::duration<Rep, Period> duration) noexcept
+    {
+        return this->sleep_until(clock::now() + std::chrono::ceil<clock::duration>(duration));
+    }
+
+    /// @cond INTERNAL
+    /**
+     * @brief Arms a timer, or moves an armed timer to a new deadline.
+     *
+     * @param node The timer; `m_fire` must be set.
+     * @param deadline When the timer fires.
+     */
+    void schedule(detail::timer_node* node, clock::time_point deadline)
+    {
+        bool new_head = false;
+        {
+            const std::scoped_lock lock(this->m_mutex);
+            if (node->m_linked) {
+                this->unlink(node);
+            }
+
+            new_head = this->link(node, deadline);
+        }
+
+        if (new_head) {
+            this->m_cv.notify_one();
+        }
+    }
+
+    /**
+     * @brief Moves an armed timer to an earlier deadline.
+     *
+     * Unlike `schedule()`, does nothing if the timer is not armed, so it may be called while the owner of the timer
+     * is running and is about to re-arm it.
+     *
+     * @param node The timer.
+     * @param deadline The new deadline.
+     * @return Whether the timer was moved.
+     */
+    bool expedite(detail::timer_node* node, clock::time_point deadline)
+    {
+        bool new_head = false;
+        {
+            const std::scoped_lock lock(this->m_mutex);
+            if (!node->m_linked || node->m_deadline <= deadline) {
+                return false;
+            }
+
+            this->unlink(node);
+            new_head = this->link(node, deadline);
+        }
+
+        if (new_head) {
+            this->m_cv.notify_one();
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Disarms a timer.
+     *
+     * If the timer is firing at the moment, waits until its callback returns (the callback may re-arm the timer).
+     * On the timer thread, the callback that is running is the caller itself, so there is nothing to wait for: this
+     * lets an object that owns a timer be destroyed by a coroutine that its own callback has resumed.
+     *
+     * @param node The timer.
+     * @return Whether the timer was armed.
+     * @warning If called from the callback of the same timer, the timer must not be touched after the callback
+     * returns.
+     */
+    bool cancel(detail::timer_node* node)
+    {
+        std::unique_lock lock(this->m_mutex);
+        if (std::this_thread::get_id() != this->m_thread.get_id()) {
+            this->m_fired_cv.wait(lock, [this, node] { return this->m_firing != node; });
+        }
+
+        if (node->m_linked) {
+            this->unlink(node);
+            return true;
+        }
+
+        return false;
+    }
+    /// @endcond
+
+private:
+    std::mutex m_mutex;                       ///< Guards the timer list.
+    std::condition_variable m_cv;             ///< Wakes up the timer thread.
+    std::condition_variable m_fired_cv;       ///< Signals that a timer callback has returned.
+    detail::timer_node* m_head   = nullptr;   ///< The timer with the earliest deadline.
+    detail::timer_node* m_tail   = nullptr;   ///< The timer with the latest deadline.
+    detail::timer_node* m_firing = nullptr;   ///< The timer whose callback is running.
+    bool m_stop                  = false;     ///< Whether the thread should exit.
+    std::thread m_thread;                     ///< The timer thread.
+
+    /**
+     * @brief Awaitable that resumes the coroutine at a given point in time.
+     */
+    class [[nodiscard]] sleep_op : private detail::timer_node {
+    public:
+        /**
+         * @brief Constructs a new operation.
+         *
+         * @param service The timer service.
+         * @param deadline When to resume the coroutine.
+         */
+        sleep_op(timer_service& service, clock::time_point deadline) noexcept
+            : m_service(service), m_wake_at(deadline)
+        {
+            this->m_fire = &sleep_op::fire;
+        }
+
+        /**
+         * @brief Checks whether the deadline has already passed.
+         *
+         * @return Whether the operation has completed.
+         */
+        [[nodiscard]] bool await_ready() const noexcept { return this->m_wake_at <= clock::now(); }
+
+        /**
+         * @brief Arms the timer.
+         *
+         * @param h The awaiting coroutine.
+         */
+        void await_suspend(std::coroutine_handle<> h)
+        {
+            this->m_awaiting = h;
+            this->m_service.schedule(this, this->m_wake_at);
+        }
+
+        /** @brief Does nothing. */
+        constexpr void await_resume() const noexcept {}
+
+    private:
+        timer_service& m_service;            ///< The timer service.
+        clock::time_point m_wake_at;         ///< When to resume the coroutine.
+        std::coroutine_handle<> m_awaiting;  ///< The sleeping coroutine.
+
+        /**
+         * @brief Resumes the sleeping coroutine.
+         *
+         * @param node The timer.
+         */
+        static void fire(detail::timer_node* node) noexcept { static_cast<sleep_op*>(node)->m_awaiting.resume(); }
+    };
+
+    /**
+     * @brief Inserts a timer into the list; the mutex must be held.
+     *
+     * The list is scanned from the latest deadline.
+     *
+     * @param node The timer; must not be armed.
+     * @param deadline When the timer fires.
+     * @return Whether the timer is now the earliest one.
+     */
+    bool link(detail::timer_node* node, clock::time_point deadline) noexcept
+    {
+        node->m_deadline          = deadline;
+        detail::timer_node* after = this->m_tail;
+        while (after != nullptr && after->m_deadline > deadline) {
+            after = after->m_prev;
+        }
+
+        node->m_prev = after;
+        node->m_next = after != nullptr ? after->m_next : this->m_head;
+        (node->m_next != nullptr ? node->m_next->m_prev : this->m_tail) = node;
+        (after != nullptr ? after->m_next : this->m_head)                = node;
+        node->m_linked                                                   = true;
+        return this->m_head == node;
+    }
+
+    /**
+     * @brief Removes a timer from the list; the mutex must be held.
+     *
+     * @param node The timer.
+     */
+    void unlink(detail::timer_node* node) noexcept
+    {
+        (node->m_prev != nullptr ? node->m_prev->m_next : this->m_head) = node->m_next;
+        (node->m_next != nullptr ? node->m_next->m_prev : this->m_tail) = node->m_prev;
+        node->m_prev = node->m_next = nullptr;
+        node->m_linked              = false;
+    }
+
+    /**
+     * @brief The body of the timer thread.
+     */
+    void run()
+    {
+        std::unique_lock lock(this->m_mutex);
+        while (!this->m_stop) {
+            if (this->m_head == nullptr) {
+                this->m_cv.wait(lock);
+                continue;
+            }
+
+            if (this->m_head->m_deadline > clock::now()) {
+                this->m_cv.wait_until(lock, this->m_head->m_deadline);
+                continue;
+            }
+
+            detail::timer_node* node = this->m_head;
+            this->unlink(node);
+            this->m_firing = node;
+
+            lock.unlock();
+            node->m_fire(node);
+            lock.lock();
+
+            this->m_firing = nullptr;
+            this->m_fired_cv.notify_all();
+        }
+    }
+};
+
+/**
+ * @brief Suspends the awaiting coroutine for the given duration using the default timer service.
+ *
+ * @param duration How long to sleep.
+ * @return An awaitable.
+ * @see timer_service::instance()
+ */
+template<typename Rep, typename Period>
+[[nodiscard]] inline auto sleep_for(std::chrono::duration<Rep, Period> duration) noexcept
+{
+    return timer_service::instance().sleep_for(duration);
+}
+
+/**
+ * @brief Suspends the awaiting coroutine until the given point in time using the default timer service.
+ *
+ * @param deadline When to resume the coroutine.
+ * @return An awaitable.
+ * @see timer_service::instance()
+ */
+[[nodiscard]] inline auto sleep_until(timer_service::clock::time_point deadline) noexcept
+{
+    return timer_service::instance().sleep_until(deadline);
+}
+
+/**
+ * @example timer.cpp
+ * Example of suspending coroutines with timers.
+ */
+
+}  // namespace wwa::coro
+
+#endif /* B5E29C7A_0D43_4A6F_9E18_C27F4B8D3A51 */
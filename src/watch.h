@@ -0,0 +1,340 @@
+#ifndef A7D4E2B9_61C3_4F85_B0E8_93F2C5A14D76
+#define A7D4E2B9_61C3_4F85_B0E8_93F2C5A14D76
+
+/**
+ * @file watch.h
+ * @brief Latest-value broadcast channel.
+ *
+ * This file contains the definition of the `watch` class template. A watch holds a single value; writers replace it,
+ * and any number of readers can read the latest value or wait until it changes. Intermediate values may be skipped.
+ *
+ * Example:
+ * @snippet watch.cpp watch example
+ */
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+
+#include "detail.h"
+
+namespace wwa::coro {
+
+/**
+ * @brief A latest-value broadcast channel protected by a seqlock.
+ *
+ * The value is stored in a seqlock: a writer makes the sequence counter odd, updates the value, and makes the counter
+ * even again; a reader copies the value out and retries if the counter changed in the meantime. Readers never take
+ * a lock, never write to shared memory, and never suspend in `borrow()`.
+ *
+ * `co_await w.changed()` suspends until a writer publishes a new value. Writers resume all waiting readers in one batch.
+ *
+ * Example:
+ * @snippet watch.cpp watch example
+ *
+ * @tparam T The type of the value; must be trivially copyable.
+ */
+template<typename T>
+requires std::is_trivially_copyable_v<T>
+class watch {
+public:
+    /** @brief The type of the value. */
+    using value_type = T;
+
+    class changed_op;
+
+    /**
+     * @brief Constructs a new watch.
+     *
+     * @param initial The initial value; its version is 0.
+     */
+    explicit watch(const T& initial = T{}) noexcept
+    {
+        std::array<word, word_count> words{};
+        std::memcpy(words.data(), &initial, sizeof(T));
+        for (std::size_t i = 0; i < word_count; ++i) {
+            this->m_words[i].store(words[i], std::memory_order_relaxed);
+        }
+    }
+
+    /// @cond
+    watch(const watch&)            = delete;
+    watch(watch&&)                 = delete;
+    watch& operator=(const watch&) = delete;
+    watch& operator=(watch&&)      = delete;
+    /// @endcond
+
+    /**
+     * @brief Destructor.
+     *
+     * @warning No coroutines may be suspended on the watch when it is destroyed; call `close()` first.
+     */
+    ~watch() = default;
+
+    /**
+     * @brief Returns the latest value.
+     *
+     * @return A copy of the latest value.
+     *
+     * @internal
+     * @test @a WatchTest.PublishBorrow
+     */
+    [[nodiscard]] T borrow() const noexcept
+    {
+        std::uint64_t version = 0;
+        return this->borrow(version);
+    }
+
+    /**
+     * @brief Returns the latest value together with its version.
+     *
+     * @param version Receives the version of the returned value.
+     * @return A copy of the latest value.
+     *
+     * @internal
+     * @test @a WatchTest.PublishBorrow
+     * @test @a WatchTest.ConcurrentReaders
+     */
+    T borrow(std::uint64_t& version) const noexcept
+    {
+        std::array<word, word_count> words{};
+        while (true) {
+            const std::uint64_t before = this->m_sequence.load(std::memory_order_acquire);
+            if ((before & 1U) != 0) {
+                detail::cpu_relax();
+                continue;
+            }
+
+            for (std::size_t i = 0; i < word_count; ++i) {
+                words[i] = this->m_words[i].load(std::memory_order_relaxed);
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (this->m_sequence.load(std::memory_order_relaxed) == before) {
+                version = before / 2;
+                break;
+            }
+        }
+
+        std::array<std::byte, sizeof(T)> bytes{};
+        std::memcpy(bytes.data(), words.data(), sizeof(T));
+        return std::bit_cast<T>(bytes);
+    }
+
+    /**
+     * @brief Returns the version of the latest value.
+     *
+     * The version starts at 0 and is incremented by every `publish()`.
+     *
+     * @return The version of the latest value.
+     */
+    [[nodiscard]] std::uint64_t version() const noexcept { return this->m_sequence.load(std::memory_order_acquire) / 2; }
+
+    /**
+     * @brief Replaces the value and resumes all readers waiting for a change.
+     *
+     * Concurrent writers are serialized.
+     *
+     * @param value The new value.
+     *
+     * @internal
+     * @test @a WatchTest.PublishBorrow
+     * @test @a WatchTest.ChangedWakesAll
+     */
+    void publish(const T& value)
+    {
+        {
+            const std::scoped_lock lock(this->m_write_lock);
+            this->store(value);
+        }
+
+        changed_op* waiters = nullptr;
+        {
+            const std::scoped_lock lock(this->m_waiters_lock);
+            waiters = this->m_waiters.take_all();
+        }
+
+        resume_all(waiters);
+    }
+
+    /**
+     * @brief Resumes all waiting readers; subsequent `changed()` operations complete immediately.
+     *
+     * The value can still be read after the watch is closed.
+     *
+     * @internal
+     * @test @a WatchTest.Close
+     */
+    void close()
+    {
+        changed_op* waiters = nullptr;
+        {
+            const std::scoped_lock lock(this->m_waiters_lock);
+            this->m_closed.store(true, std::memory_order_release);
+            waiters = this->m_waiters.take_all();
+        }
+
+        resume_all(waiters);
+    }
+
+    /**
+     * @brief Checks whether the watch has been closed.
+     *
+     * @return Whether the watch has been closed.
+     */
+    [[nodiscard]] bool is_closed() const noexcept { return this->m_closed.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Waits for the value to change.
+     *
+     * The awaitable completes when the version of the value differs from the version at the time of this call.
+     *
+     * @return An awaitable that yields `true` if the value has changed, or `false` if the watch has been closed.
+     *
+     * @internal
+     * @test @a WatchTest.ChangedWakesAll
+     */
+    [[nodiscard]] changed_op changed() noexcept { return changed_op{*this, this->version()}; }
+
+    /**
+     * @brief Waits for the value to change since the given version.
+     *
+     * Use this overload together with `borrow(version)` to avoid missing an update that happens between the two calls.
+     *
+     * @param since The version the caller has already seen.
+     * @return An awaitable that yields `true` if the value has changed, or `false` if the watch has been closed.
+     *
+     * @internal
+     * @test @a WatchTest.ChangedSince
+     */
+    [[nodiscard]] changed_op changed(std::uint64_t since) noexcept { return changed_op{*this, since}; }
+
+    /**
+     * @brief Awaitable that waits for the value to change.
+     *
+     * @see watch::changed()
+     */
+    class [[nodiscard]] changed_op : public detail::intrusive_hook<changed_op> {
+    public:
+        /// @cond INTERNAL
+        /**
+         * @brief Constructs a new operation.
+         *
+         * @param w The watch.
+         * @param since The version the caller has already seen.
+         */
+        changed_op(watch& w, std::uint64_t since) noexcept : m_watch(w), m_since(since) {}
+        /// @endcond
+
+        /**
+         * @brief Checks whether the value has already changed without taking any locks.
+         *
+         * @return Whether the operation has completed.
+         */
+        [[nodiscard]] bool await_ready() const noexcept
+        {
+            return this->m_watch.version() != this->m_since || this->m_watch.is_closed();
+        }
+
+        /**
+         * @brief Registers the reader unless the value has changed in the meantime.
+         *
+         * @param h The awaiting coroutine.
+         * @return Whether the coroutine should stay suspended.
+         */
+        bool await_suspend(std::coroutine_handle<> h) noexcept
+        {
+            const std::scoped_lock lock(this->m_watch.m_waiters_lock);
+            if (this->await_ready()) {
+                return false;
+            }
+
+            this->m_awaiting = h;
+            this->m_watch.m_waiters.push_back(this);
+            return true;
+        }
+
+        /**
+         * @brief Returns the result of the operation.
+         *
+         * @return Whether the value has changed; `false` means that the watch has been closed.
+         */
+        [[nodiscard]] bool await_resume() const noexcept { return this->m_watch.version() != this->m_since; }
+
+    private:
+        friend class watch;
+
+        watch& m_watch;                      ///< The watch.
+        std::uint64_t m_since;               ///< The version the caller has already seen.
+        std::coroutine_handle<> m_awaiting;  ///< The suspended reader.
+    };
+
+private:
+    /** @brief Storage unit of the value. */
+    using word = std::uintptr_t;
+
+    /** @brief Number of words needed to store the value. */
+    static constexpr std::size_t word_count = (sizeof(T) + sizeof(word) - 1) / sizeof(word);
+
+    /**
+     * @brief Sequence counter; odd while a write is in progress.
+     *
+     * The value is stored as atomic words so that readers racing with a writer do not cause undefined behavior;
+     * torn reads are detected and discarded by the sequence check.
+     */
+    alignas(detail::cache_line_size) std::atomic<std::uint64_t> m_sequence = 0;
+    std::array<std::atomic<word>, word_count> m_words{};                      ///< The value.
+    alignas(detail::cache_line_size) detail::spinlock m_write_lock;           ///< Serializes writers.
+    detail::spinlock m_waiters_lock;                                          ///< Guards the waiter list.
+    detail::intrusive_queue<changed_op> m_waiters;                            ///< Waiting readers.
+    std::atomic<bool> m_closed = false;                                       ///< Whether the watch has been closed.
+
+    /**
+     * @brief Writes the value under the seqlock; the caller must serialize writers.
+     *
+     * @param value The new value.
+     */
+    void store(const T& value) noexcept
+    {
+        std::array<word, word_count> words{};
+        std::memcpy(words.data(), &value, sizeof(T));
+
+        const std::uint64_t seq = this->m_sequence.load(std::memory_order_relaxed);
+        this->m_sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t i = 0; i < word_count; ++i) {
+            this->m_words[i].store(words[i], std::memory_order_relaxed);
+        }
+
+        this->m_sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief Resumes a chain of waiters.
+     *
+     * @param waiters The first waiter of the chain.
+     */
+    static void resume_all(changed_op* waiters)
+    {
+        while (waiters != nullptr) {
+            std::coroutine_handle<> h = waiters->m_awaiting;
+            waiters                   = waiters->m_next;
+            h.resume();
+        }
+    }
+};
+
+/**
+ * @example watch.cpp
+ * Example of broadcasting configuration updates with a watch.
+ */
+
+}  // namespace wwa::coro
+
+#endif /* A7D4E2B9_61C3_4F85_B0E8_93F2C5A14D76 */
@@ -0,0 +1,319 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <coroutine>
+#include <latch>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "actor.h"
+#include "eager_task.h"
+#include "task.h"
+#include "thread_pool.h"
+
+using namespace wwa::coro;
+
+namespace {
+
+struct add {
+    int value;
+};
+
+struct get {};
+
+struct fail {};
+
+struct counter {
+    int total = 0;
+
+    int handle(add msg)
+    {
+        this->total += msg.value;
+        return this->total;
+    }
+
+    [[nodiscard]] int handle(get) const { return this->total; }
+
+    [[noreturn]] static int handle(fail) { throw std::runtime_error("fail"); }
+};
+
+struct slow_append {
+    std::string text;
+};
+
+struct journal {
+    explicit journal(thread_pool* p) : pool(p) {}
+
+    thread_pool* pool = nullptr;
+    std::vector<std::string> entries;
+    std::atomic<bool> busy = false;
+    bool overlap           = false;
+
+    // Suspends in the middle of a message; the actor must not take the next one meanwhile
+    task<std::size_t> handle(slow_append msg)
+    {
+        this->overlap = this->overlap || this->busy.exchange(true);
+        co_await this->pool->schedule();
+        this->entries.push_back(std::move(msg.text));
+        this->busy = false;
+        co_return this->entries.size();
+    }
+
+    [[nodiscard]] std::vector<std::string> handle(get) const { return this->entries; }
+
+    [[nodiscard]] bool handle(fail) const { return this->overlap; }
+};
+
+struct park {};
+
+struct note {
+    std::string text;
+};
+
+// Parks the first message until the test resumes it, so that the messages after it queue up
+struct parking {
+    std::coroutine_handle<>* parked;
+    std::vector<std::string>* log;
+
+    struct parker {
+        std::coroutine_handle<>* m_parked;
+
+        [[nodiscard]] static constexpr bool await_ready() noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) const noexcept { *this->m_parked = h; }
+        constexpr void await_resume() const noexcept {}
+    };
+
+    task<int> handle(park) const
+    {
+        co_await parker{this->parked};
+        co_return 1;
+    }
+
+    int handle(note msg) const
+    {
+        this->log->push_back(std::move(msg.text));
+        return 2;
+    }
+};
+
+// Like `parking`, but counts the notes from any thread
+struct gated {
+    std::coroutine_handle<>* parked;
+    std::atomic<int>* handled;
+
+    task<int> handle(park) const
+    {
+        co_await parking::parker{this->parked};
+        co_return 1;
+    }
+
+    int handle(const note&) const { return this->handled->fetch_add(1) + 1; }
+};
+
+}  // namespace
+
+TEST(ActorTest, Ask)
+{
+    actor<counter> a;
+    int reply = 0;
+
+    [](actor<counter>& c, int& r) -> eager_task {
+        // Synchronous handlers on an idle actor run inline
+        for (int i = 0; i < 1000; ++i) {
+            r = co_await c.ask(add{1});
+        }
+    }(a, reply);
+
+    EXPECT_EQ(reply, 1000);
+}
+
+TEST(ActorTest, Exception)
+{
+    actor<counter> a;
+    bool caught = false;
+    int total   = 0;
+
+    [](actor<counter>& c, bool& e, int& t) -> eager_task {
+        co_await c.ask(add{5});
+        try {
+            co_await c.ask(fail{});
+        }
+        catch (const std::runtime_error&) {
+            e = true;
+        }
+
+        t = co_await c.ask(get{});
+    }(a, caught, total);
+
+    EXPECT_TRUE(caught);
+    EXPECT_EQ(total, 5);
+}
+
+TEST(ActorTest, Tell)
+{
+    actor<counter> a;
+    int total = 0;
+
+    a.tell(add{1});
+    a.tell(add{2});
+    [](actor<counter>& c, int& t) -> eager_task { t = co_await c.ask(get{}); }(a, total);
+
+    EXPECT_EQ(total, 3);
+}
+
+TEST(ActorTest, AsyncHandler)
+{
+    thread_pool pool({.threads = 2});
+    actor<journal> a(&pool);
+    std::vector<std::size_t> sizes(3);
+    std::latch done(3);
+
+    const auto append = [](actor<journal>& j, std::string text, std::size_t& size, std::latch& d) -> eager_task {
+        // Not a temporary inside co_await: GCC 12 destroys such arguments of coroutines too early
+        slow_append msg{std::move(text)};
+        size = co_await j.ask(std::move(msg));
+        d.count_down();
+    };
+
+    // The first message suspends on the pool; the other two are queued behind it
+    append(a, "one", sizes[0], done);
+    append(a, "two", sizes[1], done);
+    append(a, "three", sizes[2], done);
+    done.wait();
+
+    std::vector<std::string> entries;
+    bool overlap = true;
+    std::latch read(1);
+    [](actor<journal>& j, std::vector<std::string>& e, bool& o, std::latch& l) -> eager_task {
+        e = co_await j.ask(get{});
+        o = co_await j.ask(fail{});
+        l.count_down();
+    }(a, entries, overlap, read);
+    read.wait();
+
+    EXPECT_EQ(entries, (std::vector<std::string>{"one", "two", "three"}));
+    EXPECT_EQ(sizes, (std::vector<std::size_t>{1, 2, 3}));
+    EXPECT_FALSE(overlap);
+}
+
+TEST(ActorTest, Serializes)
+{
+    constexpr int senders = 4;
+    constexpr int steps   = 200;
+
+    thread_pool pool({.threads = 4});
+    actor<journal> a(&pool);
+    std::latch done(senders);
+
+    for (int i = 0; i < senders; ++i) {
+        [](thread_pool& p, actor<journal>& j, std::latch& d) -> eager_task {
+            for (int k = 0; k < steps; ++k) {
+                co_await p.schedule();
+                slow_append msg{"x"};
+                co_await j.ask(std::move(msg));
+            }
+
+            d.count_down();
+        }(pool, a, done);
+    }
+
+    done.wait();
+
+    std::size_t size = 0;
+    bool overlap     = true;
+    std::latch read(1);
+    [](actor<journal>& j, std::size_t& s, bool& o, std::latch& l) -> eager_task {
+        s = (co_await j.ask(get{})).size();
+        o = co_await j.ask(fail{});
+        l.count_down();
+    }(a, size, overlap, read);
+    read.wait();
+
+    EXPECT_EQ(size, static_cast<std::size_t>(senders * steps));
+    EXPECT_FALSE(overlap);
+}
+
+TEST(ActorTest, DestroyFromContinuation)
+{
+    std::coroutine_handle<> parked;
+    std::vector<std::string> log;
+    auto a       = std::make_unique<actor<parking>>(&parked, &log);
+    int first    = 0;
+    int second   = 0;
+    bool deleted = false;
+
+    [](actor<parking>& p, int& r) -> eager_task { r = co_await p.ask(park{}); }(*a, first);
+    [](std::unique_ptr<actor<parking>>& p, int& r, bool& d) -> eager_task {
+        note msg{"queued"};
+        r = co_await p->ask(std::move(msg));
+        // The last reply may destroy the actor: the actor is idle by the time the reply is delivered
+        p.reset();
+        d = true;
+    }(a, second, deleted);
+
+    ASSERT_TRUE(parked);
+    parked.resume();
+
+    EXPECT_EQ(first, 1);
+    EXPECT_EQ(second, 2);
+    EXPECT_TRUE(deleted);
+}
+
+TEST(ActorTest, ReplyBeforeBacklog)
+{
+    std::coroutine_handle<> parked;
+    std::vector<std::string> log;
+    actor<parking> a(&parked, &log);
+
+    [](actor<parking>& p, std::vector<std::string>& l) -> eager_task {
+        co_await p.ask(park{});
+        l.emplace_back("reply");
+    }(a, log);
+
+    for (int i = 0; i < 3; ++i) {
+        a.tell(note{"backlog"});
+    }
+
+    ASSERT_TRUE(parked);
+    parked.resume();
+
+    // Without a scheduler, the reply waits for the next message to start, but not for the rest of the backlog
+    EXPECT_EQ(log, (std::vector<std::string>{"backlog", "reply", "backlog", "backlog"}));
+}
+
+TEST(ActorTest, ContinuationOnPool)
+{
+    thread_pool pool({.threads = 1});
+    std::coroutine_handle<> parked;
+    std::atomic<int> handled = 0;
+    actor<gated> a(&parked, &handled);
+    std::latch done(1);
+
+    [](actor<gated>& g, std::atomic<int>& h, std::latch& d) -> eager_task {
+        co_await g.ask(park{});
+
+        // Waits for the messages queued behind this one: the actor must not wait for this coroutine in turn
+        while (h.load() < 3) {
+            std::this_thread::yield();
+        }
+
+        d.count_down();
+    }(a, handled, done);
+
+    for (int i = 0; i < 3; ++i) {
+        a.tell(note{"backlog"});
+    }
+
+    ASSERT_TRUE(parked);
+    [](thread_pool& p, std::coroutine_handle<> h) -> eager_task {
+        co_await p.schedule();
+        h.resume();
+    }(pool, parked);
+
+    done.wait();
+    EXPECT_EQ(handled.load(), 3);
+}
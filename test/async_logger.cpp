@@ -0,0 +1,197 @@
+#include <gtest/gtest.h>
+
+#include <poll.h>
+#include <unistd.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "async_logger.h"
+
+using namespace wwa::coro;
+using namespace std::chrono_literals;
+
+namespace {
+
+class pipe_fixture : public ::testing::Test {
+protected:
+    void SetUp() override { ASSERT_EQ(pipe(this->m_fds.data()), 0); }
+
+    void TearDown() override
+    {
+        close(this->m_fds[0]);
+        close(this->m_fds[1]);
+    }
+
+    [[nodiscard]] int write_end() const noexcept { return this->m_fds[1]; }
+
+    // Reads until `size` bytes arrive or nothing arrives for a while
+    std::string read(std::size_t size, int timeout_ms = 5000) const
+    {
+        std::string out;
+        std::array<char, 4096> buf{};
+        while (out.size() < size) {
+            pollfd pfd{this->m_fds[0], POLLIN, 0};
+            if (poll(&pfd, 1, timeout_ms) <= 0) {
+                break;
+            }
+
+            const ssize_t n = ::read(this->m_fds[0], buf.data(), std::min(buf.size(), size - out.size()));
+            if (n <= 0) {
+                break;
+            }
+
+            out.append(buf.data(), static_cast<std::size_t>(n));
+        }
+
+        return out;
+    }
+
+private:
+    std::array<int, 2> m_fds{-1, -1};
+};
+
+class AsyncLoggerTest : public pipe_fixture {};
+
+}  // namespace
+
+TEST_F(AsyncLoggerTest, InvalidOptions)
+{
+    EXPECT_THROW(async_logger(this->write_end(), {.ring_capacity = 0}), std::invalid_argument);
+}
+
+TEST_F(AsyncLoggerTest, Format)
+{
+    async_logger logger(this->write_end(), {.flush_interval = 1h});
+
+    const std::string name = "answer";
+    EXPECT_TRUE(logger.log(name, '=', 42, " pi=", 3.5, " ok=", true, " min=", -9223372036854775807LL - 1));
+    EXPECT_TRUE(logger.log("unsigned=", 18446744073709551615ULL));
+    logger.flush();
+
+    const std::string expected = "answer=42 pi=3.5 ok=true min=-9223372036854775808\nunsigned=18446744073709551615\n";
+    EXPECT_EQ(this->read(expected.size()), expected);
+}
+
+TEST_F(AsyncLoggerTest, ThresholdWakesFlusher)
+{
+    async_logger logger(this->write_end(), {.flush_threshold = 16, .flush_interval = 1h});
+
+    EXPECT_TRUE(logger.log("short"));
+    EXPECT_EQ(this->read(1, 50), "");
+
+    // Crossing the threshold wakes up the flusher long before the interval passes
+    EXPECT_TRUE(logger.log("a somewhat longer record"));
+    EXPECT_EQ(this->read(31), "short\na somewhat longer record\n");
+}
+
+TEST_F(AsyncLoggerTest, IntervalFlush)
+{
+    async_logger logger(this->write_end(), {.flush_interval = 10ms});
+
+    EXPECT_TRUE(logger.log("tick"));
+    EXPECT_EQ(this->read(5), "tick\n");
+}
+
+TEST_F(AsyncLoggerTest, DropPolicy)
+{
+    async_logger logger(this->write_end(), {.ring_capacity = 64, .flush_threshold = 1024, .flush_interval = 1h});
+
+    const std::string record(29, 'x');  // 30 bytes with the newline
+    EXPECT_TRUE(logger.log(record));
+    EXPECT_TRUE(logger.log(record));
+    EXPECT_FALSE(logger.log(record));
+    EXPECT_FALSE(logger.log(std::string(100, 'y')));
+    EXPECT_EQ(logger.dropped(), 2U);
+
+    // The records that fit are written out; dropping wakes up the flusher
+    EXPECT_EQ(this->read(60), record + "\n" + record + "\n");
+}
+
+TEST_F(AsyncLoggerTest, BlockPolicy)
+{
+    async_logger logger(
+        this->write_end(),
+        {.ring_capacity = 64, .flush_threshold = 1024, .flush_interval = 1h, .overflow = overflow_policy::block}
+    );
+
+    std::thread reader_thread;
+    std::string output;
+    reader_thread = std::thread([this, &output] { output = this->read(300); });
+
+    const std::string record(29, 'x');
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_TRUE(logger.log(record));
+    }
+
+    logger.flush();
+    reader_thread.join();
+
+    EXPECT_EQ(output.size(), 300U);
+    EXPECT_EQ(logger.dropped(), 0U);
+}
+
+TEST_F(AsyncLoggerTest, ManyThreads)
+{
+    constexpr int threads = 4;
+    constexpr int count   = 2000;
+
+    std::string output;
+    std::size_t expected_size = 0;
+    for (int t = 0; t < threads; ++t) {
+        for (int i = 0; i < count; ++i) {
+            expected_size += std::to_string(t).size() + 1 + std::to_string(i).size() + 1;
+        }
+    }
+
+    std::thread reader_thread([this, &output, expected_size] { output = this->read(expected_size); });
+
+    {
+        async_logger logger(this->write_end(), {.ring_capacity = 1024, .overflow = overflow_policy::block});
+        std::vector<std::thread> writers;
+        for (int t = 0; t < threads; ++t) {
+            writers.emplace_back([&logger, t] {
+                for (int i = 0; i < count; ++i) {
+                    logger.log(t, ' ', i);
+                }
+            });
+        }
+
+        for (auto& w : writers) {
+            w.join();
+        }
+    }
+
+    reader_thread.join();
+
+    // Records of one thread come out in order
+    std::map<int, int> next;
+    std::istringstream in(output);
+    int t = 0;
+    int i = 0;
+    int lines = 0;
+    while (in >> t >> i) {
+        EXPECT_EQ(i, next[t]);
+        next[t] = i + 1;
+        ++lines;
+    }
+
+    EXPECT_EQ(lines, threads * count);
+}
+
+TEST_F(AsyncLoggerTest, DestructorFlushes)
+{
+    {
+        async_logger logger(this->write_end(), {.flush_interval = 1h});
+        EXPECT_TRUE(logger.log("bye"));
+    }
+
+    EXPECT_EQ(this->read(4, 0), "bye\n");
+}
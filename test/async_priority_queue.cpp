@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "async_priority_queue.h"
+#include "eager_task.h"
+
+using namespace wwa::coro;
+
+TEST(AsyncPriorityQueueTest, ZeroShards)
+{
+    EXPECT_THROW(async_priority_queue<int>{0}, std::invalid_argument);
+    EXPECT_GE(async_priority_queue<int>{}.shards(), 2U);
+}
+
+TEST(AsyncPriorityQueueTest, StrictOrderWithOneShard)
+{
+    async_priority_queue<int> q(1);
+    for (int v : {3, 1, 4, 1, 5, 9, 2, 6}) {
+        EXPECT_TRUE(q.push(v));
+    }
+
+    EXPECT_EQ(q.size(), 8U);
+
+    std::vector<int> out;
+    while (auto v = q.try_pop()) {
+        out.push_back(*v);
+    }
+
+    EXPECT_EQ(out, (std::vector<int>{9, 6, 5, 4, 3, 2, 1, 1}));
+    EXPECT_EQ(q.size(), 0U);
+}
+
+TEST(AsyncPriorityQueueTest, CustomCompare)
+{
+    async_priority_queue<int, std::greater<>> q(1);
+    for (int v : {3, 1, 2}) {
+        q.push(v);
+    }
+
+    EXPECT_EQ(q.try_pop(), 1);
+    EXPECT_EQ(q.try_pop(), 2);
+    EXPECT_EQ(q.try_pop(), 3);
+}
+
+TEST(AsyncPriorityQueueTest, RelaxedOrderKeepsAllElements)
+{
+    async_priority_queue<int> q(8);
+    for (int i = 0; i < 1000; ++i) {
+        q.push(i);
+    }
+
+    std::vector<int> out;
+    while (auto v = q.try_pop()) {
+        out.push_back(*v);
+    }
+
+    ASSERT_EQ(out.size(), 1000U);
+
+    // The first element popped comes from the top of one of the shards
+    EXPECT_GT(out.front(), 500);
+
+    std::ranges::sort(out);
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(out[static_cast<std::size_t>(i)], i);
+    }
+}
+
+TEST(AsyncPriorityQueueTest, PopSuspendsWhenEmpty)
+{
+    async_priority_queue<int> q(4);
+    std::optional<int> received;
+
+    [](async_priority_queue<int>& queue, std::optional<int>& out) -> eager_task {
+        out = co_await queue.pop();
+    }(q, received);
+
+    EXPECT_FALSE(received.has_value());
+
+    q.push(1983);
+    EXPECT_EQ(received, 1983);
+    EXPECT_EQ(q.size(), 0U);
+}
+
+TEST(AsyncPriorityQueueTest, Close)
+{
+    async_priority_queue<int> q(2);
+    int woken = 0;
+
+    for (int i = 0; i < 2; ++i) {
+        [](async_priority_queue<int>& queue, int& n) -> eager_task {
+            EXPECT_FALSE((co_await queue.pop()).has_value());
+            ++n;
+        }(q, woken);
+    }
+
+    EXPECT_EQ(woken, 0);
+    q.close();
+    EXPECT_EQ(woken, 2);
+    EXPECT_FALSE(q.push(1));
+}
+
+TEST(AsyncPriorityQueueTest, CrossThread)
+{
+    constexpr int producers = 4;
+    constexpr int consumers = 4;
+    constexpr int count     = 2000;
+
+    async_priority_queue<int> q;
+    std::atomic<long long> sum = 0;
+    std::atomic<int> received  = 0;
+
+    const auto consume = [](async_priority_queue<int>& queue, std::atomic<long long>& s,
+                            std::atomic<int>& n) -> eager_task {
+        while (auto v = co_await queue.pop()) {
+            s.fetch_add(*v);
+            n.fetch_add(1);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(producers + consumers);
+    for (int i = 0; i < consumers; ++i) {
+        threads.emplace_back([&] { consume(q, sum, received); });
+    }
+
+    for (int i = 0; i < producers; ++i) {
+        threads.emplace_back([&] {
+            for (int v = 1; v <= count; ++v) {
+                q.push(v);
+            }
+        });
+    }
+
+    while (received.load() < producers * count) {
+        std::this_thread::yield();
+    }
+
+    q.close();
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    constexpr long long expected = static_cast<long long>(count) * (count + 1) / 2;
+    EXPECT_EQ(sum.load(), expected * producers);
+}
@@ -0,0 +1,185 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "channel.h"
+#include "eager_task.h"
+
+using namespace wwa::coro;
+
+TEST(ChannelTest, ZeroCapacity)
+{
+    EXPECT_THROW(channel<int>{0}, std::invalid_argument);
+}
+
+TEST(ChannelTest, Capacity)
+{
+    EXPECT_EQ(channel<int>{1}.capacity(), 2U);
+    EXPECT_EQ(channel<int>{4}.capacity(), 4U);
+    EXPECT_EQ(channel<int>{5}.capacity(), 8U);
+}
+
+TEST(ChannelTest, SendRecv)
+{
+    channel<std::string> ch(4);
+
+    [](channel<std::string>& c) -> eager_task {
+        EXPECT_TRUE(co_await c.send("Hello"));
+        EXPECT_TRUE(co_await c.send("World"));
+    }(ch);
+
+    [](channel<std::string>& c) -> eager_task {
+        EXPECT_EQ(co_await c.recv(), "Hello");
+        EXPECT_EQ(co_await c.recv(), "World");
+    }(ch);
+}
+
+TEST(ChannelTest, ReceiverSuspendsWhenEmpty)
+{
+    channel<int> ch(2);
+    std::optional<int> received;
+
+    [](channel<int>& c, std::optional<int>& out) -> eager_task { out = co_await c.recv(); }(ch, received);
+    EXPECT_FALSE(received.has_value());
+
+    [](channel<int>& c) -> eager_task { co_await c.send(1983); }(ch);
+    ASSERT_TRUE(received.has_value());
+    EXPECT_EQ(*received, 1983);
+}
+
+TEST(ChannelTest, SenderSuspendsWhenFull)
+{
+    channel<int> ch(2);
+    int sent = 0;
+
+    [](channel<int>& c, int& n) -> eager_task {
+        for (int i = 0; i < 4; ++i) {
+            if (co_await c.send(i)) {
+                ++n;
+            }
+        }
+    }(ch, sent);
+
+    EXPECT_EQ(sent, 2);
+
+    std::vector<int> received;
+    [](channel<int>& c, std::vector<int>& out) -> eager_task {
+        for (int i = 0; i < 4; ++i) {
+            out.push_back(*co_await c.recv());
+        }
+    }(ch, received);
+
+    EXPECT_EQ(sent, 4);
+    EXPECT_EQ(received, (std::vector<int>{0, 1, 2, 3}));
+}
+
+TEST(ChannelTest, CloseWakesReceivers)
+{
+    channel<int> ch(2);
+    int woken = 0;
+
+    for (int i = 0; i < 3; ++i) {
+        [](channel<int>& c, int& n) -> eager_task {
+            EXPECT_FALSE((co_await c.recv()).has_value());
+            ++n;
+        }(ch, woken);
+    }
+
+    EXPECT_EQ(woken, 0);
+    ch.close();
+    EXPECT_EQ(woken, 3);
+    EXPECT_TRUE(ch.is_closed());
+}
+
+TEST(ChannelTest, CloseWakesSenders)
+{
+    channel<int> ch(2);
+    std::vector<bool> results;
+
+    [](channel<int>& c, std::vector<bool>& out) -> eager_task {
+        for (int i = 0; i < 3; ++i) {
+            out.push_back(co_await c.send(i));
+        }
+    }(ch, results);
+
+    EXPECT_EQ(results.size(), 2U);
+    ch.close();
+    EXPECT_EQ(results, (std::vector<bool>{true, true, false}));
+
+    [](channel<int>& c) -> eager_task { EXPECT_FALSE(co_await c.send(1)); }(ch);
+}
+
+TEST(ChannelTest, DrainAfterClose)
+{
+    channel<std::unique_ptr<int>> ch(4);
+
+    [](channel<std::unique_ptr<int>>& c) -> eager_task {
+        co_await c.send(std::make_unique<int>(1));
+        co_await c.send(std::make_unique<int>(2));
+        c.close();
+    }(ch);
+
+    [](channel<std::unique_ptr<int>>& c) -> eager_task {
+        auto first = co_await c.recv();
+        EXPECT_EQ(first ? **first : 0, 1);
+
+        auto second = co_await c.recv();
+        EXPECT_EQ(second ? **second : 0, 2);
+
+        EXPECT_FALSE((co_await c.recv()).has_value());
+    }(ch);
+}
+
+TEST(ChannelTest, MultipleProducersConsumers)
+{
+    constexpr int producers          = 4;
+    constexpr int consumers          = 4;
+    constexpr int values_per_producer = 2000;
+
+    channel<int> ch(8);
+    std::atomic<long long> sum = 0;
+    std::atomic<int> received  = 0;
+
+    const auto consume = [](channel<int>& c, std::atomic<long long>& s, std::atomic<int>& n) -> eager_task {
+        while (auto v = co_await c.recv()) {
+            s.fetch_add(*v);
+            n.fetch_add(1);
+        }
+    };
+
+    const auto produce = [](channel<int>& c, int count) -> eager_task {
+        for (int i = 1; i <= count; ++i) {
+            co_await c.send(i);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(producers + consumers);
+    for (int i = 0; i < consumers; ++i) {
+        threads.emplace_back([&] { consume(ch, sum, received); });
+    }
+
+    for (int i = 0; i < producers; ++i) {
+        threads.emplace_back([&] { produce(ch, values_per_producer); });
+    }
+
+    while (received.load() < producers * values_per_producer) {
+        std::this_thread::yield();
+    }
+
+    ch.close();
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    constexpr long long expected = static_cast<long long>(values_per_producer) * (values_per_producer + 1) / 2;
+    EXPECT_EQ(sum.load(), expected * producers);
+}
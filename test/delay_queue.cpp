@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "delay_queue.h"
+#include "eager_task.h"
+#include "timer.h"
+
+using namespace wwa::coro;
+using namespace std::chrono_literals;
+
+namespace {
+
+void wait_for(const std::atomic<int>& counter, int value)
+{
+    while (counter.load() < value) {
+        std::this_thread::yield();
+    }
+}
+
+}  // namespace
+
+TEST(DelayQueueTest, DeadlineOrder)
+{
+    timer_service timers;
+    delay_queue<std::string> q(timers);
+
+    const auto now = delay_queue<std::string>::clock::now();
+    EXPECT_TRUE(q.push("second", now - 1s));
+    EXPECT_TRUE(q.push("first", now - 2s));
+    EXPECT_TRUE(q.push("third", now - 1s));
+    EXPECT_TRUE(q.push("later", 1h));
+
+    EXPECT_EQ(q.size(), 4U);
+    EXPECT_EQ(q.try_pop(), "first");
+    EXPECT_EQ(q.try_pop(), "second");
+    EXPECT_EQ(q.try_pop(), "third");
+    EXPECT_FALSE(q.try_pop().has_value());
+    EXPECT_EQ(q.size(), 1U);
+}
+
+TEST(DelayQueueTest, PopWaitsForDeadline)
+{
+    timer_service timers;
+    delay_queue<int> q(timers);
+    std::atomic<int> done = 0;
+    std::optional<int> received;
+
+    const auto start = delay_queue<int>::clock::now();
+    q.push(1983, 20ms);
+
+    [](delay_queue<int>& queue, std::optional<int>& out, std::atomic<int>& d) -> eager_task {
+        out = co_await queue.pop();
+        d.store(1);
+    }(q, received, done);
+
+    EXPECT_EQ(done.load(), 0);
+    wait_for(done, 1);
+
+    EXPECT_GE(delay_queue<int>::clock::now() - start, 20ms);
+    EXPECT_EQ(received, 1983);
+}
+
+TEST(DelayQueueTest, DestroyFromConsumer)
+{
+    // The consumer is resumed by the timer and destroys the queue on the timer thread
+    timer_service timers;
+    auto q = std::make_unique<delay_queue<int>>(timers);
+    std::atomic<int> done = 0;
+    std::optional<int> received;
+
+    q->push(1983, 10ms);
+
+    [](std::unique_ptr<delay_queue<int>>& queue, std::optional<int>& out, std::atomic<int>& d) -> eager_task {
+        out = co_await queue->pop();
+        queue.reset();
+        d.store(1);
+    }(q, received, done);
+
+    wait_for(done, 1);
+
+    EXPECT_EQ(q, nullptr);
+    EXPECT_EQ(received, 1983);
+}
+
+TEST(DelayQueueTest, EarlierPushMovesTimer)
+{
+    timer_service timers;
+    delay_queue<int> q(timers);
+    std::atomic<int> done = 0;
+    std::optional<int> received;
+
+    q.push(2, 1h);
+    [](delay_queue<int>& queue, std::optional<int>& out, std::atomic<int>& d) -> eager_task {
+        out = co_await queue.pop();
+        d.store(1);
+    }(q, received, done);
+
+    q.push(1, 10ms);
+    wait_for(done, 1);
+    EXPECT_EQ(received, 1);
+
+    // A due element is handed to a suspended consumer by push() itself
+    [](delay_queue<int>& queue, std::optional<int>& out, std::atomic<int>& d) -> eager_task {
+        out = co_await queue.pop();
+        d.store(2);
+    }(q, received, done);
+
+    q.push(0, 0ms);
+    EXPECT_EQ(done.load(), 2);
+    EXPECT_EQ(received, 0);
+
+    q.close();
+}
+
+TEST(DelayQueueTest, ManyConsumersShareTimer)
+{
+    constexpr int consumers = 100;
+
+    timer_service timers;
+    delay_queue<int> q(timers);
+    std::atomic<int> done = 0;
+    std::atomic<int> sum  = 0;
+
+    for (int i = 0; i < consumers; ++i) {
+        [](delay_queue<int>& queue, std::atomic<int>& s, std::atomic<int>& d) -> eager_task {
+            auto v = co_await queue.pop();
+            s.fetch_add(v.value_or(0));
+            d.fetch_add(1);
+        }(q, sum, done);
+    }
+
+    for (int i = 1; i <= consumers; ++i) {
+        q.push(i, std::chrono::milliseconds(i % 10));
+    }
+
+    wait_for(done, consumers);
+    EXPECT_EQ(sum.load(), consumers * (consumers + 1) / 2);
+}
+
+TEST(DelayQueueTest, Close)
+{
+    timer_service timers;
+    delay_queue<int> q(timers);
+    int woken = 0;
+
+    q.push(1, 1h);
+    for (int i = 0; i < 2; ++i) {
+        [](delay_queue<int>& queue, int& n) -> eager_task {
+            EXPECT_FALSE((co_await queue.pop()).has_value());
+            ++n;
+        }(q, woken);
+    }
+
+    EXPECT_EQ(woken, 0);
+    q.close();
+    EXPECT_EQ(woken, 2);
+    EXPECT_TRUE(q.is_closed());
+    EXPECT_FALSE(q.push(2, 0ms));
+}
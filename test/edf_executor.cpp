@@ -0,0 +1,233 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <latch>
+#include <thread>
+#include <vector>
+
+#include "eager_task.h"
+#include "edf_executor.h"
+#include "offload.h"
+#include "task.h"
+#include "thread_pool.h"
+
+using namespace wwa::coro;
+using namespace std::chrono_literals;
+
+namespace {
+
+// Occupies the only worker of an executor until released, so that work can be queued behind it
+class blocker {
+public:
+    explicit blocker(edf_executor& executor)
+    {
+        [](edf_executor& e, std::atomic<bool>& started, std::atomic<bool>& release) -> eager_task {
+            co_await e.schedule();
+            started.store(true);
+            while (!release.load()) {
+                std::this_thread::yield();
+            }
+        }(executor, this->m_started, this->m_release);
+
+        while (!this->m_started.load()) {
+            std::this_thread::yield();
+        }
+    }
+
+    void release() { this->m_release.store(true); }
+
+private:
+    std::atomic<bool> m_started = false;
+    std::atomic<bool> m_release = false;
+};
+
+eager_task record(edf_executor& executor, edf_executor::clock::time_point deadline, int id, std::vector<int>& log,
+                  std::latch& done)
+{
+    co_await executor.schedule(deadline);
+    log.push_back(id);
+    done.count_down();
+}
+
+}  // namespace
+
+TEST(EdfExecutorTest, RunsOnWorkers)
+{
+    edf_executor executor(2);
+    std::atomic<bool> on_worker = false;
+    std::latch done(1);
+
+    EXPECT_EQ(executor.size(), 2U);
+    EXPECT_FALSE(executor.running_in_this_thread());
+    EXPECT_EQ(executor.current_deadline(), edf_executor::no_deadline);
+    [](edf_executor& e, std::atomic<bool>& flag, std::latch& l) -> eager_task {
+        co_await e.schedule();
+        flag.store(e.running_in_this_thread());
+        l.count_down();
+    }(executor, on_worker, done);
+
+    done.wait();
+    EXPECT_TRUE(on_worker.load());
+}
+
+TEST(EdfExecutorTest, EarliestDeadlineFirst)
+{
+    edf_executor executor(1);
+    std::vector<int> log;
+    std::latch done(6);
+
+    const auto now = edf_executor::clock::now();
+    blocker b(executor);
+    record(executor, edf_executor::no_deadline, 5, log, done);
+    record(executor, now + 3s, 3, log, done);
+    record(executor, now + 1s, 1, log, done);
+    record(executor, edf_executor::no_deadline, 6, log, done);
+    record(executor, now + 2s, 2, log, done);
+    record(executor, now + 3s, 4, log, done);
+
+    b.release();
+    done.wait();
+
+    // Equal deadlines keep the order of scheduling
+    EXPECT_EQ(log, (std::vector<int>{1, 2, 3, 4, 5, 6}));
+}
+
+TEST(EdfExecutorTest, DeadlineInheritance)
+{
+    edf_executor executor(2);
+    const auto deadline = edf_executor::clock::now() + 1h;
+    std::atomic<bool> inherited = false;
+    std::latch done(1);
+
+    [](edf_executor& e, edf_executor::clock::time_point d, std::atomic<bool>& out, std::latch& l) -> eager_task {
+        co_await e.schedule(d);
+
+        // A child task started from a coroutine with a deadline gets rescheduled with the same deadline
+        co_await [](edf_executor& ee, edf_executor::clock::time_point dd, std::atomic<bool>& o) -> task<> {
+            co_await ee.schedule();
+            o.store(ee.current_deadline() == dd);
+        }(e, d, out);
+
+        l.count_down();
+    }(executor, deadline, inherited, done);
+
+    done.wait();
+    EXPECT_TRUE(inherited.load());
+}
+
+TEST(EdfExecutorTest, Offload)
+{
+    edf_executor executor(1);
+    const auto deadline = edf_executor::clock::now() + 1h;
+    std::atomic<bool> on_worker = false;
+    std::atomic<bool> inherited = false;
+    std::latch done(1);
+
+    [](edf_executor& e, edf_executor::clock::time_point d, std::atomic<bool>& w, std::atomic<bool>& i,
+       std::latch& l) -> eager_task {
+        co_await e.schedule(d);
+        co_await offload([] {});
+
+        // The blocking call returns on its own thread; the coroutine goes back to a worker with its deadline
+        w.store(e.running_in_this_thread());
+        i.store(e.current_deadline() == d);
+        l.count_down();
+    }(executor, deadline, on_worker, inherited, done);
+
+    done.wait();
+    EXPECT_TRUE(on_worker.load());
+    EXPECT_TRUE(inherited.load());
+}
+
+TEST(EdfExecutorTest, YieldNow)
+{
+    edf_executor executor(1);
+    const auto deadline = edf_executor::clock::now() + 1h;
+    std::vector<int> log;
+    std::latch done(2);
+
+    [](edf_executor& e, edf_executor::clock::time_point d, std::vector<int>& out, std::latch& l) -> eager_task {
+        co_await e.schedule(d);
+        out.push_back(1);
+
+        // Queued behind the running coroutine with the same deadline
+        [](edf_executor& ee, std::vector<int>& o, std::latch& ll) -> eager_task {
+            co_await ee.schedule();
+            o.push_back(2);
+            ll.count_down();
+        }(e, out, l);
+
+        co_await yield_now();
+        out.push_back(3);
+        l.count_down();
+    }(executor, deadline, log, done);
+
+    done.wait();
+    EXPECT_EQ(log, (std::vector<int>{1, 2, 3}));
+}
+
+TEST(EdfExecutorTest, MissedDeadlines)
+{
+    edf_executor executor(1);
+    std::vector<int> log;
+    std::latch done(3);
+
+    const auto now = edf_executor::clock::now();
+    record(executor, now - 1s, 1, log, done);
+    record(executor, now + 1h, 2, log, done);
+    record(executor, edf_executor::no_deadline, 3, log, done);
+    done.wait();
+
+    EXPECT_EQ(executor.missed(), 1U);
+}
+
+TEST(EdfExecutorTest, CrossThread)
+{
+    constexpr int count = 10000;
+
+    edf_executor executor(4);
+    std::atomic<int> sum = 0;
+    std::latch done(count);
+
+    std::vector<std::thread> submitters;
+    for (int t = 0; t < 2; ++t) {
+        submitters.emplace_back([&executor, &sum, &done, t] {
+            for (int i = t; i < count; i += 2) {
+                [](edf_executor& e, std::atomic<int>& s, std::latch& l, int v) -> eager_task {
+                    co_await e.schedule_within(std::chrono::microseconds(v % 100));
+                    // Rescheduling from a worker goes to the local heap
+                    co_await e.schedule();
+                    s.fetch_add(v);
+                    l.count_down();
+                }(executor, sum, done, i);
+            }
+        });
+    }
+
+    for (auto& t : submitters) {
+        t.join();
+    }
+
+    done.wait();
+    EXPECT_EQ(sum.load(), count * (count - 1) / 2);
+}
+
+TEST(EdfExecutorTest, DestructorDrains)
+{
+    std::atomic<int> ran = 0;
+    {
+        edf_executor executor(1);
+        blocker b(executor);
+        for (int i = 0; i < 10; ++i) {
+            [](edf_executor& e, std::atomic<int>& r) -> eager_task {
+                co_await e.schedule();
+                r.fetch_add(1);
+            }(executor, ran);
+        }
+
+        b.release();
+    }
+
+    EXPECT_EQ(ran.load(), 10);
+}
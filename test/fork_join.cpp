@@ -0,0 +1,306 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <latch>
+#include <numeric>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "eager_task.h"
+#include "fork_join.h"
+
+using namespace wwa::coro;
+
+namespace {
+
+parallel_task<long> fib(int n)
+{
+    if (n < 2) {
+        co_return n;
+    }
+
+    auto a = fib(n - 1);
+    a.fork();
+    const long b = co_await fib(n - 2);
+    co_return co_await a + b;
+}
+
+parallel_task<> merge_sort(std::span<int> v, std::span<int> tmp)
+{
+    if (v.size() <= 32) {
+        std::ranges::sort(v);
+        co_return;
+    }
+
+    const std::size_t mid = v.size() / 2;
+    auto left             = merge_sort(v.first(mid), tmp.first(mid));
+    left.fork();
+    co_await merge_sort(v.subspan(mid), tmp.subspan(mid));
+    co_await std::move(left);
+
+    std::ranges::merge(v.first(mid), v.subspan(mid), tmp.begin());
+    std::ranges::copy(tmp.first(v.size()), v.begin());
+}
+
+}  // namespace
+
+TEST(ForkJoinTest, InvalidOptions)
+{
+    EXPECT_THROW(fork_join_pool({.threads = 1, .deque_capacity = 0}), std::invalid_argument);
+}
+
+TEST(ForkJoinTest, Inline)
+{
+    // Outside a pool, fork() does nothing and the tasks run inline
+    long result = 0;
+    [](long& r) -> eager_task { r = co_await fib(15); }(result);
+    EXPECT_EQ(result, 610);
+}
+
+TEST(ForkJoinTest, Fibonacci)
+{
+    fork_join_pool pool({.threads = 4});
+    long result = 0;
+    std::latch done(1);
+
+    EXPECT_EQ(pool.size(), 4U);
+
+    [](fork_join_pool& p, long& r, std::latch& d) -> eager_task {
+        co_await p.schedule();
+        r = co_await fib(20);
+        d.count_down();
+    }(pool, result, done);
+
+    done.wait();
+    EXPECT_EQ(result, 6765);
+}
+
+TEST(ForkJoinTest, MergeSort)
+{
+    fork_join_pool pool({.threads = 4});
+    std::vector<int> data(20000);
+    std::iota(data.begin(), data.end(), 0);
+    std::ranges::shuffle(data, std::mt19937{42});
+    std::vector<int> tmp(data.size());
+    std::latch done(1);
+
+    [](fork_join_pool& p, std::vector<int>& v, std::vector<int>& t, std::latch& d) -> eager_task {
+        co_await p.schedule();
+        co_await merge_sort(v, t);
+        d.count_down();
+    }(pool, data, tmp, done);
+
+    done.wait();
+    EXPECT_TRUE(std::ranges::is_sorted(data));
+    EXPECT_EQ(data.front(), 0);
+    EXPECT_EQ(data.back(), 19999);
+}
+
+TEST(ForkJoinTest, Steal)
+{
+    fork_join_pool pool({.threads = 2});
+    std::atomic<bool> started = false;
+    std::thread::id parent_id;
+    std::thread::id child_id;
+    std::latch done(1);
+
+    [](fork_join_pool& p, std::atomic<bool>& s, std::thread::id& pid, std::thread::id& cid,
+       std::latch& d) -> eager_task {
+        co_await p.schedule();
+        pid = std::this_thread::get_id();
+
+        auto child = [](std::atomic<bool>& s2, std::thread::id& id) -> parallel_task<> {
+            id = std::this_thread::get_id();
+            s2 = true;
+            co_return;
+        }(s, cid);
+
+        child.fork();
+        while (!s) {
+            // The parent does not join yet: only the other worker can start the child
+            std::this_thread::yield();
+        }
+
+        co_await child;
+        d.count_down();
+    }(pool, started, parent_id, child_id, done);
+
+    done.wait();
+    EXPECT_NE(parent_id, child_id);
+    EXPECT_GE(pool.steals(), 1U);
+}
+
+TEST(ForkJoinTest, JoinStolen)
+{
+    fork_join_pool pool({.threads = 2});
+    std::atomic<bool> started = false;
+    std::atomic<bool> release = false;
+    int result                = 0;
+    std::latch done(1);
+
+    [](fork_join_pool& p, std::atomic<bool>& s, std::atomic<bool>& rel, int& r, std::latch& d) -> eager_task {
+        co_await p.schedule();
+
+        auto child = [](std::atomic<bool>& s2, std::atomic<bool>& rel2) -> parallel_task<int> {
+            s2 = true;
+            while (!rel2) {
+                std::this_thread::yield();
+            }
+
+            co_return 42;
+        }(s, rel);
+
+        child.fork();
+        while (!s) {
+            std::this_thread::yield();
+        }
+
+        // The child still runs on the other worker: the parent suspends and the child continues it
+        r = co_await child;
+        d.count_down();
+    }(pool, started, release, result, done);
+
+    while (!started) {
+        std::this_thread::yield();
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    release = true;
+    done.wait();
+    EXPECT_EQ(result, 42);
+}
+
+TEST(ForkJoinTest, JoinOrder)
+{
+    fork_join_pool pool({.threads = 1});
+    int sum = 0;
+    std::latch done(1);
+
+    [](fork_join_pool& p, int& s, std::latch& d) -> eager_task {
+        co_await p.schedule();
+
+        const auto value = [](int v) -> parallel_task<int> { co_return v; };
+        auto a           = value(1);
+        auto b           = value(2);
+        a.fork();
+        b.fork();
+
+        // b sits above a in the deque; joining a first runs b on the way
+        s = co_await a;
+        s += co_await b;
+        d.count_down();
+    }(pool, sum, done);
+
+    done.wait();
+    EXPECT_EQ(sum, 3);
+    EXPECT_EQ(pool.steals(), 0U);
+}
+
+TEST(ForkJoinTest, Exception)
+{
+    fork_join_pool pool({.threads = 2});
+    bool caught = false;
+    std::latch done(1);
+
+    [](fork_join_pool& p, bool& c, std::latch& d) -> eager_task {
+        co_await p.schedule();
+
+        auto child = [](bool fail) -> parallel_task<int> {
+            if (fail) {
+                throw std::runtime_error("boom");
+            }
+
+            co_return 0;
+        }(true);
+        child.fork();
+        try {
+            co_await child;
+        }
+        catch (const std::runtime_error&) {
+            c = true;
+        }
+
+        d.count_down();
+    }(pool, caught, done);
+
+    done.wait();
+    EXPECT_TRUE(caught);
+}
+
+TEST(ForkJoinTest, Deque)
+{
+    detail::work_stealing_deque q(2);
+    std::vector<int> items(10);
+
+    EXPECT_TRUE(q.empty());
+    for (int& i : items) {
+        q.push(&i);  // Grows twice
+    }
+
+    EXPECT_FALSE(q.empty());
+    EXPECT_EQ(q.steal(), &items[0]);
+    EXPECT_EQ(q.pop(), &items[9]);
+    EXPECT_EQ(q.steal(), &items[1]);
+    for (std::size_t i = 8; i >= 2; --i) {
+        EXPECT_EQ(q.pop(), &items[i]);
+    }
+
+    EXPECT_TRUE(q.empty());
+    EXPECT_EQ(q.pop(), nullptr);
+    EXPECT_EQ(q.steal(), nullptr);
+}
+
+TEST(ForkJoinTest, DequeConcurrent)
+{
+    constexpr std::size_t count   = 20000;
+    constexpr std::size_t thieves = 2;
+
+    detail::work_stealing_deque q(4);
+    std::vector<int> items(count);
+    std::vector<std::atomic<int>> taken(count);
+    std::atomic<bool> done = false;
+
+    const auto take = [&items, &taken](void* item) {
+        taken[static_cast<std::size_t>(static_cast<int*>(item) - items.data())].fetch_add(1);
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < thieves; ++i) {
+        threads.emplace_back([&q, &done, &take] {
+            while (!done) {
+                if (void* item = q.steal(); item != nullptr) {
+                    take(item);
+                }
+                else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+        q.push(&items[i]);
+        if (i % 3 == 0) {
+            if (void* item = q.pop(); item != nullptr) {
+                take(item);
+            }
+        }
+    }
+
+    while (void* item = q.pop()) {
+        take(item);
+    }
+
+    done = true;
+    for (std::thread& t : threads) {
+        t.join();
+    }
+
+    EXPECT_TRUE(std::ranges::all_of(taken, [](const std::atomic<int>& n) { return n.load() == 1; }));
+}
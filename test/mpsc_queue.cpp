@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "eager_task.h"
+#include "mpsc_queue.h"
+
+using namespace wwa::coro;
+
+namespace {
+
+struct item : mpsc_queue_hook {
+    explicit item(int v) : value(v) {}
+    int value;
+};
+
+}  // namespace
+
+TEST(MpscQueueTest, PushPopAll)
+{
+    mpsc_queue<item> q;
+    std::vector<item> items{item{1}, item{2}, item{3}};
+
+    EXPECT_TRUE(q.empty());
+    EXPECT_TRUE(q.try_pop_all().empty());
+
+    for (auto& i : items) {
+        q.push(&i);
+    }
+
+    EXPECT_FALSE(q.empty());
+
+    std::vector<int> actual;
+    for (auto& i : q.try_pop_all()) {
+        actual.push_back(i.value);
+    }
+
+    EXPECT_EQ(actual, (std::vector<int>{1, 2, 3}));
+    EXPECT_TRUE(q.empty());
+
+    // Nodes can be pushed again while the batch that holds them is being iterated
+    q.push(&items[0]);
+    q.push(&items[1]);
+    actual.clear();
+    for (auto& i : q.try_pop_all()) {
+        actual.push_back(i.value);
+        if (i.value == 1) {
+            q.push(&i);
+        }
+    }
+
+    EXPECT_EQ(actual, (std::vector<int>{1, 2}));
+
+    actual.clear();
+    for (auto& i : q.try_pop_all()) {
+        actual.push_back(i.value);
+    }
+
+    EXPECT_EQ(actual, (std::vector<int>{1}));
+}
+
+TEST(MpscQueueTest, ConsumerSuspendsWhenEmpty)
+{
+    mpsc_queue<item> q;
+    std::vector<std::vector<int>> batches;
+
+    [](mpsc_queue<item>& queue, std::vector<std::vector<int>>& out) -> eager_task {
+        for (int n = 0; n < 2; ++n) {
+            auto& batch = out.emplace_back();
+            for (auto& i : co_await queue.pop_all()) {
+                batch.push_back(i.value);
+            }
+        }
+    }(q, batches);
+
+    ASSERT_EQ(batches.size(), 1U);
+    EXPECT_TRUE(batches[0].empty());
+
+    // The push that makes the queue non-empty resumes the consumer inline
+    item a{1};
+    q.push(&a);
+    ASSERT_EQ(batches.size(), 2U);
+    EXPECT_EQ(batches[0], (std::vector<int>{1}));
+
+    item b{2};
+    item c{3};
+    q.push(&b);
+    EXPECT_EQ(batches[1], (std::vector<int>{2}));
+
+    // Nobody waits: the node stays in the queue
+    q.push(&c);
+    EXPECT_FALSE(q.empty());
+}
+
+TEST(MpscQueueTest, Close)
+{
+    mpsc_queue<item> q;
+    bool done = false;
+
+    [](mpsc_queue<item>& queue, bool& flag) -> eager_task {
+        auto batch = co_await queue.pop_all();
+        EXPECT_TRUE(batch.empty());
+        flag = true;
+    }(q, done);
+
+    EXPECT_FALSE(done);
+    q.close();
+    EXPECT_TRUE(done);
+    EXPECT_TRUE(q.is_closed());
+
+    // Nodes pushed after close are still delivered
+    item a{1};
+    q.push(&a);
+    [](mpsc_queue<item>& queue) -> eager_task {
+        auto batch = co_await queue.pop_all();
+        EXPECT_FALSE(batch.empty());
+        batch = co_await queue.pop_all();
+        EXPECT_TRUE(batch.empty());
+    }(q);
+}
+
+TEST(MpscQueueTest, CrossThread)
+{
+    constexpr int producers = 4;
+    constexpr int count     = 5000;
+
+    mpsc_queue<item> q;
+    std::vector<std::vector<item>> storage(producers);
+    for (int p = 0; p < producers; ++p) {
+        storage[p].reserve(count);
+        for (int i = 0; i < count; ++i) {
+            storage[p].emplace_back(p * count + i);
+        }
+    }
+
+    std::atomic<long long> sum = 0;
+    std::atomic<int> received  = 0;
+    std::vector<int> last(producers, -1);
+    bool ordered = true;
+
+    std::thread consumer([&] {
+        [](mpsc_queue<item>& queue, std::atomic<long long>& s, std::atomic<int>& n, std::vector<int>& prev,
+           bool& in_order) -> eager_task {
+            while (n.load() < producers * count) {
+                for (auto& i : co_await queue.pop_all()) {
+                    // Nodes of one producer arrive in the order they were pushed
+                    const int p = i.value / count;
+                    in_order    = in_order && i.value > prev[p];
+                    prev[p]     = i.value;
+                    s.fetch_add(i.value);
+                    n.fetch_add(1);
+                }
+            }
+        }(q, sum, received, last, ordered);
+    });
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&q, &storage, p] {
+            for (auto& i : storage[p]) {
+                q.push(&i);
+            }
+        });
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    consumer.join();
+
+    constexpr long long total = static_cast<long long>(producers) * count;
+    EXPECT_EQ(received.load(), total);
+    EXPECT_EQ(sum.load(), total * (total - 1) / 2);
+    EXPECT_TRUE(ordered);
+}
@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <latch>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "eager_task.h"
+#include "offload.h"
+#include "thread_pool.h"
+
+using namespace wwa::coro;
+
+TEST(OffloadTest, InvalidOptions)
+{
+    EXPECT_THROW(blocking_pool({.max_threads = 0}), std::invalid_argument);
+}
+
+TEST(OffloadTest, ResumesOnExecutor)
+{
+    thread_pool pool({.threads = 1, .priorities = 3});
+    blocking_pool blocking;
+    std::atomic<bool> off_pool        = false;
+    std::atomic<bool> back_on_pool    = false;
+    std::atomic<std::size_t> priority = 99;
+    std::atomic<int> result           = 0;
+    std::latch done(1);
+
+    [](thread_pool& p, blocking_pool& b, std::atomic<bool>& off, std::atomic<bool>& back, std::atomic<std::size_t>& prio,
+       std::atomic<int>& res, std::latch& l) -> eager_task {
+        co_await p.schedule(2);
+        res = co_await b.offload(
+            [&p, &off](int a, int c) {
+                off = !p.running_in_this_thread();
+                return a + c;
+            },
+            40, 2
+        );
+
+        back = p.running_in_this_thread();
+        prio = p.current_priority();
+        l.count_down();
+    }(pool, blocking, off_pool, back_on_pool, priority, result, done);
+
+    done.wait();
+    EXPECT_TRUE(off_pool.load());
+    EXPECT_TRUE(back_on_pool.load());
+    EXPECT_EQ(priority.load(), 2U);
+    EXPECT_EQ(result.load(), 42);
+}
+
+TEST(OffloadTest, Exception)
+{
+    blocking_pool blocking;
+    std::atomic<bool> caught = false;
+    std::latch done(1);
+
+    [](blocking_pool& b, std::atomic<bool>& c, std::latch& l) -> eager_task {
+        try {
+            co_await b.offload([] { throw std::runtime_error("boom"); });
+        }
+        catch (const std::runtime_error& e) {
+            c = std::string(e.what()) == "boom";
+        }
+
+        l.count_down();
+    }(blocking, caught, done);
+
+    done.wait();
+    EXPECT_TRUE(caught.load());
+}
+
+TEST(OffloadTest, Results)
+{
+    blocking_pool blocking;
+    int value = 1;
+    std::latch done(1);
+
+    [](blocking_pool& b, int& v, std::latch& l) -> eager_task {
+        // References are passed through, move-only results are moved out
+        int& ref = co_await b.offload([&v]() -> int& { return v; });
+        EXPECT_EQ(&ref, &v);
+
+        auto ptr = co_await b.offload([](int x) { return std::make_unique<int>(x); }, 5);
+        EXPECT_EQ(*ptr, 5);
+
+        co_await b.offload([&v] { v = 2; });
+        l.count_down();
+    }(blocking, value, done);
+
+    done.wait();
+    EXPECT_EQ(value, 2);
+}
+
+TEST(OffloadTest, Grows)
+{
+    constexpr int calls = 4;
+
+    blocking_pool blocking({.max_threads = 2, .keep_alive = std::chrono::milliseconds(10)});
+    std::atomic<int> running = 0;
+    std::atomic<int> peak    = 0;
+    std::latch done(calls);
+
+    for (int i = 0; i < calls; ++i) {
+        [](blocking_pool& b, std::atomic<int>& r, std::atomic<int>& p, std::latch& l) -> eager_task {
+            co_await b.offload([&r, &p] {
+                const int now = ++r;
+                int expected  = p.load();
+                while (now > expected && !p.compare_exchange_weak(expected, now)) {
+                }
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                --r;
+            });
+
+            l.count_down();
+        }(blocking, running, peak, done);
+    }
+
+    done.wait();
+    EXPECT_EQ(peak.load(), 2);
+
+    // Idle threads exit after the keep-alive period
+    for (int i = 0; i < 100 && blocking.threads() != 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    EXPECT_EQ(blocking.threads(), 0U);
+}
+
+TEST(OffloadTest, DefaultPool)
+{
+    std::atomic<int> result = 0;
+    std::latch done(1);
+
+    [](std::atomic<int>& r, std::latch& l) -> eager_task {
+        r = co_await offload([](int x) { return x * 2; }, 21);
+        l.count_down();
+    }(result, done);
+
+    done.wait();
+    EXPECT_EQ(result.load(), 42);
+}
+
+TEST(OffloadDeathTest, ExitAfterFork)
+{
+    // The pool has threads now; a forked child inherits the pool but not the threads, and must still be able to exit
+    std::latch done(1);
+    [](std::latch& l) -> eager_task {
+        co_await offload([] {});
+        l.count_down();
+    }(done);
+
+    done.wait();
+    ASSERT_GT(blocking_pool::instance().threads(), 0U);
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunknown-warning-option"
+#pragma clang diagnostic ignored "-Wswitch-default"
+    EXPECT_EXIT(std::exit(0), ::testing::ExitedWithCode(0), "");  // NOLINT(concurrency-mt-unsafe)
+#pragma clang diagnostic pop
+}
@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+
+#include <latch>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "eager_task.h"
+#include "rendezvous_channel.h"
+#include "thread_pool.h"
+
+using namespace wwa::coro;
+
+TEST(RendezvousChannelTest, ReceiverFirst)
+{
+    rendezvous_channel<std::string> ch;
+    std::vector<std::string> log;
+
+    [](rendezvous_channel<std::string>& c, std::vector<std::string>& out) -> eager_task {
+        auto v = co_await c.recv();
+        out.push_back("received " + v.value_or("nothing"));
+    }(ch, log);
+
+    EXPECT_TRUE(log.empty());
+
+    [](rendezvous_channel<std::string>& c, std::vector<std::string>& out) -> eager_task {
+        const bool sent = co_await c.send("Hello");
+        out.push_back(sent ? "sent" : "not sent");
+    }(ch, log);
+
+    // The parked receiver runs first; the sender goes on once the receiver has suspended
+    EXPECT_EQ(log, (std::vector<std::string>{"received Hello", "sent"}));
+}
+
+TEST(RendezvousChannelTest, SenderFirst)
+{
+    rendezvous_channel<std::unique_ptr<int>> ch;
+    std::vector<int> log;
+
+    [](rendezvous_channel<std::unique_ptr<int>>& c, std::vector<int>& out) -> eager_task {
+        const bool sent = co_await c.send(std::make_unique<int>(1983));
+        out.push_back(sent ? 1 : 0);
+    }(ch, log);
+
+    EXPECT_TRUE(log.empty());
+
+    [](rendezvous_channel<std::unique_ptr<int>>& c, std::vector<int>& out) -> eager_task {
+        auto v = co_await c.recv();
+        out.push_back(v ? **v : -1);
+    }(ch, log);
+
+    // The parked sender runs first; the receiver goes on once the sender has suspended
+    EXPECT_EQ(log, (std::vector<int>{1, 1983}));
+}
+
+TEST(RendezvousChannelTest, PingPong)
+{
+    rendezvous_channel<int> requests;
+    rendezvous_channel<int> responses;
+    int total = 0;
+
+    [](rendezvous_channel<int>& req, rendezvous_channel<int>& resp) -> eager_task {
+        while (auto v = co_await req.recv()) {
+            co_await resp.send(*v * 2);
+        }
+    }(requests, responses);
+
+    [](rendezvous_channel<int>& req, rendezvous_channel<int>& resp, int& sum) -> eager_task {
+        for (int i = 1; i <= 100; ++i) {
+            co_await req.send(i);
+            sum += (co_await resp.recv()).value_or(0);
+        }
+
+        req.close();
+    }(requests, responses, total);
+
+    EXPECT_EQ(total, 10100);
+    EXPECT_TRUE(requests.is_closed());
+}
+
+TEST(RendezvousChannelTest, PingPongOnPool)
+{
+    // On a scheduler, the side that completes a rendezvous is queued instead of running on its peer's stack
+    thread_pool pool({.threads = 2});
+    rendezvous_channel<int> requests;
+    rendezvous_channel<int> responses;
+    int total = 0;
+    std::latch done(2);
+
+    [](thread_pool& p, rendezvous_channel<int>& req, rendezvous_channel<int>& resp, std::latch& d) -> eager_task {
+        co_await p.schedule();
+        while (auto v = co_await req.recv()) {
+            co_await resp.send(*v * 2);
+        }
+
+        d.count_down();
+    }(pool, requests, responses, done);
+
+    [](thread_pool& p, rendezvous_channel<int>& req, rendezvous_channel<int>& resp, int& sum,
+       std::latch& d) -> eager_task {
+        co_await p.schedule();
+        for (int i = 1; i <= 1000; ++i) {
+            co_await req.send(i);
+            sum += (co_await resp.recv()).value_or(0);
+        }
+
+        req.close();
+        d.count_down();
+    }(pool, requests, responses, total, done);
+
+    done.wait();
+    EXPECT_EQ(total, 1001000);
+}
+
+TEST(RendezvousChannelTest, Close)
+{
+    rendezvous_channel<int> ch;
+    std::optional<int> received = 0;
+    bool sent                   = true;
+
+    [](rendezvous_channel<int>& c, std::optional<int>& out) -> eager_task { out = co_await c.recv(); }(ch, received);
+    ch.close();
+    EXPECT_FALSE(received.has_value());
+
+    [](rendezvous_channel<int>& c, bool& out) -> eager_task { out = co_await c.send(1); }(ch, sent);
+    EXPECT_FALSE(sent);
+
+    rendezvous_channel<int> ch2;
+    sent = true;
+    [](rendezvous_channel<int>& c, bool& out) -> eager_task { out = co_await c.send(1); }(ch2, sent);
+    ch2.close();
+    EXPECT_FALSE(sent);
+
+    received = 0;
+    [](rendezvous_channel<int>& c, std::optional<int>& out) -> eager_task { out = co_await c.recv(); }(ch2, received);
+    EXPECT_FALSE(received.has_value());
+}
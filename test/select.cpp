@@ -0,0 +1,213 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <string>
+#include <thread>
+#include <variant>
+#include <vector>
+
+#include "channel.h"
+#include "eager_task.h"
+#include "select.h"
+#include "timer.h"
+
+using namespace wwa::coro;
+using namespace std::chrono_literals;
+
+TEST(SelectTest, ReadyClauseWins)
+{
+    channel<int> a(2);
+    channel<int> b(2);
+
+    [](channel<int>& x, channel<int>& y) -> eager_task {
+        co_await x.send(1);
+        co_await y.send(2);
+    }(a, b);
+
+    [](channel<int>& x, channel<int>& y) -> eager_task {
+        // Both clauses are ready; the first one wins and the second one has no effect
+        auto r = co_await select(recv(y), recv(x));
+        EXPECT_EQ(r.index(), 0U);
+        EXPECT_EQ(std::get<0>(r), 2);
+
+        r = co_await select(recv(y), recv(x));
+        EXPECT_EQ(r.index(), 1U);
+        EXPECT_EQ(std::get<1>(r), 1);
+    }(a, b);
+}
+
+TEST(SelectTest, WaitsForFirst)
+{
+    channel<int> a(2);
+    channel<std::string> b(2);
+    std::vector<std::string> log;
+
+    [](channel<int>& x, channel<std::string>& y, std::vector<std::string>& out) -> eager_task {
+        for (int i = 0; i < 2; ++i) {
+            auto r = co_await select(recv(x), recv(y));
+            if (r.index() == 0) {
+                out.push_back("a:" + std::to_string(std::get<0>(r).value_or(-1)));
+            }
+            else {
+                out.push_back("b:" + std::get<1>(r).value_or("closed"));
+            }
+        }
+    }(a, b, log);
+
+    EXPECT_TRUE(log.empty());
+
+    [](channel<int>& x, channel<std::string>& y) -> eager_task {
+        co_await y.send("Hello");
+        co_await x.send(1983);
+        co_await y.send("World");
+    }(a, b);
+
+    EXPECT_EQ(log, (std::vector<std::string>{"b:Hello", "a:1983"}));
+
+    // The losing registrations have been removed: the remaining value stays in the channel
+    [](channel<std::string>& y) -> eager_task { EXPECT_EQ(co_await y.recv(), "World"); }(b);
+}
+
+TEST(SelectTest, Send)
+{
+    channel<int> full(1);  // Capacity is rounded up to 2
+    channel<int> in(2);
+    std::optional<std::size_t> which;
+
+    [](channel<int>& c) -> eager_task {
+        co_await c.send(1);
+        co_await c.send(2);
+    }(full);
+
+    [](channel<int>& f, channel<int>& i, std::optional<std::size_t>& w) -> eager_task {
+        auto r = co_await select(send(f, 3), recv(i));
+        w      = r.index();
+        EXPECT_TRUE(r.index() != 0 || std::get<0>(r));
+    }(full, in, which);
+
+    EXPECT_FALSE(which.has_value());
+
+    // Freeing a slot lets the pending send complete
+    [](channel<int>& c) -> eager_task { EXPECT_EQ(co_await c.recv(), 1); }(full);
+    EXPECT_EQ(which, 0U);
+
+    [](channel<int>& c) -> eager_task {
+        EXPECT_EQ(co_await c.recv(), 2);
+        EXPECT_EQ(co_await c.recv(), 3);
+    }(full);
+}
+
+TEST(SelectTest, Timeout)
+{
+    timer_service timers;
+    channel<int> ch(2);
+    std::atomic<int> result = -1;
+
+    [](timer_service& t, channel<int>& c, std::atomic<int>& out) -> eager_task {
+        auto r = co_await select(recv(c), timeout(t, 10ms));
+        out.store(static_cast<int>(r.index()));
+    }(timers, ch, result);
+
+    while (result.load() == -1) {
+        std::this_thread::yield();
+    }
+
+    EXPECT_EQ(result.load(), 1);
+
+    // The receiver has been deregistered, so the value is not lost
+    [](channel<int>& c) -> eager_task {
+        co_await c.send(1983);
+        EXPECT_EQ(co_await c.recv(), 1983);
+    }(ch);
+
+    // A zero timeout completes immediately unless another clause is ready
+    [](timer_service& t, channel<int>& c) -> eager_task {
+        auto r = co_await select(recv(c), timeout(t, 0ms));
+        EXPECT_EQ(r.index(), 1U);
+    }(timers, ch);
+}
+
+TEST(SelectTest, Close)
+{
+    channel<int> a(2);
+    channel<int> b(2);
+    std::optional<std::size_t> which;
+
+    [](channel<int>& x, channel<int>& y, std::optional<std::size_t>& w) -> eager_task {
+        auto r = co_await select(recv(x), recv(y));
+        w      = r.index();
+        EXPECT_FALSE(std::visit([](const auto& v) { return v.has_value(); }, r));
+    }(a, b, which);
+
+    b.close();
+    EXPECT_EQ(which, 1U);
+
+    // Closing the other channel does not touch the completed select
+    a.close();
+}
+
+TEST(SelectTest, CloseSameChannelTwice)
+{
+    channel<int> empty(2);
+    channel<int> full(2);
+    std::optional<std::size_t> received;
+    std::optional<std::size_t> sent;
+
+    [](channel<int>& c) -> eager_task {
+        co_await c.send(1);
+        co_await c.send(2);
+    }(full);
+
+    [](channel<int>& c, std::optional<std::size_t>& w) -> eager_task {
+        auto r = co_await select(recv(c), recv(c));
+        w      = r.index();
+        EXPECT_FALSE(std::visit([](const auto& v) { return v.has_value(); }, r));
+    }(empty, received);
+
+    [](channel<int>& c, std::optional<std::size_t>& w) -> eager_task {
+        auto r = co_await select(send(c, 3), send(c, 4));
+        w      = r.index();
+        EXPECT_FALSE(std::visit([](bool v) { return v; }, r));
+    }(full, sent);
+
+    // Both clauses of each select wait on the same channel: closing it completes the select once, via the first one
+    empty.close();
+    full.close();
+    EXPECT_EQ(received, 0U);
+    EXPECT_EQ(sent, 0U);
+}
+
+TEST(SelectTest, CrossThread)
+{
+    constexpr int count = 2000;
+
+    channel<int> a(4);
+    channel<int> b(4);
+    std::atomic<int> sum = 0;
+
+    std::thread consumer([&] {
+        [](channel<int>& x, channel<int>& y, std::atomic<int>& s) -> eager_task {
+            for (int i = 0; i < 2 * count; ++i) {
+                auto r = co_await select(recv(x), recv(y));
+                s.fetch_add(std::visit([](const auto& v) { return v.value_or(0); }, r));
+            }
+        }(a, b, sum);
+    });
+
+    const auto produce = [](channel<int>& c) -> eager_task {
+        for (int i = 1; i <= count; ++i) {
+            co_await c.send(i);
+        }
+    };
+
+    std::thread pa([&] { produce(a); });
+    std::thread pb([&] { produce(b); });
+
+    pa.join();
+    pb.join();
+    consumer.join();
+
+    EXPECT_EQ(sum.load(), count * (count + 1));
+}
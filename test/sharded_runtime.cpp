@@ -0,0 +1,251 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <latch>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "eager_task.h"
+#include "sharded_runtime.h"
+#include "task.h"
+
+using namespace wwa::coro;
+using namespace std::chrono_literals;
+
+namespace {
+
+// Whether the frames of coroutines with this promise come from an allocator of their own
+template<typename Promise>
+concept own_frames = requires(std::size_t size) { Promise::operator new(size); };
+
+// Records the address of the frame of the awaiting coroutine without suspending it
+struct frame_address {
+    void** m_address;
+
+    [[nodiscard]] static constexpr bool await_ready() noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> h) const noexcept
+    {
+        *this->m_address = h.address();
+        return false;
+    }
+
+    constexpr void await_resume() const noexcept {}
+};
+
+}  // namespace
+
+TEST(ShardedRuntimeTest, InvalidOptions)
+{
+    EXPECT_THROW(sharded_runtime({.shards = 2, .queue_capacity = 0}), std::invalid_argument);
+}
+
+TEST(ShardedRuntimeTest, Schedule)
+{
+    sharded_runtime rt({.shards = 2, .pin_shards = false});
+    std::vector<std::size_t> seen;
+    std::latch done(1);
+
+    EXPECT_EQ(rt.size(), 2U);
+    EXPECT_EQ(rt.current_shard(), sharded_runtime::npos);
+
+    [](sharded_runtime& r, std::vector<std::size_t>& s, std::latch& d) -> eager_task {
+        co_await r.schedule(1);
+        s.push_back(r.current_shard());
+        co_await r.schedule(0);
+        s.push_back(r.current_shard());
+        co_await r.schedule(0);  // Already there
+        s.push_back(r.current_shard());
+        d.count_down();
+    }(rt, seen, done);
+
+    done.wait();
+    EXPECT_EQ(seen, (std::vector<std::size_t>{1, 0, 0}));
+}
+
+TEST(ShardedRuntimeTest, SubmitTo)
+{
+    sharded_runtime rt({.shards = 3, .pin_shards = false});
+    std::size_t ran_on  = 99;
+    std::size_t back_on = 99;
+    int value           = 0;
+    std::string from_task;
+    std::latch done(1);
+
+    [](sharded_runtime& r, std::size_t& on, std::size_t& back, int& v, std::string& t, std::latch& d) -> eager_task {
+        co_await r.schedule(0);
+        v = co_await r.submit_to(2, [&r, &on] {
+            on = r.current_shard();
+            return 42;
+        });
+
+        t = co_await r.submit_to(1, [&r]() -> task<std::string> {
+            co_await r.schedule(2);  // The task may move on; the result still comes back to shard 0
+            co_return "shard " + std::to_string(r.current_shard());
+        });
+
+        co_await r.submit_to(1, [] {});
+        back = r.current_shard();
+        d.count_down();
+    }(rt, ran_on, back_on, value, from_task, done);
+
+    done.wait();
+    EXPECT_EQ(ran_on, 2U);
+    EXPECT_EQ(value, 42);
+    EXPECT_EQ(from_task, "shard 2");
+    EXPECT_EQ(back_on, 0U);
+}
+
+TEST(ShardedRuntimeTest, Exception)
+{
+    sharded_runtime rt({.shards = 2, .pin_shards = false});
+    bool caught           = false;
+    std::size_t caught_on = 99;
+    std::latch done(1);
+
+    [](sharded_runtime& r, bool& c, std::size_t& on, std::latch& d) -> eager_task {
+        co_await r.schedule(0);
+        try {
+            co_await r.submit_to(1, []() -> int { throw std::runtime_error("boom"); });
+        }
+        catch (const std::runtime_error&) {
+            c  = true;
+            on = r.current_shard();
+        }
+
+        d.count_down();
+    }(rt, caught, caught_on, done);
+
+    done.wait();
+    EXPECT_TRUE(caught);
+    EXPECT_EQ(caught_on, 0U);
+}
+
+TEST(ShardedRuntimeTest, Overflow)
+{
+    constexpr int messages = 200;
+
+    // A queue of one slot overflows at once; the messages must still arrive, in order
+    sharded_runtime rt({.shards = 2, .queue_capacity = 1, .pin_shards = false});
+    std::vector<int> received;  // Owned by shard 1
+    std::latch done(messages);
+
+    [](sharded_runtime& r, std::vector<int>& rec, std::latch& d) -> eager_task {
+        co_await r.schedule(0);
+        for (int i = 0; i < messages; ++i) {
+            [](sharded_runtime& r2, std::vector<int>& rec2, std::latch& d2, int n) -> eager_task {
+                co_await r2.submit_to(1, [&rec2, n] { rec2.push_back(n); });
+                d2.count_down();
+            }(r, rec, d, i);
+        }
+    }(rt, received, done);
+
+    done.wait();
+
+    std::vector<int> expected(messages);
+    for (int i = 0; i < messages; ++i) {
+        expected[static_cast<std::size_t>(i)] = i;
+    }
+
+    EXPECT_EQ(received, expected);
+}
+
+TEST(ShardedRuntimeTest, FrameArena)
+{
+    detail::frame_arena arena;
+    detail::frame_arena::current() = &arena;
+
+    void* a = detail::frame_arena::allocate(100);
+    detail::frame_arena::deallocate(a, 100);
+    void* b = detail::frame_arena::allocate(120);  // Same size class
+    void* c = detail::frame_arena::allocate(120);
+    EXPECT_EQ(a, b);
+    EXPECT_NE(b, c);
+    detail::frame_arena::deallocate(b, 120);
+    detail::frame_arena::deallocate(c, 120);
+
+    // Large frames bypass the arena
+    void* big = detail::frame_arena::allocate(detail::frame_arena::max_size + 1);
+    detail::frame_arena::deallocate(big, detail::frame_arena::max_size + 1);
+
+    detail::frame_arena::current() = nullptr;
+}
+
+TEST(ShardedRuntimeTest, ArenaTask)
+{
+    // Only tasks that opt in use the arena
+    static_assert(!own_frames<task<>::promise_type>);
+    static_assert(!own_frames<task<int>::promise_type>);
+    static_assert(own_frames<arena_task<>::promise_type>);
+    static_assert(own_frames<arena_task<int>::promise_type>);
+
+    detail::frame_arena arena;
+    detail::frame_arena::current() = &arena;
+
+    void* first  = nullptr;
+    void* second = nullptr;
+    int result   = 0;
+
+    const auto frame = [](void*& address) -> arena_task<int> {
+        co_await frame_address{&address};
+        co_return 1;
+    };
+
+    [](const auto& fn, void*& f, void*& s, int& r) -> eager_task {
+        r += co_await fn(f);
+        // The frame of the first task is back in the arena and is reused
+        r += co_await fn(s);
+    }(frame, first, second, result);
+
+    EXPECT_EQ(result, 2);
+    EXPECT_NE(first, nullptr);
+    EXPECT_EQ(first, second);
+
+    detail::frame_arena::current() = nullptr;
+}
+
+TEST(ShardedRuntimeTest, StopTogether)
+{
+    constexpr int count = 8;
+
+    std::atomic<int> ran      = 0;
+    std::atomic<bool> started = false;
+    std::atomic<bool> go      = false;
+    std::thread releaser;
+    {
+        sharded_runtime rt({.shards = 2, .queue_capacity = 1, .pin_shards = false});
+
+        // Shard 0 is still busy when shard 1 runs out of work during destruction; then it overflows the queue to it
+        [](sharded_runtime& r, std::atomic<bool>& s, std::atomic<bool>& g, std::atomic<int>& n) -> eager_task {
+            co_await r.schedule(0);
+            s.store(true);
+            while (!g.load()) {
+                std::this_thread::yield();
+            }
+
+            for (int i = 0; i < count; ++i) {
+                [](sharded_runtime& rr, std::atomic<int>& nn) -> eager_task {
+                    co_await rr.schedule(1);
+                    nn.fetch_add(1);
+                }(r, n);
+            }
+        }(rt, started, go, ran);
+
+        while (!started.load()) {
+            std::this_thread::yield();
+        }
+
+        releaser = std::thread([&go] {
+            std::this_thread::sleep_for(50ms);
+            go.store(true);
+        });
+    }
+
+    releaser.join();
+    EXPECT_EQ(ran.load(), count);
+}
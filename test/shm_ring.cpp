@@ -0,0 +1,324 @@
+#include <gtest/gtest.h>
+
+#include <sys/eventfd.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "eager_task.h"
+#include "shm_ring.h"
+
+using namespace wwa::coro;
+
+namespace {
+
+std::span<const std::byte> bytes(std::string_view s)
+{
+    return std::as_bytes(std::span(s.data(), s.size()));
+}
+
+std::string text(std::span<const std::byte> b)
+{
+    return {reinterpret_cast<const char*>(b.data()), b.size()};
+}
+
+eager_task collect(shm_ring& ring, std::vector<std::string>& out, std::atomic<bool>& done)
+{
+    auto gen = ring.receive();
+    for (auto it = co_await gen.begin(); it != gen.end(); co_await ++it) {
+        out.push_back(text(*it));
+    }
+
+    done.store(true);
+}
+
+void wait_for(const std::atomic<bool>& flag)
+{
+    while (!flag.load()) {
+        std::this_thread::yield();
+    }
+}
+
+}  // namespace
+
+TEST(ShmRingTest, InvalidCapacity)
+{
+    EXPECT_THROW(shm_ring(0), std::invalid_argument);
+
+    const shm_ring ring(100);
+    EXPECT_EQ(ring.capacity(), 128U);
+    EXPECT_EQ(ring.max_payload(), 56U);
+}
+
+TEST(ShmRingTest, SendReceive)
+{
+    shm_ring ring(256);
+    std::vector<std::string> received;
+    std::atomic<bool> done = false;
+
+    collect(ring, received, done);
+    EXPECT_TRUE(received.empty());
+
+    [](shm_ring& r) -> eager_task {
+        EXPECT_TRUE(co_await r.send(bytes("Hello")));
+        EXPECT_TRUE(co_await r.send(bytes("")));
+        EXPECT_TRUE(co_await r.send(bytes("World")));
+        r.close();
+    }(ring);
+
+    wait_for(done);
+    EXPECT_EQ(received, (std::vector<std::string>{"Hello", "", "World"}));
+
+    EXPECT_THROW((void)ring.send(std::vector<std::byte>(ring.max_payload() + 1)), std::invalid_argument);
+}
+
+TEST(ShmRingTest, Wraparound)
+{
+    shm_ring ring(64);
+    std::vector<std::string> expected;
+    std::vector<std::string> received;
+    std::atomic<bool> done = false;
+
+    for (int i = 0; i < 200; ++i) {
+        expected.emplace_back(static_cast<std::size_t>(i % 23), static_cast<char>('a' + i % 26));
+    }
+
+    collect(ring, received, done);
+
+    // Records of uneven sizes force the producer to skip to the start of the data area,
+    // and the small ring makes the producer wait for space
+    [](shm_ring& r, const std::vector<std::string>& records) -> eager_task {
+        for (const auto& record : records) {
+            EXPECT_TRUE(co_await r.send(bytes(record)));
+        }
+
+        r.close();
+    }(ring, expected);
+
+    wait_for(done);
+    EXPECT_EQ(received, expected);
+}
+
+TEST(ShmRingTest, LargestPayloadAfterSkip)
+{
+    shm_ring ring(64);
+    const std::vector<std::string> expected{"", std::string(24, 'x'), std::string(ring.max_payload(), 'y')};
+    std::vector<std::string> received;
+    std::atomic<bool> done = false;
+
+    collect(ring, received, done);
+
+    // The first two records move the positions to 40: the largest record no longer fits before the end of the data
+    // area, and has to skip to the start once the ring is empty
+    [](shm_ring& r, const std::vector<std::string>& records) -> eager_task {
+        for (const auto& record : records) {
+            EXPECT_TRUE(co_await r.send(bytes(record)));
+        }
+
+        r.close();
+    }(ring, expected);
+
+    wait_for(done);
+    EXPECT_EQ(received, expected);
+    EXPECT_THROW((void)ring.try_send(std::vector<std::byte>(ring.max_payload() + 1)), std::invalid_argument);
+}
+
+TEST(ShmRingTest, ProducerWaitsForSpace)
+{
+    shm_ring ring(64);
+    const std::string record(24, 'x');  // 32 bytes with the length prefix
+    std::atomic<bool> sent = false;
+
+    [](shm_ring& r, const std::string& rec, std::atomic<bool>& flag) -> eager_task {
+        for (int i = 0; i < 3; ++i) {
+            EXPECT_TRUE(co_await r.send(bytes(rec)));
+        }
+
+        flag.store(true);
+    }(ring, record, sent);
+
+    EXPECT_FALSE(sent.load());
+
+    std::vector<std::string> received;
+    std::atomic<bool> done = false;
+    collect(ring, received, done);
+
+    wait_for(sent);
+    ring.close();
+    wait_for(done);
+    EXPECT_EQ(received, (std::vector<std::string>(3, record)));
+}
+
+TEST(ShmRingTest, BusyPoll)
+{
+    fd_poller poller({.mode = poll_mode::busy, .busy_idle = std::chrono::milliseconds(5)});
+    shm_ring ring(256, poller);
+    std::vector<std::string> received;
+    std::atomic<bool> done = false;
+
+    collect(ring, received, done);
+    EXPECT_TRUE(ring.try_send(bytes("Hello")));
+    ring.close();
+    wait_for(done);
+    EXPECT_EQ(received, (std::vector<std::string>{"Hello"}));
+
+    // The poller polls after an event, then goes to sleep once it has been idle for a while
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const fd_poller_stats stats = poller.stats();
+    EXPECT_GE(stats.completions, 1U);
+    EXPECT_GT(stats.busy_polls, 0U);
+    EXPECT_GE(stats.blocking_waits, 1U);
+}
+
+TEST(ShmRingTest, Close)
+{
+    shm_ring ring(64);
+    const std::string record(24, 'x');  // Two records fill the ring
+    std::atomic<bool> finished = false;
+
+    [](shm_ring& r, const std::string& rec, std::atomic<bool>& flag) -> eager_task {
+        EXPECT_TRUE(co_await r.send(bytes(rec)));
+        EXPECT_TRUE(co_await r.send(bytes(rec)));
+        EXPECT_FALSE(co_await r.send(bytes(rec)));
+        flag.store(true);
+    }(ring, record, finished);
+
+    EXPECT_FALSE(finished.load());
+
+    // Either side may close the ring; the waiting producer gives up, and the consumer still gets the sent records
+    ring.close();
+    wait_for(finished);
+    EXPECT_TRUE(ring.is_closed());
+    EXPECT_FALSE(ring.try_send(bytes("late")));
+
+    std::vector<std::string> received;
+    std::atomic<bool> done = false;
+    collect(ring, received, done);
+    EXPECT_TRUE(done.load());
+    EXPECT_EQ(received, (std::vector<std::string>(2, record)));
+}
+
+TEST(ShmRingTest, WatchError)
+{
+    shm_ring ring(64);
+    const int doorbell = ::dup(ring.native_handles().readable);
+    ASSERT_NE(doorbell, -1);
+    std::atomic<bool> failed = false;
+
+    [](shm_ring& r, int d, std::atomic<bool>& f) -> eager_task {
+        auto gen = r.receive();
+        try {
+            co_await gen.begin();
+        }
+        catch (const std::system_error&) {
+            // Runs on the poller thread: quiet the doorbell, whose registration is now stale
+            eventfd_t value;
+            ::eventfd_read(d, &value);
+            f.store(true);
+        }
+    }(ring, doorbell, failed);
+
+    // Epoll cannot watch a regular file: the doorbell fires, but re-arming it fails on the poller thread
+    std::FILE* file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    ASSERT_NE(::dup2(::fileno(file), ring.native_handles().readable), -1);
+    static_cast<void>(std::fclose(file));
+    ::eventfd_write(doorbell, 1);
+
+    wait_for(failed);
+    ::close(doorbell);
+}
+
+TEST(ShmRingDeathTest, ExitAfterFork)
+{
+    // The default poller has a thread now; a forked child inherits the poller but not the thread, and must still be
+    // able to exit
+    const shm_ring ring(64);
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunknown-warning-option"
+#pragma clang diagnostic ignored "-Wswitch-default"
+    EXPECT_EXIT(std::exit(0), ::testing::ExitedWithCode(0), "");  // NOLINT(concurrency-mt-unsafe)
+#pragma clang diagnostic pop
+}
+
+TEST(ShmRingTest, Attach)
+{
+    shm_ring ring(256);
+    shm_ring attached(ring.native_handles());
+    EXPECT_EQ(attached.capacity(), ring.capacity());
+
+    std::vector<std::string> received;
+    std::atomic<bool> done = false;
+    collect(ring, received, done);
+
+    // The producer uses a separate mapping of the same memory
+    std::thread producer([&attached] {
+        [](shm_ring& r) -> eager_task {
+            for (int i = 0; i < 1000; ++i) {
+                EXPECT_TRUE(co_await r.send(bytes(std::to_string(i))));
+            }
+
+            r.close();
+        }(attached);
+    });
+
+    producer.join();
+    wait_for(done);
+
+    ASSERT_EQ(received.size(), 1000U);
+    EXPECT_EQ(received.front(), "0");
+    EXPECT_EQ(received.back(), "999");
+
+    // A descriptor that is not a ring is rejected
+    const shm_ring::handles h = ring.native_handles();
+    EXPECT_THROW(shm_ring({h.readable, h.readable, h.writable}), std::invalid_argument);
+}
+
+TEST(ShmRingTest, CrossProcess)
+{
+    constexpr int count = 1000;
+
+    shm_ring ring(128);
+    const pid_t pid = fork();
+    ASSERT_NE(pid, -1);
+
+    if (pid == 0) {
+        // The child inherits the mapping and the doorbells; it only produces, without suspending
+        for (int i = 0; i < count; ++i) {
+            const std::string record = std::to_string(i);
+            while (!ring.try_send(bytes(record))) {
+                std::this_thread::yield();
+            }
+        }
+
+        ring.close();
+        _exit(0);
+    }
+
+    std::vector<std::string> received;
+    std::atomic<bool> done = false;
+    collect(ring, received, done);
+    wait_for(done);
+
+    int status = 0;
+    EXPECT_EQ(waitpid(pid, &status, 0), pid);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    ASSERT_EQ(received.size(), static_cast<std::size_t>(count));
+    for (int i = 0; i < count; ++i) {
+        EXPECT_EQ(received[static_cast<std::size_t>(i)], std::to_string(i));
+    }
+}
@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "eager_task.h"
+#include "spsc_channel.h"
+
+using namespace wwa::coro;
+
+TEST(SpscChannelTest, ZeroCapacity)
+{
+    EXPECT_THROW(spsc_channel<int>{0}, std::invalid_argument);
+}
+
+TEST(SpscChannelTest, Capacity)
+{
+    EXPECT_EQ(spsc_channel<int>{1}.capacity(), 1U);
+    EXPECT_EQ(spsc_channel<int>{3}.capacity(), 4U);
+}
+
+TEST(SpscChannelTest, TryReservePeek)
+{
+    spsc_channel<int> ch(1);
+
+    EXPECT_EQ(ch.try_peek(), nullptr);
+
+    int* slot = ch.try_reserve();
+    ASSERT_NE(slot, nullptr);
+    *slot = 1983;
+    ch.commit();
+
+    EXPECT_EQ(ch.try_reserve(), nullptr);
+
+    const int* value = ch.try_peek();
+    ASSERT_NE(value, nullptr);
+    EXPECT_EQ(*value, 1983);
+    ch.release();
+
+    EXPECT_EQ(ch.try_peek(), nullptr);
+    EXPECT_NE(ch.try_reserve(), nullptr);
+}
+
+TEST(SpscChannelTest, ReserveCommitPeekRelease)
+{
+    spsc_channel<std::string> ch(2);
+
+    [](spsc_channel<std::string>& c) -> eager_task {
+        std::string* slot = co_await c.reserve();
+        EXPECT_NE(slot, nullptr);
+        slot->assign("Hello");
+        c.commit();
+    }(ch);
+
+    [](spsc_channel<std::string>& c) -> eager_task {
+        const std::string* slot = co_await c.peek();
+        EXPECT_NE(slot, nullptr);
+        EXPECT_EQ(slot != nullptr ? *slot : "", "Hello");
+        c.release();
+    }(ch);
+}
+
+TEST(SpscChannelTest, ConsumerSuspendsWhenEmpty)
+{
+    spsc_channel<int> ch(2);
+    int received = 0;
+
+    [](spsc_channel<int>& c, int& out) -> eager_task {
+        const int* slot = co_await c.peek();
+        out             = slot != nullptr ? *slot : -1;
+        c.release();
+    }(ch, received);
+
+    EXPECT_EQ(received, 0);
+
+    *ch.try_reserve() = 1983;
+    ch.commit();
+    EXPECT_EQ(received, 1983);
+}
+
+TEST(SpscChannelTest, ProducerSuspendsWhenFull)
+{
+    spsc_channel<int> ch(2);
+    int produced = 0;
+
+    [](spsc_channel<int>& c, int& n) -> eager_task {
+        for (int i = 0; i < 3; ++i) {
+            int* slot = co_await c.reserve();
+            *slot     = i;
+            c.commit();
+            ++n;
+        }
+    }(ch, produced);
+
+    EXPECT_EQ(produced, 2);
+
+    EXPECT_EQ(*ch.try_peek(), 0);
+    ch.release();
+    EXPECT_EQ(produced, 3);
+}
+
+TEST(SpscChannelTest, Close)
+{
+    spsc_channel<int> ch(2);
+    std::vector<int> received;
+    bool finished = false;
+
+    [](spsc_channel<int>& c, std::vector<int>& out, bool& done) -> eager_task {
+        while (const int* slot = co_await c.peek()) {
+            out.push_back(*slot);
+            c.release();
+        }
+
+        done = true;
+    }(ch, received, finished);
+
+    *ch.try_reserve() = 1;
+    ch.commit();
+    EXPECT_FALSE(finished);
+
+    ch.close();
+    EXPECT_TRUE(finished);
+    EXPECT_EQ(received, std::vector<int>{1});
+    EXPECT_EQ(ch.try_reserve(), nullptr);
+
+    [](spsc_channel<int>& c) -> eager_task { EXPECT_EQ(co_await c.reserve(), nullptr); }(ch);
+}
+
+TEST(SpscChannelTest, CrossThread)
+{
+    constexpr std::size_t count = 100000;
+    spsc_channel<std::size_t> ch(64);
+    std::size_t sum = 0;
+
+    std::thread consumer([&ch, &sum] {
+        [](spsc_channel<std::size_t>& c, std::size_t& s) -> eager_task {
+            while (const std::size_t* slot = co_await c.peek()) {
+                s += *slot;
+                c.release();
+            }
+        }(ch, sum);
+    });
+
+    std::thread producer([&ch] {
+        [](spsc_channel<std::size_t>& c) -> eager_task {
+            for (std::size_t i = 1; i <= count; ++i) {
+                *co_await c.reserve() = i;
+                c.commit();
+            }
+
+            c.close();
+        }(ch);
+    });
+
+    producer.join();
+    consumer.join();
+
+    EXPECT_EQ(sum, count * (count + 1) / 2);
+}
@@ -0,0 +1,214 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <latch>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "eager_task.h"
+#include "exceptions.h"
+#include "static_graph.h"
+#include "task.h"
+#include "thread_pool.h"
+
+using namespace wwa::coro;
+
+namespace {
+
+struct source {
+    std::unique_ptr<int> operator()() const { return std::make_unique<int>(2); }
+};
+
+struct times_ten {
+    task<int> operator()(std::unique_ptr<int>& p) const { co_return *p * 10; }
+};
+
+struct plus_one {
+    int operator()(const std::unique_ptr<int>& p) const { return *p + 1; }
+};
+
+struct sum {
+    task<int> operator()(int& x, int& y) const { co_return x + y; }
+};
+
+// Listed out of order on purpose: the graph sorts the nodes itself
+using diamond = static_graph<node<sum, depends<times_ten, plus_one>>, node<plus_one, depends<source>>, node<source>,
+                             node<times_ten, depends<source>>>;
+
+template<typename Graph, typename Scheduler>
+eager_task run_graph(Graph& g, Scheduler& sched, std::latch& done)
+{
+    co_await g.run(sched);
+    done.count_down();
+}
+
+struct log_step {
+    std::vector<int>* m_log;
+    int m_id;
+
+    void operator()() const { this->m_log->push_back(this->m_id); }
+};
+
+struct first : log_step {};
+struct second : log_step {};
+struct third : log_step {};
+
+struct meet_a {
+    std::latch* m_latch;
+
+    void operator()() const { this->m_latch->arrive_and_wait(); }
+};
+
+struct meet_b : meet_a {};
+
+struct counter {
+    std::atomic<int>* m_calls;
+
+    int operator()() const { return ++*this->m_calls; }
+};
+
+struct doubler {
+    int operator()(int& x) const { return x * 2; }
+};
+
+struct value {
+    int operator()() const { return 1; }
+};
+
+struct thrower {
+    int operator()(int&) const { throw std::runtime_error("boom"); }
+};
+
+struct increment {
+    int operator()(int& x) const { return x + 1; }
+};
+
+struct after_both {
+    std::atomic<bool>* m_skipped;
+
+    void operator()(int&, int&) const { *this->m_skipped = false; }
+};
+
+using failing = static_graph<node<value>, node<thrower, depends<value>>, node<increment, depends<value>>,
+                             node<after_both, depends<thrower, increment>>>;
+
+}  // namespace
+
+TEST(StaticGraphTest, Order)
+{
+    static_assert(diamond::size() == 4);
+    static_assert(diamond::order() == std::array<std::size_t, 4>{2, 1, 3, 0});
+    static_assert(std::is_same_v<diamond::result_t<source>, std::unique_ptr<int>>);
+    static_assert(std::is_same_v<diamond::result_t<sum>, int>);
+    SUCCEED();
+}
+
+TEST(StaticGraphTest, Diamond)
+{
+    thread_pool pool({.threads = 4});
+    diamond g;
+    std::latch done(1);
+    run_graph(g, pool, done);
+    done.wait();
+
+    EXPECT_EQ(*g.get<source>(), 2);
+    EXPECT_EQ(g.get<times_ten>(), 20);
+    EXPECT_EQ(g.get<plus_one>(), 3);
+    EXPECT_EQ(g.get<sum>(), 23);
+}
+
+TEST(StaticGraphTest, Inline)
+{
+    std::vector<int> log;
+    static_graph<node<third, depends<second>>, node<second, depends<first>>, node<first>> g(
+        third{{&log, 3}}, second{{&log, 2}}, first{{&log, 1}}
+    );
+
+    [](decltype(g)& gr) -> eager_task { co_await gr.run(); }(g);
+    EXPECT_EQ(log, (std::vector<int>{1, 2, 3}));
+}
+
+TEST(StaticGraphTest, Parallel)
+{
+    // Each node waits for the other: this only completes if independent nodes run at the same time
+    thread_pool pool({.threads = 2});
+    std::latch meeting(2);
+    static_graph<node<meet_a>, node<meet_b>> g(meet_a{&meeting}, meet_b{{&meeting}});
+
+    std::latch done(1);
+    run_graph(g, pool, done);
+    done.wait();
+
+    EXPECT_NO_THROW(g.get<meet_a>());
+    EXPECT_NO_THROW(g.get<meet_b>());
+}
+
+TEST(StaticGraphTest, Exception)
+{
+    thread_pool pool({.threads = 2});
+    std::atomic<bool> skipped = true;
+    failing g(value{}, thrower{}, increment{}, after_both{&skipped});
+
+    bool caught = false;
+    std::latch done(1);
+    [](failing& gr, thread_pool& p, bool& e, std::latch& l) -> eager_task {
+        try {
+            co_await gr.run(p);
+        }
+        catch (const std::runtime_error&) {
+            e = true;
+        }
+
+        l.count_down();
+    }(g, pool, caught, done);
+    done.wait();
+
+    EXPECT_TRUE(caught);
+    EXPECT_TRUE(skipped);
+    EXPECT_EQ(g.get<increment>(), 2);
+    EXPECT_THROW(g.get<thrower>(), std::runtime_error);
+    EXPECT_THROW(g.get<after_both>(), std::runtime_error);
+
+    // Running inline fails the same way
+    caught = false;
+    [](failing& gr, bool& e) -> eager_task {
+        try {
+            co_await gr.run();
+        }
+        catch (const std::runtime_error&) {
+            e = true;
+        }
+    }(g, caught);
+
+    EXPECT_TRUE(caught);
+    EXPECT_TRUE(skipped);
+}
+
+TEST(StaticGraphTest, Empty)
+{
+    thread_pool pool({.threads = 1});
+    static_graph<> g;
+    std::latch done(1);
+    run_graph(g, pool, done);
+    done.wait();
+    EXPECT_EQ(g.size(), 0U);
+}
+
+TEST(StaticGraphTest, Rerun)
+{
+    thread_pool pool({.threads = 2});
+    std::atomic<int> calls = 0;
+    static_graph<node<counter>, node<doubler, depends<counter>>> g(counter{&calls}, doubler{});
+
+    EXPECT_THROW(g.get<doubler>(), bad_result_access);
+
+    for (int i = 1; i <= 2; ++i) {
+        std::latch done(1);
+        run_graph(g, pool, done);
+        done.wait();
+        EXPECT_EQ(g.get<doubler>(), i * 2);
+    }
+}
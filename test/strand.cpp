@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <latch>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "eager_task.h"
+#include "strand.h"
+#include "task.h"
+#include "thread_pool.h"
+
+using namespace wwa::coro;
+
+TEST(StrandTest, RunsInline)
+{
+    strand s;
+    std::thread::id id;
+    bool on_strand = false;
+
+    [](strand& st, std::thread::id& i, bool& on) -> eager_task {
+        co_await st.schedule();
+        i  = std::this_thread::get_id();
+        on = st.running_in_this_thread();
+    }(s, id, on_strand);
+
+    EXPECT_EQ(id, std::this_thread::get_id());
+    EXPECT_TRUE(on_strand);
+    EXPECT_FALSE(s.running_in_this_thread());
+}
+
+TEST(StrandTest, Fifo)
+{
+    strand s;
+    std::vector<std::string> order;
+
+    const auto enter = [](strand& st, std::vector<std::string>& o, std::string name) -> eager_task {
+        co_await st.schedule();
+        o.push_back(name);
+    };
+
+    [](strand& st, std::vector<std::string>& o, auto& e) -> eager_task {
+        co_await st.schedule();
+        o.emplace_back("first");
+
+        // The strand is busy: these wait until the current coroutine leaves it
+        e(st, o, "second");
+        e(st, o, "third");
+        o.emplace_back("first done");
+    }(s, order, enter);
+
+    EXPECT_EQ(order, (std::vector<std::string>{"first", "first done", "second", "third"}));
+}
+
+TEST(StrandTest, Serializes)
+{
+    constexpr int coroutines = 8;
+    constexpr int steps      = 500;
+
+    thread_pool pool({.threads = 4});
+    strand s;
+    int counter               = 0;  // Guarded by the strand only
+    std::atomic<bool> inside  = false;
+    std::atomic<bool> overlap = false;
+    std::latch done(coroutines);
+
+    for (int i = 0; i < coroutines; ++i) {
+        [](thread_pool& p, strand& st, int& c, std::atomic<bool>& in, std::atomic<bool>& ov,
+           std::latch& d) -> eager_task {
+            for (int j = 0; j < steps; ++j) {
+                co_await p.schedule();
+                co_await st.schedule();
+                if (in.exchange(true)) {
+                    ov = true;
+                }
+
+                ++c;
+                in = false;
+            }
+
+            d.count_down();
+        }(pool, s, counter, inside, overlap, done);
+    }
+
+    done.wait();
+    EXPECT_FALSE(overlap.load());
+    EXPECT_EQ(counter, coroutines * steps);
+}
+
+TEST(StrandTest, KeepsBudgetOff)
+{
+    thread_pool pool({.threads = 1, .budget = 4});
+    strand s;
+    std::atomic<bool> stayed = false;
+    std::latch done(1);
+
+    [](thread_pool& p, strand& st, std::atomic<bool>& ok, std::latch& d) -> eager_task {
+        co_await p.schedule();
+        co_await st.schedule();
+
+        // Every await spends budget on the pool; on the strand, it must not send the coroutine back to the pool
+        bool on = true;
+        for (int i = 0; i < 100; ++i) {
+            co_await []() -> task<> { co_return; }();
+            on = on && st.running_in_this_thread();
+        }
+
+        ok = on;
+        d.count_down();
+    }(pool, s, stayed, done);
+
+    done.wait();
+    EXPECT_TRUE(stayed.load());
+}
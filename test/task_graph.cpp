@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstddef>
+#include <latch>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "eager_task.h"
+#include "exceptions.h"
+#include "task.h"
+#include "task_graph.h"
+#include "thread_pool.h"
+
+using namespace wwa::coro;
+
+namespace {
+
+eager_task run_graph(task_graph& g, thread_pool& pool, std::latch& done)
+{
+    co_await g.run(pool);
+    done.count_down();
+}
+
+}  // namespace
+
+TEST(TaskGraphTest, Diamond)
+{
+    thread_pool pool({.threads = 4});
+    task_graph g;
+
+    // A move-only result proves that results are passed by reference
+    auto a = g.add([] { return std::make_unique<int>(2); });
+    auto b = g.add([](std::unique_ptr<int>& p) -> task<int> { co_return *p * 10; }, a);
+    auto c = g.add([](const std::unique_ptr<int>& p) { return *p + 1; }, a);
+    auto d = g.add([](int& x, int& y) -> task<int> { co_return x + y; }, b, c);
+
+    EXPECT_EQ(g.size(), 4U);
+
+    std::latch done(1);
+    run_graph(g, pool, done);
+    done.wait();
+
+    EXPECT_EQ(*a.get(), 2);
+    EXPECT_EQ(b.get(), 20);
+    EXPECT_EQ(c.get(), 3);
+    EXPECT_EQ(d.get(), 23);
+}
+
+TEST(TaskGraphTest, Dependencies)
+{
+    constexpr std::size_t count = 500;
+
+    thread_pool pool({.threads = 4});
+    task_graph g;
+    std::atomic<std::size_t> clock = 0;
+    std::vector<std::size_t> finished(count);
+    std::vector<std::pair<std::size_t, std::size_t>> deps(count);
+    std::vector<task_graph::node<void>> nodes;
+
+    std::mt19937 rng(7);
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto body = [&clock, &finished, i] { finished[i] = ++clock; };
+        if (i < 2) {
+            nodes.push_back(g.add(body));
+        }
+        else {
+            deps[i] = {rng() % i, rng() % i};
+            nodes.push_back(g.add(body, nodes[deps[i].first], nodes[deps[i].second]));
+        }
+    }
+
+    std::latch done(1);
+    run_graph(g, pool, done);
+    done.wait();
+
+    EXPECT_EQ(clock, count);
+    for (std::size_t i = 2; i < count; ++i) {
+        EXPECT_GT(finished[i], finished[deps[i].first]);
+        EXPECT_GT(finished[i], finished[deps[i].second]);
+    }
+}
+
+TEST(TaskGraphTest, VoidNodes)
+{
+    thread_pool pool({.threads = 2});
+    task_graph g;
+    bool ready = false;
+
+    auto init  = g.add([&ready] { ready = true; });
+    auto value = g.add([] { return 5; });
+    // Dependencies without a result order the nodes but pass nothing
+    auto check = g.add([&ready](int& v) { return ready ? v : -1; }, init, value);
+
+    std::latch done(1);
+    run_graph(g, pool, done);
+    done.wait();
+
+    EXPECT_EQ(check.get(), 5);
+}
+
+TEST(TaskGraphTest, Exception)
+{
+    thread_pool pool({.threads = 2});
+    task_graph g;
+    std::atomic<bool> skipped = true;
+
+    auto a = g.add([] { return 1; });
+    auto b = g.add([](int&) -> int { throw std::runtime_error("boom"); }, a);
+    auto c = g.add([](int& x) { return x + 1; }, a);
+    auto d = g.add(
+        [&skipped](int&, int&) {
+            skipped = false;
+            return 0;
+        },
+        b, c
+    );
+
+    bool caught = false;
+    std::latch done(1);
+    [](task_graph& gr, thread_pool& p, bool& e, std::latch& l) -> eager_task {
+        try {
+            co_await gr.run(p);
+        }
+        catch (const std::runtime_error&) {
+            e = true;
+        }
+
+        l.count_down();
+    }(g, pool, caught, done);
+    done.wait();
+
+    EXPECT_TRUE(caught);
+    EXPECT_TRUE(skipped);
+    EXPECT_EQ(c.get(), 2);
+    EXPECT_THROW(b.get(), std::runtime_error);
+    EXPECT_THROW(d.get(), std::runtime_error);
+}
+
+TEST(TaskGraphTest, Empty)
+{
+    thread_pool pool({.threads = 1});
+    task_graph g;
+    std::latch done(1);
+    run_graph(g, pool, done);
+    done.wait();
+    EXPECT_EQ(g.size(), 0U);
+}
+
+TEST(TaskGraphTest, Rerun)
+{
+    thread_pool pool({.threads = 2});
+    task_graph g;
+    std::atomic<int> calls = 0;
+
+    auto a = g.add([&calls] { return ++calls; });
+    auto b = g.add([](int& x) { return x * 2; }, a);
+
+    EXPECT_THROW(b.get(), bad_result_access);
+
+    for (int i = 1; i <= 2; ++i) {
+        std::latch done(1);
+        run_graph(g, pool, done);
+        done.wait();
+        EXPECT_EQ(b.get(), i * 2);
+    }
+}
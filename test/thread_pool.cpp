@@ -0,0 +1,428 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <latch>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+#include "eager_task.h"
+#include "exceptions.h"
+#include "task.h"
+#include "thread_pool.h"
+
+using namespace wwa::coro;
+
+namespace {
+
+// Occupies the only worker of a pool until released, so that work can be queued behind it
+class blocker {
+public:
+    explicit blocker(thread_pool& pool)
+    {
+        [](thread_pool& p, std::atomic<bool>& started, std::atomic<bool>& release) -> eager_task {
+            co_await p.schedule(0);
+            started.store(true);
+            while (!release.load()) {
+                std::this_thread::yield();
+            }
+        }(pool, this->m_started, this->m_release);
+
+        while (!this->m_started.load()) {
+            std::this_thread::yield();
+        }
+    }
+
+    void release() { this->m_release.store(true); }
+
+private:
+    std::atomic<bool> m_started = false;
+    std::atomic<bool> m_release = false;
+};
+
+eager_task record(thread_pool& pool, std::size_t priority, std::vector<std::size_t>& log, std::latch& done)
+{
+    co_await pool.schedule(priority);
+    log.push_back(priority);
+    done.count_down();
+}
+
+}  // namespace
+
+TEST(ThreadPoolTest, InvalidOptions)
+{
+    EXPECT_THROW(thread_pool({.threads = 1, .priorities = 0}), std::invalid_argument);
+    EXPECT_THROW(thread_pool({.threads = 1, .priorities = 2, .default_priority = 2}), std::invalid_argument);
+    EXPECT_THROW(thread_pool({.threads = 1, .priorities = 2, .weights = {1}}), std::invalid_argument);
+    EXPECT_THROW(thread_pool({.threads = 1, .priorities = 2, .weights = {1, 0}}), std::invalid_argument);
+
+    thread_pool pool({.threads = 1, .priorities = 2, .default_priority = 0});
+    EXPECT_EQ(pool.size(), 1U);
+    EXPECT_EQ(pool.priorities(), 2U);
+    EXPECT_THROW((void)pool.schedule(2), std::invalid_argument);
+}
+
+TEST(ThreadPoolTest, RunsOnWorkers)
+{
+    thread_pool pool({.threads = 2});
+    std::atomic<bool> on_worker = false;
+    std::latch done(1);
+
+    EXPECT_FALSE(pool.running_in_this_thread());
+    [](thread_pool& p, std::atomic<bool>& flag, std::latch& l) -> eager_task {
+        co_await p.schedule();
+        flag.store(p.running_in_this_thread());
+        l.count_down();
+    }(pool, on_worker, done);
+
+    done.wait();
+    EXPECT_TRUE(on_worker.load());
+}
+
+TEST(ThreadPoolTest, StrictPriority)
+{
+    thread_pool pool({.threads = 1, .priorities = 3});
+    std::vector<std::size_t> log;
+    std::latch done(6);
+
+    blocker b(pool);
+    for (std::size_t p : {2U, 1U, 2U, 0U, 1U, 0U}) {
+        record(pool, p, log, done);
+    }
+
+    b.release();
+    done.wait();
+    EXPECT_EQ(log, (std::vector<std::size_t>{0, 0, 1, 1, 2, 2}));
+}
+
+TEST(ThreadPoolTest, WeightedSelection)
+{
+    thread_pool pool({.threads = 1, .priorities = 2, .selection = priority_selection::weighted, .weights = {2, 1}});
+    std::vector<std::size_t> log;
+    std::latch done(8);
+
+    blocker b(pool);
+    for (std::size_t i = 0; i < 4; ++i) {
+        record(pool, 1, log, done);
+        record(pool, 0, log, done);
+    }
+
+    b.release();
+    done.wait();
+
+    // The blocker has used up one unit of the credit of level 0; then two of level 0 for every one of level 1
+    EXPECT_EQ(log, (std::vector<std::size_t>{0, 1, 0, 0, 1, 0, 1, 1}));
+}
+
+TEST(ThreadPoolTest, PriorityInheritance)
+{
+    thread_pool pool({.threads = 2, .priorities = 3});
+    std::atomic<std::size_t> child_priority = 99;
+    std::latch done(1);
+
+    [](thread_pool& p, std::atomic<std::size_t>& out, std::latch& l) -> eager_task {
+        co_await p.schedule(2);
+
+        // A child task started from a coroutine with priority 2 gets rescheduled with priority 2
+        co_await [](thread_pool& pp, std::atomic<std::size_t>& o) -> task<> {
+            co_await pp.schedule();
+            o.store(pp.current_priority());
+        }(p, out);
+
+        l.count_down();
+    }(pool, child_priority, done);
+
+    done.wait();
+    EXPECT_EQ(child_priority.load(), 2U);
+    EXPECT_EQ(pool.current_priority(), 1U);
+}
+
+TEST(ThreadPoolTest, CrossThread)
+{
+    constexpr int count = 10000;
+
+    thread_pool pool({.threads = 4});
+    std::atomic<int> sum = 0;
+    std::latch done(count);
+
+    std::vector<std::thread> submitters;
+    for (int t = 0; t < 2; ++t) {
+        submitters.emplace_back([&pool, &sum, &done, t] {
+            for (int i = t; i < count; i += 2) {
+                [](thread_pool& p, std::atomic<int>& s, std::latch& l, int v) -> eager_task {
+                    co_await p.schedule(static_cast<std::size_t>(v) % p.priorities());
+                    // Rescheduling from a worker goes to the local queue
+                    co_await p.schedule();
+                    s.fetch_add(v);
+                    l.count_down();
+                }(pool, sum, done, i);
+            }
+        });
+    }
+
+    for (auto& t : submitters) {
+        t.join();
+    }
+
+    done.wait();
+    EXPECT_EQ(sum.load(), count * (count - 1) / 2);
+}
+
+TEST(ThreadPoolTest, CpuList)
+{
+    EXPECT_EQ(detail::parse_cpu_list("0-3,8,10-11\n"), (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_EQ(detail::parse_cpu_list("5"), (std::vector<int>{5}));
+    EXPECT_EQ(detail::parse_cpu_list(""), (std::vector<int>{}));
+    EXPECT_EQ(detail::parse_cpu_list("x,2-y,4"), (std::vector<int>{4}));
+}
+
+TEST(ThreadPoolTest, PinnedWorkers)
+{
+    thread_pool pool({.threads = 4, .pin_workers = true});
+    std::atomic<int> pinned  = 0;
+    std::atomic<int> on_node = 0;
+    std::latch done(8);
+
+    EXPECT_GE(pool.nodes(), 1U);
+    EXPECT_EQ(pool.current_node(), 0U);
+    for (int i = 0; i < 8; ++i) {
+        [](thread_pool& p, std::atomic<int>& pin, std::atomic<int>& node, std::latch& l) -> eager_task {
+            co_await p.schedule();
+#if defined(__linux__)
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            if (sched_getaffinity(0, sizeof(set), &set) == 0 && CPU_COUNT(&set) == 1) {
+                pin.fetch_add(1);
+            }
+#else
+            pin.fetch_add(1);
+#endif
+            if (p.current_node() < p.nodes()) {
+                node.fetch_add(1);
+            }
+
+            l.count_down();
+        }(pool, pinned, on_node, done);
+    }
+
+    done.wait();
+    EXPECT_EQ(pinned.load(), 8);
+    EXPECT_EQ(on_node.load(), 8);
+}
+
+TEST(ThreadPoolTest, IdleStrategies)
+{
+    // Sleep right away, spin only, and the default spin-yield-sleep sequence
+    for (const auto& [spins, yields] : {std::pair<std::size_t, std::size_t>{0, 0}, {1000000, 0}, {512, 8}}) {
+        thread_pool pool({.threads = 2, .spins = spins, .yields = yields});
+        std::atomic<int> ran = 0;
+
+        for (int i = 0; i < 100; ++i) {
+            std::latch done(1);
+            [](thread_pool& p, std::atomic<int>& r, std::latch& l) -> eager_task {
+                co_await p.schedule();
+                r.fetch_add(1);
+                l.count_down();
+            }(pool, ran, done);
+
+            done.wait();
+            if (i % 10 == 0) {
+                // Give the workers time to go to sleep
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+
+        EXPECT_EQ(ran.load(), 100);
+    }
+}
+
+TEST(ThreadPoolTest, YieldNow)
+{
+    thread_pool pool({.threads = 1});
+    std::vector<int> log;
+    std::latch done(2);
+
+    blocker b(pool);
+    [](thread_pool& p, std::vector<int>& l, std::latch& d) -> eager_task {
+        co_await p.schedule();
+        l.push_back(1);
+        co_await yield_now();
+        l.push_back(3);
+        d.count_down();
+    }(pool, log, done);
+
+    [](thread_pool& p, std::vector<int>& l, std::latch& d) -> eager_task {
+        co_await p.schedule();
+        l.push_back(2);
+        d.count_down();
+    }(pool, log, done);
+
+    b.release();
+    done.wait();
+    EXPECT_EQ(log, (std::vector<int>{1, 2, 3}));
+
+    // Outside of a pool, yielding does nothing
+    bool resumed = false;
+    [](bool& r) -> eager_task {
+        co_await yield_now();
+        r = true;
+    }(resumed);
+
+    EXPECT_TRUE(resumed);
+}
+
+TEST(ThreadPoolTest, Budget)
+{
+    constexpr int steps = 100;
+
+    // Each step awaits a task that completes synchronously: two symmetric transfers
+    const auto busy = [](thread_pool& p, std::atomic<int>& progress, std::latch& d) -> eager_task {
+        co_await p.schedule();
+        for (int i = 0; i < steps; ++i) {
+            co_await []() -> task<> { co_return; }();
+            progress.store(i + 1);
+        }
+
+        d.count_down();
+    };
+
+    for (const std::size_t budget : {std::size_t{0}, std::size_t{16}}) {
+        thread_pool pool({.threads = 1, .budget = budget});
+        std::atomic<int> progress = 0;
+        std::atomic<int> seen     = -1;
+        std::latch done(2);
+
+        blocker b(pool);
+        busy(pool, progress, done);
+        [](thread_pool& p, std::atomic<int>& pr, std::atomic<int>& s, std::latch& d) -> eager_task {
+            co_await p.schedule();
+            s.store(pr.load());
+            d.count_down();
+        }(pool, progress, seen, done);
+
+        b.release();
+        done.wait();
+
+        if (budget == 0) {
+            EXPECT_EQ(seen.load(), steps);
+        }
+        else {
+            // The busy coroutine has been sent to the back of the queue after using up its budget
+            EXPECT_LT(seen.load(), steps);
+        }
+    }
+}
+
+TEST(ThreadPoolTest, ShedExpired)
+{
+    thread_pool pool({.threads = 1});
+    std::atomic<int> ran       = 0;
+    std::atomic<int> cancelled = 0;
+    std::latch done(3);
+
+    const auto job = [](thread_pool& p, thread_pool::clock::time_point deadline, std::atomic<int>& r,
+                        std::atomic<int>& c, std::latch& d) -> eager_task {
+        try {
+            co_await p.schedule(1, deadline);
+            r.fetch_add(1);
+        }
+        catch (const deadline_exceeded&) {
+            c.fetch_add(1);
+        }
+
+        d.count_down();
+    };
+
+    blocker b(pool);
+    const auto now = thread_pool::clock::now();
+    job(pool, now + std::chrono::milliseconds(1), ran, cancelled, done);
+    job(pool, now + std::chrono::hours(1), ran, cancelled, done);
+    job(pool, thread_pool::no_deadline, ran, cancelled, done);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    b.release();
+    done.wait();
+
+    EXPECT_EQ(ran.load(), 2);
+    EXPECT_EQ(cancelled.load(), 1);
+    EXPECT_EQ(pool.shed(), 1U);
+    EXPECT_THROW((void)pool.schedule(3, now), std::invalid_argument);
+}
+
+TEST(ThreadPoolTest, Elastic)
+{
+    EXPECT_THROW(thread_pool({.threads = 2, .min_threads = 3}), std::invalid_argument);
+
+    thread_pool pool({
+        .threads         = 4,
+        .min_threads     = 1,
+        .target_delay    = std::chrono::microseconds(100),
+        .resize_interval = std::chrono::milliseconds(1),
+    });
+
+    EXPECT_EQ(pool.size(), 4U);
+    EXPECT_EQ(pool.active(), 1U);
+
+    const auto work = [](thread_pool& p, std::chrono::microseconds cost, std::latch& d) -> eager_task {
+        co_await p.schedule();
+        const auto until = std::chrono::steady_clock::now() + cost;
+        while (std::chrono::steady_clock::now() < until) {
+            // Busy
+        }
+
+        d.count_down();
+    };
+
+    // A burst of work queues up behind the only active worker
+    std::size_t peak = 0;
+    {
+        std::latch done(200);
+        for (int i = 0; i < 200; ++i) {
+            work(pool, std::chrono::microseconds(200), done);
+            peak = std::max(peak, pool.active());
+        }
+
+        done.wait();
+        peak = std::max(peak, pool.active());
+    }
+
+    EXPECT_GT(peak, 1U);
+    EXPECT_GT(pool.queue_delay(), thread_pool::clock::duration::zero());
+
+    // A trickle of work lets the pool shrink back
+    for (int i = 0; i < 1000 && pool.active() > 1; ++i) {
+        std::latch done(1);
+        work(pool, std::chrono::microseconds(0), done);
+        done.wait();
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+
+    EXPECT_EQ(pool.active(), 1U);
+}
+
+TEST(ThreadPoolTest, DestructorDrains)
+{
+    std::atomic<int> ran = 0;
+    {
+        thread_pool pool({.threads = 1});
+        blocker b(pool);
+        for (int i = 0; i < 10; ++i) {
+            [](thread_pool& p, std::atomic<int>& r) -> eager_task {
+                co_await p.schedule();
+                r.fetch_add(1);
+            }(pool, ran);
+        }
+
+        b.release();
+    }
+
+    EXPECT_EQ(ran.load(), 10);
+}
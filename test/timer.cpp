@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "eager_task.h"
+#include "timer.h"
+
+using namespace wwa::coro;
+using namespace std::chrono_literals;
+
+namespace {
+
+void wait_for(const std::atomic<int>& counter, int value)
+{
+    while (counter.load() < value) {
+        std::this_thread::yield();
+    }
+}
+
+}  // namespace
+
+TEST(TimerTest, SleepFor)
+{
+    timer_service timers;
+    std::atomic<int> done = 0;
+
+    const auto start = timer_service::clock::now();
+    auto elapsed     = timer_service::clock::duration::zero();
+
+    [](timer_service& t, std::atomic<int>& d, timer_service::clock::time_point s,
+       timer_service::clock::duration& e) -> eager_task {
+        co_await t.sleep_for(20ms);
+        e = timer_service::clock::now() - s;
+        d.store(1);
+    }(timers, done, start, elapsed);
+
+    wait_for(done, 1);
+    EXPECT_GE(elapsed, 20ms);
+}
+
+TEST(TimerTest, SleepUntil)
+{
+    timer_service timers;
+    std::atomic<int> done = 0;
+    std::vector<int> order;
+
+    const auto now = timer_service::clock::now();
+    for (int i : {3, 1, 2}) {
+        [](timer_service& t, timer_service::clock::time_point tp, int n, std::vector<int>& o,
+           std::atomic<int>& d) -> eager_task {
+            co_await t.sleep_until(tp);
+            o.push_back(n);
+            d.fetch_add(1);
+        }(timers, now + i * 10ms, i, order, done);
+    }
+
+    wait_for(done, 3);
+    EXPECT_EQ(order, (std::vector<int>{1, 2, 3}));
+}
+
+TEST(TimerTest, PastDeadlineDoesNotSuspend)
+{
+    timer_service timers;
+    bool done = false;
+
+    [](timer_service& t, bool& d) -> eager_task {
+        co_await t.sleep_until(timer_service::clock::now() - 1s);
+        d = true;
+    }(timers, done);
+
+    EXPECT_TRUE(done);
+}
+
+TEST(TimerTest, DestructorFiresPending)
+{
+    bool done = false;
+    {
+        timer_service timers;
+        [](timer_service& t, bool& d) -> eager_task {
+            co_await t.sleep_for(1h);
+            d = true;
+        }(timers, done);
+
+        EXPECT_FALSE(done);
+    }
+
+    EXPECT_TRUE(done);
+}
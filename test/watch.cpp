@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "eager_task.h"
+#include "watch.h"
+
+using namespace wwa::coro;
+
+namespace {
+
+struct config {
+    int a;
+    int b;
+    double c;
+};
+
+}  // namespace
+
+TEST(WatchTest, PublishBorrow)
+{
+    watch<config> w({1, 2, 3.0});
+    std::uint64_t version = 1;
+
+    auto value = w.borrow(version);
+    EXPECT_EQ(version, 0U);
+    EXPECT_EQ(value.a, 1);
+    EXPECT_EQ(value.b, 2);
+    EXPECT_EQ(value.c, 3.0);
+
+    w.publish({4, 5, 6.0});
+    value = w.borrow(version);
+    EXPECT_EQ(version, 1U);
+    EXPECT_EQ(w.version(), 1U);
+    EXPECT_EQ(value.a, 4);
+    EXPECT_EQ(value.b, 5);
+    EXPECT_EQ(value.c, 6.0);
+}
+
+TEST(WatchTest, ChangedWakesAll)
+{
+    watch<int> w(0);
+    std::vector<int> seen;
+
+    for (int i = 0; i < 3; ++i) {
+        [](watch<int>& wt, std::vector<int>& out) -> eager_task {
+            if (co_await wt.changed()) {
+                out.push_back(wt.borrow());
+            }
+        }(w, seen);
+    }
+
+    EXPECT_TRUE(seen.empty());
+    w.publish(1983);
+    EXPECT_EQ(seen, (std::vector<int>{1983, 1983, 1983}));
+}
+
+TEST(WatchTest, ChangedSince)
+{
+    watch<int> w(1);
+    bool changed = false;
+
+    std::uint64_t version = 0;
+    EXPECT_EQ(w.borrow(version), 1);
+
+    w.publish(2);  // Happens between borrow() and changed()
+
+    [](watch<int>& wt, std::uint64_t since, bool& out) -> eager_task {
+        out = co_await wt.changed(since);
+    }(w, version, changed);
+
+    EXPECT_TRUE(changed);
+}
+
+TEST(WatchTest, Close)
+{
+    watch<int> w(1);
+    bool changed = true;
+
+    [](watch<int>& wt, bool& out) -> eager_task { out = co_await wt.changed(); }(w, changed);
+    w.close();
+    EXPECT_FALSE(changed);
+    EXPECT_TRUE(w.is_closed());
+    EXPECT_EQ(w.borrow(), 1);
+
+    changed = true;
+    [](watch<int>& wt, bool& out) -> eager_task { out = co_await wt.changed(); }(w, changed);
+    EXPECT_FALSE(changed);
+}
+
+TEST(WatchTest, ConcurrentReaders)
+{
+    constexpr int updates = 20000;
+    watch<config> w({0, 0, 0.0});
+    std::atomic<bool> done = false;
+    std::atomic<int> torn  = 0;
+
+    std::vector<std::thread> readers;
+    readers.reserve(3);
+    for (int i = 0; i < 3; ++i) {
+        readers.emplace_back([&w, &done, &torn] {
+            std::uint64_t last = 0;
+            while (!done.load()) {
+                std::uint64_t version = 0;
+                const auto v          = w.borrow(version);
+                if (v.a != v.b || v.c != static_cast<double>(v.a) || version < last) {
+                    torn.fetch_add(1);
+                }
+
+                last = version;
+            }
+        });
+    }
+
+    for (int i = 1; i <= updates; ++i) {
+        w.publish({i, i, static_cast<double>(i)});
+    }
+
+    done = true;
+    for (auto& t : readers) {
+        t.join();
+    }
+
+    EXPECT_EQ(torn.load(), 0);
+    EXPECT_EQ(w.version(), static_cast<std::uint64_t>(updates));
+}